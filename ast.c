@@ -1,5 +1,6 @@
 #include "ast.h"
 #include <stdlib.h>
+#include <string.h>
 #include "common.h"
 #include "memory.h"
 #include "scope.h"
@@ -54,6 +55,7 @@ static AstFn* ast_fn_init_(Token start, Token end, FnType type, AstId* name, Ast
   fn->upvalue_count = 0;
   fn->local_count   = 0;
   fn->is_lambda     = false;
+  fn->compiled      = NULL;
 
   ast_node_add_child((AstNode*)fn, (AstNode*)name);
   ast_node_add_child((AstNode*)fn, (AstNode*)params);
@@ -145,6 +147,7 @@ static AstStatement* ast_stmt_init(Token start, Token end, StatementType type) {
   stmt->type          = type;
   stmt->path          = NULL;
   stmt->locals_to_pop = 0;
+  stmt->uses_error    = false;
   return stmt;
 }
 
@@ -205,6 +208,20 @@ AstStatement* ast_stmt_for_init(Token start,
   return stmt;
 }
 
+AstStatement* ast_stmt_for_in_init(Token start,
+                                   Token end,
+                                   AstDeclaration* vars,
+                                   AstExpression* iterable,
+                                   AstExpression* range_end,
+                                   AstStatement* body) {
+  AstStatement* stmt = ast_stmt_init(start, end, STMT_FOR_IN);
+  ast_node_add_child((AstNode*)stmt, (AstNode*)vars);
+  ast_node_add_child((AstNode*)stmt, (AstNode*)iterable);
+  ast_node_add_child((AstNode*)stmt, (AstNode*)range_end);
+  ast_node_add_child((AstNode*)stmt, (AstNode*)body);
+  return stmt;
+}
+
 AstStatement* ast_stmt_return_init(Token start, Token end, AstExpression* expression) {
   AstStatement* stmt = ast_stmt_init(start, end, STMT_RETURN);
   ast_node_add_child((AstNode*)stmt, (AstNode*)expression);
@@ -252,6 +269,9 @@ static AstExpression* ast_expr_init(Token start, Token end, ExpressionType type)
   AstExpression* expr = (AstExpression*)ast_allocate_node(sizeof(AstExpression), NODE_EXPR, start, end);
   expr->type          = type;
   expr->operator_     = (Token){TOKEN_ERROR, NULL, 0, 0, false};
+  expr->uses_error    = false;
+  expr->reuse         = -1;
+  expr->inlined       = NULL;
   return expr;
 }
 
@@ -317,6 +337,13 @@ AstExpression* ast_expr_or_init(Token start, Token end, AstExpression* left, Ast
   return expr;
 }
 
+AstExpression* ast_expr_coalesce_init(Token start, Token end, AstExpression* left, AstExpression* right) {
+  AstExpression* expr = ast_expr_init(start, end, EXPR_COALESCE);
+  ast_node_add_child((AstNode*)expr, (AstNode*)left);
+  ast_node_add_child((AstNode*)expr, (AstNode*)right);
+  return expr;
+}
+
 AstExpression* ast_expr_is_init(Token start, Token end, Token operator_, AstExpression* left, AstExpression* right) {
   AstExpression* expr = ast_expr_init(start, end, EXPR_IS);
   expr->operator_     = operator_;
@@ -536,6 +563,82 @@ void ast_free(AstNode* node) {
   free(node);
 }
 
+static size_t ast_node_size(NodeType type) {
+  switch (type) {
+    case NODE_ID: return sizeof(AstId);
+    case NODE_FN: return sizeof(AstFn);
+    case NODE_BLOCK: return sizeof(AstBlock);
+    case NODE_DECL: return sizeof(AstDeclaration);
+    case NODE_STMT: return sizeof(AstStatement);
+    case NODE_EXPR: return sizeof(AstExpression);
+    case NODE_LIT: return sizeof(AstLiteral);
+    case NODE_PATTERN: return sizeof(AstPattern);
+    default: INTERNAL_ERROR("Unhandled node type: %d", type); return sizeof(AstNode);
+  }
+}
+
+AstNode* ast_clone(AstNode* node) {
+  if (node == NULL) {
+    return NULL;
+  }
+  INTERNAL_ASSERT(node->scope == NULL, "Only unresolved nodes can be cloned.");
+  INTERNAL_ASSERT(node->type != NODE_ID || ((AstId*)node)->ref == NULL, "Only unresolved nodes can be cloned.");
+
+  size_t size    = ast_node_size(node->type);
+  AstNode* clone = malloc(size);
+  memcpy(clone, node, size);
+
+  clone->parent   = NULL;
+  clone->children = NULL;
+  clone->count    = 0;
+  clone->capacity = 0;
+  for (int i = 0; i < node->count; i++) {
+    ast_node_add_child(clone, ast_clone(node->children[i]));
+  }
+
+  return clone;
+}
+
+AstStatement* ast_trailing_return(AstNode* body) {
+  if (body->type != NODE_BLOCK || body->count == 0) {
+    return NULL;
+  }
+
+  AstNode* last = body->children[body->count - 1];
+  if (last->type != NODE_STMT || ((AstStatement*)last)->type != STMT_RETURN) {
+    return NULL;
+  }
+  return (AstStatement*)last;
+}
+
+AstNode* ast_returned_expr(AstFn* fn) {
+  AstNode* body = fn->base.children[2];
+  if (fn->is_lambda) {
+    return body;
+  }
+
+  AstStatement* trailing = ast_trailing_return(body);
+  return trailing != NULL && body->count == 1 ? trailing->base.children[0] : NULL;
+}
+
+bool ast_seq_loop_kind(AstId* method, SeqLoopKind* kind) {
+  static const struct {
+    const char* name;
+    SeqLoopKind kind;
+  } methods[] = {
+      {"each", SEQ_LOOP_EACH}, {"map", SEQ_LOOP_MAP},     {"sift", SEQ_LOOP_SIFT},
+      {"fold", SEQ_LOOP_FOLD}, {"every", SEQ_LOOP_EVERY}, {"some", SEQ_LOOP_SOME},
+  };
+
+  for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+    if (strcmp(method->name->chars, methods[i].name) == 0) {
+      *kind = methods[i].kind;
+      return true;
+    }
+  }
+  return false;
+}
+
 void ast_mark(AstNode* node) {
   if (node == NULL) {
     return;
@@ -557,6 +660,14 @@ void ast_mark(AstNode* node) {
     AstLiteral* lit = (AstLiteral*)node;
     mark_value(lit->value);
   }
+  if (node->scope != NULL) {
+    // Names of synthetic locals (see inject_local) are only referenced by the scope.
+    for (int i = 0; i < node->scope->capacity; i++) {
+      if (node->scope->entries[i].key != NULL) {
+        mark_obj((Obj*)node->scope->entries[i].key);
+      }
+    }
+  }
 
   for (int i = 0; i < node->count; i++) {
     ast_mark(node->children[i]);
@@ -638,6 +749,7 @@ static void ast_node_print(AstNode* node) {
         case STMT_IF: printf(STR(STMT_IF)); break;
         case STMT_WHILE: printf(STR(STMT_WHILE)); break;
         case STMT_FOR: printf(STR(STMT_FOR)); break;
+        case STMT_FOR_IN: printf(STR(STMT_FOR_IN)); break;
         case STMT_RETURN: printf(STR(STMT_RETURN)); break;
         case STMT_PRINT: printf(STR(STMT_PRINT)); break;
         case STMT_EXPR: printf(STR(STMT_EXPR)); break;
@@ -660,6 +772,7 @@ static void ast_node_print(AstNode* node) {
         case EXPR_ASSIGN: printf(STR(EXPR_ASSIGN)); break;
         case EXPR_AND: printf(STR(EXPR_AND)); break;
         case EXPR_OR: printf(STR(EXPR_OR)); break;
+        case EXPR_COALESCE: printf(STR(EXPR_COALESCE)); break;
         case EXPR_IS: printf(STR(EXPR_IS)); break;
         case EXPR_IN: printf(STR(EXPR_IN)); break;
         case EXPR_CALL: printf(STR(EXPR_CALL)); break;
@@ -680,9 +793,9 @@ static void ast_node_print(AstNode* node) {
       switch (((AstLiteral*)node)->type) {
         case LIT_NUMBER: {
           if (is_float(((AstLiteral*)node)->value)) {
-            printf(STR(LIT_NUMBER) " " ANSI_BLUE_STR("%g"), ((AstLiteral*)node)->value.as.float_);
+            printf(STR(LIT_NUMBER) " " ANSI_BLUE_STR("%g"), AS_FLOAT(((AstLiteral*)node)->value));
           } else {
-            printf(STR(LIT_NUMBER) " " ANSI_BLUE_STR("%llu"), ((AstLiteral*)node)->value.as.integer);
+            printf(STR(LIT_NUMBER) " " ANSI_BLUE_STR("%llu"), AS_INT(((AstLiteral*)node)->value));
           }
           break;
         }
@@ -699,7 +812,7 @@ static void ast_node_print(AstNode* node) {
         }
         case LIT_BOOL:
           printf(STR(LIT_BOOL) " " ANSI_BLUE_STR("%s"),
-                 (((AstLiteral*)node)->value.as.boolean) ? VALUE_STR_TRUE : VALUE_STR_FALSE);
+                 (AS_BOOL(((AstLiteral*)node)->value)) ? VALUE_STR_TRUE : VALUE_STR_FALSE);
           break;
         case LIT_NIL: printf(STR(LIT_NIL) " " ANSI_BLUE_STR(VALUE_STR_NIL)); break;
         case LIT_TUPLE: printf(STR(LIT_TUPLE) " " ANSI_BLUE_STR("(" STR(LIT_TUPLE) ")")); break;
@@ -23,6 +23,7 @@ typedef enum {
   STMT_IF,      // If statement
   STMT_WHILE,   // While loop
   STMT_FOR,     // For loop
+  STMT_FOR_IN,  // For-in loop
   STMT_RETURN,  // Return statement
   STMT_PRINT,   // Print statement
   STMT_EXPR,    // Expression statement
@@ -42,6 +43,7 @@ typedef enum {
   EXPR_ASSIGN,        // Assignment
   EXPR_AND,           // Logical AND
   EXPR_OR,            // Logical OR
+  EXPR_COALESCE,      // Nil-coalescing (??)
   EXPR_IS,            // Type check
   EXPR_IN,            // Contains check
   EXPR_CALL,          // Function call
@@ -138,7 +140,8 @@ struct AstFn {
   int upvalue_count;  // Number of upvalues in the function, including sub-scopes
   int local_count;    // Number of local variables in the function, including sub-scopes
   FnType type;
-  bool is_lambda;  // True if the function is a lambda function
+  bool is_lambda;         // True if the function is a lambda function
+  ObjFunction* compiled;  // The function compiled from this node, NULL until compiled. Guards the calls it was inlined into.
 };
 
 AstFn* ast_fn_init(Token start, Token end, FnType type, AstId* name, AstDeclaration* params, AstBlock* body);
@@ -184,6 +187,7 @@ struct AstStatement {
   StatementType type;
   ObjString* path;    // STMT_IMPORT
   int locals_to_pop;  // STMT_BREAK, STMT_SKIP
+  bool uses_error;    // STMT_TRY
 };
 
 AstStatement* ast_stmt_import_init(Token start, Token end, ObjString* path, AstId* id);
@@ -201,6 +205,12 @@ AstStatement* ast_stmt_for_init(Token start,
                                 AstExpression* condition,
                                 AstExpression* increment,
                                 AstStatement* body);
+AstStatement* ast_stmt_for_in_init(Token start,
+                                   Token end,
+                                   AstDeclaration* vars,
+                                   AstExpression* iterable,
+                                   AstExpression* range_end,
+                                   AstStatement* body);
 
 AstStatement* ast_stmt_return_init(Token start, Token end, AstExpression* expression);
 AstStatement* ast_stmt_print_init(Token start, Token end, AstExpression* expression);
@@ -217,7 +227,10 @@ AstStatement* ast_stmt_try_init(Token start, Token end, AstStatement* try_stmt,
 struct AstExpression {
   AstNode base;
   ExpressionType type;
-  Token operator_;  // EXPR_ASSIGN, EXPR_UNARY, EXPR_POSTFIX, EXPR_BINARY
+  Token operator_;  // EXPR_ASSIGN, EXPR_UNARY, EXPR_POSTFIX, EXPR_BINARY. TOKEN_SAFE_DOT for nil-safe EXPR_DOT and EXPR_SUBS
+  bool uses_error;  // EXPR_TRY
+  int reuse;        // Distance of an equal value on the stack, which is reused instead of evaluating this again. -1 if none
+  AstFn* inlined;   // EXPR_CALL, EXPR_INVOKE: The function which is inlined at this call, see the resolver. NULL if none
 };
 
 AstExpression* ast_expr_binary_init(Token start, Token end, Token operator_, AstExpression* left, AstExpression* right);
@@ -229,6 +242,7 @@ AstExpression* ast_expr_variable_init(Token start, Token end, AstId* identifier)
 AstExpression* ast_expr_assign_init(Token start, Token end, Token operator_, AstExpression* left, AstExpression* right);
 AstExpression* ast_expr_and_init(Token start, Token end, AstExpression* left, AstExpression* right);
 AstExpression* ast_expr_or_init(Token start, Token end, AstExpression* left, AstExpression* right);
+AstExpression* ast_expr_coalesce_init(Token start, Token end, AstExpression* left, AstExpression* right);
 AstExpression* ast_expr_is_init(Token start, Token end, Token operator_, AstExpression* left, AstExpression* right);
 AstExpression* ast_expr_in_init(Token start, Token end, Token operator_, AstExpression* left, AstExpression* right);
 AstExpression* ast_expr_call_init(Token start, Token end, AstExpression* target);
@@ -299,6 +313,20 @@ void ast_node_add_child(AstNode* parent, AstNode* child);
 // Frees an AST node and all its children
 void ast_free(AstNode* node);
 
+// Creates a deep copy of an unresolved AST node and all its children.
+AstNode* ast_clone(AstNode* node);
+
+// Returns the return statement at the end of a function [body], or NULL if there is none.
+AstStatement* ast_trailing_return(AstNode* body);
+
+// Returns the expression [fn] returns, if that's all its body does: The body of a lambda, or the value of the only statement of
+// the body if that's a return statement. NULL otherwise.
+AstNode* ast_returned_expr(AstFn* fn);
+
+// Determines which of the higher-order Seq and Tuple methods, which can be lowered into a loop, [method] refers to. Returns false
+// if it's none of them.
+bool ast_seq_loop_kind(AstId* method, SeqLoopKind* kind);
+
 // Marks all Objs in a AST.
 void ast_mark(AstNode* node);
 
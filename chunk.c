@@ -1,6 +1,7 @@
 #include "chunk.h"
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include "memory.h"
 #include "scanner.h"
 #include "value.h"
@@ -12,6 +13,15 @@ void chunk_init(Chunk* chunk) {
   chunk->code         = NULL;
   chunk->source_views = NULL;
   value_array_init(&chunk->constants);
+  chunk->cache_count    = 0;
+  chunk->cache_capacity = 0;
+  chunk->caches         = NULL;
+  chunk->inlined_count    = 0;
+  chunk->inlined_capacity = 0;
+  chunk->inlined          = NULL;
+  chunk->try_count        = 0;
+  chunk->try_capacity     = 0;
+  chunk->tries            = NULL;
 }
 
 void chunk_write(Chunk* chunk, uint16_t data, Token error_start, Token error_end) {
@@ -29,6 +39,331 @@ void chunk_write(Chunk* chunk, uint16_t data, Token error_start, Token error_end
   chunk->count++;
 }
 
+int chunk_instruction_length(Chunk* chunk, int offset) {
+  switch ((OpCode)chunk->code[offset]) {
+    case OP_CONSTANT:
+    case OP_DUPE:
+    case OP_GET_LOCAL:
+    case OP_SET_LOCAL:
+    case OP_GET_UPVALUE:
+    case OP_SET_UPVALUE:
+    case OP_GET_BASE_METHOD:
+    case OP_SEQ_LITERAL:
+    case OP_TUPLE_LITERAL:
+    case OP_OBJECT_LITERAL:
+    case OP_JUMP:
+    case OP_JUMP_IF_FALSE:
+    case OP_JUMP_IF_TRUE:
+    case OP_JUMP_IF_NOT_NIL:
+    case OP_LOOP:
+    case OP_CALL:
+    case OP_TAIL_CALL:
+    case OP_RETURN_INLINED:
+    case OP_CLASS:
+    case OP_IMPORT:
+    case OP_INC_LOCAL:
+    case OP_DEC_LOCAL:
+    case OP_RETURN_LOCAL:
+    case OP_EQ_JUMP_IF_FALSE:
+    case OP_NEQ_JUMP_IF_FALSE:
+    case OP_GT_JUMP_IF_FALSE:
+    case OP_LT_JUMP_IF_FALSE:
+    case OP_GTEQ_JUMP_IF_FALSE:
+    case OP_LTEQ_JUMP_IF_FALSE:
+    case OP_LT_LEN_JUMP_IF_FALSE:
+    case OP_SEQ_LOOP_END: return 2;
+    case OP_GET_GLOBAL_SLOT:
+    case OP_DEFINE_GLOBAL_SLOT:
+    case OP_SET_GLOBAL_SLOT:
+    case OP_GET_PROPERTY:
+    case OP_SET_PROPERTY:
+    case OP_GET_PROPERTY_SAFE:
+    case OP_GET_PROPERTY_OBJ:
+    case OP_BASE_INVOKE:
+    case OP_METHOD:
+    case OP_IMPORT_FROM:
+    case OP_GET_LOCAL_GET_LOCAL:
+    case OP_ADD_LOCAL_CONST:
+    case OP_REUSE:
+    case OP_SEQ_LOOP_ENTER:
+    case OP_SEQ_LOOP_STEP:
+    case OP_FOR_RANGE_NEXT: return 3;
+    case OP_INVOKE:
+    case OP_TAIL_INVOKE:
+    case OP_CALL_INLINED:
+    case OP_SEQ_LOOP_NEXT:
+    case OP_FOR_IN_NEXT: return 4;
+    case OP_INVOKE_INLINED: return 6;
+    case OP_CLOSURE: return 2 + 2 * AS_FUNCTION(chunk->constants.values[chunk->code[offset + 1]])->upvalue_count;
+    case OP_NIL:
+    case OP_TRUE:
+    case OP_FALSE:
+    case OP_POP:
+    case OP_GET_SUBSCRIPT:
+    case OP_SET_SUBSCRIPT:
+    case OP_GET_SUBSCRIPT_SAFE:
+    case OP_GET_SLICE:
+    case OP_EQ:
+    case OP_NEQ:
+    case OP_GT:
+    case OP_LT:
+    case OP_GTEQ:
+    case OP_LTEQ:
+    case OP_ADD:
+    case OP_SUBTRACT:
+    case OP_MULTIPLY:
+    case OP_DIVIDE:
+    case OP_MODULO:
+    case OP_NOT:
+    case OP_NEGATE:
+    case OP_PRINT:
+    case OP_CLOSE_UPVALUE:
+    case OP_RETURN:
+    case OP_RETURN_NIL:
+    case OP_INHERIT:
+    case OP_FINALIZE:
+    case OP_THROW:
+    case OP_IS:
+    case OP_IN:
+    case OP_GT_INT_INT:
+    case OP_GT_FLOAT_FLOAT:
+    case OP_LT_INT_INT:
+    case OP_LT_FLOAT_FLOAT:
+    case OP_GTEQ_INT_INT:
+    case OP_GTEQ_FLOAT_FLOAT:
+    case OP_LTEQ_INT_INT:
+    case OP_LTEQ_FLOAT_FLOAT:
+    case OP_ADD_INT_INT:
+    case OP_ADD_FLOAT_FLOAT:
+    case OP_SUBTRACT_INT_INT:
+    case OP_SUBTRACT_FLOAT_FLOAT:
+    case OP_MULTIPLY_INT_INT:
+    case OP_MULTIPLY_FLOAT_FLOAT:
+    case OP_GET_SUBSCRIPT_SEQ_INT:
+    case OP_GET_SUBSCRIPT_IN_BOUNDS:
+    case OP_FOR_IN_INIT:
+    case OP_FOR_RANGE_INIT: return 1;
+    default: return -1;
+  }
+}
+
+int chunk_jump_operand(OpCode op) {
+  switch (op) {
+    case OP_JUMP:
+    case OP_JUMP_IF_FALSE:
+    case OP_JUMP_IF_TRUE:
+    case OP_JUMP_IF_NOT_NIL:
+    case OP_EQ_JUMP_IF_FALSE:
+    case OP_NEQ_JUMP_IF_FALSE:
+    case OP_GT_JUMP_IF_FALSE:
+    case OP_LT_JUMP_IF_FALSE:
+    case OP_GTEQ_JUMP_IF_FALSE:
+    case OP_LTEQ_JUMP_IF_FALSE:
+    case OP_LT_LEN_JUMP_IF_FALSE: return 1;
+    case OP_REUSE:
+    case OP_SEQ_LOOP_ENTER:
+    case OP_FOR_RANGE_NEXT: return 2;
+    case OP_CALL_INLINED:
+    case OP_SEQ_LOOP_NEXT:
+    case OP_FOR_IN_NEXT: return 3;
+    case OP_INVOKE_INLINED: return 5;
+    default: return 0;
+  }
+}
+
+// Returns the change in the depth of the stack window caused by the instruction at [offset], along its fall-through edge - or
+// along its jump, if [branch] is set. [peak] receives the most values the instruction holds above the depth it started with, which
+// can be more than its effect: The slow paths of OP_INC_LOCAL and friends push their operands for a call to a special method.
+static int stack_effect(Chunk* chunk, int offset, bool branch, int* peak) {
+  uint16_t* code = chunk->code + offset;
+  int effect     = 0;
+  *peak          = 0;
+
+  switch ((OpCode)code[0]) {
+    case OP_CONSTANT:
+    case OP_NIL:
+    case OP_TRUE:
+    case OP_FALSE:
+    case OP_DUPE:
+    case OP_GET_LOCAL:
+    case OP_GET_GLOBAL_SLOT:
+    case OP_GET_UPVALUE:
+    case OP_CLOSURE:
+    case OP_CLASS:
+    case OP_IMPORT:
+    case OP_IMPORT_FROM:
+    case OP_FOR_IN_INIT: effect = 1; break;
+    case OP_GET_LOCAL_GET_LOCAL: effect = 2; break;
+    case OP_POP:
+    case OP_DEFINE_GLOBAL_SLOT:
+    case OP_CLOSE_UPVALUE:
+    case OP_PRINT:
+    case OP_INHERIT:
+    case OP_METHOD:
+    case OP_SET_PROPERTY:
+    case OP_SEQ_LOOP_STEP:
+    case OP_GET_SUBSCRIPT:
+    case OP_GET_SUBSCRIPT_SAFE:
+    case OP_GET_SUBSCRIPT_SEQ_INT:
+    case OP_GET_SUBSCRIPT_IN_BOUNDS:
+    case OP_EQ:
+    case OP_NEQ:
+    case OP_GT:
+    case OP_LT:
+    case OP_GTEQ:
+    case OP_LTEQ:
+    case OP_ADD:
+    case OP_SUBTRACT:
+    case OP_MULTIPLY:
+    case OP_DIVIDE:
+    case OP_MODULO:
+    case OP_GT_INT_INT:
+    case OP_GT_FLOAT_FLOAT:
+    case OP_LT_INT_INT:
+    case OP_LT_FLOAT_FLOAT:
+    case OP_GTEQ_INT_INT:
+    case OP_GTEQ_FLOAT_FLOAT:
+    case OP_LTEQ_INT_INT:
+    case OP_LTEQ_FLOAT_FLOAT:
+    case OP_ADD_INT_INT:
+    case OP_ADD_FLOAT_FLOAT:
+    case OP_SUBTRACT_INT_INT:
+    case OP_SUBTRACT_FLOAT_FLOAT:
+    case OP_MULTIPLY_INT_INT:
+    case OP_MULTIPLY_FLOAT_FLOAT: effect = -1; break;
+    case OP_SET_SUBSCRIPT:
+    case OP_GET_SLICE:
+    case OP_IS:
+    case OP_IN:
+    case OP_EQ_JUMP_IF_FALSE:
+    case OP_NEQ_JUMP_IF_FALSE:
+    case OP_GT_JUMP_IF_FALSE:
+    case OP_LT_JUMP_IF_FALSE:
+    case OP_GTEQ_JUMP_IF_FALSE:
+    case OP_LTEQ_JUMP_IF_FALSE:
+    case OP_LT_LEN_JUMP_IF_FALSE: effect = -2; break;
+    case OP_SEQ_LOOP_END: effect = -3; break;
+    case OP_SET_LOCAL:
+    case OP_SET_GLOBAL_SLOT:
+    case OP_SET_UPVALUE:
+    case OP_GET_PROPERTY:
+    case OP_GET_PROPERTY_SAFE:
+    case OP_GET_PROPERTY_OBJ:
+    case OP_GET_BASE_METHOD:
+    case OP_NOT:
+    case OP_NEGATE:
+    case OP_JUMP:
+    case OP_JUMP_IF_FALSE:
+    case OP_JUMP_IF_TRUE:
+    case OP_JUMP_IF_NOT_NIL:
+    case OP_LOOP:
+    case OP_FINALIZE:
+    case OP_FOR_RANGE_INIT:
+    case OP_RETURN:
+    case OP_THROW: break;
+    case OP_RETURN_LOCAL:
+    case OP_RETURN_NIL: *peak = 1; break;
+    case OP_INC_LOCAL:
+    case OP_DEC_LOCAL:
+    case OP_ADD_LOCAL_CONST: *peak = 2; break;
+    case OP_CALL:
+    case OP_TAIL_CALL: effect = -code[1]; break;
+    case OP_INVOKE:
+    case OP_TAIL_INVOKE: effect = -code[2]; break;
+    case OP_BASE_INVOKE: effect = -code[2] - 1; break;
+    case OP_CALL_INLINED: effect = branch ? -code[1] : 0; break;
+    case OP_INVOKE_INLINED: effect = branch ? -code[2] : 0; break;
+    case OP_RETURN_INLINED: effect = -code[1] - 1; break;
+    case OP_SEQ_LITERAL:
+    case OP_TUPLE_LITERAL: effect = 1 - code[1]; break;
+    case OP_OBJECT_LITERAL: effect = 1 - 2 * code[1]; break;
+    case OP_REUSE: effect = branch ? 1 : 0; break;
+    case OP_SEQ_LOOP_ENTER: effect = branch ? 0 : code[1] == SEQ_LOOP_FOLD ? 2 : 3; break;
+    case OP_SEQ_LOOP_NEXT: {
+      if (!branch) {
+        effect = ((code[2] & SEQ_LOOP_PUSH_ACC) != 0) + ((code[2] & SEQ_LOOP_PUSH_ITEM) != 0) +
+                 ((code[2] & SEQ_LOOP_PUSH_INDEX) != 0);
+      }
+      break;
+    }
+    case OP_FOR_IN_NEXT: effect = branch ? 0 : code[2]; break;
+    case OP_FOR_RANGE_NEXT: effect = branch ? 0 : 1; break;
+  }
+
+  if (effect > *peak) {
+    *peak = effect;
+  }
+  return effect;
+}
+
+// Returns whether execution can continue with the instruction after [op].
+static bool falls_through(OpCode op) {
+  switch (op) {
+    case OP_JUMP:
+    case OP_LOOP:
+    case OP_RETURN:
+    case OP_RETURN_LOCAL:
+    case OP_RETURN_NIL:
+    case OP_THROW: return false;
+    default: return true;
+  }
+}
+
+int chunk_max_depth(Chunk* chunk, int depth) {
+  // The compiler makes sure that the depth is the same on every path to an instruction, so each one is visited once.
+  int* depth_at = malloc(sizeof(int) * ((size_t)chunk->count + 1));
+  int* worklist = malloc(sizeof(int) * ((size_t)chunk->count + 1));
+  int count     = 0;
+  for (int i = 0; i < chunk->count; i++) {
+    depth_at[i] = -1;
+  }
+
+#define VISIT(offset, value)                                                   \
+  do {                                                                         \
+    if ((offset) >= 0 && (offset) < chunk->count && depth_at[(offset)] < 0) { \
+      depth_at[(offset)] = (value);                                            \
+      worklist[count++]  = (offset);                                           \
+    }                                                                          \
+  } while (0)
+
+  VISIT(0, depth);
+  for (int i = 0; i < chunk->try_count; i++) {
+    VISIT(chunk->tries[i].handler, chunk->tries[i].depth + 1);  // Entering the handler pushes the error.
+  }
+
+  int max_depth = depth;
+  while (count > 0) {
+    int offset = worklist[--count];
+    int length = chunk_instruction_length(chunk, offset);
+    if (length < 0) {
+      continue;
+    }
+
+    OpCode op   = (OpCode)chunk->code[offset];
+    int next    = offset + length;
+    int operand = chunk_jump_operand(op);
+    int peak;
+
+    int effect = stack_effect(chunk, offset, false, &peak);
+    max_depth  = MAX(max_depth, depth_at[offset] + peak);
+    if (falls_through(op)) {
+      VISIT(next, depth_at[offset] + effect);
+    }
+
+    if (operand > 0 || op == OP_LOOP) {
+      effect     = stack_effect(chunk, offset, true, &peak);
+      max_depth  = MAX(max_depth, depth_at[offset] + peak);
+      int target = op == OP_LOOP ? next - chunk->code[offset + 1] : next + chunk->code[offset + operand];
+      VISIT(target, depth_at[offset] + effect);
+    }
+  }
+#undef VISIT
+
+  free(depth_at);
+  free(worklist);
+  return max_depth;
+}
+
 SourceView chunk_make_source_view(Token error_start, Token error_end) {
   const char* start = scanner_get_line_start(error_start);
   const char* end =
@@ -46,6 +381,9 @@ void chunk_free(Chunk* chunk) {
   FREE_ARRAY(uint16_t, chunk->code, chunk->capacity);
   FREE_ARRAY(SourceView, chunk->source_views, chunk->capacity);
   value_array_free(&chunk->constants);
+  FREE_ARRAY(InlineCache, chunk->caches, chunk->cache_capacity);
+  FREE_ARRAY(InlinedRange, chunk->inlined, chunk->inlined_capacity);
+  FREE_ARRAY(TryRange, chunk->tries, chunk->try_capacity);
   chunk_init(chunk);
 }
 
@@ -56,6 +394,17 @@ int chunk_add_constant(Chunk* chunk, Value value) {
   return chunk->constants.count - 1;
 }
 
+int chunk_add_inline_cache(Chunk* chunk) {
+  if (SHOULD_GROW(chunk->cache_count + 1, chunk->cache_capacity)) {
+    int old_capacity      = chunk->cache_capacity;
+    chunk->cache_capacity = GROW_CAPACITY(old_capacity);
+    chunk->caches         = RESIZE_ARRAY(InlineCache, chunk->caches, old_capacity, chunk->cache_capacity);
+  }
+
+  chunk->caches[chunk->cache_count] = (InlineCache){.count = 0, .shape = NULL, .transition = NULL, .slot = 0};
+  return chunk->cache_count++;
+}
+
 void report_error_location(SourceView source) {
   const char* error_end   = source.start + source.error_end_ofs;
   const char* error_start = source.start + source.error_start_ofs;
@@ -103,4 +452,25 @@ void report_error_location(SourceView source) {
 
   // Done!
   fputs("\n\n", stderr);
-}
\ No newline at end of file
+}
+
+void chunk_add_inlined_range(Chunk* chunk, int start, int end, int site, ObjString* name) {
+  if (SHOULD_GROW(chunk->inlined_count + 1, chunk->inlined_capacity)) {
+    int old_capacity        = chunk->inlined_capacity;
+    chunk->inlined_capacity = GROW_CAPACITY(old_capacity);
+    chunk->inlined          = RESIZE_ARRAY(InlinedRange, chunk->inlined, old_capacity, chunk->inlined_capacity);
+  }
+
+  chunk->inlined[chunk->inlined_count++] = (InlinedRange){.start = start, .end = end, .site = site, .name = name};
+}
+
+void chunk_add_try_range(Chunk* chunk, int start, int end, int handler, int depth, bool uses_error) {
+  if (SHOULD_GROW(chunk->try_count + 1, chunk->try_capacity)) {
+    int old_capacity    = chunk->try_capacity;
+    chunk->try_capacity = GROW_CAPACITY(old_capacity);
+    chunk->tries        = RESIZE_ARRAY(TryRange, chunk->tries, old_capacity, chunk->try_capacity);
+  }
+
+  chunk->tries[chunk->try_count++] =
+      (TryRange){.start = start, .end = end, .handler = handler, .depth = depth, .uses_error = uses_error};
+}
@@ -7,62 +7,109 @@
 
 // Functional macro expanding into all of the opcodes of slang. See run() in vm.c for the dispatch table and the synopsis of each
 // opcode.
-#define OPCODES(X)   \
-  X(CONSTANT)        \
-  X(NIL)             \
-  X(TRUE)            \
-  X(FALSE)           \
-  X(POP)             \
-  X(DUPE)            \
-  X(GET_LOCAL)       \
-  X(GET_GLOBAL)      \
-  X(GET_UPVALUE)     \
-  X(DEFINE_GLOBAL)   \
-  X(SET_LOCAL)       \
-  X(SET_GLOBAL)      \
-  X(SET_UPVALUE)     \
-  X(GET_SUBSCRIPT)   \
-  X(SET_SUBSCRIPT)   \
-  X(GET_PROPERTY)    \
-  X(SET_PROPERTY)    \
-  X(GET_BASE_METHOD) \
-  X(GET_SLICE)       \
-  X(EQ)              \
-  X(NEQ)             \
-  X(GT)              \
-  X(LT)              \
-  X(GTEQ)            \
-  X(LTEQ)            \
-  X(ADD)             \
-  X(SUBTRACT)        \
-  X(MULTIPLY)        \
-  X(DIVIDE)          \
-  X(MODULO)          \
-  X(NOT)             \
-  X(NEGATE)          \
-  X(PRINT)           \
-  X(JUMP)            \
-  X(JUMP_IF_FALSE)   \
-  X(TRY)             \
-  X(LOOP)            \
-  X(CALL)            \
-  X(INVOKE)          \
-  X(BASE_INVOKE)     \
-  X(CLOSURE)         \
-  X(CLOSE_UPVALUE)   \
-  X(SEQ_LITERAL)     \
-  X(TUPLE_LITERAL)   \
-  X(OBJECT_LITERAL)  \
-  X(RETURN)          \
-  X(CLASS)           \
-  X(INHERIT)         \
-  X(FINALIZE)        \
-  X(METHOD)          \
-  X(IMPORT)          \
-  X(IMPORT_FROM)     \
-  X(THROW)           \
-  X(IS)              \
-  X(IN)
+#define OPCODES(X)           \
+  X(CONSTANT)                \
+  X(NIL)                     \
+  X(TRUE)                    \
+  X(FALSE)                   \
+  X(POP)                     \
+  X(DUPE)                    \
+  X(GET_LOCAL)               \
+  X(GET_GLOBAL_SLOT)         \
+  X(GET_UPVALUE)             \
+  X(DEFINE_GLOBAL_SLOT)      \
+  X(SET_LOCAL)               \
+  X(SET_GLOBAL_SLOT)         \
+  X(SET_UPVALUE)             \
+  X(GET_SUBSCRIPT)           \
+  X(SET_SUBSCRIPT)           \
+  X(GET_SUBSCRIPT_SAFE)      \
+  X(GET_PROPERTY)            \
+  X(SET_PROPERTY)            \
+  X(GET_PROPERTY_SAFE)       \
+  X(GET_BASE_METHOD)         \
+  X(GET_SLICE)               \
+  X(EQ)                      \
+  X(NEQ)                     \
+  X(GT)                      \
+  X(LT)                      \
+  X(GTEQ)                    \
+  X(LTEQ)                    \
+  X(ADD)                     \
+  X(SUBTRACT)                \
+  X(MULTIPLY)                \
+  X(DIVIDE)                  \
+  X(MODULO)                  \
+  X(NOT)                     \
+  X(NEGATE)                  \
+  X(PRINT)                   \
+  X(JUMP)                    \
+  X(JUMP_IF_FALSE)           \
+  X(JUMP_IF_TRUE)            \
+  X(JUMP_IF_NOT_NIL)         \
+  X(LOOP)                    \
+  X(CALL)                    \
+  X(INVOKE)                  \
+  X(BASE_INVOKE)             \
+  X(CLOSURE)                 \
+  X(CLOSE_UPVALUE)           \
+  X(SEQ_LITERAL)             \
+  X(TUPLE_LITERAL)           \
+  X(OBJECT_LITERAL)          \
+  X(RETURN)                  \
+  X(CLASS)                   \
+  X(INHERIT)                 \
+  X(FINALIZE)                \
+  X(METHOD)                  \
+  X(IMPORT)                  \
+  X(IMPORT_FROM)             \
+  X(THROW)                   \
+  X(IS)                      \
+  X(IN)                      \
+  X(GT_INT_INT)              \
+  X(GT_FLOAT_FLOAT)          \
+  X(LT_INT_INT)              \
+  X(LT_FLOAT_FLOAT)          \
+  X(GTEQ_INT_INT)            \
+  X(GTEQ_FLOAT_FLOAT)        \
+  X(LTEQ_INT_INT)            \
+  X(LTEQ_FLOAT_FLOAT)        \
+  X(ADD_INT_INT)             \
+  X(ADD_FLOAT_FLOAT)         \
+  X(SUBTRACT_INT_INT)        \
+  X(SUBTRACT_FLOAT_FLOAT)    \
+  X(MULTIPLY_INT_INT)        \
+  X(MULTIPLY_FLOAT_FLOAT)    \
+  X(GET_SUBSCRIPT_SEQ_INT)   \
+  X(GET_SUBSCRIPT_IN_BOUNDS) \
+  X(GET_PROPERTY_OBJ)        \
+  X(GET_LOCAL_GET_LOCAL)     \
+  X(INC_LOCAL)               \
+  X(DEC_LOCAL)               \
+  X(ADD_LOCAL_CONST)         \
+  X(RETURN_LOCAL)            \
+  X(RETURN_NIL)              \
+  X(EQ_JUMP_IF_FALSE)        \
+  X(NEQ_JUMP_IF_FALSE)       \
+  X(GT_JUMP_IF_FALSE)        \
+  X(LT_JUMP_IF_FALSE)        \
+  X(GTEQ_JUMP_IF_FALSE)      \
+  X(LTEQ_JUMP_IF_FALSE)      \
+  X(LT_LEN_JUMP_IF_FALSE)    \
+  X(TAIL_CALL)               \
+  X(TAIL_INVOKE)             \
+  X(CALL_INLINED)            \
+  X(INVOKE_INLINED)          \
+  X(RETURN_INLINED)          \
+  X(REUSE)                   \
+  X(SEQ_LOOP_ENTER)          \
+  X(SEQ_LOOP_NEXT)           \
+  X(SEQ_LOOP_STEP)           \
+  X(SEQ_LOOP_END)            \
+  X(FOR_IN_INIT)             \
+  X(FOR_IN_NEXT)             \
+  X(FOR_RANGE_INIT)          \
+  X(FOR_RANGE_NEXT)
 
 typedef enum {
 #define OPCODE_ENUM(name) OP_##name,
@@ -70,6 +117,22 @@ typedef enum {
 #undef OPCODE_ENUM
 } OpCode;
 
+// Higher-order Seq and Tuple methods which the compiler lowers into an inline loop when they are invoked with a function literal.
+// Operand of the OP_SEQ_LOOP_* instructions.
+typedef enum {
+  SEQ_LOOP_EACH,
+  SEQ_LOOP_MAP,
+  SEQ_LOOP_SIFT,
+  SEQ_LOOP_FOLD,
+  SEQ_LOOP_EVERY,
+  SEQ_LOOP_SOME,
+} SeqLoopKind;
+
+// Flags for the values OP_SEQ_LOOP_NEXT pushes as the arguments of the inlined function literal.
+#define SEQ_LOOP_PUSH_ACC 1    // The accumulator (fold)
+#define SEQ_LOOP_PUSH_ITEM 2   // The current item
+#define SEQ_LOOP_PUSH_INDEX 4  // The index of the current item
+
 typedef struct {
   const char* start;         // Pointer to first char of the line on which the error occurred.
   uint16_t error_start_ofs;  // Offset to [start]. Points to first char of the first token that caused the error.
@@ -77,6 +140,49 @@ typedef struct {
   int line;                  // Line number on which the error starts.
 } SourceView;
 
+// Maximum number of receiver types an inline cache can hold. Once full, the call site is considered megamorphic and lookups
+// take the slow path.
+#define INLINE_CACHE_SIZE 4
+
+// Maps a receiver type to the method which was resolved for it.
+typedef struct {
+  ObjClass* klass;
+  Obj* method;
+} InlineCacheEntry;
+
+// Per-call-site cache for method and property lookups. Each OP_INVOKE, OP_GET_PROPERTY and OP_SET_PROPERTY instruction has its
+// own inline cache (referenced by an operand), which remembers the resolved method per receiver type. Entries stay valid, because
+// the methods of a class cannot change after it has been finalized.
+// Additionally, property accesses on objects with a shape remember the slot of the field for the last seen shape (monomorphic).
+typedef struct {
+  int count;
+  InlineCacheEntry entries[INLINE_CACHE_SIZE];
+
+  struct Shape* shape;       // Shape of the receiver the field slot was resolved for.
+  struct Shape* transition;  // Shape of the receiver after setting the field. Same as [shape] if the field already existed.
+  int slot;                  // Slot of the field.
+} InlineCache;
+
+// Range of instructions which were inlined from a function literal or a function, see compile_seq_loop and compile_inlined_call.
+// Stack traces of errors raised within the range get an additional frame, as if the function had been called.
+typedef struct {
+  int start;        // Offset of the first inlined instruction.
+  int end;          // Offset past the last inlined instruction.
+  int site;         // Offset of the instruction which stands in for the call.
+  ObjString* name;  // Name of the inlined function, NULL for function literals. Kept alive by the function, which is a constant.
+} InlinedRange;
+
+// Range of instructions which are protected by a try statement or expression. Errors raised within the range are handled at
+// [handler], after the stack has been cut back to [depth] slots of the frame - where the error value is then placed. Entering a
+// try costs nothing, the range is only looked up when an error is raised, see handle_runtime_error.
+typedef struct {
+  int start;        // Offset of the first protected instruction.
+  int end;          // Offset past the last protected instruction.
+  int handler;      // Offset of the first instruction of the handler.
+  int depth;        // Number of slots of the frame's stack window that are kept when the error is handled.
+  bool uses_error;  // Whether the handler reads the error. If not, the message of a lazy error is never formatted.
+} TryRange;
+
 // Dynamic array of instructions.
 // Provides a cache-friendly, constant-time lookup (and append) dense
 // storage for instructions.
@@ -86,6 +192,15 @@ typedef struct {
   uint16_t* code;
   SourceView* source_views;
   ValueArray constants;
+  int cache_count;
+  int cache_capacity;
+  InlineCache* caches;
+  int inlined_count;
+  int inlined_capacity;
+  InlinedRange* inlined;  // Ordered innermost-first, since nested ranges are completed before the ones they are nested in.
+  int try_count;
+  int try_capacity;
+  TryRange* tries;  // Ordered innermost-first, just like [inlined].
 } Chunk;
 
 // Initialize a chunk.
@@ -102,6 +217,30 @@ void chunk_write(Chunk* chunk, uint16_t data, Token error_start, Token error_end
 // Returns the index of the value in the constant pool.
 int chunk_add_constant(Chunk* chunk, Value value);
 
+// Record that the instructions from [start] up to [end] were inlined at the instruction at [site]. [name] is the name of the
+// inlined function, or NULL for a function literal.
+void chunk_add_inlined_range(Chunk* chunk, int start, int end, int site, ObjString* name);
+
+// Record that errors raised by the instructions from [start] up to [end] are handled at [handler], keeping [depth] slots.
+// [uses_error] tells whether the handler reads the error value.
+void chunk_add_try_range(Chunk* chunk, int start, int end, int handler, int depth, bool uses_error);
+
+// Add a new, empty inline cache to the chunk.
+// Returns the index of the inline cache.
+int chunk_add_inline_cache(Chunk* chunk);
+
+// Returns the number of code units of the instruction at [offset], including its operands. Returns -1 for unknown opcodes.
+int chunk_instruction_length(Chunk* chunk, int offset);
+
+// Returns the index of the operand of a forward branch [op] which holds its offset (from the next instruction), or 0 if [op] is
+// not a forward branch. OP_LOOP is the only backward branch.
+int chunk_jump_operand(OpCode op);
+
+// Returns the most values the stack window of a frame which executes [chunk] ever holds, if it starts out with [depth] values (the
+// callable and the arguments). run() and the machine code of the JIT push without checking the capacity of the stack, which is why
+// call_managed makes room for this many values before it pushes a frame.
+int chunk_max_depth(Chunk* chunk, int depth);
+
 SourceView chunk_make_source_view(Token error_start, Token error_end);
 
 // Report an error at the given source location. Squiggles the line where the error occurred.
@@ -33,6 +33,7 @@
 //
 
 // #define SLANG_ENABLE_COLOR_OUTPUT  // Enable ANSI-colors in terminal. Defined as default for release builds - see Makefile
+// #define SLANG_NAN_BOXING           // Represent values as NaN-boxed 64-bit words. Ints beyond 50 bits are boxed. See value.h
 
 //
 // Constants
@@ -135,6 +136,9 @@ typedef enum {
 // Get the smaller of two numbers
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
+// Get the larger of two numbers
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
 // Suppress unused parameter macro
 #define UNUSED(x) (void)(x)
 
@@ -5,8 +5,10 @@
 #include "ast.h"
 #include "common.h"
 #include "debug.h"
+#include "ir.h"
 #include "memory.h"
 #include "object.h"
+#include "peephole.h"
 #include "scope.h"
 #include "vm.h"
 
@@ -17,6 +19,9 @@ AstFn* compiler_root         = NULL;
 void compile_children(FnCompiler* compiler, AstNode* node);
 static void compile_node(FnCompiler* compiler, AstNode* node);
 static void emit_return(FnCompiler* compiler, AstNode* source);
+static void compile_expr_call(FnCompiler* compiler, AstExpression* expr, bool tail);
+static void compile_expr_invoke(FnCompiler* compiler, AstExpression* expr, bool tail);
+static void compile_returned(FnCompiler* compiler, AstNode* expr);
 
 static void compiler_init(FnCompiler* compiler, FnCompiler* enclosing, AstFn* function, ObjObject* globals_context) {
   compiler->enclosing = enclosing;
@@ -36,6 +41,10 @@ static void compiler_init(FnCompiler* compiler, FnCompiler* enclosing, AstFn* fu
 
   compiler->innermost_loop_scope = NULL;
   compiler->innermost_loop_start = -1;
+  compiler->bounded_loop         = (BoundedLoop){.index = NULL, .seq = NULL, .body_start = -1, .loop_start = -1};
+
+  compiler->try_depth    = 0;
+  compiler->inline_frame = 0;
 
   compiler->had_error = false;
 }
@@ -43,6 +52,11 @@ static void compiler_init(FnCompiler* compiler, FnCompiler* enclosing, AstFn* fu
 static ObjFunction* end_compiler(FnCompiler* compiler) {
   emit_return(compiler, (AstNode*)compiler->function);
   ObjFunction* function = compiler->result;
+  if (!compiler->had_error) {
+    ir_optimize(function);
+    peephole_optimize(&function->chunk);
+    function->max_depth = chunk_max_depth(&function->chunk, function->arity + 1);
+  }
 #ifdef DEBUG_PRINT_BYTECODE
   debug_disassemble_chunk(&function->chunk, function->name->chars);
 #endif
@@ -95,6 +109,18 @@ static uint16_t id_constant(FnCompiler* compiler, ObjString* id, AstNode* source
   return make_constant(compiler, str_value(id), source);
 }
 
+// Resolves the global [id] to its slot in the module the current function is compiled for. Adds a slot for it, if the module does
+// not have one yet.
+static uint16_t global_slot(FnCompiler* compiler, AstId* id) {
+  int slot = module_global_slot(compiler->result->globals_context, id->name);
+  if (slot > MAX_GLOBALS) {
+    compiler_error(compiler, (AstNode*)id, "Too many globals in one module. Max is " STR(MAX_GLOBALS));
+    return 0;
+  }
+
+  return (uint16_t)slot;
+}
+
 // Adds the synthetic name to the constant pool and returns its index.
 static uint16_t synthetic_constant(FnCompiler* compiler, const char* name, AstNode* source) {
   return make_constant(compiler, str_value(copy_string(name, strlen(name))), source);
@@ -117,13 +143,24 @@ static void emit_three(FnCompiler* compiler, uint16_t data1, uint16_t data2, uin
   emit_one(compiler, data3, source);
 }
 
+// Adds a new inline cache to the current chunk and emits its index as an operand.
+static void emit_inline_cache(FnCompiler* compiler, AstNode* source) {
+  int cache = chunk_add_inline_cache(&compiler->result->chunk);
+  if (cache > MAX_INLINE_CACHES) {
+    compiler_error(compiler, source, "Too many call sites in one chunk. Max is " STR(MAX_INLINE_CACHES));
+    return;
+  }
+
+  emit_one(compiler, (uint16_t)cache, source);
+}
+
 static void emit_return(FnCompiler* compiler, AstNode* source) {
   if (compiler->function->type == FN_TYPE_CONSTRUCTOR) {
-    emit_two(compiler, OP_GET_LOCAL, 0, source);  // Return class instance, e.g. 'this'.
-  } else {
-    emit_one(compiler, OP_NIL, source);
+    emit_two(compiler, OP_RETURN_LOCAL, 0, source);  // Return class instance, e.g. 'this'.
+    return;
   }
 
+  emit_one(compiler, OP_NIL, source);
   emit_one(compiler, OP_RETURN, source);
 }
 
@@ -174,18 +211,24 @@ static void emit_loop(FnCompiler* compiler, int loop_start, AstNode* source) {
   emit_one(compiler, (uint16_t)offset, source);
 }
 
+// Returns the index of the local or upvalue [id] refers to. Locals of a function which is being inlined are relative to the slot
+// its frame starts at.
+static uint16_t id_index(FnCompiler* compiler, AstId* id) {
+  return (uint16_t)(id->ref->is_upvalue ? id->ref->index : id->ref->index + compiler->inline_frame);
+}
+
 // Emits bytecode to assign the value at the top of the stack to the given [id].
 static void emit_assign_id(FnCompiler* compiler, AstId* id) {
   switch (id->ref->symbol->type) {
     case SYMBOL_LOCAL: {
       OpCode op = id->ref->is_upvalue ? OP_SET_UPVALUE : OP_SET_LOCAL;
-      emit_two(compiler, op, id->ref->index, (AstNode*)id);
+      emit_two(compiler, op, id_index(compiler, id), (AstNode*)id);
       break;
     }
     case SYMBOL_NATIVE: INTERNAL_ASSERT(false, "Fix resolver. Assigning to natives is forbidden."); break;
     case SYMBOL_GLOBAL: {
       uint16_t global_constant = id_constant(compiler, id->name, (AstNode*)id);
-      emit_two(compiler, OP_SET_GLOBAL, global_constant, (AstNode*)id);
+      emit_three(compiler, OP_SET_GLOBAL_SLOT, global_slot(compiler, id), global_constant, (AstNode*)id);
       break;
     }
     default: INTERNAL_ERROR("Unknown symbol type: %d", id->ref->symbol->type);
@@ -203,7 +246,7 @@ static void emit_define_id_explicit(FnCompiler* compiler, AstId* id, uint16_t gl
     case SYMBOL_LOCAL: break;  // Locals are already defined.
     case SYMBOL_NATIVE: INTERNAL_ASSERT(false, "Fix resolver. Cannot define natives."); break;
     case SYMBOL_GLOBAL: {
-      emit_two(compiler, OP_DEFINE_GLOBAL, global_constant, (AstNode*)id);
+      emit_three(compiler, OP_DEFINE_GLOBAL_SLOT, global_slot(compiler, id), global_constant, (AstNode*)id);
       break;
     }
     default: INTERNAL_ERROR("Unknown symbol type: %d", sym->type);
@@ -225,19 +268,202 @@ static void emit_load_id(FnCompiler* compiler, AstId* id) {
   switch (id->ref->symbol->type) {
     case SYMBOL_LOCAL: {
       OpCode op = id->ref->is_upvalue ? OP_GET_UPVALUE : OP_GET_LOCAL;
-      emit_two(compiler, op, id->ref->index, (AstNode*)id);
+      emit_two(compiler, op, id_index(compiler, id), (AstNode*)id);
+      break;
+    }
+    case SYMBOL_NATIVE: {
+      // Natives can't be reassigned and are all known at this point - so they're just constants.
+      Value native = nil_value();
+      if (!hashtable_get_by_string(&vm.natives, id->name, &native)) {
+        INTERNAL_ERROR("Native '%s' does not exist.", id->name->chars);
+      }
+      emit_constant(compiler, native, (AstNode*)id);
       break;
     }
-    case SYMBOL_NATIVE:
     case SYMBOL_GLOBAL: {
-      uint16_t global = id_constant(compiler, id->name, (AstNode*)id);
-      emit_two(compiler, OP_GET_GLOBAL, global, (AstNode*)id);
+      uint16_t global_constant = id_constant(compiler, id->name, (AstNode*)id);
+      emit_three(compiler, OP_GET_GLOBAL_SLOT, global_slot(compiler, id), global_constant, (AstNode*)id);
       break;
     }
     default: INTERNAL_ERROR("Unknown symbol type: %d", id->ref->symbol->type);
   }
 }
 
+// Returns the slot of the local variable [node] refers to, or -1 if [node] is not a plain variable expression referring to a
+// local of the current function. Used to emit superinstructions which operate directly on a frames' slots.
+static int local_slot(FnCompiler* compiler, AstNode* node) {
+  if (node->type != NODE_EXPR || ((AstExpression*)node)->type != EXPR_VARIABLE) {
+    return -1;
+  }
+
+  AstId* id = (AstId*)node->children[0];
+  if (id->ref->symbol->type != SYMBOL_LOCAL || id->ref->is_upvalue) {
+    return -1;
+  }
+  return id_index(compiler, id);
+}
+
+// Returns true if [node] is a higher-order Seq method call which the resolver lowered into a loop, see compile_seq_loop.
+static bool is_seq_loop(AstNode* node) {
+  return node != NULL && node->type == NODE_EXPR && ((AstExpression*)node)->type == EXPR_INVOKE && node->scope != NULL &&
+         ((AstExpression*)node)->inlined == NULL;
+}
+
+// Checks whether [node] is a try statement or expression. They discard their locals themselves, since the error only exists in
+// the catch branch.
+static bool is_try(AstNode* node) {
+  return (node->type == NODE_STMT && ((AstStatement*)node)->type == STMT_TRY) ||
+         (node->type == NODE_EXPR && ((AstExpression*)node)->type == EXPR_TRY);
+}
+
+// Returns true if [node] is a call or invocation which the resolver decided to inline, see compile_inlined_call.
+static bool is_inlined_call(AstNode* node) {
+  return node->type == NODE_EXPR && ((AstExpression*)node)->inlined != NULL;
+}
+
+// Checks whether [node] contains an expression with locals of its own - a try expression or an inlined call - which is evaluated
+// in the current function.
+static bool contains_scoped_expr(AstNode* node) {
+  if (node == NULL || node->type == NODE_FN) {
+    return false;
+  }
+  if (node->type == NODE_EXPR && node->scope != NULL) {
+    return true;
+  }
+  for (int i = 0; i < node->count; i++) {
+    if (contains_scoped_expr(node->children[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Emits the operands of a binary expression [expr]. Two local variable operands are loaded using a single superinstruction.
+static void emit_binary_operands(FnCompiler* compiler, AstExpression* expr) {
+  AstNode* left  = expr->base.children[0];
+  AstNode* right = expr->base.children[1];
+
+  int left_slot  = local_slot(compiler, left);
+  int right_slot = local_slot(compiler, right);
+  if (left_slot != -1 && right_slot != -1) {
+    emit_three(compiler, OP_GET_LOCAL_GET_LOCAL, (uint16_t)left_slot, (uint16_t)right_slot, (AstNode*)expr);
+    return;
+  }
+
+  compile_node(compiler, left);
+  compile_node(compiler, right);
+}
+
+// Returns the id [node] refers to, or NULL if [node] is not a plain variable expression.
+static AstId* variable_id(AstNode* node) {
+  if (node == NULL || node->type != NODE_EXPR || ((AstExpression*)node)->type != EXPR_VARIABLE ||
+      ((AstExpression*)node)->reuse != -1) {
+    return NULL;
+  }
+  return (AstId*)node->children[0];
+}
+
+// Returns true if [node] is an int literal, and stores its value in [value].
+static bool int_literal(AstNode* node, SLANG_TYPE_INT* value) {
+  if (node == NULL || node->type != NODE_EXPR || ((AstExpression*)node)->type != EXPR_LITERAL) {
+    return false;
+  }
+  AstLiteral* lit = (AstLiteral*)node->children[0];
+  if (lit->type != LIT_NUMBER || !is_int(lit->value)) {
+    return false;
+  }
+  *value = AS_INT(lit->value);
+  return true;
+}
+
+// Returns true if [node] gets the `len` property of something, e.g. `list.len`. The receiver is children[0].
+static bool is_len_property(AstNode* node) {
+  AstExpression* expr = (AstExpression*)node;
+  if (node->type != NODE_EXPR || expr->type != EXPR_DOT || expr->operator_.type == TOKEN_SAFE_DOT || expr->reuse != -1 ||
+      ((AstExpression*)node->children[0])->type == EXPR_BASE) {
+    return false;
+  }
+  return ((AstId*)node->children[1])->name == vm.special_prop_names[SPECIAL_PROP_LEN];
+}
+
+// Compiles a [condition] and emits a jump which is taken if the condition is falsy. Returns the offset of the jump instruction.
+// Comparisons are fused into a single compare-and-branch instruction, which consumes the condition. Otherwise, the condition is
+// left on the stack and must be popped on both paths - [fused] is set accordingly. A less-than with a length, like the
+// `i < list.len` of most loops, also gets the length in the same instruction.
+static int emit_condition_jump(FnCompiler* compiler, AstNode* condition, bool* fused) {
+  *fused = false;
+  if (condition->type == NODE_EXPR && ((AstExpression*)condition)->type == EXPR_BINARY) {
+    AstExpression* expr = (AstExpression*)condition;
+    OpCode op;
+    switch (expr->operator_.type) {
+      case TOKEN_NEQ: op = OP_NEQ_JUMP_IF_FALSE; break;
+      case TOKEN_EQ: op = OP_EQ_JUMP_IF_FALSE; break;
+      case TOKEN_GT: op = OP_GT_JUMP_IF_FALSE; break;
+      case TOKEN_GTEQ: op = OP_GTEQ_JUMP_IF_FALSE; break;
+      case TOKEN_LT: op = OP_LT_JUMP_IF_FALSE; break;
+      case TOKEN_LTEQ: op = OP_LTEQ_JUMP_IF_FALSE; break;
+      default: op = OP_JUMP_IF_FALSE; break;
+    }
+
+    if (op == OP_LT_JUMP_IF_FALSE && is_len_property(expr->base.children[1])) {
+      *fused = true;
+      compile_node(compiler, expr->base.children[0]);
+      compile_node(compiler, expr->base.children[1]->children[0]);  // The receiver of the length.
+      return emit_jump(compiler, OP_LT_LEN_JUMP_IF_FALSE, condition);
+    }
+
+    if (op != OP_JUMP_IF_FALSE) {
+      *fused = true;
+      emit_binary_operands(compiler, expr);
+      return emit_jump(compiler, op, condition);
+    }
+  }
+
+  compile_node(compiler, condition);
+  return emit_jump(compiler, OP_JUMP_IF_FALSE, condition);
+}
+
+// Compiles an expression [node] whose result is not used. Increments, decrements and additions of a number literal on a local
+// variable are compiled into a single superinstruction which updates the local in place, without touching the stack.
+static void compile_discarded(FnCompiler* compiler, AstNode* node) {
+  AstExpression* expr = (AstExpression*)node;
+  if (node->type == NODE_EXPR) {
+    switch (expr->type) {
+      case EXPR_UNARY:
+      case EXPR_POSTFIX: {
+        int slot = local_slot(compiler, expr->base.children[0]);
+        if (slot == -1) {
+          break;
+        }
+        if (expr->operator_.type == TOKEN_PLUS_PLUS) {
+          emit_two(compiler, OP_INC_LOCAL, (uint16_t)slot, node);
+          return;
+        }
+        if (expr->operator_.type == TOKEN_MINUS_MINUS) {
+          emit_two(compiler, OP_DEC_LOCAL, (uint16_t)slot, node);
+          return;
+        }
+        break;
+      }
+      case EXPR_ASSIGN: {
+        AstNode* value = expr->base.children[1];
+        int slot       = local_slot(compiler, expr->base.children[0]);
+        if (slot == -1 || expr->operator_.type != TOKEN_PLUS_ASSIGN || value->type != NODE_EXPR ||
+            ((AstExpression*)value)->type != EXPR_LITERAL || ((AstLiteral*)value->children[0])->type != LIT_NUMBER) {
+          break;
+        }
+        uint16_t constant = make_constant(compiler, ((AstLiteral*)value->children[0])->value, value);
+        emit_three(compiler, OP_ADD_LOCAL_CONST, (uint16_t)slot, constant, node);
+        return;
+      }
+      default: break;
+    }
+  }
+
+  compile_node(compiler, node);
+  emit_one(compiler, OP_POP, node);  // Discard the result.
+}
+
 // Emits preliminary bytecode for any supported assignment target in a compound assignment case (++,--,%= etc.). These assignments
 // require the target to be loaded onto the stack before the value to be assigned is computed. Used in combination with
 // emit_assignment. Returns the name index if the target is a property access, 0 otherwise.
@@ -253,6 +479,7 @@ static uint16_t emit_compound_assignment_prelude(FnCompiler* compiler, AstExpres
     compile_node(compiler, receiver);                               // [target]
     emit_two(compiler, OP_DUPE, 0, (AstNode*)target);               // Duplicate the receiver: [target][target]
     emit_two(compiler, OP_GET_PROPERTY, name, (AstNode*)property);  // [target][value]
+    emit_inline_cache(compiler, (AstNode*)property);
     return name;
   } else if (target->type == EXPR_SUBS) {
     AstNode* receiver = target->base.children[0];
@@ -280,6 +507,7 @@ static void emit_compound_assignment(FnCompiler* compiler, AstExpression* target
     // Expects Stack: [target][value]
     AstId* property = (AstId*)target->base.children[1];
     emit_two(compiler, OP_SET_PROPERTY, name, (AstNode*)property);
+    emit_inline_cache(compiler, (AstNode*)property);
   } else if (target->type == EXPR_SUBS) {
     // Expects Stack: [target][idx][value]
     emit_one(compiler, OP_SET_SUBSCRIPT, (AstNode*)target);
@@ -323,6 +551,7 @@ static void emit_assignment(FnCompiler* compiler, AstExpression* target, uint16_
     // Expects Stack: [target][value]
     AstId* property = (AstId*)target->base.children[1];
     emit_two(compiler, OP_SET_PROPERTY, name, (AstNode*)property);
+    emit_inline_cache(compiler, (AstNode*)property);
   } else if (target->type == EXPR_SUBS) {
     // Expects Stack: [target][idx][value]
     emit_one(compiler, OP_SET_SUBSCRIPT, (AstNode*)target);
@@ -375,7 +604,7 @@ static void emit_define_pattern(FnCompiler* compiler, AstPattern* pattern) {
 
 // Emits preliminary bytecode for defining a pattern. Used in combination with emit_define_pattern.
 static void emit_define_pattern_prelude(FnCompiler* compiler, AstPattern* pattern) {
-  // Emit placeholder values when in local scope. Not needed for globals, as they are declared with OP_DEFINE_GLOBAL.
+  // Emit placeholder values when in local scope. Not needed for globals, as they are declared with OP_DEFINE_GLOBAL_SLOT.
   // We only get here when the pattern is preceded by a 'let' or 'const' keyword, so we can safely assume all of the bindings are
   // locals.
   for (int i = 0; i < pattern->base.count; i++) {
@@ -411,6 +640,20 @@ static void discard_locals(FnCompiler* compiler, Scope* scope, AstNode* source)
   }
 }
 
+// Returns the lowest slot of the locals in [scope], e.g. the slot the scope's locals start at.
+static uint16_t first_local_slot(Scope* scope) {
+  int count = scope->local_count;
+  SymbolEntry locals[count];
+  scope_get_locals(scope, locals);
+  uint16_t slot = UINT16_MAX;
+  for (int i = 0; i < count; i++) {
+    if (locals[i].value->function_index < slot) {
+      slot = (uint16_t)locals[i].value->function_index;
+    }
+  }
+  return slot;
+}
+
 // Compiles a function.
 static ObjFunction* compile_function(FnCompiler* compiler, AstFn* fn) {
   FnCompiler subcompiler;
@@ -430,14 +673,16 @@ static ObjFunction* compile_function(FnCompiler* compiler, AstFn* fn) {
   }
 
   // Body / expression
-  compile_node(&subcompiler, body);
   if (fn->is_lambda) {
     INTERNAL_ASSERT(body->type == NODE_EXPR, "Lambda body should be an expression.");
-    emit_one(&subcompiler, OP_RETURN, (AstNode*)fn);  // Implicit return for lambdas.
+    compile_returned(&subcompiler, body);  // Implicit return for lambdas.
+  } else {
+    compile_node(&subcompiler, body);
   }
 
   // Done. Now emit the produced function and its upvalues in the parent compiler.
   ObjFunction* function = end_compiler(&subcompiler);
+  fn->compiled          = function;
   emit_two(compiler, OP_CLOSURE, make_constant(compiler, fn_value((Obj*)function), (AstNode*)fn), (AstNode*)fn);
   for (int i = 0; i < function->upvalue_count; i++) {
     emit_one(compiler, fn->upvalues[i].is_local ? 1 : 0, (AstNode*)fn);
@@ -506,8 +751,15 @@ static void compile_declare_variable(FnCompiler* compiler, AstDeclaration* decl)
   AstNode* id_or_pattern = decl->base.children[0];
   AstNode* initializer   = decl->base.children[1];
 
+  // The locals of a lowered Seq method call, a try expression or an inlined call are placed above the slot of the variable, so it
+  // needs a placeholder.
+  bool placeholder = id_or_pattern->type == NODE_ID && (is_seq_loop(initializer) || contains_scoped_expr(initializer)) &&
+                     ((AstId*)id_or_pattern)->ref->symbol->type == SYMBOL_LOCAL;
+
   if (id_or_pattern->type == NODE_PATTERN) {
     emit_define_pattern_prelude(compiler, (AstPattern*)id_or_pattern);
+  } else if (placeholder) {
+    emit_one(compiler, OP_NIL, id_or_pattern);
   }
 
   if (initializer != NULL) {
@@ -518,6 +770,9 @@ static void compile_declare_variable(FnCompiler* compiler, AstDeclaration* decl)
 
   if (id_or_pattern->type == NODE_PATTERN) {
     emit_define_pattern(compiler, (AstPattern*)id_or_pattern);
+  } else if (placeholder) {
+    emit_assign_id(compiler, (AstId*)id_or_pattern);
+    emit_one(compiler, OP_POP, (AstNode*)decl);
   } else if (id_or_pattern->type == NODE_ID) {
     emit_define_id(compiler, (AstId*)id_or_pattern);
   } else {
@@ -565,15 +820,19 @@ static void compile_statement_if(FnCompiler* compiler, AstStatement* stmt) {
   AstNode* then_branch = stmt->base.children[1];
   AstNode* else_branch = stmt->base.children[2];
 
-  compile_node(compiler, condition);
-  int then_jump = emit_jump(compiler, OP_JUMP_IF_FALSE, (AstNode*)stmt);
-  emit_one(compiler, OP_POP, condition);  // Discard the condition value.
+  bool fused;
+  int then_jump = emit_condition_jump(compiler, condition, &fused);
+  if (!fused) {
+    emit_one(compiler, OP_POP, condition);  // Discard the condition value.
+  }
 
   compile_node(compiler, then_branch);
   int else_jump = emit_jump(compiler, OP_JUMP, (AstNode*)stmt);
 
   patch_jump(compiler, then_jump);
-  emit_one(compiler, OP_POP, (AstNode*)stmt);
+  if (!fused) {
+    emit_one(compiler, OP_POP, (AstNode*)stmt);
+  }
 
   if (else_branch != NULL) {
     compile_node(compiler, else_branch);
@@ -595,14 +854,18 @@ static void compile_statement_while(FnCompiler* compiler, AstStatement* stmt) {
   // Save the loop state for continue(skip)/break statements, which might occur in the loop body.
   NEW_LOOP();
 
-  compile_node(compiler, condition);
-  int exit_jump = emit_jump(compiler, OP_JUMP_IF_FALSE, condition);  // Jump out of the loop if the condition is false.
-  emit_one(compiler, OP_POP, condition);                             // Discard the result of the condition expression.
+  bool fused;
+  int exit_jump = emit_condition_jump(compiler, condition, &fused);  // Jump out of the loop if the condition is false.
+  if (!fused) {
+    emit_one(compiler, OP_POP, condition);  // Discard the result of the condition expression.
+  }
 
   compile_node(compiler, body);
   emit_loop(compiler, compiler->innermost_loop_start, (AstNode*)stmt);
   patch_jump(compiler, exit_jump);
-  emit_one(compiler, OP_POP, condition);
+  if (!fused) {
+    emit_one(compiler, OP_POP, condition);
+  }
 
   patch_breaks(compiler, compiler->innermost_loop_start);
 
@@ -610,6 +873,154 @@ static void compile_statement_while(FnCompiler* compiler, AstStatement* stmt) {
   END_LOOP();
 }
 
+// Determines whether the `for` loop [stmt] is a canonical loop over a seq, like `for let i = 0; i < list.len; i++; { ... }`: The
+// loop variable is a local which starts at a non-negative int, only grows and is compared with the length of a variable each
+// time before the body runs. Stores the loop variable in [index] and the variable in the condition in [seq].
+static bool is_bounded_loop(AstStatement* stmt, AstId** index, AstId** seq) {
+  AstNode* initializer = stmt->base.children[0];
+  AstNode* condition   = stmt->base.children[1];
+  AstNode* increment   = stmt->base.children[2];
+  SLANG_TYPE_INT value;
+
+  if (initializer == NULL || initializer->type != NODE_DECL || ((AstDeclaration*)initializer)->type != DECL_VARIABLE ||
+      initializer->children[0]->type != NODE_ID || !int_literal(initializer->children[1], &value) || value < 0) {
+    return false;
+  }
+  Symbol* symbol = ((AstId*)initializer->children[0])->ref->symbol;
+  if (symbol->type != SYMBOL_LOCAL || symbol->is_captured) {
+    return false;
+  }
+
+  // The condition: `i < seq.len`
+  if (condition == NULL || condition->type != NODE_EXPR || ((AstExpression*)condition)->type != EXPR_BINARY ||
+      ((AstExpression*)condition)->operator_.type != TOKEN_LT || !is_len_property(condition->children[1])) {
+    return false;
+  }
+  *index = variable_id(condition->children[0]);
+  *seq   = variable_id(condition->children[1]->children[0]);
+  if (*index == NULL || *seq == NULL || (*index)->ref->symbol != symbol || (*index)->ref->is_upvalue ||
+      (*seq)->ref->symbol == symbol) {
+    return false;
+  }
+
+  // The increment: `i++`, `++i` or `i += n` with a positive int n. Since i < len when it's incremented, n must not exceed
+  // INT32_MAX, so that i can't overflow - the length of a seq is an int.
+  if (increment == NULL || increment->type != NODE_EXPR) {
+    return false;
+  }
+  AstExpression* expr = (AstExpression*)increment;
+  AstId* target       = variable_id(increment->children[0]);
+  if (target == NULL || target->ref->symbol != symbol) {
+    return false;
+  }
+  switch (expr->type) {
+    case EXPR_POSTFIX:
+    case EXPR_UNARY: return expr->operator_.type == TOKEN_PLUS_PLUS;
+    case EXPR_ASSIGN:
+      return expr->operator_.type == TOKEN_PLUS_ASSIGN && int_literal(increment->children[1], &value) && value > 0 &&
+             value <= INT32_MAX;
+    default: return false;
+  }
+}
+
+// Determines whether the instruction at [offset] assigns the variable [id].
+static bool assigns_variable(FnCompiler* compiler, int offset, AstId* id) {
+  uint16_t* code = compiler->result->chunk.code + offset;
+  SymbolRef* ref = id->ref;
+  switch ((OpCode)code[0]) {
+    case OP_SET_LOCAL:
+    case OP_INC_LOCAL:
+    case OP_DEC_LOCAL:
+    case OP_ADD_LOCAL_CONST:
+      return ref->symbol->type == SYMBOL_LOCAL && !ref->is_upvalue && code[1] == id_index(compiler, id);
+    case OP_SET_UPVALUE: return ref->symbol->type == SYMBOL_LOCAL && ref->is_upvalue && code[1] == id_index(compiler, id);
+    case OP_SET_GLOBAL_SLOT: return ref->symbol->type == SYMBOL_GLOBAL && code[1] == global_slot(compiler, id);
+    default: return false;
+  }
+}
+
+// Determines whether the instruction at [offset] in the body of the canonical loop [compiler->bounded_loop] leaves the seq, its
+// length and the loop variable alone. That's the case if it can't run user code (no calls, no arithmetic or comparisons, which
+// might end up in an overload), does not jump back and does not assign either variable.
+static bool keeps_bounds(FnCompiler* compiler, int offset) {
+  BoundedLoop* loop = &compiler->bounded_loop;
+  switch ((OpCode)compiler->result->chunk.code[offset]) {
+    case OP_CONSTANT:
+    case OP_NIL:
+    case OP_TRUE:
+    case OP_FALSE:
+    case OP_POP:
+    case OP_DUPE:
+    case OP_GET_LOCAL:
+    case OP_GET_LOCAL_GET_LOCAL:
+    case OP_GET_GLOBAL_SLOT:
+    case OP_GET_UPVALUE:
+    case OP_GET_PROPERTY:
+    case OP_GET_PROPERTY_SAFE:
+    case OP_GET_SUBSCRIPT:
+    case OP_GET_SUBSCRIPT_SAFE:
+    case OP_GET_SUBSCRIPT_IN_BOUNDS:
+    case OP_GET_SUBSCRIPT_SEQ_INT:
+    case OP_SET_PROPERTY:
+    case OP_SET_SUBSCRIPT:  // Can't change the length of a seq.
+    case OP_EQ:
+    case OP_NEQ:
+    case OP_NOT:
+    case OP_JUMP:
+    case OP_JUMP_IF_FALSE:
+    case OP_JUMP_IF_TRUE:
+    case OP_JUMP_IF_NOT_NIL:
+    case OP_EQ_JUMP_IF_FALSE:
+    case OP_NEQ_JUMP_IF_FALSE: return true;
+    case OP_SET_LOCAL:
+    case OP_SET_UPVALUE:
+    case OP_SET_GLOBAL_SLOT:
+      return !assigns_variable(compiler, offset, loop->index) && !assigns_variable(compiler, offset, loop->seq);
+    default: return false;
+  }
+}
+
+// Determines whether the subscript [target][[index]] which is being compiled is known to be within bounds: [target] and [index]
+// are the seq and the loop variable of the canonical loop whose body is being compiled, and nothing in the body up to here can
+// have changed either of them or the length of the seq since the condition was checked.
+static bool is_in_bounds(FnCompiler* compiler, AstNode* target, AstNode* index) {
+  BoundedLoop* loop = &compiler->bounded_loop;
+  AstId* target_id  = variable_id(target);
+  AstId* index_id   = variable_id(index);
+  if (loop->index == NULL || loop->loop_start != compiler->innermost_loop_start || target_id == NULL || index_id == NULL ||
+      target_id->ref->symbol != loop->seq->ref->symbol || index_id->ref->symbol != loop->index->ref->symbol) {
+    return false;
+  }
+
+  Chunk* chunk = &compiler->result->chunk;
+  for (int offset = loop->body_start; offset < chunk->count; offset += chunk_instruction_length(chunk, offset)) {
+    if (!keeps_bounds(compiler, offset)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Reverts the OP_GET_SUBSCRIPT_IN_BOUNDS in the body of the canonical loop [compiler->bounded_loop] to OP_GET_SUBSCRIPT if the
+// body assigns the loop variable somewhere - it might be negative in the next iteration.
+static void check_bounded_loop_body(FnCompiler* compiler) {
+  BoundedLoop* loop = &compiler->bounded_loop;
+  Chunk* chunk      = &compiler->result->chunk;
+  bool assigned     = false;
+  for (int offset = loop->body_start; offset < chunk->count && !assigned; offset += chunk_instruction_length(chunk, offset)) {
+    assigned = assigns_variable(compiler, offset, loop->index);
+  }
+  if (!assigned) {
+    return;
+  }
+
+  for (int offset = loop->body_start; offset < chunk->count; offset += chunk_instruction_length(chunk, offset)) {
+    if (chunk->code[offset] == OP_GET_SUBSCRIPT_IN_BOUNDS) {
+      chunk->code[offset] = OP_GET_SUBSCRIPT;
+    }
+  }
+}
+
 static void compile_statement_for(FnCompiler* compiler, AstStatement* stmt) {
   AstNode* initializer = stmt->base.children[0];
   AstNode* condition   = stmt->base.children[1];
@@ -626,32 +1037,95 @@ static void compile_statement_for(FnCompiler* compiler, AstStatement* stmt) {
 
   // Loop condition
   int exit_jump = -1;
+  bool fused    = false;
   if (condition != NULL) {
-    compile_node(compiler, condition);
-    exit_jump = emit_jump(compiler, OP_JUMP_IF_FALSE, condition);  // Jump out of the loop if the condition is false.
-    emit_one(compiler, OP_POP, condition);                         // Discard the result of the condition expression.
+    exit_jump = emit_condition_jump(compiler, condition, &fused);  // Jump out of the loop if the condition is false.
+    if (!fused) {
+      emit_one(compiler, OP_POP, condition);  // Discard the result of the condition expression.
+    }
   }
 
   // Loop increment
   if (increment != NULL) {
     int body_jump       = emit_jump(compiler, OP_JUMP, increment);
     int increment_start = compiler->result->chunk.count;
-    compile_node(compiler, increment);
-    emit_one(compiler, OP_POP, increment);  // Discard the result of the increment expression.
+    compile_discarded(compiler, increment);
     emit_loop(compiler, compiler->innermost_loop_start, (AstNode*)stmt);
     compiler->innermost_loop_start = increment_start;
     patch_jump(compiler, body_jump);
   }
 
-  // Loop body
+  // Loop body. Subscripts of the seq in a canonical loop might not need a bounds check, see is_in_bounds.
+  BoundedLoop surrounding_bounded_loop = compiler->bounded_loop;
+  AstId* index                         = NULL;
+  AstId* seq                           = NULL;
+  bool is_bounded                      = is_bounded_loop(stmt, &index, &seq);
+  if (is_bounded) {
+    compiler->bounded_loop = (BoundedLoop){
+        .index      = index,
+        .seq        = seq,
+        .body_start = compiler->result->chunk.count,
+        .loop_start = compiler->innermost_loop_start,
+    };
+  }
   compile_node(compiler, body);
+  if (is_bounded) {
+    check_bounded_loop_body(compiler);
+  }
+  compiler->bounded_loop = surrounding_bounded_loop;
   emit_loop(compiler, compiler->innermost_loop_start, (AstNode*)stmt);
 
   if (exit_jump != -1) {
     patch_jump(compiler, exit_jump);
-    emit_one(compiler, OP_POP, condition);  // Discard the result of the condition expression.
+    if (!fused) {
+      emit_one(compiler, OP_POP, condition);  // Discard the result of the condition expression.
+    }
+  }
+
+  patch_breaks(compiler, compiler->innermost_loop_start);
+
+  // Restore the surrounding loop state.
+  END_LOOP();
+}
+
+static void compile_statement_for_in(FnCompiler* compiler, AstStatement* stmt) {
+  AstDeclaration* vars = (AstDeclaration*)stmt->base.children[0];
+  AstNode* iterable    = stmt->base.children[1];
+  AstNode* range_end   = stmt->base.children[2];
+  AstNode* body        = stmt->base.children[3];
+
+  // The state of the loop lives in the hidden locals of the statement's scope: [iterable][index] or, for a range, [next][end].
+  uint16_t slot = first_local_slot(stmt->base.scope);
+
+  compile_node(compiler, iterable);
+  if (range_end != NULL) {
+    compile_node(compiler, range_end);
+    emit_one(compiler, OP_FOR_RANGE_INIT, iterable);
+  } else {
+    emit_one(compiler, OP_FOR_IN_INIT, iterable);
+  }
+
+  // Save the loop state for continue(skip)/break statements, which might occur in the loop body. Both re-enter the loop at the
+  // instruction which advances it.
+  NEW_LOOP();
+
+  if (range_end != NULL) {
+    emit_two(compiler, OP_FOR_RANGE_NEXT, slot, (AstNode*)stmt);
+  } else {
+    emit_three(compiler, OP_FOR_IN_NEXT, slot, (uint16_t)vars->base.count, (AstNode*)stmt);
+  }
+  emit_one(compiler, UINT16_MAX, (AstNode*)stmt);
+  int exit_jump = compiler->result->chunk.count - 1;  // Patched like any other jump.
+
+  // The loop variables are on the stack now. They are discarded with each iteration, which closes them if they are captured.
+  for (int i = 0; i < vars->base.count; i++) {
+    emit_define_id(compiler, (AstId*)vars->base.children[i]);
   }
+  compile_node(compiler, body);
+  discard_locals(compiler, vars->base.scope, (AstNode*)stmt);
+  emit_loop(compiler, compiler->innermost_loop_start, (AstNode*)stmt);
 
+  patch_jump(compiler, exit_jump);
   patch_breaks(compiler, compiler->innermost_loop_start);
 
   // Restore the surrounding loop state.
@@ -661,11 +1135,64 @@ static void compile_statement_for(FnCompiler* compiler, AstStatement* stmt) {
 #undef NEW_LOOP
 #undef END_LOOP
 
-static void compile_statement_return(FnCompiler* compiler, AstStatement* stmt) {
-  AstNode* expr = stmt->base.children[0];
-  if (expr != NULL) {
+// Checks whether calls in the current function can be compiled as tail calls. Constructors must return their instance and the
+// toplevel must return itself, so they can't have tail calls. Neither can a try statement, because a tail call would discard its
+// handler.
+static bool can_tail_call(FnCompiler* compiler) {
+  return compiler->try_depth == 0 && compiler->function->type != FN_TYPE_CONSTRUCTOR &&
+         compiler->function->type != FN_TYPE_MODULE;
+}
+
+// Compiles [expr] and returns its value. Calls and invocations (except the ones on "base") are compiled as tail calls, which
+// replace the current call frame. This also applies to the branches of a ternary.
+static void compile_returned(FnCompiler* compiler, AstNode* expr) {
+  AstExpression* ex = (AstExpression*)expr;
+  if (expr->type != NODE_EXPR || !can_tail_call(compiler) || is_seq_loop(expr)) {
     compile_node(compiler, expr);
     emit_one(compiler, OP_RETURN, expr);
+    return;
+  }
+
+  switch (ex->type) {
+    case EXPR_CALL:
+    case EXPR_INVOKE: {
+      AstExpression* target = (AstExpression*)ex->base.children[0];
+      if (target->type == EXPR_BASE) {
+        compile_node(compiler, expr);
+      } else if (ex->type == EXPR_CALL) {
+        compile_expr_call(compiler, ex, true);
+      } else {
+        compile_expr_invoke(compiler, ex, true);
+      }
+      emit_one(compiler, OP_RETURN, expr);  // Also returns the result of calls which returned immediately.
+      break;
+    }
+    case EXPR_TERNARY: {
+      AstNode* condition = ex->base.children[0];
+      compile_node(compiler, condition);  // Condition
+      int else_jump = emit_jump(compiler, OP_JUMP_IF_FALSE, condition);
+      emit_one(compiler, OP_POP, condition);             // Discard the condition.
+      compile_returned(compiler, ex->base.children[1]);  // True branch
+
+      patch_jump(compiler, else_jump);
+      emit_one(compiler, OP_POP, condition);              // Discard the condition.
+      compile_returned(compiler, ex->base.children[2]);  // False branch
+      break;
+    }
+    default: {
+      compile_node(compiler, expr);
+      emit_one(compiler, OP_RETURN, expr);
+      break;
+    }
+  }
+}
+
+static void compile_statement_return(FnCompiler* compiler, AstStatement* stmt) {
+  AstNode* expr = stmt->base.children[0];
+  if (expr != NULL && local_slot(compiler, expr) != -1) {
+    emit_two(compiler, OP_RETURN_LOCAL, (uint16_t)local_slot(compiler, expr), expr);
+  } else if (expr != NULL) {
+    compile_returned(compiler, expr);
   } else {
     emit_return(compiler, (AstNode*)stmt);
   }
@@ -678,9 +1205,7 @@ static void compile_statement_print(FnCompiler* compiler, AstStatement* stmt) {
 }
 
 static void compile_statement_expr(FnCompiler* compiler, AstStatement* stmt) {
-  AstNode* expr = stmt->base.children[0];
-  compile_node(compiler, expr);
-  emit_one(compiler, OP_POP, expr);
+  compile_discarded(compiler, stmt->base.children[0]);
 }
 
 static void compile_statement_break(FnCompiler* compiler, AstStatement* stmt) {
@@ -718,21 +1243,27 @@ static void compile_statement_throw(FnCompiler* compiler, AstStatement* stmt) {
   emit_one(compiler, OP_THROW, (AstNode*)stmt);
 }
 
+// Try blocks don't emit any code on entry. Their range is recorded in the chunk's handler table instead, which is only consulted
+// once an error is thrown - see handle_runtime_error.
 static void compile_statement_try(FnCompiler* compiler, AstStatement* stmt) {
   AstNode* try_stmt   = stmt->base.children[0];
   AstNode* catch_stmt = stmt->base.children[1];
 
-  int try_jump = emit_jump(compiler, OP_TRY, (AstNode*)stmt);
+  int start = compiler->result->chunk.count;
+  compiler->try_depth++;
   compile_node(compiler, try_stmt);  // Try statement
+  compiler->try_depth--;
 
   // If the try stmt was successful, skip the catch stmt.
   int success_jump = emit_jump(compiler, OP_JUMP, try_stmt);
-  patch_jump(compiler, try_jump);
+  chunk_add_try_range(&compiler->result->chunk, start, success_jump - 1, compiler->result->chunk.count,
+                      first_local_slot(stmt->base.scope), stmt->uses_error);
 
   if (catch_stmt != NULL) {
     compile_node(compiler, catch_stmt);  // Catch statement
   }
-  patch_jump(compiler, success_jump);  // Skip the catch block if the try block was successful.
+  discard_locals(compiler, stmt->base.scope, (AstNode*)stmt);  // Discard the error.
+  patch_jump(compiler, success_jump);                           // Skip the catch block if the try block was successful.
 }
 
 //
@@ -740,11 +1271,7 @@ static void compile_statement_try(FnCompiler* compiler, AstStatement* stmt) {
 //
 
 static void compile_expr_binary(FnCompiler* compiler, AstExpression* expr) {
-  AstNode* left  = expr->base.children[0];
-  AstNode* right = expr->base.children[1];
-
-  compile_node(compiler, left);
-  compile_node(compiler, right);
+  emit_binary_operands(compiler, expr);
   switch (expr->operator_.type) {
     case TOKEN_NEQ: emit_one(compiler, OP_NEQ, (AstNode*)expr); break;
     case TOKEN_EQ: emit_one(compiler, OP_EQ, (AstNode*)expr); break;
@@ -768,7 +1295,7 @@ static void compile_expr_postfix(FnCompiler* compiler, AstExpression* expr) {
   switch (expr->operator_.type) {
     case TOKEN_PLUS_PLUS: op = OP_ADD; break;
     case TOKEN_MINUS_MINUS: op = OP_SUBTRACT; break;
-    default: INTERNAL_ERROR("Unhandled postfix operator type: %d", expr->operator_.type); break;
+    default: INTERNAL_ERROR("Unhandled postfix operator type: %d", expr->operator_.type); return;
   }
 
   // TODO (optimize): That's a lot of bytecode for a simple operation.
@@ -800,7 +1327,7 @@ static void compile_expr_unary(FnCompiler* compiler, AstExpression* expr) {
     switch (expr->operator_.type) {
       case TOKEN_PLUS_PLUS: op = OP_ADD; break;
       case TOKEN_MINUS_MINUS: op = OP_SUBTRACT; break;
-      default: INTERNAL_ERROR("Unhandled unary operator type: %d", expr->operator_.type); break;
+      default: INTERNAL_ERROR("Unhandled unary operator type: %d", expr->operator_.type); return;
     }
 
     // TODO (optimize): That's a lot of bytecode for a simple operation.
@@ -845,7 +1372,7 @@ static void compile_expr_assign(FnCompiler* compiler, AstExpression* expr) {
     case TOKEN_MULT_ASSIGN: op = OP_MULTIPLY; break;
     case TOKEN_DIV_ASSIGN: op = OP_DIVIDE; break;
     case TOKEN_MOD_ASSIGN: op = OP_MODULO; break;
-    default: INTERNAL_ERROR("Unhandled compound assignment operator type: %d", expr->operator_.type); break;
+    default: INTERNAL_ERROR("Unhandled compound assignment operator type: %d", expr->operator_.type); return;
   }
 
   // TODO (optimize): That's a lot of bytecode for a simple operation.
@@ -886,6 +1413,18 @@ static void compile_expr_or(FnCompiler* compiler, AstExpression* expr) {
   patch_jump(compiler, end_jump);
 }
 
+static void compile_expr_coalesce(FnCompiler* compiler, AstExpression* expr) {
+  AstNode* left  = expr->base.children[0];
+  AstNode* right = expr->base.children[1];
+
+  compile_node(compiler, left);
+  int end_jump = emit_jump(compiler, OP_JUMP_IF_NOT_NIL, left);
+  emit_one(compiler, OP_POP, left);  // Discard the nil.
+
+  compile_node(compiler, right);
+  patch_jump(compiler, end_jump);
+}
+
 static void compile_expr_is(FnCompiler* compiler, AstExpression* expr) {
   AstNode* left  = expr->base.children[0];
   AstNode* right = expr->base.children[1];
@@ -906,10 +1445,71 @@ static void compile_expr_in(FnCompiler* compiler, AstExpression* expr) {
   emit_one(compiler, OP_IN, (AstNode*)expr);
 }
 
-static void compile_expr_call(FnCompiler* compiler, AstExpression* expr) {
+// Compiles a call or invocation which the resolver decided to inline (see resolve_inlined_call). The callee - or the receiver -
+// and the arguments are pushed as usual. If the callee turns out to be the function which was inlined, its returned expression is
+// evaluated right there - on top of the callee and the arguments, which make up its frame. Otherwise, it's called like any other
+// function. Calls in tail position are not inlined, they already reuse the current frame.
+static void compile_inlined_call(FnCompiler* compiler, AstExpression* expr, bool tail) {
+  AstFn* callee  = expr->inlined;
+  bool invoke    = expr->type == EXPR_INVOKE;
+  uint16_t argc  = (uint16_t)(expr->base.count - (invoke ? 2 : 1));
+  uint16_t name  = invoke ? id_constant(compiler, ((AstId*)expr->base.children[1])->name, expr->base.children[1]) : 0;
+  OpCode regular = invoke ? (tail ? OP_TAIL_INVOKE : OP_INVOKE) : (tail ? OP_TAIL_CALL : OP_CALL);
+
+  // The callee is the last local of the call, apart from the arguments. Temporaries of enclosing expressions come before it.
+  Scope* scope   = expr->base.scope;
+  uint16_t frame = (uint16_t)(first_local_slot(scope) + scope->local_count - 1 - argc);
+
+  for (int i = 0; i < expr->base.count; i++) {
+    if (!invoke || i != 1) {
+      compile_node(compiler, expr->base.children[i]);  // [callee][arg_0]...[arg_n], the method name is not pushed
+    }
+  }
+
+  // Not compiled (yet), nothing to compare to.
+  if (tail || callee->compiled == NULL) {
+    if (invoke) {
+      emit_three(compiler, regular, name, argc, (AstNode*)expr);
+      emit_inline_cache(compiler, (AstNode*)expr);
+    } else {
+      emit_two(compiler, regular, argc, (AstNode*)expr);
+    }
+    return;
+  }
+
+  int site          = compiler->result->chunk.count;
+  uint16_t function = make_constant(compiler, fn_value((Obj*)callee->compiled), (AstNode*)expr);
+  if (invoke) {
+    emit_three(compiler, OP_INVOKE_INLINED, name, argc, (AstNode*)expr);
+    emit_inline_cache(compiler, (AstNode*)expr);
+    emit_one(compiler, function, (AstNode*)expr);
+  } else {
+    emit_three(compiler, OP_CALL_INLINED, argc, function, (AstNode*)expr);
+  }
+  emit_one(compiler, UINT16_MAX, (AstNode*)expr);
+  int call_jump = compiler->result->chunk.count - 1;  // Patched like any other jump, it's where the regular call returns to.
+
+  int enclosing_frame    = compiler->inline_frame;
+  compiler->inline_frame = frame;
+  int body_start         = compiler->result->chunk.count;
+  compile_node(compiler, ast_returned_expr(callee));  // [callee][arg_0]...[arg_n][result]
+  chunk_add_inlined_range(&compiler->result->chunk, body_start, compiler->result->chunk.count, site, callee->compiled->name);
+  compiler->inline_frame = enclosing_frame;
+
+  emit_two(compiler, OP_RETURN_INLINED, argc, (AstNode*)expr);  // [result]
+  patch_jump(compiler, call_jump);
+}
+
+// Compiles a call. If [tail] is true, the call is compiled as a tail call, which replaces the current call frame.
+static void compile_expr_call(FnCompiler* compiler, AstExpression* expr, bool tail) {
   AstExpression* target = (AstExpression*)expr->base.children[0];
   uint16_t argc         = (uint16_t)expr->base.count - 1;
 
+  if (is_inlined_call((AstNode*)expr)) {
+    compile_inlined_call(compiler, expr, tail);
+    return;
+  }
+
   // Calling "base" is a special case
   if (target->type == EXPR_BASE) {
     AstId* this_  = (AstId*)target->base.children[0];
@@ -928,7 +1528,7 @@ static void compile_expr_call(FnCompiler* compiler, AstExpression* expr) {
     for (int i = 1; i < expr->base.count; i++) {
       compile_node(compiler, expr->base.children[i]);
     }
-    emit_two(compiler, OP_CALL, argc, (AstNode*)expr);
+    emit_two(compiler, tail ? OP_TAIL_CALL : OP_CALL, argc, (AstNode*)expr);
   }
 }
 
@@ -947,12 +1547,117 @@ static void compile_expr_dot(FnCompiler* compiler, AstExpression* expr) {
     emit_load_id(compiler, base_);  // Base
     emit_two(compiler, OP_GET_BASE_METHOD, name, (AstNode*)expr);
   } else {
+    OpCode op = expr->operator_.type == TOKEN_SAFE_DOT ? OP_GET_PROPERTY_SAFE : OP_GET_PROPERTY;
     compile_node(compiler, target);
-    emit_two(compiler, OP_GET_PROPERTY, name, (AstNode*)expr);
+    emit_two(compiler, op, name, (AstNode*)expr);
+    emit_inline_cache(compiler, (AstNode*)expr);
   }
 }
 
-static void compile_expr_invoke(FnCompiler* compiler, AstExpression* expr) {
+// Compiles an invocation. If [tail] is true, the invocation is compiled as a tail call, which replaces the current call frame.
+// Compiles a higher-order Seq or Tuple method call with a function literal, which the resolver lowered into a loop (see
+// resolve_seq_loop). If the receiver is a Seq or Tuple at runtime, the body of the function literal runs inline - in the current
+// frame, without creating a closure or calling into the native. Otherwise, the function literal is compiled into a closure and
+// the method is invoked as usual.
+static void compile_seq_loop(FnCompiler* compiler, AstExpression* expr) {
+  AstNode* target  = expr->base.children[0];
+  AstId* method    = (AstId*)expr->base.children[1];
+  AstNode* literal = expr->base.children[expr->base.count - 1];
+  AstFn* inlined   = (AstFn*)literal->children[1];
+
+  SeqLoopKind kind;
+  ast_seq_loop_kind(method, &kind);
+
+  // The state of the loop lives in the locals of the scope of the call, the receiver being the first one.
+  uint16_t slot = first_local_slot(expr->base.scope);
+
+  AstDeclaration* params = (AstDeclaration*)inlined->base.children[1];
+  int arity              = params == NULL ? 0 : params->base.count;
+  uint16_t args          = 0;
+  if (kind == SEQ_LOOP_FOLD) {
+    args = SEQ_LOOP_PUSH_ACC | SEQ_LOOP_PUSH_ITEM | (arity > 2 ? SEQ_LOOP_PUSH_INDEX : 0);
+  } else {
+    args = (arity > 0 ? SEQ_LOOP_PUSH_ITEM : 0) | (arity > 1 ? SEQ_LOOP_PUSH_INDEX : 0);
+  }
+
+  compile_node(compiler, target);  // [receiver]
+  if (kind == SEQ_LOOP_FOLD) {
+    compile_node(compiler, expr->base.children[2]);  // [receiver][initial]
+  }
+  int site = compiler->result->chunk.count;
+  emit_three(compiler, OP_SEQ_LOOP_ENTER, (uint16_t)kind, UINT16_MAX, (AstNode*)expr);
+  int fallback_jump = compiler->result->chunk.count - 1;  // Patched like any other jump.
+
+  // The loop: [receiver][acc][count][index]
+  int loop_start = compiler->result->chunk.count;
+  emit_three(compiler, OP_SEQ_LOOP_NEXT, slot, args, (AstNode*)expr);
+  emit_one(compiler, UINT16_MAX, (AstNode*)expr);
+  int exit_jump = compiler->result->chunk.count - 1;
+
+  // The arguments are on the stack now, so they take the place of the parameters.
+  for (int i = 0; i < arity; i++) {
+    emit_define_id(compiler, (AstId*)params->base.children[i]);
+  }
+
+  int body_start = compiler->result->chunk.count;
+  AstNode* body  = inlined->base.children[2];
+  if (inlined->is_lambda) {
+    if (kind == SEQ_LOOP_EACH) {
+      compile_discarded(compiler, body);
+    } else {
+      compile_node(compiler, body);
+    }
+  } else {
+    AstStatement* trailing = ast_trailing_return(body);
+    for (int i = 0; i < body->count; i++) {
+      if (body->children[i] != (AstNode*)trailing) {
+        compile_node(compiler, body->children[i]);
+      }
+    }
+
+    AstNode* result = trailing == NULL ? NULL : trailing->base.children[0];
+    if (result != NULL && kind == SEQ_LOOP_EACH) {
+      compile_discarded(compiler, result);
+    } else if (result != NULL) {
+      compile_node(compiler, result);
+    } else if (kind != SEQ_LOOP_EACH) {
+      emit_one(compiler, OP_NIL, body);
+    }
+  }
+
+  chunk_add_inlined_range(&compiler->result->chunk, body_start, compiler->result->chunk.count, site, NULL);
+
+  if (kind != SEQ_LOOP_EACH) {
+    emit_three(compiler, OP_SEQ_LOOP_STEP, (uint16_t)kind, slot, (AstNode*)expr);
+  }
+  discard_locals(compiler, inlined->base.scope, (AstNode*)expr);
+  emit_two(compiler, OP_INC_LOCAL, (uint16_t)(slot + 3), (AstNode*)expr);  // Next index
+  emit_loop(compiler, loop_start, (AstNode*)expr);
+
+  patch_jump(compiler, exit_jump);
+  emit_two(compiler, OP_SEQ_LOOP_END, (uint16_t)kind, (AstNode*)expr);  // [result]
+  int end_jump = emit_jump(compiler, OP_JUMP, (AstNode*)expr);
+
+  // Not a Seq or Tuple, so we need the function literal after all.
+  patch_jump(compiler, fallback_jump);
+  compile_node(compiler, literal);
+  uint16_t name = id_constant(compiler, method->name, (AstNode*)method);
+  emit_three(compiler, OP_INVOKE, name, (uint16_t)(expr->base.count - 2), (AstNode*)expr);
+  emit_inline_cache(compiler, (AstNode*)expr);
+
+  patch_jump(compiler, end_jump);
+}
+
+static void compile_expr_invoke(FnCompiler* compiler, AstExpression* expr, bool tail) {
+  if (is_seq_loop((AstNode*)expr)) {
+    compile_seq_loop(compiler, expr);
+    return;
+  }
+  if (is_inlined_call((AstNode*)expr)) {
+    compile_inlined_call(compiler, expr, tail);
+    return;
+  }
+
   AstNode* target = expr->base.children[0];
   AstId* property = (AstId*)expr->base.children[1];
   uint16_t name   = id_constant(compiler, property->name, (AstNode*)property);
@@ -974,7 +1679,8 @@ static void compile_expr_invoke(FnCompiler* compiler, AstExpression* expr) {
     for (int i = 2; i < expr->base.count; i++) {
       compile_node(compiler, expr->base.children[i]);
     }
-    emit_three(compiler, OP_INVOKE, name, argc, (AstNode*)expr);
+    emit_three(compiler, tail ? OP_TAIL_INVOKE : OP_INVOKE, name, argc, (AstNode*)expr);
+    emit_inline_cache(compiler, (AstNode*)expr);
   }
 }
 
@@ -984,7 +1690,12 @@ static void compile_expr_subs(FnCompiler* compiler, AstExpression* expr) {
 
   compile_node(compiler, (AstNode*)target);
   compile_node(compiler, index);
-  emit_one(compiler, OP_GET_SUBSCRIPT, (AstNode*)expr);
+  if (expr->operator_.type == TOKEN_SAFE_DOT) {
+    emit_one(compiler, OP_GET_SUBSCRIPT_SAFE, (AstNode*)expr);
+  } else {
+    emit_one(compiler, is_in_bounds(compiler, (AstNode*)target, index) ? OP_GET_SUBSCRIPT_IN_BOUNDS : OP_GET_SUBSCRIPT,
+             (AstNode*)expr);
+  }
 }
 
 static void compile_expr_slice(FnCompiler* compiler, AstExpression* expr) {
@@ -1036,26 +1747,37 @@ static void compile_expr_ternary(FnCompiler* compiler, AstExpression* expr) {
   patch_jump(compiler, end_jump);
 }
 
+// Like try statements, try expressions only record their range in the chunk's handler table. The handler unwinds the stack to
+// the slot of the result, where it pushes the error - see resolve_expr_try.
 static void compile_expr_try(FnCompiler* compiler, AstExpression* expr) {
   AstId* error        = (AstId*)expr->base.children[0];
   AstNode* try_expr   = expr->base.children[1];
   AstNode* catch_expr = expr->base.children[2];
 
-  int try_jump = emit_jump(compiler, OP_TRY, (AstNode*)expr);
+  uint16_t result_slot = (uint16_t)(error->ref->symbol->function_index - 1);  // The error is injected right after the result.
+
+  int start = compiler->result->chunk.count;
+  compiler->try_depth++;
   compile_node(compiler, try_expr);  // Try expression
-  emit_assign_id(compiler, error);
+  compiler->try_depth--;
 
-  // If the try block was successful, skip the catch block.
+  // If the try expression was successful, its value already is the result - skip the catch expression.
   int success_jump = emit_jump(compiler, OP_JUMP, try_expr);
-  patch_jump(compiler, try_jump);
+  chunk_add_try_range(&compiler->result->chunk, start, success_jump - 1, compiler->result->chunk.count, result_slot,
+                      expr->uses_error);
 
+  emit_two(compiler, OP_DUPE, 0, (AstNode*)expr);  // Keep the error in the result slot, the copy becomes the error variable.
   if (catch_expr == NULL) {
     emit_one(compiler, OP_NIL, try_expr);  // Push nil as the "else" value.
   } else {
     compile_node(compiler, catch_expr);  // Catch expression
   }
-  emit_assign_id(compiler, error);     // Assign the error variable.
-  patch_jump(compiler, success_jump);  // Skip the catch block if the try block was successful.
+  emit_two(compiler, OP_SET_LOCAL, result_slot, (AstNode*)expr);  // Move the "else" value into the result slot.
+  emit_one(compiler, OP_POP, (AstNode*)expr);
+
+  // Discard the error variable.
+  emit_one(compiler, error->ref->symbol->is_captured ? OP_CLOSE_UPVALUE : OP_POP, (AstNode*)expr);
+  patch_jump(compiler, success_jump);  // Skip the catch expression if the try expression was successful.
 }
 
 //
@@ -1071,7 +1793,7 @@ static void compile_lit_string(FnCompiler* compiler, AstLiteral* lit) {
 }
 
 static void compile_lit_bool(FnCompiler* compiler, AstLiteral* lit) {
-  emit_one(compiler, lit->value.as.boolean ? OP_TRUE : OP_FALSE, (AstNode*)lit);
+  emit_one(compiler, AS_BOOL(lit->value) ? OP_TRUE : OP_FALSE, (AstNode*)lit);
 }
 
 static void compile_lit_nil(FnCompiler* compiler, AstLiteral* lit) {
@@ -1117,6 +1839,7 @@ static void compile_node(FnCompiler* compiler, AstNode* node) {
         case STMT_IF: compile_statement_if(compiler, stmt); break;
         case STMT_WHILE: compile_statement_while(compiler, stmt); break;
         case STMT_FOR: compile_statement_for(compiler, stmt); break;
+        case STMT_FOR_IN: compile_statement_for_in(compiler, stmt); break;
         case STMT_RETURN: compile_statement_return(compiler, stmt); break;
         case STMT_PRINT: compile_statement_print(compiler, stmt); break;
         case STMT_EXPR: compile_statement_expr(compiler, stmt); break;
@@ -1130,6 +1853,11 @@ static void compile_node(FnCompiler* compiler, AstNode* node) {
     }
     case NODE_EXPR: {
       AstExpression* expr = (AstExpression*)node;
+      int reuse_jump      = -1;
+      if (expr->reuse >= 0) {
+        emit_three(compiler, OP_REUSE, (uint16_t)expr->reuse, UINT16_MAX, node);  // Common subexpression, see find_reuse.
+        reuse_jump = compiler->result->chunk.count - 1;
+      }
       switch (expr->type) {
         case EXPR_BINARY: compile_expr_binary(compiler, expr); break;
         case EXPR_POSTFIX: compile_expr_postfix(compiler, expr); break;
@@ -1140,11 +1868,12 @@ static void compile_node(FnCompiler* compiler, AstNode* node) {
         case EXPR_ASSIGN: compile_expr_assign(compiler, expr); break;
         case EXPR_AND: compile_expr_and(compiler, expr); break;
         case EXPR_OR: compile_expr_or(compiler, expr); break;
+        case EXPR_COALESCE: compile_expr_coalesce(compiler, expr); break;
         case EXPR_IS: compile_expr_is(compiler, expr); break;
         case EXPR_IN: compile_expr_in(compiler, expr); break;
-        case EXPR_CALL: compile_expr_call(compiler, expr); break;
+        case EXPR_CALL: compile_expr_call(compiler, expr, false); break;
         case EXPR_DOT: compile_expr_dot(compiler, expr); break;
-        case EXPR_INVOKE: compile_expr_invoke(compiler, expr); break;
+        case EXPR_INVOKE: compile_expr_invoke(compiler, expr, false); break;
         case EXPR_SUBS: compile_expr_subs(compiler, expr); break;
         case EXPR_SLICE: compile_expr_slice(compiler, expr); break;
         case EXPR_THIS: compile_expr_this(compiler, expr); break;
@@ -1154,6 +1883,9 @@ static void compile_node(FnCompiler* compiler, AstNode* node) {
         case EXPR_TRY: compile_expr_try(compiler, expr); break;
         default: INTERNAL_ERROR("Unhandled expression type."); break;
       }
+      if (reuse_jump != -1) {
+        patch_jump(compiler, reuse_jump);
+      }
       break;
     }
     case NODE_LIT: {
@@ -1174,8 +1906,9 @@ static void compile_node(FnCompiler* compiler, AstNode* node) {
   }
 
   // Exit the scope, if we entered one - no need to do that for functions though, since their locals are popped when the function
-  // returns.
-  if (node->scope != NULL && node->type != NODE_FN) {
+  // returns. Lowered Seq method calls, inlined calls and try expressions replace their locals with the result themselves, try
+  // statements discard the error in the catch branch.
+  if (node->scope != NULL && node->type != NODE_FN && !is_seq_loop(node) && !is_inlined_call(node) && !is_try(node)) {
     discard_locals(compiler, node->scope, node);
   }
 }
@@ -4,8 +4,10 @@
 #include "ast.h"
 #include "object.h"
 
-#define MAX_CONSTANTS 65535  // UINT16_MAX
-#define MAX_JUMP 65535       // UINT16_MAX
+#define MAX_CONSTANTS 65535      // UINT16_MAX
+#define MAX_JUMP 65535           // UINT16_MAX
+#define MAX_INLINE_CACHES 65535  // UINT16_MAX
+#define MAX_GLOBALS 65535        // UINT16_MAX
 
 typedef struct FnCompiler FnCompiler;
 
@@ -18,6 +20,15 @@ typedef enum {
   TYPE_MODULE
 } FunctionType;
 
+// Canonical `for` loop over a seq whose body is being compiled, e.g. `for let i = 0; i < list.len; i++; { ... }`. See
+// compile_statement_for.
+typedef struct {
+  AstId* index;    // The loop variable, which is within the bounds of [seq] when the body is entered. NULL if there's no loop.
+  AstId* seq;      // The variable holding the seq.
+  int body_start;  // Offset of the first instruction of the body.
+  int loop_start;  // Value of innermost_loop_start while the body is compiled. Tells the body apart from nested loops.
+} BoundedLoop;
+
 struct FnCompiler {
   struct FnCompiler* enclosing;
   AstFn* function;
@@ -29,6 +40,10 @@ struct FnCompiler {
   int brakes_count;
   int brakes_capacity;
   int* brake_jumps;
+  BoundedLoop bounded_loop;
+
+  int try_depth;     // Number of enclosing try statements. Calls within a try statement can't be tail calls.
+  int inline_frame;  // Slot at which the frame of the function which is being inlined starts, see compile_inlined_call.
 
   bool had_error;
 };
@@ -69,14 +69,36 @@ static int byte_instruction(const char* name, Chunk* chunk, int offset) {
   return offset + 2;
 }
 
+// Prints an instruction that has two byte-sized operands.
+static int byte_byte_instruction(const char* name, Chunk* chunk, int offset) {
+  uint16_t slot  = chunk->code[offset + 1];
+  uint16_t slot2 = chunk->code[offset + 2];
+  PRINT_OPCODE(name);
+  PRINT_NUMBER(slot);
+  char slot_str[VALUE_STR_LEN];
+  sprintf(slot_str, "%d", slot2);
+  PRINT_VALUE_STR(slot_str);
+  return offset + 3;
+}
+
+// Prints an instruction that has one byte-sized operand, followed by an index into the constant table.
+static int byte_constant_instruction(const char* name, Chunk* chunk, int offset) {
+  uint16_t slot           = chunk->code[offset + 1];
+  uint16_t constant_index = chunk->code[offset + 2];
+  PRINT_OPCODE(name);
+  PRINT_NUMBER(slot);
+  debug_print_value(chunk->constants.values[constant_index]);
+  return offset + 3;
+}
+
 static int jump_instruction(const char* name, int sign, Chunk* chunk, int offset) {
   uint16_t jump = chunk->code[offset + 1];
   char jmp_str[13];
-  sprintf(jmp_str, "%04d -> %04d", offset, offset + 3 + (sign * jump));
+  sprintf(jmp_str, "%04d -> %04d", offset, offset + 2 + (sign * jump));
   PRINT_OPCODE(name);
   PRINT_NO_NUM();
   PRINT_VALUE_STR(jmp_str);
-  return offset + 3;
+  return offset + 2;
 }
 
 // Prints an instruction with one operand that is an index into the constant table.
@@ -144,6 +166,35 @@ static int invoke_instruction(const char* name, Chunk* chunk, int offset) {
   return offset + 3;
 }
 
+// Prints an instruction with one operand that is an index into the constant table, followed by an inline cache index.
+static int cached_constant_instruction(const char* name, Chunk* chunk, int offset) {
+  uint16_t cache = chunk->code[offset + 2];
+  constant_instruction(name, chunk, offset);
+  printf(ANSI_RED_STR(" ic %d"), cache);
+  return offset + 3;
+}
+
+// Prints an invoke instruction, followed by an inline cache index.
+static int cached_invoke_instruction(const char* name, Chunk* chunk, int offset) {
+  uint16_t cache = chunk->code[offset + 3];
+  invoke_instruction(name, chunk, offset);
+  printf(ANSI_RED_STR(" ic %d"), cache);
+  return offset + 4;
+}
+
+// Prints a lowered seq loop instruction which has [operands] operands, the last of which is a jump offset.
+static int seq_loop_instruction(const char* name, int operands, Chunk* chunk, int offset) {
+  uint16_t first = chunk->code[offset + 1];
+  uint16_t jump  = chunk->code[offset + operands];
+  int next       = offset + 1 + operands;
+  char jmp_str[VALUE_STR_LEN];
+  sprintf(jmp_str, "%04d -> %04d", offset, next + jump);
+  PRINT_OPCODE(name);
+  PRINT_NUMBER(first);
+  PRINT_VALUE_STR(jmp_str);
+  return next;
+}
+
 int debug_disassemble_instruction(Chunk* chunk, int offset) {
   PRINT_OFFSET(offset);
 
@@ -163,15 +214,17 @@ int debug_disassemble_instruction(Chunk* chunk, int offset) {
     case OP_DUPE: return byte_instruction(STR(OP_DUPE), chunk, offset);
     case OP_GET_LOCAL: return byte_instruction(STR(OP_GET_LOCAL), chunk, offset);
     case OP_SET_LOCAL: return byte_instruction(STR(OP_SET_LOCAL), chunk, offset);
-    case OP_GET_GLOBAL: return constant_instruction(STR(OP_GET_GLOBAL), chunk, offset);
-    case OP_DEFINE_GLOBAL: return constant_instruction(STR(OP_DEFINE_GLOBAL), chunk, offset);
-    case OP_SET_GLOBAL: return constant_instruction(STR(OP_SET_GLOBAL), chunk, offset);
+    case OP_GET_GLOBAL_SLOT: return byte_constant_instruction(STR(OP_GET_GLOBAL_SLOT), chunk, offset);
+    case OP_DEFINE_GLOBAL_SLOT: return byte_constant_instruction(STR(OP_DEFINE_GLOBAL_SLOT), chunk, offset);
+    case OP_SET_GLOBAL_SLOT: return byte_constant_instruction(STR(OP_SET_GLOBAL_SLOT), chunk, offset);
     case OP_GET_UPVALUE: return byte_instruction(STR(OP_GET_UPVALUE), chunk, offset);
     case OP_SET_UPVALUE: return byte_instruction(STR(OP_SET_UPVALUE), chunk, offset);
     case OP_GET_SUBSCRIPT: return simple_instruction(STR(OP_GET_SUBSCRIPT), offset);
+    case OP_GET_SUBSCRIPT_SAFE: return simple_instruction(STR(OP_GET_SUBSCRIPT_SAFE), offset);
     case OP_SET_SUBSCRIPT: return simple_instruction(STR(OP_SET_SUBSCRIPT), offset);
-    case OP_GET_PROPERTY: return constant_instruction(STR(OP_GET_PROPERTY), chunk, offset);
-    case OP_SET_PROPERTY: return constant_instruction(STR(OP_SET_PROPERTY), chunk, offset);
+    case OP_GET_PROPERTY: return cached_constant_instruction(STR(OP_GET_PROPERTY), chunk, offset);
+    case OP_GET_PROPERTY_SAFE: return cached_constant_instruction(STR(OP_GET_PROPERTY_SAFE), chunk, offset);
+    case OP_SET_PROPERTY: return cached_constant_instruction(STR(OP_SET_PROPERTY), chunk, offset);
     case OP_GET_BASE_METHOD: return constant_instruction(STR(OP_GET_BASE_METHOD), chunk, offset);
     case OP_EQ: return simple_instruction(STR(OP_EQ), offset);
     case OP_NEQ: return simple_instruction(STR(OP_NEQ), offset);
@@ -186,10 +239,13 @@ int debug_disassemble_instruction(Chunk* chunk, int offset) {
     case OP_OBJECT_LITERAL: return byte_instruction(STR(OP_OBJECT_LITERAL), chunk, offset);
     case OP_JUMP: return jump_instruction(STR(OP_JUMP), 1, chunk, offset);
     case OP_JUMP_IF_FALSE: return jump_instruction(STR(OP_JUMP_IF_FALSE), 1, chunk, offset);
-    case OP_TRY: return jump_instruction(STR(OP_TRY), 1, chunk, offset);
+    case OP_JUMP_IF_TRUE: return jump_instruction(STR(OP_JUMP_IF_TRUE), 1, chunk, offset);
+    case OP_JUMP_IF_NOT_NIL: return jump_instruction(STR(OP_JUMP_IF_NOT_NIL), 1, chunk, offset);
     case OP_LOOP: return jump_instruction(STR(OP_LOOP), -1, chunk, offset);
     case OP_CALL: return byte_instruction(STR(OP_CALL), chunk, offset);
-    case OP_INVOKE: return invoke_instruction(STR(OP_INVOKE), chunk, offset);
+    case OP_INVOKE: return cached_invoke_instruction(STR(OP_INVOKE), chunk, offset);
+    case OP_TAIL_CALL: return byte_instruction(STR(OP_TAIL_CALL), chunk, offset);
+    case OP_TAIL_INVOKE: return cached_invoke_instruction(STR(OP_TAIL_INVOKE), chunk, offset);
     case OP_BASE_INVOKE: return invoke_instruction(STR(OP_BASE_INVOKE), chunk, offset);
     case OP_CLOSURE: return closure_instruction(STR(OP_CLOSURE), chunk, offset);
     case OP_CLOSE_UPVALUE: return simple_instruction(STR(OP_CLOSE_UPVALUE), offset);
@@ -210,6 +266,48 @@ int debug_disassemble_instruction(Chunk* chunk, int offset) {
     case OP_IS: return simple_instruction(STR(OP_IS), offset);
     case OP_IN: return simple_instruction(STR(OP_IN), offset);
     case OP_GET_SLICE: return simple_instruction(STR(OP_GET_SLICE), offset);
+    case OP_GT_INT_INT: return simple_instruction(STR(OP_GT_INT_INT), offset);
+    case OP_GT_FLOAT_FLOAT: return simple_instruction(STR(OP_GT_FLOAT_FLOAT), offset);
+    case OP_LT_INT_INT: return simple_instruction(STR(OP_LT_INT_INT), offset);
+    case OP_LT_FLOAT_FLOAT: return simple_instruction(STR(OP_LT_FLOAT_FLOAT), offset);
+    case OP_GTEQ_INT_INT: return simple_instruction(STR(OP_GTEQ_INT_INT), offset);
+    case OP_GTEQ_FLOAT_FLOAT: return simple_instruction(STR(OP_GTEQ_FLOAT_FLOAT), offset);
+    case OP_LTEQ_INT_INT: return simple_instruction(STR(OP_LTEQ_INT_INT), offset);
+    case OP_LTEQ_FLOAT_FLOAT: return simple_instruction(STR(OP_LTEQ_FLOAT_FLOAT), offset);
+    case OP_ADD_INT_INT: return simple_instruction(STR(OP_ADD_INT_INT), offset);
+    case OP_ADD_FLOAT_FLOAT: return simple_instruction(STR(OP_ADD_FLOAT_FLOAT), offset);
+    case OP_SUBTRACT_INT_INT: return simple_instruction(STR(OP_SUBTRACT_INT_INT), offset);
+    case OP_SUBTRACT_FLOAT_FLOAT: return simple_instruction(STR(OP_SUBTRACT_FLOAT_FLOAT), offset);
+    case OP_MULTIPLY_INT_INT: return simple_instruction(STR(OP_MULTIPLY_INT_INT), offset);
+    case OP_MULTIPLY_FLOAT_FLOAT: return simple_instruction(STR(OP_MULTIPLY_FLOAT_FLOAT), offset);
+    case OP_GET_SUBSCRIPT_SEQ_INT: return simple_instruction(STR(OP_GET_SUBSCRIPT_SEQ_INT), offset);
+    case OP_GET_SUBSCRIPT_IN_BOUNDS: return simple_instruction(STR(OP_GET_SUBSCRIPT_IN_BOUNDS), offset);
+    case OP_GET_PROPERTY_OBJ: return cached_constant_instruction(STR(OP_GET_PROPERTY_OBJ), chunk, offset);
+    case OP_GET_LOCAL_GET_LOCAL: return byte_byte_instruction(STR(OP_GET_LOCAL_GET_LOCAL), chunk, offset);
+    case OP_INC_LOCAL: return byte_instruction(STR(OP_INC_LOCAL), chunk, offset);
+    case OP_DEC_LOCAL: return byte_instruction(STR(OP_DEC_LOCAL), chunk, offset);
+    case OP_ADD_LOCAL_CONST: return byte_constant_instruction(STR(OP_ADD_LOCAL_CONST), chunk, offset);
+    case OP_RETURN_LOCAL: return byte_instruction(STR(OP_RETURN_LOCAL), chunk, offset);
+    case OP_RETURN_NIL: return simple_instruction(STR(OP_RETURN_NIL), offset);
+    case OP_EQ_JUMP_IF_FALSE: return jump_instruction(STR(OP_EQ_JUMP_IF_FALSE), 1, chunk, offset);
+    case OP_NEQ_JUMP_IF_FALSE: return jump_instruction(STR(OP_NEQ_JUMP_IF_FALSE), 1, chunk, offset);
+    case OP_GT_JUMP_IF_FALSE: return jump_instruction(STR(OP_GT_JUMP_IF_FALSE), 1, chunk, offset);
+    case OP_LT_JUMP_IF_FALSE: return jump_instruction(STR(OP_LT_JUMP_IF_FALSE), 1, chunk, offset);
+    case OP_GTEQ_JUMP_IF_FALSE: return jump_instruction(STR(OP_GTEQ_JUMP_IF_FALSE), 1, chunk, offset);
+    case OP_LTEQ_JUMP_IF_FALSE: return jump_instruction(STR(OP_LTEQ_JUMP_IF_FALSE), 1, chunk, offset);
+    case OP_LT_LEN_JUMP_IF_FALSE: return jump_instruction(STR(OP_LT_LEN_JUMP_IF_FALSE), 1, chunk, offset);
+    case OP_CALL_INLINED: return seq_loop_instruction(STR(OP_CALL_INLINED), 3, chunk, offset);
+    case OP_INVOKE_INLINED: return seq_loop_instruction(STR(OP_INVOKE_INLINED), 5, chunk, offset);
+    case OP_RETURN_INLINED: return byte_instruction(STR(OP_RETURN_INLINED), chunk, offset);
+    case OP_REUSE: return seq_loop_instruction(STR(OP_REUSE), 2, chunk, offset);
+    case OP_SEQ_LOOP_ENTER: return seq_loop_instruction(STR(OP_SEQ_LOOP_ENTER), 2, chunk, offset);
+    case OP_SEQ_LOOP_NEXT: return seq_loop_instruction(STR(OP_SEQ_LOOP_NEXT), 3, chunk, offset);
+    case OP_SEQ_LOOP_STEP: return byte_byte_instruction(STR(OP_SEQ_LOOP_STEP), chunk, offset);
+    case OP_SEQ_LOOP_END: return byte_instruction(STR(OP_SEQ_LOOP_END), chunk, offset);
+    case OP_FOR_IN_INIT: return simple_instruction(STR(OP_FOR_IN_INIT), offset);
+    case OP_FOR_IN_NEXT: return seq_loop_instruction(STR(OP_FOR_IN_NEXT), 3, chunk, offset);
+    case OP_FOR_RANGE_INIT: return simple_instruction(STR(OP_FOR_RANGE_INIT), offset);
+    case OP_FOR_RANGE_NEXT: return seq_loop_instruction(STR(OP_FOR_RANGE_NEXT), 2, chunk, offset);
     default: INTERNAL_ERROR("Unhandled opcode: %d\n", instruction); return offset + 1;
   }
 }
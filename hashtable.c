@@ -19,7 +19,7 @@ void hashtable_free(HashTable* table) {
 
 // Find the entry for key. Returns a pointer to the entry if found, or a pointer to an empty entry if not found.
 static Entry* find_entry(Entry* entries, int capacity, Value key) {
-  uint64_t index = key.type->__hash(key) & (capacity - 1);
+  uint64_t index = value_type(key)->__hash(key) & (capacity - 1);
 
   // If we pass a tombstone and don't end up finding the key, its entry will be re-used for the insert.
   Entry* tombstone = NULL;
@@ -37,7 +37,7 @@ static Entry* find_entry(Entry* entries, int capacity, Value key) {
       if (tombstone == NULL) {
         tombstone = entry;
       }
-    } else if (entry->key.type->__equals(entry->key, key)) {
+    } else if (value_type(entry->key)->__equals(entry->key, key)) {
       // We found the key.
       return entry;
     }
@@ -199,7 +199,7 @@ ObjString* hashtable_find_string(HashTable* table, const char* chars, int length
 void hashtable_remove_white(HashTable* table) {
   for (int i = 0; i < table->capacity; i++) {
     Entry* entry = &table->entries[i];
-    if (!is_empty_internal(entry->key) && !atomic_load(&entry->key.as.obj->is_marked)) {
+    if (!is_empty_internal(entry->key) && !atomic_load(&AS_OBJ(entry->key)->is_marked)) {
       hashtable_delete(table, entry->key);
     }
   }
@@ -0,0 +1,1404 @@
+#include "ir.h"
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+#include "peephole.h"
+#include "vm.h"
+
+#define IR_ARRAY_PUSH(array, count, capacity, item)                        \
+  do {                                                                     \
+    if ((count) + 1 > (capacity)) {                                        \
+      (capacity) = (capacity) < 8 ? 8 : (capacity) * 2;                    \
+      (array)    = realloc((array), sizeof(*(array)) * (size_t)(capacity)); \
+    }                                                                      \
+    (array)[(count)++] = (item);                                           \
+  } while (0)
+
+#define IR_EDGE_FALL 0
+#define IR_EDGE_BRANCH 1
+
+// Stack of the values in the slots of a frame, during the abstract interpretation of a block.
+typedef struct {
+  int* slots;
+  int depth;
+  int capacity;
+} IrState;
+
+// Effect of the instruction which is currently being interpreted, see transfer.
+typedef struct {
+  IrFunction* ir;
+  IrState* state;
+  int block;
+  int offset;
+  bool record;  // Whether the effect is recorded as an IrInstr. False for the second edge of a branch.
+  bool failed;  // Whether the instruction does something the IR can't model.
+  int pops;
+  int* inputs;
+  int input_count;
+  int input_capacity;
+  int* outputs;
+  int output_count;
+  int output_capacity;
+  int* writes;  // Pairs of slot and value.
+  int write_count;
+  int write_capacity;
+} IrTransfer;
+
+//
+// Values
+//
+
+static int new_value(IrFunction* ir, IrValueKind kind, int block, int offset, IrType type) {
+  IrValue value = {
+      .kind        = kind,
+      .op          = OP_CONSTANT,
+      .offset      = offset,
+      .block       = block,
+      .operands    = {-1, -1},
+      .phi_start   = -1,
+      .constant    = nil_value(),
+      .type        = type,
+      .number      = -1,
+      .replacement = ir->value_count,
+      .is_live     = false,
+  };
+  IR_ARRAY_PUSH(ir->values, ir->value_count, ir->value_capacity, value);
+  return ir->value_count - 1;
+}
+
+int ir_resolve(IrFunction* ir, int value) {
+  while (ir->values[value].replacement != value) {
+    value = ir->values[value].replacement;
+  }
+  return value;
+}
+
+static IrType type_of(IrFunction* ir, int value) {
+  return ir->values[ir_resolve(ir, value)].type;
+}
+
+static IrType constant_type(Value value) {
+  if (is_nil(value)) {
+    return IR_TYPE_NIL;
+  }
+  if (is_bool(value)) {
+    return IR_TYPE_BOOL;
+  }
+  if (is_int(value)) {
+    return IR_TYPE_INT;
+  }
+  if (is_float(value)) {
+    return IR_TYPE_FLOAT;
+  }
+  if (is_str(value)) {
+    return IR_TYPE_STR;
+  }
+  return IR_TYPE_OTHER;
+}
+
+// Determines whether the constants [a] and [b] are the same value. Unlike __equals, 1 and 1.0 are different values.
+static bool is_same_constant(Value a, Value b) {
+  if (value_type(a) != value_type(b)) {
+    return false;
+  }
+  if (is_nil(a)) {
+    return true;
+  }
+  if (is_bool(a)) {
+    return AS_BOOL(a) == AS_BOOL(b);
+  }
+  if (is_int(a)) {
+    return AS_INT(a) == AS_INT(b);
+  }
+  if (is_float(a)) {
+    SLANG_TYPE_FLOAT fa = AS_FLOAT(a);
+    SLANG_TYPE_FLOAT fb = AS_FLOAT(b);
+    return memcmp(&fa, &fb, sizeof(fa)) == 0;
+  }
+  return AS_OBJ(a) == AS_OBJ(b);
+}
+
+//
+// Control flow graph
+//
+
+static bool is_terminator(OpCode op) {
+  switch (op) {
+    case OP_RETURN:
+    case OP_RETURN_LOCAL:
+    case OP_RETURN_NIL:
+    case OP_THROW:
+    case OP_TAIL_CALL:
+    case OP_TAIL_INVOKE: return true;
+    default: return false;
+  }
+}
+
+// Returns the offset the branch at [offset] jumps to, or -1 if the instruction is not a branch.
+static int branch_target(Chunk* chunk, int offset) {
+  OpCode op   = (OpCode)chunk->code[offset];
+  int next    = offset + chunk_instruction_length(chunk, offset);
+  int operand = chunk_jump_operand(op);
+  if (operand > 0) {
+    return next + chunk->code[offset + operand];
+  }
+  return op == OP_LOOP ? next - chunk->code[offset + 1] : -1;
+}
+
+static bool is_volatile(IrFunction* ir, int slot) {
+  return slot < ir->slot_count && ir->is_volatile[slot];
+}
+
+// Splits the chunk into basic blocks and connects them. Block 0 is an empty block which stands for the entry of the function, so
+// that the first real block can have predecessors - e.g. if the function starts with a loop. Returns false if the chunk contains
+// something the IR does not model.
+static bool build_blocks(IrFunction* ir) {
+  Chunk* chunk  = ir->chunk;
+  ir->is_leader = calloc((size_t)chunk->count + 1, sizeof(bool));
+
+  int max_captured = -1;
+  for (int offset = 0; offset < chunk->count;) {
+    int length = chunk_instruction_length(chunk, offset);
+    if (length < 0) {
+      return false;
+    }
+
+    OpCode op  = (OpCode)chunk->code[offset];
+    int target = branch_target(chunk, offset);
+    if (target > chunk->count) {
+      return false;
+    }
+    if (target >= 0) {
+      ir->is_leader[target] = true;
+    }
+    if (target >= 0 || is_terminator(op)) {
+      ir->is_leader[offset + length] = true;
+    }
+    if (op == OP_CLOSURE) {
+      for (int i = offset + 2; i < offset + length; i += 2) {
+        if (chunk->code[i] && chunk->code[i + 1] > max_captured) {
+          max_captured = chunk->code[i + 1];
+        }
+      }
+    }
+    offset += length;
+  }
+
+  ir->slot_count  = max_captured + 1;
+  ir->is_volatile = calloc((size_t)ir->slot_count + 1, sizeof(bool));
+  for (int offset = 0; offset < chunk->count; offset += chunk_instruction_length(chunk, offset)) {
+    if (chunk->code[offset] == OP_CLOSURE) {
+      int length = chunk_instruction_length(chunk, offset);
+      for (int i = offset + 2; i < offset + length; i += 2) {
+        if (chunk->code[i]) {
+          ir->is_volatile[chunk->code[i + 1]] = true;
+        }
+      }
+    }
+  }
+
+  // The blocks, in the order of their offsets.
+  int* block_at = malloc(sizeof(int) * ((size_t)chunk->count + 1));
+  IrBlock entry = {.start = 0, .end = 0, .succs = {1, -1}, .depth = -1, .order = -1};
+  IR_ARRAY_PUSH(ir->blocks, ir->block_count, ir->block_capacity, entry);
+  ir->is_leader[0] = true;
+  for (int offset = 0; offset < chunk->count; offset++) {
+    if (ir->is_leader[offset]) {
+      IrBlock block = {.start = offset, .succs = {-1, -1}, .depth = -1, .order = -1};
+      IR_ARRAY_PUSH(ir->blocks, ir->block_count, ir->block_capacity, block);
+    }
+    block_at[offset] = ir->block_count - 1;
+  }
+  block_at[chunk->count] = -1;
+
+  bool ok = true;
+  for (int b = 1; b < ir->block_count; b++) {
+    IrBlock* block = &ir->blocks[b];
+    block->end     = b + 1 < ir->block_count ? ir->blocks[b + 1].start : chunk->count;
+
+    int last = block->start;
+    while (last + chunk_instruction_length(chunk, last) < block->end) {
+      last += chunk_instruction_length(chunk, last);
+    }
+
+    OpCode op     = (OpCode)chunk->code[last];
+    int target    = branch_target(chunk, last);
+    bool falls    = !is_terminator(op) && op != OP_JUMP && op != OP_LOOP;
+    ok            = ok && (!falls || block->end < chunk->count);
+    block->succs[IR_EDGE_FALL]   = falls && block->end < chunk->count ? block_at[block->end] : -1;
+    block->succs[IR_EDGE_BRANCH] = target >= 0 && target < chunk->count ? block_at[target] : -1;
+    ok                           = ok && (target < 0 || target < chunk->count);
+  }
+  free(block_at);
+  if (!ok) {
+    return false;
+  }
+
+  // Predecessors are stored as edges: The index of the predecessor times two, plus the edge it comes along.
+  for (int b = 0; b < ir->block_count; b++) {
+    ir->blocks[b].pred_start = ir->pred_count;
+    for (int p = 0; p < ir->block_count; p++) {
+      for (int edge = 0; edge < 2; edge++) {
+        if (ir->blocks[p].succs[edge] == b) {
+          IR_ARRAY_PUSH(ir->preds, ir->pred_count, ir->pred_capacity, p * 2 + edge);
+        }
+      }
+    }
+    ir->blocks[b].pred_count = ir->pred_count - ir->blocks[b].pred_start;
+  }
+
+  return true;
+}
+
+// Orders the blocks which are reachable from the entry in reverse postorder, so that each block comes after its predecessors -
+// except for those it's reached from along a back edge.
+static void order_blocks(IrFunction* ir) {
+  int* stack    = malloc(sizeof(int) * (size_t)ir->block_count * 3);
+  bool* visited = calloc((size_t)ir->block_count, sizeof(bool));
+  int* post     = malloc(sizeof(int) * (size_t)ir->block_count);
+  int post_count = 0;
+  int top        = 0;
+
+  stack[top++] = 0;
+  stack[top++] = 0;  // Next successor edge to visit.
+  visited[0]   = true;
+  while (top > 0) {
+    int block = stack[top - 2];
+    int edge  = stack[top - 1];
+    if (edge == 2) {
+      post[post_count++] = block;
+      top -= 2;
+      continue;
+    }
+
+    stack[top - 1] = edge + 1;
+    int succ       = ir->blocks[block].succs[edge];
+    if (succ >= 0 && !visited[succ]) {
+      visited[succ] = true;
+      stack[top++]  = succ;
+      stack[top++]  = 0;
+    }
+  }
+
+  ir->rpo       = malloc(sizeof(int) * (size_t)(post_count + 1));
+  ir->rpo_count = post_count;
+  for (int i = 0; i < post_count; i++) {
+    ir->rpo[i]                    = post[post_count - 1 - i];
+    ir->blocks[ir->rpo[i]].order = i;
+  }
+
+  free(stack);
+  free(visited);
+  free(post);
+}
+
+//
+// Abstract interpretation
+//
+
+static void state_push(IrState* state, int value) {
+  IR_ARRAY_PUSH(state->slots, state->depth, state->capacity, value);
+}
+
+static void input(IrTransfer* t, int value) {
+  IR_ARRAY_PUSH(t->inputs, t->input_count, t->input_capacity, value);
+}
+
+static int peek(IrTransfer* t, int distance) {
+  if (distance >= t->state->depth) {
+    t->failed = true;
+    return 0;
+  }
+  return t->state->slots[t->state->depth - 1 - distance];
+}
+
+// Pops a value the instruction reads.
+static int pop_input(IrTransfer* t) {
+  int value = peek(t, 0);
+  if (!t->failed) {
+    t->state->depth--;
+    t->pops++;
+    input(t, value);
+  }
+  return value;
+}
+
+// Pops a value the instruction discards, without reading it.
+static int pop_discard(IrTransfer* t) {
+  int value = peek(t, 0);
+  if (!t->failed) {
+    t->state->depth--;
+    t->pops++;
+  }
+  return value;
+}
+
+static void pop_inputs(IrTransfer* t, int count) {
+  for (int i = 0; i < count; i++) {
+    pop_input(t);
+  }
+}
+
+static void push(IrTransfer* t, int value) {
+  state_push(t->state, value);
+  IR_ARRAY_PUSH(t->outputs, t->output_count, t->output_capacity, value);
+}
+
+static int read_slot(IrTransfer* t, int slot) {
+  if (slot >= t->state->depth) {
+    t->failed = true;
+    return 0;
+  }
+  return t->state->slots[slot];
+}
+
+static void write_slot(IrTransfer* t, int slot, int value) {
+  if (slot >= t->state->depth) {
+    t->failed = true;
+    return;
+  }
+  t->state->slots[slot] = value;
+  IR_ARRAY_PUSH(t->writes, t->write_count, t->write_capacity, slot);
+  IR_ARRAY_PUSH(t->writes, t->write_count, t->write_capacity, value);
+}
+
+static int opaque(IrTransfer* t, IrType type) {
+  return new_value(t->ir, IR_VALUE_OPAQUE, t->block, t->offset, type);
+}
+
+static int constant(IrTransfer* t, Value value) {
+  int result                      = new_value(t->ir, IR_VALUE_CONSTANT, t->block, t->offset, constant_type(value));
+  t->ir->values[result].constant = value;
+  return result;
+}
+
+static int op_value(IrTransfer* t, OpCode op, int a, int b) {
+  int result                         = new_value(t->ir, IR_VALUE_OP, t->block, t->offset, IR_TYPE_NONE);
+  t->ir->values[result].op          = op;
+  t->ir->values[result].operands[0] = a;
+  t->ir->values[result].operands[1] = b;
+  return result;
+}
+
+// Pushes the value of a local. The value of a captured local is unknown, a closure might have written it.
+static void push_local(IrTransfer* t, int slot) {
+  int value = read_slot(t, slot);
+  push(t, is_volatile(t->ir, slot) ? opaque(t, IR_TYPE_ANY) : value);
+}
+
+// Writes the result of an in-place update of the local in [slot], e.g. OP_INC_LOCAL.
+static void update_local(IrTransfer* t, OpCode op, int slot, Value operand) {
+  int old = read_slot(t, slot);
+  input(t, old);
+  if (is_volatile(t->ir, slot)) {
+    write_slot(t, slot, opaque(t, IR_TYPE_ANY));
+    return;
+  }
+
+  int value                          = op_value(t, op, old, -1);
+  t->ir->values[value].constant     = operand;
+  write_slot(t, slot, value);
+}
+
+// Interprets the instruction at the offset of [t] along [edge], e.g. applies its effect to the state of [t]. The effect of a
+// branch can differ between its edges - OP_FOR_RANGE_NEXT for example pushes a value only if it does not jump.
+static void transfer(IrTransfer* t, int edge) {
+  Chunk* chunk     = t->ir->chunk;
+  uint16_t* code   = chunk->code + t->offset;
+  Value* constants = chunk->constants.values;
+  bool fall        = edge == IR_EDGE_FALL;
+
+  switch ((OpCode)code[0]) {
+    case OP_CONSTANT: push(t, constant(t, constants[code[1]])); break;
+    case OP_NIL: push(t, constant(t, nil_value())); break;
+    case OP_TRUE: push(t, constant(t, bool_value(true))); break;
+    case OP_FALSE: push(t, constant(t, bool_value(false))); break;
+    case OP_POP:
+    case OP_CLOSE_UPVALUE: pop_discard(t); break;
+    case OP_DUPE: push(t, peek(t, code[1])); break;
+    case OP_REUSE: {
+      if (!fall) {
+        push(t, peek(t, code[1]));
+      }
+      break;
+    }
+    case OP_GET_LOCAL: push_local(t, code[1]); break;
+    case OP_GET_LOCAL_GET_LOCAL: {
+      push_local(t, code[1]);
+      push_local(t, code[2]);
+      break;
+    }
+    case OP_SET_LOCAL: {
+      int value = peek(t, 0);
+      if (is_volatile(t->ir, code[1])) {
+        input(t, value);
+        write_slot(t, code[1], opaque(t, IR_TYPE_ANY));
+        break;
+      }
+      int copy                          = new_value(t->ir, IR_VALUE_COPY, t->block, t->offset, IR_TYPE_NONE);
+      t->ir->values[copy].operands[0] = value;
+      write_slot(t, code[1], copy);
+      break;
+    }
+    case OP_GET_GLOBAL_SLOT:
+    case OP_GET_UPVALUE:
+    case OP_IMPORT:
+    case OP_IMPORT_FROM: push(t, opaque(t, IR_TYPE_ANY)); break;
+    case OP_CLASS: push(t, opaque(t, IR_TYPE_OTHER)); break;
+    case OP_DEFINE_GLOBAL_SLOT:
+    case OP_PRINT:
+    case OP_RETURN:
+    case OP_THROW: pop_input(t); break;
+    case OP_SET_GLOBAL_SLOT:
+    case OP_SET_UPVALUE:
+    case OP_FINALIZE:
+    case OP_JUMP_IF_FALSE:
+    case OP_JUMP_IF_TRUE:
+    case OP_JUMP_IF_NOT_NIL: input(t, peek(t, 0)); break;
+    case OP_INHERIT:
+    case OP_METHOD: {
+      pop_input(t);
+      input(t, peek(t, 0));
+      break;
+    }
+    case OP_GET_SUBSCRIPT:
+    case OP_GET_SUBSCRIPT_SAFE:
+    case OP_GET_SUBSCRIPT_SEQ_INT:
+    case OP_GET_SUBSCRIPT_IN_BOUNDS:
+    case OP_EQ:
+    case OP_NEQ:
+    case OP_GT:
+    case OP_LT:
+    case OP_GTEQ:
+    case OP_LTEQ:
+    case OP_ADD:
+    case OP_SUBTRACT:
+    case OP_MULTIPLY:
+    case OP_DIVIDE:
+    case OP_MODULO:
+    case OP_GT_INT_INT:
+    case OP_GT_FLOAT_FLOAT:
+    case OP_LT_INT_INT:
+    case OP_LT_FLOAT_FLOAT:
+    case OP_GTEQ_INT_INT:
+    case OP_GTEQ_FLOAT_FLOAT:
+    case OP_LTEQ_INT_INT:
+    case OP_LTEQ_FLOAT_FLOAT:
+    case OP_ADD_INT_INT:
+    case OP_ADD_FLOAT_FLOAT:
+    case OP_SUBTRACT_INT_INT:
+    case OP_SUBTRACT_FLOAT_FLOAT:
+    case OP_MULTIPLY_INT_INT:
+    case OP_MULTIPLY_FLOAT_FLOAT: {
+      int b = pop_input(t);
+      int a = pop_input(t);
+      push(t, op_value(t, (OpCode)code[0], a, b));
+      break;
+    }
+    case OP_NOT:
+    case OP_NEGATE: push(t, op_value(t, (OpCode)code[0], pop_input(t), -1)); break;
+    case OP_GET_PROPERTY: {
+      int receiver = pop_input(t);
+      bool is_len  = AS_STR(constants[code[1]]) == vm.special_prop_names[SPECIAL_PROP_LEN];
+      push(t, is_len ? op_value(t, OP_GET_PROPERTY, receiver, -1) : opaque(t, IR_TYPE_ANY));  // See infer_op
+      break;
+    }
+    case OP_GET_PROPERTY_SAFE:
+    case OP_GET_PROPERTY_OBJ:
+    case OP_GET_BASE_METHOD: {
+      pop_input(t);
+      push(t, opaque(t, IR_TYPE_ANY));
+      break;
+    }
+    case OP_SET_PROPERTY: {
+      pop_inputs(t, 2);
+      push(t, opaque(t, IR_TYPE_ANY));
+      break;
+    }
+    case OP_SET_SUBSCRIPT:
+    case OP_GET_SLICE:
+    case OP_IN: {
+      pop_inputs(t, 3);
+      push(t, opaque(t, IR_TYPE_ANY));
+      break;
+    }
+    case OP_IS: {
+      pop_inputs(t, 3);
+      push(t, opaque(t, IR_TYPE_BOOL));
+      break;
+    }
+    case OP_JUMP:
+    case OP_LOOP:
+    case OP_RETURN_NIL: break;
+    case OP_EQ_JUMP_IF_FALSE:
+    case OP_NEQ_JUMP_IF_FALSE:
+    case OP_GT_JUMP_IF_FALSE:
+    case OP_LT_JUMP_IF_FALSE:
+    case OP_GTEQ_JUMP_IF_FALSE:
+    case OP_LTEQ_JUMP_IF_FALSE:
+    case OP_LT_LEN_JUMP_IF_FALSE: pop_inputs(t, 2); break;
+    case OP_CALL:
+    case OP_TAIL_CALL: {
+      pop_inputs(t, code[1] + 1);
+      push(t, opaque(t, IR_TYPE_ANY));
+      break;
+    }
+    case OP_INVOKE:
+    case OP_TAIL_INVOKE: {
+      pop_inputs(t, code[2] + 1);
+      push(t, opaque(t, IR_TYPE_ANY));
+      break;
+    }
+    case OP_BASE_INVOKE: {
+      pop_inputs(t, code[2] + 2);
+      push(t, opaque(t, IR_TYPE_ANY));
+      break;
+    }
+    case OP_CALL_INLINED:
+    case OP_INVOKE_INLINED: {
+      // Continues into the inlined body, or makes the regular call and jumps over it.
+      int arg_count = code[0] == OP_CALL_INLINED ? code[1] : code[2];
+      if (fall) {
+        input(t, peek(t, arg_count));
+      } else {
+        pop_inputs(t, arg_count + 1);
+        push(t, opaque(t, IR_TYPE_ANY));
+      }
+      break;
+    }
+    case OP_RETURN_INLINED: {
+      int result = pop_discard(t);
+      for (int i = 0; i <= code[1]; i++) {
+        pop_discard(t);
+      }
+      push(t, result);
+      break;
+    }
+    case OP_CLOSURE: {
+      int length = chunk_instruction_length(chunk, t->offset);
+      for (int i = 2; i < length; i += 2) {
+        if (code[i]) {
+          input(t, read_slot(t, code[i + 1]));
+        }
+      }
+      push(t, opaque(t, IR_TYPE_OTHER));
+      break;
+    }
+    case OP_SEQ_LITERAL:
+    case OP_TUPLE_LITERAL: {
+      pop_inputs(t, code[1]);
+      push(t, opaque(t, code[0] == OP_SEQ_LITERAL ? IR_TYPE_SEQ : IR_TYPE_TUPLE));
+      break;
+    }
+    case OP_OBJECT_LITERAL: {
+      pop_inputs(t, code[1] * 2);
+      push(t, opaque(t, IR_TYPE_OTHER));
+      break;
+    }
+    case OP_RETURN_LOCAL: input(t, read_slot(t, code[1])); break;
+    case OP_INC_LOCAL:
+    case OP_DEC_LOCAL: update_local(t, (OpCode)code[0], code[1], int_value(1)); break;
+    case OP_ADD_LOCAL_CONST: update_local(t, OP_ADD_LOCAL_CONST, code[1], constants[code[2]]); break;
+    case OP_SEQ_LOOP_ENTER: {
+      // [receiver][initial] -> [receiver][acc][count][index] for a fold, [receiver] -> [receiver][acc][count][index] otherwise.
+      if (fall) {
+        if (code[1] == SEQ_LOOP_FOLD) {
+          pop_input(t);
+        }
+        input(t, peek(t, 0));
+        push(t, opaque(t, IR_TYPE_ANY));
+        push(t, opaque(t, IR_TYPE_INT));
+        push(t, opaque(t, IR_TYPE_INT));
+      }
+      break;
+    }
+    case OP_SEQ_LOOP_NEXT: {
+      for (int i = 0; i < 4; i++) {
+        input(t, read_slot(t, code[1] + i));
+      }
+      if (fall) {
+        if (code[2] & SEQ_LOOP_PUSH_ACC) {
+          push(t, opaque(t, IR_TYPE_ANY));
+        }
+        if (code[2] & SEQ_LOOP_PUSH_ITEM) {
+          push(t, opaque(t, IR_TYPE_ANY));
+        }
+        if (code[2] & SEQ_LOOP_PUSH_INDEX) {
+          push(t, opaque(t, IR_TYPE_INT));
+        }
+      }
+      break;
+    }
+    case OP_SEQ_LOOP_STEP: {
+      pop_input(t);
+      for (int i = 0; i < 4; i++) {
+        input(t, read_slot(t, code[2] + i));
+      }
+      write_slot(t, code[2] + 1, opaque(t, IR_TYPE_ANY));
+      write_slot(t, code[2] + 3, opaque(t, IR_TYPE_INT));
+      break;
+    }
+    case OP_SEQ_LOOP_END: {
+      pop_inputs(t, 4);
+      push(t, opaque(t, IR_TYPE_ANY));
+      break;
+    }
+    case OP_FOR_IN_INIT: {
+      input(t, peek(t, 0));
+      push(t, opaque(t, IR_TYPE_INT));
+      break;
+    }
+    case OP_FOR_IN_NEXT: {
+      input(t, read_slot(t, code[1]));
+      input(t, read_slot(t, code[1] + 1));
+      write_slot(t, code[1] + 1, opaque(t, IR_TYPE_INT));
+      if (fall) {
+        for (int i = 0; i < code[2]; i++) {
+          push(t, opaque(t, IR_TYPE_ANY));
+        }
+      }
+      break;
+    }
+    case OP_FOR_RANGE_INIT: {
+      // Makes sure both bounds are TYPENAME_INTs, or throws.
+      pop_inputs(t, 2);
+      push(t, opaque(t, IR_TYPE_INT));
+      push(t, opaque(t, IR_TYPE_INT));
+      break;
+    }
+    case OP_FOR_RANGE_NEXT: {
+      int next = read_slot(t, code[1]);
+      input(t, next);
+      input(t, read_slot(t, code[1] + 1));
+      if (fall) {
+        push(t, next);
+        write_slot(t, code[1], opaque(t, IR_TYPE_INT));
+      }
+      break;
+    }
+    default: t->failed = true; break;
+  }
+}
+
+// Appends [count] entries of [items] to the refs of [ir]. Returns the index of the first one.
+static int add_refs(IrFunction* ir, int* items, int count) {
+  int start = ir->ref_count;
+  for (int i = 0; i < count; i++) {
+    IR_ARRAY_PUSH(ir->refs, ir->ref_count, ir->ref_capacity, items[i]);
+  }
+  return start;
+}
+
+static void record_instr(IrTransfer* t) {
+  IrInstr instr = {
+      .offset       = t->offset,
+      .pops         = t->pops,
+      .input_start  = add_refs(t->ir, t->inputs, t->input_count),
+      .input_count  = t->input_count,
+      .output_start = add_refs(t->ir, t->outputs, t->output_count),
+      .output_count = t->output_count,
+      .write_start  = add_refs(t->ir, t->writes, t->write_count),
+      .write_count  = t->write_count / 2,
+  };
+  IR_ARRAY_PUSH(t->ir->instrs, t->ir->instr_count, t->ir->instr_capacity, instr);
+}
+
+// Sets up the state at the start of [block]. Blocks with a single predecessor which was already interpreted continue with its
+// state, all others start with a phi for each slot. Returns false if the stack depths of the predecessors don't agree.
+static bool enter_block(IrFunction* ir, int b, IrState* state) {
+  IrBlock* block = &ir->blocks[b];
+  int known      = -1;  // An edge from a predecessor that was already interpreted.
+  int reachable  = 0;
+  for (int i = 0; i < block->pred_count; i++) {
+    int edge = ir->preds[block->pred_start + i];
+    int pred = edge / 2;
+    if (ir->blocks[pred].order < 0) {
+      continue;
+    }
+    reachable++;
+    if (ir->blocks[pred].order < block->order) {
+      known = edge;
+    }
+  }
+  if (known < 0) {
+    return false;
+  }
+
+  IrBlock* pred = &ir->blocks[known / 2];
+  block->depth  = pred->exit_depths[known % 2];
+  state->depth  = 0;
+  for (int slot = 0; slot < block->depth; slot++) {
+    int value = ir->refs[pred->exits[known % 2] + slot];
+    state_push(state, reachable == 1 ? value : new_value(ir, IR_VALUE_PHI, b, -1, IR_TYPE_NONE));
+  }
+  block->entry = add_refs(ir, state->slots, state->depth);
+  return true;
+}
+
+// Interprets the instructions of [block], recording their effects and the states along both edges out of the block.
+static bool interpret_block(IrFunction* ir, int b, IrState* state, IrState* branch_state, IrTransfer* t) {
+  IrBlock* block     = &ir->blocks[b];
+  block->instr_start = ir->instr_count;
+
+  for (int offset = block->start; offset < block->end; offset += chunk_instruction_length(ir->chunk, offset)) {
+    bool is_last = offset + chunk_instruction_length(ir->chunk, offset) >= block->end;
+    bool forks   = is_last && block->succs[IR_EDGE_BRANCH] >= 0;
+
+    if (forks) {
+      branch_state->depth = 0;
+      for (int i = 0; i < state->depth; i++) {
+        state_push(branch_state, state->slots[i]);
+      }
+      *t = (IrTransfer){.ir = ir, .state = branch_state, .block = b, .offset = offset, .inputs = t->inputs,
+                        .input_capacity = t->input_capacity, .outputs = t->outputs, .output_capacity = t->output_capacity,
+                        .writes = t->writes, .write_capacity = t->write_capacity};
+      transfer(t, IR_EDGE_BRANCH);
+      if (t->failed) {
+        return false;
+      }
+      block->exits[IR_EDGE_BRANCH]       = add_refs(ir, branch_state->slots, branch_state->depth);
+      block->exit_depths[IR_EDGE_BRANCH] = branch_state->depth;
+    }
+
+    *t = (IrTransfer){.ir = ir, .state = state, .block = b, .offset = offset, .inputs = t->inputs,
+                      .input_capacity = t->input_capacity, .outputs = t->outputs, .output_capacity = t->output_capacity,
+                      .writes = t->writes, .write_capacity = t->write_capacity};
+    transfer(t, IR_EDGE_FALL);
+    if (t->failed) {
+      return false;
+    }
+    record_instr(t);
+  }
+
+  block->instr_count             = ir->instr_count - block->instr_start;
+  block->exits[IR_EDGE_FALL]       = add_refs(ir, state->slots, state->depth);
+  block->exit_depths[IR_EDGE_FALL] = state->depth;
+  return true;
+}
+
+// Connects the phis at the start of each block with the values of the slots at the end of its predecessors.
+static bool connect_phis(IrFunction* ir) {
+  for (int b = 1; b < ir->block_count; b++) {
+    IrBlock* block = &ir->blocks[b];
+    if (block->order < 0) {
+      continue;
+    }
+
+    for (int slot = 0; slot < block->depth; slot++) {
+      int phi = ir->refs[block->entry + slot];
+      if (ir->values[phi].kind != IR_VALUE_PHI || ir->values[phi].block != b) {
+        break;  // A block either starts with phis for all slots, or with none.
+      }
+      ir->values[phi].phi_start = ir->phi_operand_count;
+      for (int i = 0; i < block->pred_count; i++) {
+        int edge       = ir->preds[block->pred_start + i];
+        IrBlock* pred  = &ir->blocks[edge / 2];
+        if (pred->order < 0) {
+          continue;
+        }
+        if (pred->exit_depths[edge % 2] != block->depth) {
+          return false;
+        }
+        int operand = ir->refs[pred->exits[edge % 2] + slot];
+        IR_ARRAY_PUSH(ir->phi_operands, ir->phi_operand_count, ir->phi_operand_capacity, operand);
+      }
+    }
+  }
+  return true;
+}
+
+// Returns the number of operands of [phi], e.g. the number of reachable edges into its block.
+static int phi_operand_count(IrFunction* ir, IrValue* phi) {
+  IrBlock* block = &ir->blocks[phi->block];
+  int count      = 0;
+  for (int i = 0; i < block->pred_count; i++) {
+    count += ir->blocks[ir->preds[block->pred_start + i] / 2].order >= 0 ? 1 : 0;
+  }
+  return count;
+}
+
+IrFunction* ir_build(ObjFunction* function) {
+  IrFunction* ir = calloc(1, sizeof(IrFunction));
+  ir->chunk      = &function->chunk;
+  ir->arity      = function->arity;
+
+  if (ir->chunk->try_count > 0 || ir->chunk->count == 0 || !build_blocks(ir)) {
+    ir_free(ir);
+    return NULL;
+  }
+  order_blocks(ir);
+
+  // The entry block holds the callee and the arguments.
+  IrBlock* entry = &ir->blocks[0];
+  entry->depth   = ir->arity + 1;
+  int* params    = malloc(sizeof(int) * (size_t)entry->depth);
+  for (int slot = 0; slot < entry->depth; slot++) {
+    params[slot] = new_value(ir, IR_VALUE_PARAM, 0, -1, IR_TYPE_ANY);
+  }
+  entry->entry                     = add_refs(ir, params, entry->depth);
+  entry->exits[IR_EDGE_FALL]       = entry->entry;
+  entry->exit_depths[IR_EDGE_FALL] = entry->depth;
+  entry->instr_start               = 0;
+  free(params);
+
+  IrState state        = {0};
+  IrState branch_state = {0};
+  IrTransfer t         = {0};
+  bool ok              = true;
+  for (int i = 1; i < ir->rpo_count && ok; i++) {
+    ok = enter_block(ir, ir->rpo[i], &state) && interpret_block(ir, ir->rpo[i], &state, &branch_state, &t);
+  }
+  ok = ok && connect_phis(ir);
+
+  free(state.slots);
+  free(branch_state.slots);
+  free(t.inputs);
+  free(t.outputs);
+  free(t.writes);
+  if (!ok) {
+    ir_free(ir);
+    return NULL;
+  }
+  return ir;
+}
+
+void ir_free(IrFunction* ir) {
+  free(ir->blocks);
+  free(ir->rpo);
+  free(ir->instrs);
+  free(ir->values);
+  free(ir->refs);
+  free(ir->preds);
+  free(ir->phi_operands);
+  free(ir->is_leader);
+  free(ir->is_volatile);
+  free(ir);
+}
+
+//
+// Passes
+//
+
+// Copy propagation: Replaces phis which merge a single value - or only themselves, along back edges - with that value. Removing
+// one can make others trivial, so this is repeated until nothing changes. Reads of locals are no instructions of their own, they
+// refer to the value that was stored, so they are propagated by construction.
+static void propagate_copies(IrFunction* ir) {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int v = 0; v < ir->value_count; v++) {
+      IrValue* phi = &ir->values[v];
+      if (phi->kind != IR_VALUE_PHI || phi->replacement != v) {
+        continue;
+      }
+
+      int same  = -1;
+      int count = phi_operand_count(ir, phi);
+      for (int i = 0; i < count && same != -2; i++) {
+        int operand = ir_resolve(ir, ir->phi_operands[phi->phi_start + i]);
+        if (operand == v || operand == same) {
+          continue;
+        }
+        same = same == -1 ? operand : -2;
+      }
+      if (same >= 0) {
+        phi->replacement = same;
+        changed          = true;
+      }
+    }
+  }
+}
+
+// Returns the type of the result of [op] on operands of the types [a] and [b], exactly like the Vm computes it. Anything that's
+// left to a special method might return anything.
+static IrType infer_op(OpCode op, IrType a, IrType b) {
+  bool ints   = (a & ~IR_TYPE_INT) == 0 && (b & ~IR_TYPE_INT) == 0;
+  bool nums   = (a & ~IR_TYPE_NUM) == 0 && (b & ~IR_TYPE_NUM) == 0;
+  bool floats = nums && ((a & ~IR_TYPE_FLOAT) == 0 || (b & ~IR_TYPE_FLOAT) == 0);
+
+  switch (op) {
+    case OP_ADD:
+    case OP_ADD_INT_INT:
+    case OP_ADD_FLOAT_FLOAT:
+    case OP_ADD_LOCAL_CONST:
+      if (op != OP_ADD_LOCAL_CONST && (a & ~IR_TYPE_STR) == 0 && (b & ~IR_TYPE_STR) == 0) {
+        return IR_TYPE_STR;
+      }
+      // Fallthrough
+    case OP_SUBTRACT:
+    case OP_SUBTRACT_INT_INT:
+    case OP_SUBTRACT_FLOAT_FLOAT:
+    case OP_MULTIPLY:
+    case OP_MULTIPLY_INT_INT:
+    case OP_MULTIPLY_FLOAT_FLOAT:
+    case OP_INC_LOCAL:
+    case OP_DEC_LOCAL:
+    case OP_MODULO: return ints ? IR_TYPE_INT : floats ? IR_TYPE_FLOAT : nums ? IR_TYPE_NUM : IR_TYPE_ANY;
+    case OP_DIVIDE: return nums ? IR_TYPE_FLOAT : IR_TYPE_ANY;
+    case OP_GT:
+    case OP_LT:
+    case OP_GTEQ:
+    case OP_LTEQ:
+    case OP_GT_INT_INT:
+    case OP_GT_FLOAT_FLOAT:
+    case OP_LT_INT_INT:
+    case OP_LT_FLOAT_FLOAT:
+    case OP_GTEQ_INT_INT:
+    case OP_GTEQ_FLOAT_FLOAT:
+    case OP_LTEQ_INT_INT:
+    case OP_LTEQ_FLOAT_FLOAT: return nums ? IR_TYPE_BOOL : IR_TYPE_ANY;
+    case OP_EQ:
+    case OP_NEQ:
+    case OP_NOT: return IR_TYPE_BOOL;
+    case OP_NEGATE: return (a & ~IR_TYPE_INT) == 0 ? IR_TYPE_INT : (a & ~IR_TYPE_FLOAT) == 0 ? IR_TYPE_FLOAT : IR_TYPE_NUM;
+    case OP_GET_PROPERTY: return (a & ~(IR_TYPE_STR | IR_TYPE_SEQ | IR_TYPE_TUPLE)) == 0 ? IR_TYPE_INT : IR_TYPE_ANY;  // .len
+    default: return IR_TYPE_ANY;
+  }
+}
+
+// Type propagation: Computes the set of types each value might have. Starts out optimistic - a phi has no type until one of its
+// operands has one - and widens the types until nothing changes, so that loop counters stay TYPENAME_INTs.
+static void propagate_types(IrFunction* ir) {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int v = 0; v < ir->value_count; v++) {
+      IrValue* value = &ir->values[v];
+      if (value->replacement != v) {
+        continue;
+      }
+
+      IrType type = value->type;
+      switch (value->kind) {
+        case IR_VALUE_COPY: type |= type_of(ir, value->operands[0]); break;
+        case IR_VALUE_PHI: {
+          int count = phi_operand_count(ir, value);
+          for (int i = 0; i < count; i++) {
+            type |= type_of(ir, ir->phi_operands[value->phi_start + i]);
+          }
+          break;
+        }
+        case IR_VALUE_OP: {
+          IrType a = type_of(ir, value->operands[0]);
+          IrType b = value->operands[1] >= 0 ? type_of(ir, value->operands[1]) : constant_type(value->constant);
+          if (a != IR_TYPE_NONE) {
+            type |= infer_op(value->op, a, b);
+          }
+          break;
+        }
+        default: break;
+      }
+
+      if (type != value->type) {
+        value->type = type;
+        changed     = true;
+      }
+    }
+  }
+}
+
+// Determines whether evaluating the IR_VALUE_OP [value] has no side effects and can't throw, given the types of its operands.
+// Anything that might be left to a special method, which might run user code, is not.
+static bool is_pure_op(IrFunction* ir, IrValue* value) {
+  IrType a = type_of(ir, value->operands[0]);
+  IrType b = value->operands[1] >= 0 ? type_of(ir, value->operands[1]) : IR_TYPE_NONE;
+  bool nums = a != IR_TYPE_NONE && (a & ~IR_TYPE_NUM) == 0 && (b & ~IR_TYPE_NUM) == 0 &&
+              (value->operands[1] < 0 || b != IR_TYPE_NONE);
+  IrType primitive = IR_TYPE_NIL | IR_TYPE_BOOL | IR_TYPE_NUM | IR_TYPE_STR;
+
+  switch (value->op) {
+    case OP_ADD:
+    case OP_ADD_INT_INT:
+    case OP_ADD_FLOAT_FLOAT:
+    case OP_SUBTRACT:
+    case OP_SUBTRACT_INT_INT:
+    case OP_SUBTRACT_FLOAT_FLOAT:
+    case OP_MULTIPLY:
+    case OP_MULTIPLY_INT_INT:
+    case OP_MULTIPLY_FLOAT_FLOAT:
+    case OP_GT:
+    case OP_LT:
+    case OP_GTEQ:
+    case OP_LTEQ:
+    case OP_GT_INT_INT:
+    case OP_GT_FLOAT_FLOAT:
+    case OP_LT_INT_INT:
+    case OP_LT_FLOAT_FLOAT:
+    case OP_GTEQ_INT_INT:
+    case OP_GTEQ_FLOAT_FLOAT:
+    case OP_LTEQ_INT_INT:
+    case OP_LTEQ_FLOAT_FLOAT:
+    case OP_NEGATE: return nums;
+    case OP_EQ:
+    case OP_NEQ: return a != IR_TYPE_NONE && b != IR_TYPE_NONE && (a & ~primitive) == 0 && (b & ~primitive) == 0;
+    case OP_NOT: return true;
+    default: return false;
+  }
+}
+
+// Maps the specialized variants of an opcode to the generic one, so that they get the same value number.
+static OpCode generic_op(OpCode op) {
+  switch (op) {
+    case OP_ADD_INT_INT:
+    case OP_ADD_FLOAT_FLOAT: return OP_ADD;
+    case OP_SUBTRACT_INT_INT:
+    case OP_SUBTRACT_FLOAT_FLOAT: return OP_SUBTRACT;
+    case OP_MULTIPLY_INT_INT:
+    case OP_MULTIPLY_FLOAT_FLOAT: return OP_MULTIPLY;
+    case OP_GT_INT_INT:
+    case OP_GT_FLOAT_FLOAT: return OP_GT;
+    case OP_LT_INT_INT:
+    case OP_LT_FLOAT_FLOAT: return OP_LT;
+    case OP_GTEQ_INT_INT:
+    case OP_GTEQ_FLOAT_FLOAT: return OP_GTEQ;
+    case OP_LTEQ_INT_INT:
+    case OP_LTEQ_FLOAT_FLOAT: return OP_LTEQ;
+    default: return op;
+  }
+}
+
+// Entry of the hash table number_values looks values up in. Keyed on the constant of an IR_VALUE_CONSTANT, or on the generic
+// opcode and the operand numbers of an IR_VALUE_OP.
+typedef struct {
+  int value;  // The first value with the key, -1 if the entry is empty.
+  int op;     // Generic opcode of an IR_VALUE_OP, -1 for a constant.
+  int a;      // Operand numbers of an IR_VALUE_OP.
+  int b;      //
+} IrNumbering;
+
+static uint32_t hash_bits(uint64_t bits) {
+  bits ^= bits >> 33;
+  bits *= 0xff51afd7ed558ccdULL;
+  bits ^= bits >> 33;
+  return (uint32_t)bits;
+}
+
+// Hashes a constant consistently with is_same_constant.
+static uint32_t hash_constant(Value value) {
+  uint64_t bits = 0;
+  if (is_bool(value)) {
+    bits = AS_BOOL(value);
+  } else if (is_int(value)) {
+    bits = (uint64_t)AS_INT(value);
+  } else if (is_float(value)) {
+    SLANG_TYPE_FLOAT float_ = AS_FLOAT(value);
+    memcpy(&bits, &float_, sizeof(bits));
+  } else if (!is_nil(value)) {
+    bits = (uint64_t)(uintptr_t)AS_OBJ(value);
+  }
+  return hash_bits(bits ^ (uint64_t)(uintptr_t)value_type(value));
+}
+
+// Returns the entry of [table] (with [capacity] entries, a power of two) which holds the value with the key of [value] - or the
+// empty entry where it belongs. [op], [a] and [b] are the key of an IR_VALUE_OP.
+static IrNumbering* find_numbering(IrFunction* ir, IrNumbering* table, int capacity, IrValue* value, int op, int a, int b) {
+  uint32_t hash = value->kind == IR_VALUE_CONSTANT ? hash_constant(value->constant)
+                                                   : hash_bits(((uint64_t)(uint32_t)op << 48) ^ ((uint64_t)(uint32_t)a << 24) ^
+                                                               (uint64_t)(uint32_t)b);
+  for (uint32_t i = hash & (uint32_t)(capacity - 1);; i = (i + 1) & (uint32_t)(capacity - 1)) {
+    IrNumbering* entry = &table[i];
+    if (entry->value < 0) {
+      return entry;
+    }
+    if (value->kind == IR_VALUE_CONSTANT ? entry->op < 0 && is_same_constant(ir->values[entry->value].constant, value->constant)
+                                         : entry->op == op && entry->a == a && entry->b == b) {
+      return entry;
+    }
+  }
+}
+
+// Global value numbering: Gives equal values the same number. Constants are equal if they are the same value, pure operations if
+// they apply the same operator to operands with the same numbers. Copies have the number of their source. Everything else -
+// phis included - gets a number of its own. Since the IR is in SSA form, values with the same number are equal wherever both are
+// available. Equal values are found through a hash table, so that large functions don't take quadratic time.
+static void number_values(IrFunction* ir) {
+  int capacity = 8;
+  while (capacity < ir->value_count * 2) {
+    capacity *= 2;
+  }
+  IrNumbering* table = malloc(sizeof(IrNumbering) * (size_t)capacity);
+  for (int i = 0; i < capacity; i++) {
+    table[i].value = -1;
+  }
+
+  for (int v = 0; v < ir->value_count; v++) {
+    IrValue* value = &ir->values[v];
+    value->number  = v;
+    if (value->replacement != v) {
+      continue;
+    }
+
+    switch (value->kind) {
+      case IR_VALUE_COPY: value->number = ir->values[ir_resolve(ir, value->operands[0])].number; break;
+      case IR_VALUE_CONSTANT: {
+        IrNumbering* entry = find_numbering(ir, table, capacity, value, -1, -1, -1);
+        if (entry->value >= 0) {
+          value->number = ir->values[entry->value].number;
+        } else {
+          *entry = (IrNumbering){.value = v, .op = -1, .a = -1, .b = -1};
+        }
+        break;
+      }
+      case IR_VALUE_OP: {
+        if (!is_pure_op(ir, value)) {
+          break;
+        }
+        OpCode op = generic_op(value->op);
+        int a     = ir->values[ir_resolve(ir, value->operands[0])].number;
+        int b     = value->operands[1] >= 0 ? ir->values[ir_resolve(ir, value->operands[1])].number : -1;
+        if ((op == OP_ADD || op == OP_MULTIPLY || op == OP_EQ || op == OP_NEQ) && b >= 0 && b < a) {
+          int swap = a;  // Commutative, since the operands are numbers (or primitives, for equality).
+          a        = b;
+          b        = swap;
+        }
+
+        IrNumbering* entry = find_numbering(ir, table, capacity, value, (int)op, a, b);
+        if (entry->value >= 0) {
+          value->number = entry->value;
+        } else {
+          *entry = (IrNumbering){.value = v, .op = (int)op, .a = a, .b = b};
+        }
+        break;
+      }
+      default: break;
+    }
+  }
+
+  free(table);
+}
+
+// Dead code elimination, the analysis part: Marks the values which are read by an instruction, and those which flow into them
+// through copies and phis. Popping a value or reading it into another slot does not count - those just pass it on.
+static void mark_live(IrFunction* ir) {
+  int* worklist = malloc(sizeof(int) * (size_t)(ir->value_count + 1));
+  int count     = 0;
+
+  for (int i = 0; i < ir->instr_count; i++) {
+    IrInstr* instr = &ir->instrs[i];
+    for (int j = 0; j < instr->input_count; j++) {
+      int value = ir_resolve(ir, ir->refs[instr->input_start + j]);
+      if (!ir->values[value].is_live) {
+        ir->values[value].is_live = true;
+        worklist[count++]         = value;
+      }
+    }
+  }
+
+  while (count > 0) {
+    IrValue* value = &ir->values[worklist[--count]];
+    int operands   = value->kind == IR_VALUE_PHI ? phi_operand_count(ir, value) : value->kind == IR_VALUE_COPY ? 1 : 0;
+    for (int i = 0; i < operands; i++) {
+      int operand = ir_resolve(ir, value->kind == IR_VALUE_PHI ? ir->phi_operands[value->phi_start + i] : value->operands[0]);
+      if (!ir->values[operand].is_live) {
+        ir->values[operand].is_live = true;
+        worklist[count++]           = operand;
+      }
+    }
+  }
+
+  free(worklist);
+}
+
+//
+// Lowering
+//
+
+// A value on the stack during lowering, and the instructions that computed it - if they are a pure expression tree.
+typedef struct {
+  int value;
+  int start;  // Offset of the first instruction of the tree, -1 if the value was not computed by a pure tree within the block.
+  int end;    // Offset past the last instruction of the tree.
+} IrEntry;
+
+// Returns the specialized variant of the generic [op] for operands of the types [a] and [b], or [op] itself.
+static OpCode specialize(OpCode op, IrType a, IrType b) {
+  bool ints   = a != IR_TYPE_NONE && b != IR_TYPE_NONE && (a & ~IR_TYPE_INT) == 0 && (b & ~IR_TYPE_INT) == 0;
+  bool floats = a != IR_TYPE_NONE && b != IR_TYPE_NONE && (a & ~IR_TYPE_FLOAT) == 0 && (b & ~IR_TYPE_FLOAT) == 0;
+  if (!ints && !floats) {
+    return op == OP_GET_SUBSCRIPT && a == IR_TYPE_SEQ && b == IR_TYPE_INT ? OP_GET_SUBSCRIPT_SEQ_INT : op;
+  }
+
+  switch (op) {
+    case OP_ADD: return ints ? OP_ADD_INT_INT : OP_ADD_FLOAT_FLOAT;
+    case OP_SUBTRACT: return ints ? OP_SUBTRACT_INT_INT : OP_SUBTRACT_FLOAT_FLOAT;
+    case OP_MULTIPLY: return ints ? OP_MULTIPLY_INT_INT : OP_MULTIPLY_FLOAT_FLOAT;
+    case OP_GT: return ints ? OP_GT_INT_INT : OP_GT_FLOAT_FLOAT;
+    case OP_LT: return ints ? OP_LT_INT_INT : OP_LT_FLOAT_FLOAT;
+    case OP_GTEQ: return ints ? OP_GTEQ_INT_INT : OP_GTEQ_FLOAT_FLOAT;
+    case OP_LTEQ: return ints ? OP_LTEQ_INT_INT : OP_LTEQ_FLOAT_FLOAT;
+    default: return op;
+  }
+}
+
+// Determines whether the instruction [op] is part of a pure expression tree, e.g. it pushes a value computed from the values it
+// pops - and nothing else. [result] is the value it pushes.
+static bool is_pure_instr(IrFunction* ir, OpCode op, int result) {
+  switch (op) {
+    case OP_CONSTANT:
+    case OP_NIL:
+    case OP_TRUE:
+    case OP_FALSE:
+    case OP_DUPE:
+    case OP_GET_LOCAL: return true;
+    default: {
+      IrValue* value = &ir->values[ir_resolve(ir, result)];
+      return value->kind == IR_VALUE_OP && value->offset >= 0 && is_pure_op(ir, value);
+    }
+  }
+}
+
+// Returns the offset of the first code unit at or after [offset] which has not been removed.
+static int skip_removed(bool* removed, int offset, int end) {
+  while (offset < end && removed[offset]) {
+    offset++;
+  }
+  return offset;
+}
+
+// Lowers the results of the passes into the instructions of [block], see ir_optimize. Marks removed code units in [removed].
+// Returns true if anything changed.
+static bool lower_block(IrFunction* ir, IrBlock* block, bool* removed, IrEntry** stack, int* capacity) {
+  uint16_t* code = ir->chunk->code;
+  bool changed   = false;
+
+  if (*capacity < block->depth + 1) {
+    *capacity = block->depth + 1;
+    *stack    = realloc(*stack, sizeof(IrEntry) * (size_t)*capacity);
+  }
+  int depth = 0;
+  for (int slot = 0; slot < block->depth; slot++) {
+    (*stack)[depth++] = (IrEntry){.value = ir->refs[block->entry + slot], .start = -1, .end = -1};
+  }
+
+  for (int i = 0; i < block->instr_count; i++) {
+    IrInstr* instr = &ir->instrs[block->instr_start + i];
+    int offset     = instr->offset;
+    int next       = offset + chunk_instruction_length(ir->chunk, offset);
+    OpCode op      = (OpCode)code[offset];
+
+    // Type specialization.
+    if (instr->input_count == 2 && instr->output_count == 1) {
+      OpCode specialized = specialize(op, type_of(ir, ir->refs[instr->input_start + 1]), type_of(ir, ir->refs[instr->input_start]));
+      if (specialized != op) {
+        code[offset] = (uint16_t)specialized;
+        op           = specialized;
+        changed      = true;
+      }
+    }
+
+    // Dead stores.
+    if (op == OP_SET_LOCAL && instr->write_count == 1 && !is_volatile(ir, code[offset + 1])) {
+      int copy = ir->refs[instr->write_start + 1];
+      if (ir_resolve(ir, copy) == copy && !ir->values[copy].is_live) {
+        removed[offset]     = true;
+        removed[offset + 1] = true;
+        changed             = true;
+        // The slot keeps its previous value, which the IR no longer knows - it's never read anyway.
+        (*stack)[code[offset + 1]] = (IrEntry){.value = -1, .start = -1, .end = -1};
+        continue;
+      }
+    }
+
+    // Discarded pure trees: [tree][pop] -> []
+    if (op == OP_POP && depth > 0) {
+      IrEntry* top = &(*stack)[depth - 1];
+      if (top->start >= 0 && skip_removed(removed, top->end, next) == offset) {
+        for (int unit = top->start; unit < next; unit++) {
+          removed[unit] = true;
+        }
+        depth--;
+        changed = true;
+        continue;
+      }
+    }
+
+    // Find the tree of the value this instruction pushes, if it's pure and its operands were computed right before it.
+    int tree_start = -1;
+    if (instr->output_count == 1 && depth >= instr->pops && is_pure_instr(ir, op, ir->refs[instr->output_start])) {
+      tree_start = offset;
+      for (int j = 0; j < instr->pops && op != OP_DUPE; j++) {
+        IrEntry* operand = &(*stack)[depth - 1 - j];
+        if (operand->start < 0 || skip_removed(removed, operand->end, next) != tree_start) {
+          tree_start = -1;
+          break;
+        }
+        tree_start = operand->start;
+      }
+    }
+
+    // Value numbering: a tree whose value is already held by a slot is replaced by reading the slot.
+    if (tree_start >= 0 && tree_start < offset) {
+      int number = ir->values[ir_resolve(ir, ir->refs[instr->output_start])].number;
+      for (int slot = 0; slot < depth - instr->pops; slot++) {
+        if ((*stack)[slot].value < 0 || is_volatile(ir, slot)) {
+          continue;
+        }
+        // A dead copy might not be in its slot, its store might have been removed.
+        IrValue* held = &ir->values[ir_resolve(ir, (*stack)[slot].value)];
+        if (held->number == number && (held->kind != IR_VALUE_COPY || held->is_live)) {
+          code[tree_start]     = OP_GET_LOCAL;
+          code[tree_start + 1] = (uint16_t)slot;
+          for (int unit = tree_start + 2; unit < next; unit++) {
+            removed[unit] = true;
+          }
+          changed = true;
+          break;
+        }
+      }
+    }
+
+    // Apply the effect of the instruction.
+    depth -= instr->pops;
+    if (*capacity < depth + instr->output_count) {
+      *capacity = (depth + instr->output_count) * 2;
+      *stack    = realloc(*stack, sizeof(IrEntry) * (size_t)*capacity);
+    }
+    for (int j = 0; j < instr->output_count; j++) {
+      bool is_tree      = tree_start >= 0 && instr->output_count == 1;
+      (*stack)[depth++] = (IrEntry){
+          .value = ir->refs[instr->output_start + j],
+          .start = is_tree ? tree_start : -1,
+          .end   = is_tree ? next : -1,
+      };
+    }
+    for (int j = 0; j < instr->write_count; j++) {
+      int slot                = ir->refs[instr->write_start + j * 2];
+      (*stack)[slot].value = ir->refs[instr->write_start + j * 2 + 1];
+      (*stack)[slot].start = -1;
+    }
+  }
+
+  return changed;
+}
+
+void ir_optimize(ObjFunction* function) {
+  IrFunction* ir = ir_build(function);
+  if (ir == NULL) {
+    return;
+  }
+
+  propagate_copies(ir);
+  propagate_types(ir);
+  number_values(ir);
+  mark_live(ir);
+
+  Chunk* chunk   = ir->chunk;
+  bool* removed  = calloc((size_t)chunk->count + 1, sizeof(bool));
+  IrEntry* stack = NULL;
+  int capacity   = 0;
+  bool changed   = false;
+  for (int i = 1; i < ir->rpo_count; i++) {
+    changed |= lower_block(ir, &ir->blocks[ir->rpo[i]], removed, &stack, &capacity);
+  }
+  if (changed) {
+    peephole_cut(chunk, removed);
+  }
+
+  free(stack);
+  free(removed);
+  ir_free(ir);
+}
+
+#undef IR_ARRAY_PUSH
+#undef IR_EDGE_FALL
+#undef IR_EDGE_BRANCH
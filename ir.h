@@ -0,0 +1,133 @@
+#ifndef IR_H
+#define IR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "chunk.h"
+#include "object.h"
+#include "value.h"
+
+// Mid-level IR of a function: A control flow graph of basic blocks in SSA form. It is built from the bytecode of a compiled
+// function, by abstractly interpreting its stack: Every value an instruction pushes, and every value which is stored into a local,
+// becomes an IrValue. Locals live in the slots of the frame - just like temporaries - so the slots of the stack are the variables
+// of the SSA form, and phis merge them at the start of blocks with more than one predecessor.
+// The passes on the IR (copy propagation, type propagation, dead code elimination and value numbering) only analyze it. Lowering
+// applies their results to the bytecode in place, see ir_optimize.
+
+// Set of the types a value might have at runtime. IR_TYPE_ANY if nothing is known about it.
+typedef uint16_t IrType;
+
+#define IR_TYPE_NONE 0
+#define IR_TYPE_NIL (1 << 0)
+#define IR_TYPE_BOOL (1 << 1)
+#define IR_TYPE_INT (1 << 2)
+#define IR_TYPE_FLOAT (1 << 3)
+#define IR_TYPE_STR (1 << 4)
+#define IR_TYPE_SEQ (1 << 5)
+#define IR_TYPE_TUPLE (1 << 6)
+#define IR_TYPE_OTHER (1 << 7)  // Anything else, e.g. objects, functions or classes.
+#define IR_TYPE_NUM (IR_TYPE_INT | IR_TYPE_FLOAT)
+#define IR_TYPE_ANY 0xFF
+
+typedef enum {
+  IR_VALUE_PARAM,     // Value of a slot when the function is entered, e.g. the callee or an argument.
+  IR_VALUE_CONSTANT,  // Constant pushed by OP_CONSTANT, OP_NIL, OP_TRUE or OP_FALSE.
+  IR_VALUE_OP,        // Result of an instruction, computed from its operands.
+  IR_VALUE_COPY,      // Value stored into a local by OP_SET_LOCAL. Kept apart from its source, to find dead stores.
+  IR_VALUE_PHI,       // Merges the values a slot has at the end of the predecessors of a block.
+  IR_VALUE_OPAQUE,    // Value the IR knows nothing about except its type, e.g. a global, a captured local or a call result.
+} IrValueKind;
+
+typedef struct {
+  IrValueKind kind;
+  OpCode op;         // Opcode of the instruction which produced an IR_VALUE_OP.
+  int offset;        // Offset of the instruction which produced the value, -1 for params and phis.
+  int block;         // Block the value is defined in.
+  int operands[2];   // Operands of an IR_VALUE_OP (binary ops use both) or the source of an IR_VALUE_COPY.
+  int phi_start;     // Index of the first operand of an IR_VALUE_PHI in IrFunction.phi_operands.
+  Value constant;    // Value of an IR_VALUE_CONSTANT.
+  IrType type;       // Set of the types the value might have.
+  int number;        // Value number. Values with the same number are equal, see number_values.
+  int replacement;   // The value this one was replaced with by copy propagation, or its own index.
+  bool is_live;      // Whether the value is read by anything, see mark_live.
+} IrValue;
+
+// A single bytecode instruction and its effect on the stack.
+typedef struct {
+  int offset;
+  int pops;          // Number of values popped from the stack.
+  int input_start;   // The values the instruction reads, in IrFunction.refs.
+  int input_count;   //
+  int output_start;  // The values the instruction pushes, in IrFunction.refs.
+  int output_count;  //
+  int write_start;   // Pairs of a slot and the value the instruction writes into it, in IrFunction.refs.
+  int write_count;   //
+} IrInstr;
+
+typedef struct {
+  int start;        // Offset of the first instruction.
+  int end;          // Offset past the last instruction.
+  int instr_start;  // Index of the first instruction in IrFunction.instrs.
+  int instr_count;  //
+  int pred_start;   // Predecessors, in IrFunction.preds.
+  int pred_count;   //
+  int succs[2];     // Fallthrough and branch successor, -1 if there's none.
+  int depth;        // Stack depth at the start of the block, -1 while the block has not been reached.
+  int entry;        // The values of the slots at the start of the block, in IrFunction.refs.
+  int exits[2];     // The values of the slots at the end of the block, along the edge to the successor in [succs].
+  int exit_depths[2];
+  int order;        // Position in reverse postorder, -1 if the block is unreachable.
+} IrBlock;
+
+typedef struct {
+  Chunk* chunk;
+  int arity;
+
+  IrBlock* blocks;
+  int block_count;
+  int block_capacity;
+  int* rpo;  // Indices of the reachable blocks in reverse postorder.
+  int rpo_count;
+
+  IrInstr* instrs;
+  int instr_count;
+  int instr_capacity;
+
+  IrValue* values;
+  int value_count;
+  int value_capacity;
+
+  int* refs;  // Lists of value indices (and slots), referenced by instructions and blocks.
+  int ref_count;
+  int ref_capacity;
+
+  int* preds;  // Lists of block indices, referenced by blocks.
+  int pred_count;
+  int pred_capacity;
+
+  int* phi_operands;  // Lists of value indices, one per predecessor, referenced by phis.
+  int phi_operand_count;
+  int phi_operand_capacity;
+
+  bool* is_leader;    // Whether a block starts at a code unit.
+  bool* is_volatile;  // Whether a slot is captured by a closure, which might write it behind our back.
+  int slot_count;     // Number of entries in [is_volatile], e.g. the maximum stack depth.
+} IrFunction;
+
+// Builds the IR of [function], which must have been compiled without errors. Returns NULL if the function contains something
+// the IR does not model, e.g. try ranges.
+IrFunction* ir_build(ObjFunction* function);
+
+// Frees the IR of a function.
+void ir_free(IrFunction* ir);
+
+// Returns the value [value] was replaced with, following replacements made by copy propagation.
+int ir_resolve(IrFunction* ir, int value);
+
+// Builds the IR of [function], runs the passes on it and lowers the results back into its chunk: Arithmetic and comparisons on
+// proven types use the specialized opcodes right away, dead stores to locals and pure computations whose result is discarded
+// are removed, and pure computations whose value is already held by a slot are replaced by reading the slot. Functions the IR
+// does not model are left as they are.
+void ir_optimize(ObjFunction* function);
+
+#endif  // IR_H
@@ -0,0 +1,1252 @@
+#if defined(__linux__)
+  #define _DEFAULT_SOURCE  // For MAP_ANONYMOUS
+#endif
+
+#include "jit.h"
+#include <stdlib.h>
+#include <string.h>
+#include "chunk.h"
+#include "common.h"
+#include "object.h"
+#include "value.h"
+#include "vm.h"
+
+#if JIT_SUPPORTED
+
+#include <sys/mman.h>
+
+// x86-64 general purpose registers, numbered as in the instruction encoding.
+typedef enum {
+  RAX = 0,
+  RCX = 1,
+  RDX = 2,
+  RBX = 3,
+  RSP = 4,
+  RBP = 5,
+  RSI = 6,
+  RDI = 7,
+  R12 = 12,
+} Register;
+
+// SSE registers.
+typedef enum {
+  XMM0 = 0,
+  XMM1 = 1,
+} XmmRegister;
+
+// Condition codes, as used in the encoding of jcc and setcc.
+typedef enum {
+  CC_B  = 0x2,  // Below (unsigned <)
+  CC_AE = 0x3,  // Above or equal (unsigned >=)
+  CC_E  = 0x4,  // Equal
+  CC_NE = 0x5,  // Not equal
+  CC_BE = 0x6,  // Below or equal (unsigned <=)
+  CC_A  = 0x7,  // Above (unsigned >)
+  CC_L  = 0xC,  // Less (signed <)
+  CC_GE = 0xD,  // Greater or equal (signed >=)
+  CC_LE = 0xE,  // Less or equal (signed <=)
+  CC_G  = 0xF,  // Greater (signed >)
+} Condition;
+
+#define CC_NEGATE(cc) ((Condition)((cc) ^ 1))
+#define CC_ALWAYS -1
+
+// Register assignment of the compiled code. Both are callee-saved, so they survive calls into C.
+#define REG_SLOTS RBX  // Start of the current frame's stack window, e.g. frame->slots.
+#define REG_TOP R12    // The stack top, e.g. vm.stack_top. Stored back into the vm when leaving the compiled code.
+
+// Layout of a value on the stack.
+#define VALUE_SIZE ((int32_t)sizeof(Value))
+#define VALUE_TYPE_OFS ((int32_t)offsetof(Value, type))
+#define VALUE_AS_OFS ((int32_t)offsetof(Value, as))
+#define SLOT_OFS(slot) ((int32_t)(slot) * VALUE_SIZE)  // Offset of a local from REG_SLOTS.
+#define PEEK_OFS(distance) (-((int32_t)(distance) + 1) * VALUE_SIZE)  // Offset of a value from REG_TOP. 0: top, 1: second, etc.
+
+// A rel32 operand which has to be patched once all instructions are emitted.
+typedef struct {
+  int at;      // Offset into the code of the rel32 operand.
+  int target;  // Offset into the chunk of the instruction to jump to, or to exit at.
+} JitPatch;
+
+typedef struct {
+  ObjFunction* function;
+  Chunk* chunk;
+
+  uint8_t* code;
+  int count;
+  int capacity;
+
+  int* labels;  // Offset into [code] of each instruction in the chunk. -1 if there is no instruction starting there.
+  bool* entry;  // Whether an instruction has a template, e.g. whether the compiled code can be entered there.
+
+  JitPatch* jumps;  // Jumps to other instructions of the chunk.
+  int jump_count;
+  int jump_capacity;
+
+  JitPatch* exits;  // Jumps to the exit stub of an instruction, taken when a guard fails.
+  int exit_count;
+  int exit_capacity;
+
+  int exit_label;  // Offset into [code] of the common exit, which returns to the interpreter.
+  bool trace;      // Whether a trace is compiled. Jumps to instructions which are not part of it exit instead.
+} JitCompiler;
+
+#define JIT_MIN_RUN 3  // Minimum number of templated instructions the compiled code must be able to run after entering it.
+
+#define JIT_ARRAY_PUSH(array, count, capacity, item)                       \
+  do {                                                                     \
+    if ((count) + 1 > (capacity)) {                                        \
+      (capacity) = (capacity) < 8 ? 8 : (capacity) * 2;                    \
+      (array)    = realloc((array), sizeof(*(array)) * (size_t)(capacity)); \
+    }                                                                      \
+    (array)[(count)++] = (item);                                           \
+  } while (0)
+
+//
+// Encoding
+//
+
+static void emit_byte(JitCompiler* jit, uint8_t byte) {
+  JIT_ARRAY_PUSH(jit->code, jit->count, jit->capacity, byte);
+}
+
+static void emit_u32(JitCompiler* jit, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    emit_byte(jit, (uint8_t)(value >> (i * 8)));
+  }
+}
+
+static void emit_u64(JitCompiler* jit, uint64_t value) {
+  for (int i = 0; i < 8; i++) {
+    emit_byte(jit, (uint8_t)(value >> (i * 8)));
+  }
+}
+
+// Emits a REX prefix for an instruction with the register operand [reg] and the register or memory-base operand [base]. [wide]
+// selects the 64-bit operand size. Omitted if neither is needed.
+static void emit_rex(JitCompiler* jit, bool wide, int reg, int base) {
+  uint8_t rex = 0x40 | (wide ? 0x08 : 0) | ((reg & 8) ? 0x04 : 0) | ((base & 8) ? 0x01 : 0);
+  if (rex != 0x40) {
+    emit_byte(jit, rex);
+  }
+}
+
+// Emits the ModRM byte (plus SIB and displacement) for the register operand [reg] and the memory operand [base + disp].
+static void emit_modrm_mem(JitCompiler* jit, int reg, int base, int32_t disp) {
+  uint8_t mod = (disp == 0 && (base & 7) != RBP) ? 0x00 : (disp >= INT8_MIN && disp <= INT8_MAX) ? 0x40 : 0x80;
+  emit_byte(jit, mod | (uint8_t)((reg & 7) << 3) | (uint8_t)(base & 7));
+  if ((base & 7) == RSP) {
+    emit_byte(jit, 0x24);  // SIB without index, needed for RSP and R12 as a base.
+  }
+  if (mod == 0x40) {
+    emit_byte(jit, (uint8_t)(int8_t)disp);
+  } else if (mod == 0x80) {
+    emit_u32(jit, (uint32_t)disp);
+  }
+}
+
+// Emits an instruction with a register and a memory operand. [prefix] is a mandatory prefix (0 if none), [opcode] is either a
+// one-byte opcode or a two-byte opcode starting with 0x0F.
+static void emit_op_mem(JitCompiler* jit, uint8_t prefix, bool wide, uint16_t opcode, int reg, int base, int32_t disp) {
+  if (prefix != 0) {
+    emit_byte(jit, prefix);
+  }
+  emit_rex(jit, wide, reg, base);
+  if (opcode > 0xFF) {
+    emit_byte(jit, (uint8_t)(opcode >> 8));
+  }
+  emit_byte(jit, (uint8_t)opcode);
+  emit_modrm_mem(jit, reg, base, disp);
+}
+
+// mov reg, [base + disp]
+static void emit_load(JitCompiler* jit, Register reg, Register base, int32_t disp) {
+  emit_op_mem(jit, 0, true, 0x8B, reg, base, disp);
+}
+
+// mov [base + disp], reg
+static void emit_store(JitCompiler* jit, Register base, int32_t disp, Register reg) {
+  emit_op_mem(jit, 0, true, 0x89, reg, base, disp);
+}
+
+// mov reg, imm64
+static void emit_mov_imm(JitCompiler* jit, Register reg, uint64_t imm) {
+  emit_rex(jit, true, 0, reg);
+  emit_byte(jit, 0xB8 + (reg & 7));
+  emit_u64(jit, imm);
+}
+
+// lea reg, [base + disp]. Used to move the stack top, since it leaves the flags untouched.
+static void emit_lea(JitCompiler* jit, Register reg, Register base, int32_t disp) {
+  emit_op_mem(jit, 0, true, 0x8D, reg, base, disp);
+}
+
+// Moves the stack top by [count] values.
+static void emit_move_top(JitCompiler* jit, int count) {
+  emit_lea(jit, REG_TOP, REG_TOP, count * VALUE_SIZE);
+}
+
+// Copies a whole value from [src_base + src_disp] to [dst_base + dst_disp]. Uses two 8-byte moves (via rcx and rdx) rather than
+// one 16-byte move, since the templates often write only one half of a value (e.g. INC_LOCAL) right before it is copied - which
+// a 16-byte load could not be forwarded from and would stall on.
+static void emit_copy_value(JitCompiler* jit, Register dst_base, int32_t dst_disp, Register src_base, int32_t src_disp) {
+  emit_load(jit, RCX, src_base, src_disp + VALUE_TYPE_OFS);
+  emit_load(jit, RDX, src_base, src_disp + VALUE_AS_OFS);
+  emit_store(jit, dst_base, dst_disp + VALUE_TYPE_OFS, RCX);
+  emit_store(jit, dst_base, dst_disp + VALUE_AS_OFS, RDX);
+}
+
+// Pushes the value at [base + disp] onto the stack.
+static void emit_push_value(JitCompiler* jit, Register base, int32_t disp) {
+  emit_copy_value(jit, REG_TOP, 0, base, disp);
+  emit_move_top(jit, 1);
+}
+
+// Pushes a constant value onto the stack.
+static void emit_push_constant(JitCompiler* jit, Value value) {
+  uint64_t payload;
+  memcpy(&payload, &value.as, sizeof(payload));
+  emit_mov_imm(jit, RAX, (uint64_t)(uintptr_t)value.type);
+  emit_store(jit, REG_TOP, VALUE_TYPE_OFS, RAX);
+  emit_mov_imm(jit, RAX, payload);
+  emit_store(jit, REG_TOP, VALUE_AS_OFS, RAX);
+  emit_move_top(jit, 1);
+}
+
+// Emits a jump to the instruction at [target] in the chunk. Unconditional if [cc] is CC_ALWAYS.
+static void emit_jump(JitCompiler* jit, int cc, int target) {
+  if (cc == CC_ALWAYS) {
+    emit_byte(jit, 0xE9);
+  } else {
+    emit_byte(jit, 0x0F);
+    emit_byte(jit, 0x80 | (uint8_t)cc);
+  }
+  JitPatch patch = {.at = jit->count, .target = target};
+  JIT_ARRAY_PUSH(jit->jumps, jit->jump_count, jit->jump_capacity, patch);
+  emit_u32(jit, 0);
+}
+
+// Emits a jump to the exit stub of the instruction at [offset] in the chunk, which hands control back to the interpreter right
+// before that instruction. Unconditional if [cc] is CC_ALWAYS.
+static void emit_exit(JitCompiler* jit, int cc, int offset) {
+  if (cc == CC_ALWAYS) {
+    emit_byte(jit, 0xE9);
+  } else {
+    emit_byte(jit, 0x0F);
+    emit_byte(jit, 0x80 | (uint8_t)cc);
+  }
+  JitPatch patch = {.at = jit->count, .target = offset};
+  JIT_ARRAY_PUSH(jit->exits, jit->exit_count, jit->exit_capacity, patch);
+  emit_u32(jit, 0);
+}
+
+// Emits a guard which exits before the instruction at [offset] if the type of the value at [base + disp] is not [klass]. The
+// class must be loaded into RCX.
+static void emit_type_guard(JitCompiler* jit, Register base, int32_t disp, int offset) {
+  emit_op_mem(jit, 0, true, 0x39, RCX, base, disp + VALUE_TYPE_OFS);  // cmp [base + disp], rcx
+  emit_exit(jit, CC_NE, offset);
+}
+
+// Emits guards which exit before the instruction at [offset] if the top two values on the stack are not both of type [klass].
+static void emit_binary_guard(JitCompiler* jit, ObjClass* klass, int offset) {
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)klass);
+  emit_type_guard(jit, REG_TOP, PEEK_OFS(0), offset);
+  emit_type_guard(jit, REG_TOP, PEEK_OFS(1), offset);
+}
+
+// Replaces the top two values on the stack with a bool, whose payload is the result of [cc] applied to the flags.
+static void emit_bool_result(JitCompiler* jit, Condition cc) {
+  emit_byte(jit, 0x0F);  // setcc al
+  emit_byte(jit, 0x90 | (uint8_t)cc);
+  emit_byte(jit, 0xC0);
+  emit_byte(jit, 0x0F);  // movzx eax, al
+  emit_byte(jit, 0xB6);
+  emit_byte(jit, 0xC0);
+  emit_store(jit, REG_TOP, PEEK_OFS(1) + VALUE_AS_OFS, RAX);
+  emit_mov_imm(jit, RAX, (uint64_t)(uintptr_t)vm.bool_class);
+  emit_store(jit, REG_TOP, PEEK_OFS(1) + VALUE_TYPE_OFS, RAX);
+  emit_move_top(jit, -1);
+}
+
+// Compares the payloads of the top two values on the stack, which are both TYPENAME_INT. Sets the flags for signed conditions.
+static void emit_int_compare(JitCompiler* jit) {
+  emit_load(jit, RAX, REG_TOP, PEEK_OFS(1) + VALUE_AS_OFS);
+  emit_op_mem(jit, 0, true, 0x3B, RAX, REG_TOP, PEEK_OFS(0) + VALUE_AS_OFS);  // cmp rax, [right]
+}
+
+// Compares the payloads of the top two values on the stack, which are both TYPENAME_FLOAT, such that the unsigned condition
+// [*cc] reflects the result of [op] - the operands are swapped for < and <=. NaN compares as false, just like in C.
+static void emit_float_compare(JitCompiler* jit, OpCode op, Condition* cc) {
+  bool swap = op == OP_LT || op == OP_LTEQ;
+  emit_op_mem(jit, 0xF2, false, 0x0F10, XMM0, REG_TOP, PEEK_OFS(swap ? 0 : 1) + VALUE_AS_OFS);  // movsd xmm0, [a]
+  emit_op_mem(jit, 0x66, false, 0x0F2E, XMM0, REG_TOP, PEEK_OFS(swap ? 1 : 0) + VALUE_AS_OFS);  // ucomisd xmm0, [b]
+  *cc = (op == OP_LT || op == OP_GT) ? CC_A : CC_AE;
+}
+
+// Condition for a signed comparison of two TYPENAME_INTs with the generic compare opcode [op].
+static Condition int_condition(OpCode op) {
+  switch (op) {
+    case OP_EQ: return CC_E;
+    case OP_NEQ: return CC_NE;
+    case OP_LT: return CC_L;
+    case OP_GT: return CC_G;
+    case OP_LTEQ: return CC_LE;
+    default: return CC_GE;
+  }
+}
+
+//
+// Templates
+//
+
+// Emits the template for a binary operation on two TYPENAME_INTs or two TYPENAME_FLOATs (depending on [klass]). [op] is the
+// generic opcode of the operation.
+static void emit_num_binary(JitCompiler* jit, OpCode op, ObjClass* klass, int offset) {
+  emit_binary_guard(jit, klass, offset);
+  if (klass == vm.int_class) {
+    emit_load(jit, RAX, REG_TOP, PEEK_OFS(1) + VALUE_AS_OFS);
+    uint16_t opcode = op == OP_ADD ? 0x03 : op == OP_SUBTRACT ? 0x2B : 0x0FAF;  // add, sub, imul
+    emit_op_mem(jit, 0, true, opcode, RAX, REG_TOP, PEEK_OFS(0) + VALUE_AS_OFS);
+    emit_store(jit, REG_TOP, PEEK_OFS(1) + VALUE_AS_OFS, RAX);
+  } else {
+    emit_op_mem(jit, 0xF2, false, 0x0F10, XMM0, REG_TOP, PEEK_OFS(1) + VALUE_AS_OFS);  // movsd xmm0, [left]
+    uint16_t opcode = op == OP_ADD ? 0x0F58 : op == OP_SUBTRACT ? 0x0F5C : 0x0F59;    // addsd, subsd, mulsd
+    emit_op_mem(jit, 0xF2, false, opcode, XMM0, REG_TOP, PEEK_OFS(0) + VALUE_AS_OFS);
+    emit_op_mem(jit, 0xF2, false, 0x0F11, XMM0, REG_TOP, PEEK_OFS(1) + VALUE_AS_OFS);  // movsd [left], xmm0
+  }
+  emit_move_top(jit, -1);
+}
+
+// Emits the template for a comparison of two TYPENAME_INTs or two TYPENAME_FLOATs (depending on [klass]), which pushes a bool.
+// [op] is the generic opcode of the comparison.
+static void emit_num_compare(JitCompiler* jit, OpCode op, ObjClass* klass, int offset) {
+  emit_binary_guard(jit, klass, offset);
+  Condition cc = int_condition(op);
+  if (klass == vm.int_class) {
+    emit_int_compare(jit);
+  } else {
+    emit_float_compare(jit, op, &cc);
+  }
+  emit_bool_result(jit, cc);
+}
+
+// Emits the template for a fused compare-and-branch. Handles two TYPENAME_INTs and, for anything but (in)equality, two
+// TYPENAME_FLOATs - or just two values of [klass] if it is not NULL. [op] is the generic opcode of the comparison.
+static void emit_compare_jump(JitCompiler* jit, OpCode op, ObjClass* klass, int offset, int target) {
+  if (klass != NULL) {
+    emit_binary_guard(jit, klass, offset);
+    Condition cc = int_condition(op);
+    if (klass == vm.int_class) {
+      emit_int_compare(jit);
+    } else {
+      emit_float_compare(jit, op, &cc);
+    }
+    emit_move_top(jit, -2);
+    emit_jump(jit, CC_NEGATE(cc), target);
+    return;
+  }
+
+  bool floats = op != OP_EQ && op != OP_NEQ;
+
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.int_class);
+  emit_op_mem(jit, 0, true, 0x39, RCX, REG_TOP, PEEK_OFS(0) + VALUE_TYPE_OFS);  // cmp [right].type, rcx
+  int float_jump = -1;
+  if (floats) {
+    emit_byte(jit, 0x0F);  // jne to the float path, patched below.
+    emit_byte(jit, 0x80 | CC_NE);
+    float_jump = jit->count;
+    emit_u32(jit, 0);
+  } else {
+    emit_exit(jit, CC_NE, offset);
+  }
+  emit_type_guard(jit, REG_TOP, PEEK_OFS(1), offset);
+  emit_int_compare(jit);
+  emit_move_top(jit, -2);
+  emit_jump(jit, CC_NEGATE(int_condition(op)), target);
+  if (!floats) {
+    return;
+  }
+
+  // Two floats. Skipped by the int path, which falls through to the next instruction.
+  emit_byte(jit, 0xEB);  // jmp rel8 over the float path, patched below.
+  int skip_jump = jit->count;
+  emit_byte(jit, 0);
+
+  uint32_t rel = (uint32_t)(jit->count - (float_jump + 4));
+  memcpy(jit->code + float_jump, &rel, sizeof(rel));
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.float_class);
+  emit_type_guard(jit, REG_TOP, PEEK_OFS(0), offset);
+  emit_type_guard(jit, REG_TOP, PEEK_OFS(1), offset);
+  Condition cc;
+  emit_float_compare(jit, op, &cc);
+  emit_move_top(jit, -2);
+  emit_jump(jit, CC_NEGATE(cc), target);
+
+  jit->code[skip_jump] = (uint8_t)(jit->count - (skip_jump + 1));
+}
+
+// Emits the template for a TYPENAME_INT compared with the length of a TYPENAME_SEQ, e.g. OP_LT_LEN_JUMP_IF_FALSE. Tuples and
+// anything else are left to the interpreter.
+static void emit_len_compare_jump(JitCompiler* jit, int offset, int target) {
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.seq_class);
+  emit_type_guard(jit, REG_TOP, PEEK_OFS(0), offset);
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.int_class);
+  emit_type_guard(jit, REG_TOP, PEEK_OFS(1), offset);
+  emit_load(jit, RAX, REG_TOP, PEEK_OFS(0) + VALUE_AS_OFS);
+  emit_op_mem(jit, 0, true, 0x63, RDX, RAX, (int32_t)(offsetof(ObjSeq, items) + offsetof(ValueArray, count)));  // movsxd
+  emit_load(jit, RAX, REG_TOP, PEEK_OFS(1) + VALUE_AS_OFS);
+  emit_byte(jit, 0x48);  // cmp rax, rdx
+  emit_byte(jit, 0x39);
+  emit_byte(jit, 0xD0);
+  emit_move_top(jit, -2);
+  emit_jump(jit, CC_GE, target);
+}
+
+// Emits the template for OP_GET_SUBSCRIPT_IN_BOUNDS. The compiler proved that the index is within the bounds of the seq, so
+// only the types are guarded.
+static void emit_subscript_in_bounds(JitCompiler* jit, int offset) {
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.seq_class);
+  emit_type_guard(jit, REG_TOP, PEEK_OFS(1), offset);
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.int_class);
+  emit_type_guard(jit, REG_TOP, PEEK_OFS(0), offset);
+  emit_load(jit, RAX, REG_TOP, PEEK_OFS(1) + VALUE_AS_OFS);
+  emit_load(jit, RAX, RAX, (int32_t)(offsetof(ObjSeq, items) + offsetof(ValueArray, values)));
+  emit_load(jit, RCX, REG_TOP, PEEK_OFS(0) + VALUE_AS_OFS);
+  emit_byte(jit, 0x48);  // imul rcx, rcx, VALUE_SIZE
+  emit_byte(jit, 0x6B);
+  emit_byte(jit, 0xC9);
+  emit_byte(jit, (uint8_t)VALUE_SIZE);
+  emit_byte(jit, 0x48);  // add rax, rcx
+  emit_byte(jit, 0x01);
+  emit_byte(jit, 0xC8);
+  emit_copy_value(jit, REG_TOP, PEEK_OFS(1), RAX, 0);
+  emit_move_top(jit, -1);
+}
+
+// Emits the template for adding an int [operand] to the TYPENAME_INT local in [slot] in place.
+static void emit_add_local(JitCompiler* jit, uint16_t slot, SLANG_TYPE_INT operand, int offset) {
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.int_class);
+  emit_type_guard(jit, REG_SLOTS, SLOT_OFS(slot), offset);
+  emit_mov_imm(jit, RAX, (uint64_t)operand);
+  emit_op_mem(jit, 0, true, 0x01, RAX, REG_SLOTS, SLOT_OFS(slot) + VALUE_AS_OFS);  // add [local], rax
+}
+
+// Emits the template for adding a float [operand] to the TYPENAME_FLOAT local in [slot] in place.
+static void emit_add_local_float(JitCompiler* jit, uint16_t slot, SLANG_TYPE_FLOAT operand, int offset) {
+  uint64_t bits;
+  memcpy(&bits, &operand, sizeof(bits));
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.float_class);
+  emit_type_guard(jit, REG_SLOTS, SLOT_OFS(slot), offset);
+  emit_op_mem(jit, 0xF2, false, 0x0F10, XMM0, REG_SLOTS, SLOT_OFS(slot) + VALUE_AS_OFS);  // movsd xmm0, [local]
+  emit_mov_imm(jit, RAX, bits);
+  const uint8_t movq_addsd[] = {0x66, 0x48, 0x0F, 0x6E, 0xC8, 0xF2, 0x0F, 0x58, 0xC1};  // movq xmm1, rax; addsd xmm0, xmm1
+  for (size_t i = 0; i < sizeof(movq_addsd); i++) {
+    emit_byte(jit, movq_addsd[i]);
+  }
+  emit_op_mem(jit, 0xF2, false, 0x0F11, XMM0, REG_SLOTS, SLOT_OFS(slot) + VALUE_AS_OFS);  // movsd [local], xmm0
+}
+
+// Emits the template for pushing the value of a global or - if [push] is false - for setting it to the top value of the stack.
+// Exits if the global is not defined, because the interpreter has to look up the natives or report the error.
+static void emit_global(JitCompiler* jit, uint16_t slot, bool push, int offset) {
+  ObjObject* globals = jit->function->globals_context;
+  emit_mov_imm(jit, RAX, (uint64_t)(uintptr_t)&globals->slots);
+  emit_load(jit, RAX, RAX, 0);  // The slots can grow, so they're loaded every time.
+  emit_op_mem(jit, 0, true, 0x83, 7, RAX, SLOT_OFS(slot) + VALUE_TYPE_OFS);  // cmp qword [global].type, 0
+  emit_byte(jit, 0);
+  emit_exit(jit, CC_E, offset);
+  if (push) {
+    emit_push_value(jit, RAX, SLOT_OFS(slot));
+  } else {
+    emit_copy_value(jit, RAX, SLOT_OFS(slot), REG_TOP, PEEK_OFS(0));
+  }
+}
+
+// Emits the template for jumping to [target] if the top value of the stack is falsy, e.g. nil or false. Does not pop it.
+static void emit_jump_if_false(JitCompiler* jit, int target) {
+  emit_load(jit, RAX, REG_TOP, PEEK_OFS(0) + VALUE_TYPE_OFS);
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.nil_class);
+  emit_byte(jit, 0x48);  // cmp rax, rcx
+  emit_byte(jit, 0x39);
+  emit_byte(jit, 0xC8);
+  emit_jump(jit, CC_E, target);
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.bool_class);
+  emit_byte(jit, 0x48);  // cmp rax, rcx
+  emit_byte(jit, 0x39);
+  emit_byte(jit, 0xC8);
+  emit_byte(jit, 0x75);  // jne over the bool check
+  emit_byte(jit, 0);
+  int skip = jit->count;
+  emit_op_mem(jit, 0, false, 0x80, 7, REG_TOP, PEEK_OFS(0) + VALUE_AS_OFS);  // cmp byte [top].as, 0
+  emit_byte(jit, 0);
+  emit_jump(jit, CC_E, target);
+  jit->code[skip - 1] = (uint8_t)(jit->count - skip);
+}
+
+// Emits the template for jumping to [target] if the top value of the stack is truthy, e.g. neither nil nor false. Does not pop it.
+static void emit_jump_if_true(JitCompiler* jit, int target) {
+  emit_load(jit, RAX, REG_TOP, PEEK_OFS(0) + VALUE_TYPE_OFS);
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.nil_class);
+  emit_byte(jit, 0x48);  // cmp rax, rcx
+  emit_byte(jit, 0x39);
+  emit_byte(jit, 0xC8);
+  emit_byte(jit, 0x74);  // je over the rest
+  emit_byte(jit, 0);
+  int skip = jit->count;
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.bool_class);
+  emit_byte(jit, 0x48);  // cmp rax, rcx
+  emit_byte(jit, 0x39);
+  emit_byte(jit, 0xC8);
+  emit_jump(jit, CC_NE, target);
+  emit_op_mem(jit, 0, false, 0x80, 7, REG_TOP, PEEK_OFS(0) + VALUE_AS_OFS);  // cmp byte [top].as, 0
+  emit_byte(jit, 0);
+  emit_jump(jit, CC_NE, target);
+  jit->code[skip - 1] = (uint8_t)(jit->count - skip);
+}
+
+// Emits the template for jumping to [target] if the top value of the stack is not nil. Does not pop it.
+static void emit_jump_if_not_nil(JitCompiler* jit, int target) {
+  emit_load(jit, RAX, REG_TOP, PEEK_OFS(0) + VALUE_TYPE_OFS);
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.nil_class);
+  emit_byte(jit, 0x48);  // cmp rax, rcx
+  emit_byte(jit, 0x39);
+  emit_byte(jit, 0xC8);
+  emit_jump(jit, CC_NE, target);
+}
+
+// Emits the template for reusing the value at [index] and jumping to [target]. Exits before the instruction at [offset] if the
+// value is a bound method, which must be created anew.
+static void emit_reuse(JitCompiler* jit, uint16_t index, int offset, int target) {
+  emit_load(jit, RAX, REG_TOP, PEEK_OFS(index) + VALUE_TYPE_OFS);
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.fn_class);
+  emit_byte(jit, 0x48);  // cmp rax, rcx
+  emit_byte(jit, 0x39);
+  emit_byte(jit, 0xC8);
+  emit_byte(jit, 0x75);  // jne over the bound method check
+  emit_byte(jit, 0);
+  int skip = jit->count;
+  emit_load(jit, RAX, REG_TOP, PEEK_OFS(index) + VALUE_AS_OFS);
+  emit_op_mem(jit, 0, false, 0x83, 7, RAX, (int32_t)offsetof(Obj, type));  // cmp dword [rax].type, OBJ_GC_BOUND_METHOD
+  emit_byte(jit, (uint8_t)OBJ_GC_BOUND_METHOD);
+  emit_exit(jit, CC_E, offset);
+  jit->code[skip - 1] = (uint8_t)(jit->count - skip);
+  emit_push_value(jit, REG_TOP, PEEK_OFS(index));
+  emit_jump(jit, CC_ALWAYS, target);
+}
+
+// Emits the template for guarding the inlined body of [function]: Exits before the instruction at [offset] - the interpreter then
+// makes the regular call - if the callee below the [arg_count] arguments is not a closure of [function].
+static void emit_call_inlined(JitCompiler* jit, uint16_t arg_count, ObjFunction* function, int offset) {
+  emit_load(jit, RAX, REG_TOP, PEEK_OFS(arg_count) + VALUE_TYPE_OFS);
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.fn_class);
+  emit_byte(jit, 0x48);  // cmp rax, rcx
+  emit_byte(jit, 0x39);
+  emit_byte(jit, 0xC8);
+  emit_exit(jit, CC_NE, offset);
+  emit_load(jit, RAX, REG_TOP, PEEK_OFS(arg_count) + VALUE_AS_OFS);
+  emit_op_mem(jit, 0, false, 0x83, 7, RAX, (int32_t)offsetof(Obj, type));  // cmp dword [rax].type, OBJ_GC_CLOSURE
+  emit_byte(jit, (uint8_t)OBJ_GC_CLOSURE);
+  emit_exit(jit, CC_NE, offset);
+  emit_load(jit, RAX, RAX, (int32_t)offsetof(ObjClosure, function));
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)function);
+  emit_byte(jit, 0x48);  // cmp rax, rcx
+  emit_byte(jit, 0x39);
+  emit_byte(jit, 0xC8);
+  emit_exit(jit, CC_NE, offset);
+}
+
+// Returns the class for which the inline [cache] of an OP_INVOKE_INLINED holds a closure of the inlined [function], or NULL if
+// the invocation has not been made on a receiver which uses [function] yet. Prefers [observed], if it is one of them.
+static ObjClass* inlined_method_class(InlineCache* cache, ObjFunction* function, ObjClass* observed) {
+  ObjClass* klass = NULL;
+  for (int i = 0; i < cache->count; i++) {
+    Obj* method = cache->entries[i].method;
+    if (method->type == OBJ_GC_CLOSURE && ((ObjClosure*)method)->function == function &&
+        (klass == NULL || cache->entries[i].klass == observed)) {
+      klass = cache->entries[i].klass;
+    }
+  }
+  return klass;
+}
+
+// Emits the template for guarding the inlined body of a method: Exits before the instruction at [offset] - the interpreter then
+// makes the regular invocation - if the receiver below the [arg_count] arguments is not of [klass], which uses the method.
+static void emit_invoke_inlined(JitCompiler* jit, uint16_t arg_count, ObjClass* klass, int offset) {
+  emit_load(jit, RAX, REG_TOP, PEEK_OFS(arg_count) + VALUE_TYPE_OFS);
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)klass);
+  emit_byte(jit, 0x48);  // cmp rax, rcx
+  emit_byte(jit, 0x39);
+  emit_byte(jit, 0xC8);
+  emit_exit(jit, CC_NE, offset);
+}
+
+// Emits the template for OP_INVOKE of [method], which the inline cache of the instruction holds for [klass]: Calls vm_jit_invoke,
+// which runs the method to completion, and reloads the stack registers afterwards - the call might have grown the stack. Exits
+// before the instruction at [offset] if the receiver below the [arg_count] arguments is not of [klass], and before the one at
+// [next] if the method raised an error, which the interpreter handles from there.
+static void emit_invoke(JitCompiler* jit, uint16_t arg_count, ObjClass* klass, Obj* method, int offset, int next) {
+  emit_invoke_inlined(jit, arg_count, klass, offset);  // Same guard
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)&vm.stack_top);
+  emit_store(jit, RCX, 0, REG_TOP);
+  emit_mov_imm(jit, RDI, (uint64_t)(uintptr_t)method);
+  emit_mov_imm(jit, RSI, arg_count);
+  emit_mov_imm(jit, RDX, (uint64_t)(uintptr_t)(jit->chunk->code + next));
+  emit_mov_imm(jit, RAX, (uint64_t)(uintptr_t)vm_jit_invoke);
+  emit_byte(jit, 0x48);  // sub rsp, 8 - the entry stub pushed two registers, so this realigns the stack to 16 bytes
+  emit_byte(jit, 0x83);
+  emit_byte(jit, 0xEC);
+  emit_byte(jit, 0x08);
+  emit_byte(jit, 0xFF);  // call rax
+  emit_byte(jit, 0xD0);
+  emit_byte(jit, 0x48);  // add rsp, 8
+  emit_byte(jit, 0x83);
+  emit_byte(jit, 0xC4);
+  emit_byte(jit, 0x08);
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)&vm.stack_top);
+  emit_load(jit, REG_TOP, RCX, 0);
+  emit_byte(jit, 0x48);  // test rax, rax
+  emit_byte(jit, 0x85);
+  emit_byte(jit, 0xC0);
+  emit_exit(jit, CC_E, next);
+  emit_byte(jit, 0x48);  // mov rbx, rax
+  emit_byte(jit, 0x89);
+  emit_byte(jit, 0xC3);
+}
+
+// Emits the template for getting a field of a TYPENAME_OBJ or instance whose shape is the one remembered in the inline [cache] of
+// the instruction, e.g. OP_GET_PROPERTY_OBJ: The field is loaded from its slot. Exits before the instruction at [offset] if the
+// receiver does not use the `__get_prop` of TYPENAME_OBJ, or has another shape. Shapes live as long as the vm, so the one of
+// [cache] can be part of the code.
+static void emit_get_field(JitCompiler* jit, InlineCache* cache, int offset) {
+  emit_load(jit, RAX, REG_TOP, PEEK_OFS(0) + VALUE_TYPE_OFS);
+  emit_load(jit, RAX, RAX, (int32_t)offsetof(ObjClass, __get_prop));
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)vm.obj_class->__get_prop);
+  emit_byte(jit, 0x48);  // cmp rax, rcx
+  emit_byte(jit, 0x39);
+  emit_byte(jit, 0xC8);
+  emit_exit(jit, CC_NE, offset);
+  emit_load(jit, RAX, REG_TOP, PEEK_OFS(0) + VALUE_AS_OFS);
+  emit_load(jit, RDX, RAX, (int32_t)offsetof(ObjObject, shape));
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)cache->shape);
+  emit_byte(jit, 0x48);  // cmp rdx, rcx
+  emit_byte(jit, 0x39);
+  emit_byte(jit, 0xCA);
+  emit_exit(jit, CC_NE, offset);
+  emit_load(jit, RAX, RAX, (int32_t)offsetof(ObjObject, slots));
+  emit_copy_value(jit, REG_TOP, PEEK_OFS(0), RAX, SLOT_OFS(cache->slot));
+}
+
+// Emits the template for advancing a loop over a range of TYPENAME_INTs, whose next value is in [slot], followed by the upper bound.
+// Both are known to be TYPENAME_INTs, OP_FOR_RANGE_INIT made sure of that.
+static void emit_range_next(JitCompiler* jit, uint16_t slot, int target) {
+  emit_load(jit, RAX, REG_SLOTS, SLOT_OFS(slot) + VALUE_AS_OFS);
+  emit_op_mem(jit, 0, true, 0x3B, RAX, REG_SLOTS, SLOT_OFS(slot + 1) + VALUE_AS_OFS);  // cmp rax, [end]
+  emit_jump(jit, CC_GE, target);
+  emit_push_value(jit, REG_SLOTS, SLOT_OFS(slot));
+  emit_op_mem(jit, 0, true, 0xFF, 0, REG_SLOTS, SLOT_OFS(slot) + VALUE_AS_OFS);  // inc qword [next]
+}
+
+// Emits the template of the instruction at [offset]. Returns false if there is no template for it, in which case the interpreter
+// executes it - the compiled code just exits before it. [observed] is the class of the operands the instruction had when it was
+// recorded (see JitTraceStep), which its template is specialized to. NULL outside of traces.
+static bool compile_instruction(JitCompiler* jit, int offset, ObjClass* observed) {
+  Chunk* chunk     = jit->chunk;
+  uint16_t* code   = chunk->code + offset;
+  int next         = offset + chunk_instruction_length(chunk, offset);
+  Value* constants = chunk->constants.values;
+
+  switch ((OpCode)code[0]) {
+    case OP_CONSTANT: emit_push_constant(jit, constants[code[1]]); return true;
+    case OP_NIL: emit_push_constant(jit, nil_value()); return true;
+    case OP_TRUE: emit_push_constant(jit, bool_value(true)); return true;
+    case OP_FALSE: emit_push_constant(jit, bool_value(false)); return true;
+    case OP_POP: emit_move_top(jit, -1); return true;
+    case OP_DUPE: emit_push_value(jit, REG_TOP, PEEK_OFS(code[1])); return true;
+    case OP_GET_LOCAL: emit_push_value(jit, REG_SLOTS, SLOT_OFS(code[1])); return true;
+    case OP_SET_LOCAL: emit_copy_value(jit, REG_SLOTS, SLOT_OFS(code[1]), REG_TOP, PEEK_OFS(0)); return true;
+    case OP_GET_LOCAL_GET_LOCAL: {
+      emit_push_value(jit, REG_SLOTS, SLOT_OFS(code[1]));
+      emit_push_value(jit, REG_SLOTS, SLOT_OFS(code[2]));
+      return true;
+    }
+    case OP_GET_GLOBAL_SLOT:
+    case OP_SET_GLOBAL_SLOT: {
+      if (jit->function->globals_context == NULL) {
+        return false;
+      }
+      emit_global(jit, code[1], code[0] == OP_GET_GLOBAL_SLOT, offset);
+      return true;
+    }
+    case OP_JUMP: emit_jump(jit, CC_ALWAYS, next + code[1]); return true;
+    case OP_LOOP: emit_jump(jit, CC_ALWAYS, next - code[1]); return true;
+    case OP_JUMP_IF_FALSE: emit_jump_if_false(jit, next + code[1]); return true;
+    case OP_JUMP_IF_TRUE: emit_jump_if_true(jit, next + code[1]); return true;
+    case OP_JUMP_IF_NOT_NIL: emit_jump_if_not_nil(jit, next + code[1]); return true;
+    case OP_REUSE: emit_reuse(jit, code[1], offset, next + code[2]); return true;
+    case OP_CALL_INLINED: emit_call_inlined(jit, code[1], AS_FUNCTION(constants[code[2]]), offset); return true;
+    case OP_INVOKE_INLINED: {
+      ObjClass* klass = inlined_method_class(&chunk->caches[code[3]], AS_FUNCTION(constants[code[4]]), observed);
+      if (klass == NULL) {
+        return false;
+      }
+      emit_invoke_inlined(jit, code[2], klass, offset);
+      return true;
+    }
+    case OP_INVOKE: {
+      // Only in traces, which know the class of the receiver. Methods which are not cached (e.g. callable fields) are left to the
+      // interpreter.
+      InlineCache* cache = &chunk->caches[code[3]];
+      for (int i = 0; i < cache->count && observed != NULL; i++) {
+        if (cache->entries[i].klass == observed) {
+          emit_invoke(jit, code[2], observed, cache->entries[i].method, offset, next);
+          return true;
+        }
+      }
+      return false;
+    }
+    case OP_GET_PROPERTY:
+    case OP_GET_PROPERTY_OBJ: {
+      InlineCache* cache = &chunk->caches[code[2]];
+      if (cache->shape == NULL) {
+        return false;  // Has not been executed on an object with a shape yet
+      }
+      emit_get_field(jit, cache, offset);
+      return true;
+    }
+    case OP_RETURN_INLINED: {
+      emit_copy_value(jit, REG_TOP, PEEK_OFS(code[1] + 1), REG_TOP, PEEK_OFS(0));
+      emit_move_top(jit, -(code[1] + 1));
+      return true;
+    }
+
+    // Outside of traces, generic arithmetic and comparisons only get the TYPENAME_INT path. Anything else is left to the
+    // interpreter, which will most likely quicken the instruction for the next compilation.
+    case OP_ADD:
+    case OP_SUBTRACT:
+    case OP_MULTIPLY: emit_num_binary(jit, (OpCode)code[0], observed == NULL ? vm.int_class : observed, offset); return true;
+    case OP_ADD_INT_INT: emit_num_binary(jit, OP_ADD, vm.int_class, offset); return true;
+    case OP_ADD_FLOAT_FLOAT: emit_num_binary(jit, OP_ADD, vm.float_class, offset); return true;
+    case OP_SUBTRACT_INT_INT: emit_num_binary(jit, OP_SUBTRACT, vm.int_class, offset); return true;
+    case OP_SUBTRACT_FLOAT_FLOAT: emit_num_binary(jit, OP_SUBTRACT, vm.float_class, offset); return true;
+    case OP_MULTIPLY_INT_INT: emit_num_binary(jit, OP_MULTIPLY, vm.int_class, offset); return true;
+    case OP_MULTIPLY_FLOAT_FLOAT: emit_num_binary(jit, OP_MULTIPLY, vm.float_class, offset); return true;
+
+    case OP_EQ:
+    case OP_NEQ:
+    case OP_LT:
+    case OP_GT:
+    case OP_LTEQ:
+    case OP_GTEQ: emit_num_compare(jit, (OpCode)code[0], observed == NULL ? vm.int_class : observed, offset); return true;
+    case OP_LT_INT_INT: emit_num_compare(jit, OP_LT, vm.int_class, offset); return true;
+    case OP_LT_FLOAT_FLOAT: emit_num_compare(jit, OP_LT, vm.float_class, offset); return true;
+    case OP_GT_INT_INT: emit_num_compare(jit, OP_GT, vm.int_class, offset); return true;
+    case OP_GT_FLOAT_FLOAT: emit_num_compare(jit, OP_GT, vm.float_class, offset); return true;
+    case OP_LTEQ_INT_INT: emit_num_compare(jit, OP_LTEQ, vm.int_class, offset); return true;
+    case OP_LTEQ_FLOAT_FLOAT: emit_num_compare(jit, OP_LTEQ, vm.float_class, offset); return true;
+    case OP_GTEQ_INT_INT: emit_num_compare(jit, OP_GTEQ, vm.int_class, offset); return true;
+    case OP_GTEQ_FLOAT_FLOAT: emit_num_compare(jit, OP_GTEQ, vm.float_class, offset); return true;
+
+    case OP_EQ_JUMP_IF_FALSE: emit_compare_jump(jit, OP_EQ, observed, offset, next + code[1]); return true;
+    case OP_NEQ_JUMP_IF_FALSE: emit_compare_jump(jit, OP_NEQ, observed, offset, next + code[1]); return true;
+    case OP_LT_JUMP_IF_FALSE: emit_compare_jump(jit, OP_LT, observed, offset, next + code[1]); return true;
+    case OP_GT_JUMP_IF_FALSE: emit_compare_jump(jit, OP_GT, observed, offset, next + code[1]); return true;
+    case OP_LTEQ_JUMP_IF_FALSE: emit_compare_jump(jit, OP_LTEQ, observed, offset, next + code[1]); return true;
+    case OP_GTEQ_JUMP_IF_FALSE: emit_compare_jump(jit, OP_GTEQ, observed, offset, next + code[1]); return true;
+    case OP_LT_LEN_JUMP_IF_FALSE: emit_len_compare_jump(jit, offset, next + code[1]); return true;
+    case OP_GET_SUBSCRIPT_IN_BOUNDS: emit_subscript_in_bounds(jit, offset); return true;
+
+    case OP_FOR_RANGE_NEXT: emit_range_next(jit, code[1], next + code[2]); return true;
+
+    case OP_INC_LOCAL: emit_add_local(jit, code[1], 1, offset); return true;
+    case OP_DEC_LOCAL: emit_add_local(jit, code[1], -1, offset); return true;
+    case OP_ADD_LOCAL_CONST: {
+      Value constant = constants[code[2]];
+      if (is_int(constant)) {
+        emit_add_local(jit, code[1], AS_INT(constant), offset);
+        return true;
+      }
+      if (is_float(constant)) {
+        emit_add_local_float(jit, code[1], AS_FLOAT(constant), offset);
+        return true;
+      }
+      return false;
+    }
+
+    default: return false;  // Other calls, returns and everything else which is not (yet) worth a template.
+  }
+}
+
+// Emits the entry stub and the common exit. See JitFn.
+static void emit_entry_and_exit(JitCompiler* jit) {
+  emit_byte(jit, 0x53);  // push rbx
+  emit_byte(jit, 0x41);  // push r12
+  emit_byte(jit, 0x54);
+  emit_byte(jit, 0x48);  // mov rbx, rdi
+  emit_byte(jit, 0x89);
+  emit_byte(jit, 0xFB);
+  emit_mov_imm(jit, RAX, (uint64_t)(uintptr_t)&vm.stack_top);
+  emit_load(jit, REG_TOP, RAX, 0);
+  emit_byte(jit, 0xFF);  // jmp rsi
+  emit_byte(jit, 0xE6);
+
+  // The address of the instruction to continue at is in rax.
+  jit->exit_label = jit->count;
+  emit_mov_imm(jit, RCX, (uint64_t)(uintptr_t)&vm.stack_top);
+  emit_store(jit, RCX, 0, REG_TOP);
+  emit_byte(jit, 0x41);  // pop r12
+  emit_byte(jit, 0x5C);
+  emit_byte(jit, 0x5B);  // pop rbx
+  emit_byte(jit, 0xC3);  // ret
+}
+
+// Emits an exit before the instruction at [offset], e.g. loads its address into rax and jumps to the common exit.
+static void emit_exit_stub(JitCompiler* jit, int offset) {
+  emit_mov_imm(jit, RAX, (uint64_t)(uintptr_t)(jit->chunk->code + offset));
+  emit_byte(jit, 0xE9);
+  emit_u32(jit, (uint32_t)(jit->exit_label - (jit->count + 4)));
+}
+
+static void patch_rel32(JitCompiler* jit, int at, int target) {
+  uint32_t rel = (uint32_t)(target - (at + 4));
+  memcpy(jit->code + at, &rel, sizeof(rel));
+}
+
+// Resolves all jumps and emits the exit stubs. Returns false if a jump has no target.
+static bool link(JitCompiler* jit) {
+  Chunk* chunk = jit->chunk;
+  for (int i = 0; i < jit->jump_count; i++) {
+    JitPatch* jump = &jit->jumps[i];
+    if (jump->target < 0 || jump->target >= chunk->count) {
+      return false;
+    }
+    if (jit->labels[jump->target] >= 0) {
+      patch_rel32(jit, jump->at, jit->labels[jump->target]);
+    } else if (jit->trace) {
+      JIT_ARRAY_PUSH(jit->exits, jit->exit_count, jit->exit_capacity, *jump);  // Leaves the trace
+    } else {
+      return false;
+    }
+  }
+
+  // Guard failures exit through a stub per instruction, out of line so the fast paths stay compact.
+  int* stubs = malloc(sizeof(int) * (size_t)chunk->count);
+  for (int i = 0; i < chunk->count; i++) {
+    stubs[i] = -1;
+  }
+  for (int i = 0; i < jit->exit_count; i++) {
+    JitPatch* exit = &jit->exits[i];
+    if (stubs[exit->target] < 0) {
+      stubs[exit->target] = jit->count;
+      emit_exit_stub(jit, exit->target);
+    }
+    patch_rel32(jit, exit->at, stubs[exit->target]);
+  }
+  free(stubs);
+
+  return true;
+}
+
+// Translates the chunk and resolves all jumps. Returns false if the chunk contains something the compiler does not understand.
+static bool translate(JitCompiler* jit) {
+  Chunk* chunk = jit->chunk;
+  emit_entry_and_exit(jit);
+
+  for (int offset = 0; offset < chunk->count;) {
+    int length = chunk_instruction_length(chunk, offset);
+    if (length < 0) {
+      INTERNAL_ERROR("Unknown opcode %d in function '%s'.", chunk->code[offset],
+                     jit->function->name == NULL ? "" : jit->function->name->chars);
+      return false;
+    }
+
+    jit->labels[offset] = jit->count;
+    jit->entry[offset]  = compile_instruction(jit, offset, NULL);
+    if (!jit->entry[offset]) {
+      emit_exit_stub(jit, offset);
+    }
+    offset += length;
+  }
+
+  return link(jit);
+}
+
+static bool is_branch(OpCode op) {
+  switch (op) {
+    case OP_JUMP:
+    case OP_LOOP:
+    case OP_JUMP_IF_FALSE:
+    case OP_JUMP_IF_TRUE:
+    case OP_JUMP_IF_NOT_NIL:
+    case OP_REUSE:
+    case OP_EQ_JUMP_IF_FALSE:
+    case OP_NEQ_JUMP_IF_FALSE:
+    case OP_LT_JUMP_IF_FALSE:
+    case OP_GT_JUMP_IF_FALSE:
+    case OP_LTEQ_JUMP_IF_FALSE:
+    case OP_GTEQ_JUMP_IF_FALSE:
+    case OP_LT_LEN_JUMP_IF_FALSE: return true;
+    default: return false;
+  }
+}
+
+// Entering and leaving the compiled code is not free, so it is only entered where it can run for a while: At instructions which
+// start a run of at least JIT_MIN_RUN templated instructions, or a run which contains a branch. Returns false if there is no such
+// instruction, e.g. if the function is not worth compiling at all (typically short methods made up of calls and property access).
+static bool select_entries(JitCompiler* jit) {
+  Chunk* chunk = jit->chunk;
+  int* run     = malloc(sizeof(int) * (size_t)(chunk->count + 1));  // Length of the run starting at an instruction, capped.
+  bool any     = false;
+
+  run[chunk->count] = 0;
+  for (int offset = chunk->count - 1; offset >= 0; offset--) {
+    if (jit->labels[offset] < 0) {
+      continue;  // Not the start of an instruction.
+    }
+    if (!jit->entry[offset]) {
+      run[offset] = 0;
+      continue;
+    }
+    int length  = chunk_instruction_length(chunk, offset);
+    run[offset] = is_branch((OpCode)chunk->code[offset]) ? JIT_MIN_RUN : 1 + run[offset + length];
+    if (run[offset] > JIT_MIN_RUN) {
+      run[offset] = JIT_MIN_RUN;
+    }
+    jit->entry[offset] = run[offset] >= JIT_MIN_RUN;
+    any                = any || jit->entry[offset];
+  }
+
+  free(run);
+  return any;
+}
+
+// Copies the code emitted by [jit] into an executable mapping of [jit->count] bytes. Returns NULL if that fails.
+static uint8_t* make_executable(JitCompiler* jit) {
+  size_t size   = (size_t)jit->count;
+  uint8_t* code = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (code == MAP_FAILED) {
+    return NULL;
+  }
+  memcpy(code, jit->code, size);
+  if (mprotect(code, size, PROT_READ | PROT_EXEC) != 0) {
+    munmap(code, size);
+    return NULL;
+  }
+  return code;
+}
+
+bool jit_compile(ObjFunction* function) {
+  _Static_assert(sizeof(Value) == 16, "The templates assume a 16-byte value.");
+
+  Chunk* chunk = &function->chunk;
+  JitCompiler jit;
+  memset(&jit, 0, sizeof(jit));
+  jit.function = function;
+  jit.chunk    = chunk;
+  jit.labels   = malloc(sizeof(int) * (size_t)chunk->count);
+  jit.entry    = malloc(sizeof(bool) * (size_t)chunk->count);
+  for (int i = 0; i < chunk->count; i++) {
+    jit.labels[i] = -1;
+    jit.entry[i]  = false;
+  }
+
+  bool success  = translate(&jit) && select_entries(&jit);
+  uint8_t* code = success ? make_executable(&jit) : NULL;
+  if (code != NULL) {
+    JitCode* result     = malloc(sizeof(JitCode));
+    result->code        = code;
+    result->size        = (size_t)jit.count;
+    result->entry_count = chunk->count;
+    result->entries     = malloc(sizeof(uint32_t) * (size_t)chunk->count);
+    for (int i = 0; i < chunk->count; i++) {
+      result->entries[i] = jit.entry[i] ? (uint32_t)jit.labels[i] : 0;
+    }
+    function->jit = result;
+  }
+
+  free(jit.code);
+  free(jit.labels);
+  free(jit.entry);
+  free(jit.jumps);
+  free(jit.exits);
+  return code != NULL;
+}
+
+void jit_free(JitCode* jit) {
+  munmap(jit->code, jit->size);
+  free(jit->entries);
+  free(jit);
+}
+
+//
+// Traces
+//
+
+#define JIT_MAX_TRACE_LENGTH 256  // Maximum number of instructions in a trace. Longer loop bodies are not worth recording.
+#define JIT_MAX_RECORDINGS 3      // Maximum number of times a loop is recorded before the tracing tier gives up on it.
+
+// The loop being recorded. There is only ever one, since recording stops as soon as the loop returns from its frame.
+typedef struct {
+  JitTrace* trace;        // The trace being recorded. NULL if nothing is recorded.
+  ObjFunction* function;  // The function which contains the loop.
+  ptrdiff_t slots;        // Start of the stack window of the frame the loop runs on, relative to vm.stack - calls might move it.
+
+  JitTraceStep* steps;  // The instructions executed so far, starting at the loop header.
+  int step_count;
+  int step_capacity;
+} JitRecorder;
+
+static JitRecorder recorder;
+
+JitTrace* jit_trace(ObjFunction* function, uint16_t* header) {
+  for (JitTrace* trace = function->traces; trace != NULL; trace = trace->next) {
+    if (trace->header == header) {
+      return trace;
+    }
+  }
+
+  JitTrace* trace   = malloc(sizeof(JitTrace));
+  trace->header     = header;
+  trace->loop_from  = header;
+  trace->loop_to    = header;
+  trace->hotness    = 0;
+  trace->recordings = 0;
+  trace->running    = 0;
+  trace->steps      = NULL;
+  trace->step_count = 0;
+  trace->code       = NULL;
+  trace->size       = 0;
+  trace->entry      = 0;
+  trace->next       = function->traces;
+  function->traces  = trace;
+  return trace;
+}
+
+bool jit_record_start(ObjFunction* function, JitTrace* trace, Value* slots) {
+  if (trace->recordings == JIT_MAX_RECORDINGS || trace->running > 0) {
+    return false;  // Recompiling a running trace would free the code it returns to, see JitTrace
+  }
+
+  trace->recordings++;
+  recorder.trace      = trace;
+  recorder.function   = function;
+  recorder.slots      = slots - vm.stack;
+  recorder.step_count = 0;
+  return true;
+}
+
+// Stores the class of the top two values on the stack in [observed]. Returns false unless both are TYPENAME_INTs or - if
+// [floats] is true - both are TYPENAME_FLOATs, e.g. if the templates for numbers can't handle them.
+static bool observe_numbers(ObjClass** observed, bool floats) {
+  ObjClass* klass = value_type(vm.stack_top[-1]);
+  *observed       = klass;
+  return klass == value_type(vm.stack_top[-2]) && (klass == vm.int_class || (floats && klass == vm.float_class));
+}
+
+// Stores the class the template of the instruction at [ip] is specialized to in [observed], derived from its operands on the
+// stack. Returns false if the template can't handle these operands.
+static bool observe(uint16_t* ip, ObjClass** observed) {
+  *observed = NULL;
+  switch ((OpCode)ip[0]) {
+    case OP_ADD:
+    case OP_SUBTRACT:
+    case OP_MULTIPLY:
+    case OP_LT:
+    case OP_GT:
+    case OP_LTEQ:
+    case OP_GTEQ:
+    case OP_LT_JUMP_IF_FALSE:
+    case OP_GT_JUMP_IF_FALSE:
+    case OP_LTEQ_JUMP_IF_FALSE:
+    case OP_GTEQ_JUMP_IF_FALSE: return observe_numbers(observed, true);
+    case OP_EQ:
+    case OP_NEQ:
+    case OP_EQ_JUMP_IF_FALSE:
+    case OP_NEQ_JUMP_IF_FALSE: return observe_numbers(observed, false);
+    case OP_INVOKE:
+    case OP_INVOKE_INLINED: *observed = value_type(vm.stack_top[-1 - ip[2]]); return true;
+    default: return true;
+  }
+}
+
+// Whether the instruction [op] can continue with the next instruction in the chunk, e.g. is not an unconditional jump.
+static bool falls_through(OpCode op) {
+  return op != OP_JUMP && op != OP_LOOP && op != OP_REUSE;
+}
+
+// Adds the steps of the path which has just been recorded to the steps of the trace, unless they're on it already.
+static void merge_steps(JitTrace* trace) {
+  int count = trace->step_count;
+  trace->steps = realloc(trace->steps, sizeof(JitTraceStep) * (size_t)(count + recorder.step_count));
+  for (int i = 0; i < recorder.step_count; i++) {
+    bool known = false;
+    for (int j = 0; j < count && !known; j++) {
+      known = trace->steps[j].offset == recorder.steps[i].offset;
+    }
+    if (!known) {
+      trace->steps[trace->step_count++] = recorder.steps[i];
+    }
+  }
+}
+
+// Compiles the recorded paths of the loop of [trace] in [function]. Each instruction is translated with the template the
+// baseline JIT uses, but only the instructions on these paths: Jumps to any other instruction - and falling through to one -
+// exit to the interpreter. The templates of arithmetic and comparisons only handle the recorded operand types. Returns false if
+// an instruction on the trace has no template.
+static bool compile_trace(ObjFunction* function, JitTrace* trace) {
+  Chunk* chunk = &function->chunk;
+  JitCompiler jit;
+  memset(&jit, 0, sizeof(jit));
+  jit.function = function;
+  jit.chunk    = chunk;
+  jit.trace    = true;
+  jit.labels   = malloc(sizeof(int) * (size_t)chunk->count);
+  for (int i = 0; i < chunk->count; i++) {
+    jit.labels[i] = -1;
+  }
+
+  emit_entry_and_exit(&jit);
+  bool success = true;
+  for (int i = 0; i < trace->step_count && success; i++) {
+    JitTraceStep* step       = &trace->steps[i];
+    int next                 = step->offset + chunk_instruction_length(chunk, step->offset);
+    jit.labels[step->offset] = jit.count;
+    success                  = compile_instruction(&jit, step->offset, step->observed);
+
+    bool next_emitted = i + 1 < trace->step_count && trace->steps[i + 1].offset == next;
+    if (success && !next_emitted && falls_through((OpCode)chunk->code[step->offset])) {
+      emit_jump(&jit, CC_ALWAYS, next);  // The next instruction is compiled elsewhere, if at all
+    }
+  }
+
+  uint8_t* code = success && link(&jit) ? make_executable(&jit) : NULL;
+  if (code != NULL) {
+    if (trace->code != NULL) {
+      munmap(trace->code, trace->size);
+    }
+    trace->code  = code;
+    trace->size  = (size_t)jit.count;
+    trace->entry = (uint32_t)jit.labels[trace->header - chunk->code];
+  }
+
+  free(jit.code);
+  free(jit.labels);
+  free(jit.jumps);
+  free(jit.exits);
+  return code != NULL;
+}
+
+// Ends the recording. The loop starts counting again, to be recorded once more if it is still hot - or, if it has been compiled,
+// if its trace keeps exiting in the middle of the loop. Maybe it takes a path with templates for all instructions next time.
+static bool stop_recording() {
+  recorder.trace->hotness = 0;
+  recorder.trace          = NULL;
+  return false;
+}
+
+bool jit_record(ObjFunction* function, Value* slots, uint16_t* ip) {
+  JitTrace* trace = recorder.trace;
+  Chunk* chunk    = &function->chunk;
+  if (trace == NULL) {
+    return false;
+  }
+  if (slots - vm.stack > recorder.slots) {
+    return true;  // In a function the loop called. Only the instructions of the loop itself are recorded.
+  }
+  if (function != recorder.function || slots - vm.stack != recorder.slots) {
+    return stop_recording();  // Left the frame of the loop, e.g. by returning.
+  }
+  if (ip == trace->header && recorder.step_count > 0) {
+    int known = trace->step_count;
+    merge_steps(trace);
+    if (compile_trace(function, trace)) {
+      for (int i = 0; i < recorder.step_count; i++) {
+        uint16_t* at     = chunk->code + recorder.steps[i].offset;
+        trace->loop_from = at < trace->loop_from ? at : trace->loop_from;
+        trace->loop_to   = at > trace->loop_to ? at : trace->loop_to;
+      }
+    } else {
+      trace->step_count = known;  // Forget the new path, the paths recorded before still compile
+    }
+    return stop_recording();
+  }
+
+  int offset = (int)(ip - chunk->code);
+  for (int i = 0; i < recorder.step_count; i++) {
+    if (recorder.steps[i].offset == offset) {
+      return stop_recording();  // Ran an inner loop, which gets its own trace.
+    }
+  }
+
+  JitTraceStep step = {.offset = offset};
+  if (recorder.step_count == JIT_MAX_TRACE_LENGTH || !observe(ip, &step.observed)) {
+    return stop_recording();
+  }
+  JIT_ARRAY_PUSH(recorder.steps, recorder.step_count, recorder.step_capacity, step);
+  return true;
+}
+
+void jit_free_traces(JitTrace* trace) {
+  while (trace != NULL) {
+    JitTrace* next = trace->next;
+    if (trace->code != NULL) {
+      munmap(trace->code, trace->size);
+    }
+    free(trace->steps);
+    if (recorder.trace == trace) {
+      recorder.trace = NULL;
+    }
+    free(trace);
+    trace = next;
+  }
+}
+
+#undef JIT_ARRAY_PUSH
+#undef JIT_MIN_RUN
+#undef JIT_MAX_TRACE_LENGTH
+#undef JIT_MAX_RECORDINGS
+#undef CC_NEGATE
+#undef CC_ALWAYS
+#undef REG_SLOTS
+#undef REG_TOP
+#undef VALUE_SIZE
+#undef VALUE_TYPE_OFS
+#undef VALUE_AS_OFS
+#undef SLOT_OFS
+#undef PEEK_OFS
+
+#else
+
+bool jit_compile(ObjFunction* function) {
+  UNUSED(function);
+  return false;
+}
+
+void jit_free(JitCode* jit) {
+  UNUSED(jit);
+}
+
+JitTrace* jit_trace(ObjFunction* function, uint16_t* header) {
+  UNUSED(function);
+  UNUSED(header);
+  return NULL;
+}
+
+bool jit_record_start(ObjFunction* function, JitTrace* trace, Value* slots) {
+  UNUSED(function);
+  UNUSED(trace);
+  UNUSED(slots);
+  return false;
+}
+
+bool jit_record(ObjFunction* function, Value* slots, uint16_t* ip) {
+  UNUSED(function);
+  UNUSED(slots);
+  UNUSED(ip);
+  return false;
+}
+
+void jit_free_traces(JitTrace* trace) {
+  UNUSED(trace);
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef jit_h
+#define jit_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "common.h"
+#include "object.h"
+#include "value.h"
+
+// The baseline JIT translates the chunk of a hot function into x86-64 machine code, one template per instruction. The tracing
+// tier reuses the same templates for hot loops: It records the path one iteration of a loop takes through the chunk and compiles
+// just that path. Both only exist for x86-64 Linux and the default value representation - see SLANG_NAN_BOXING in common.h.
+#if defined(__x86_64__) && SLANG_PLATFORM_LINUX && !defined(SLANG_NAN_BOXING)
+#define JIT_SUPPORTED 1
+#else
+#define JIT_SUPPORTED 0
+#endif
+
+#define JIT_THRESHOLD_DEFAULT 1000      // Default number of calls after which a function is compiled.
+#define JIT_LOOP_THRESHOLD_DEFAULT 100  // Default number of iterations after which a loop is recorded.
+
+// Machine code of a compiled function.
+// The compiled code keeps all values in the vm's stack, laid out exactly like the interpreter does. That's what allows it to hand
+// control back to the interpreter before any instruction: Whenever it reaches an instruction it has no template for (e.g. calls,
+// returns) or a type guard fails, it stores the stack top and returns the address of that instruction in the chunk. The
+// interpreter executes it and re-enters the compiled code after calls and returns, and at loop back-edges - see jit_enter. Just
+// like run(), the compiled code pushes without checking the capacity of the stack, see chunk_max_depth.
+typedef struct JitCode {
+  uint8_t* code;      // Executable machine code. Starts with the entry stub, see JitFn.
+  size_t size;        // Size of the mapping which holds [code].
+  uint32_t* entries;  // Offset into [code] for each offset into the chunk. 0 if there is nothing to execute there.
+  int entry_count;    // Number of [entries], e.g. the size of the chunk.
+} JitCode;
+
+// An instruction on a trace.
+typedef struct {
+  int offset;          // Offset into the chunk of the instruction.
+  ObjClass* observed;  // Class of the operands the instruction had when it was recorded. NULL if its template doesn't need it.
+} JitTraceStep;
+
+// Machine code of a trace, e.g. of one iteration of a loop along the path it took when it was recorded. Branches which leave that
+// path, and the type guards of the operations on it, are side exits: They hand control back to the interpreter, just like the
+// compiled code of a function does. Reaching the loop's back-edge jumps right back to the start of the trace. If the trace keeps
+// exiting in the middle of the loop, the loop is recorded again and the new path is added to the trace. Methods invoked on the
+// path are called right from the trace (see vm_jit_invoke), guarded by the class of the receiver they were recorded with.
+typedef struct JitTrace {
+  uint16_t* header;       // Start of the loop, e.g. the instruction its OP_LOOP jumps back to.
+  uint16_t* loop_from;    // First instruction of the loop in the chunk, as far as the recorded paths go.
+  uint16_t* loop_to;      // Last instruction of the loop in the chunk, as far as the recorded paths go.
+  int hotness;            // Number of back-edges - or, once compiled, side exits within the loop - since the last recording.
+  int recordings;         // Number of times the loop has been recorded so far. See JIT_MAX_RECORDINGS.
+  int running;            // Number of executions of [code] in progress. Methods the trace invokes might run the loop again.
+  JitTraceStep* steps;    // The instructions on all recorded paths, in the order they are compiled in.
+  int step_count;         // Number of [steps].
+  uint8_t* code;          // Executable machine code. Starts with the entry stub, see JitFn. NULL if not compiled (yet).
+  size_t size;            // Size of the mapping which holds [code].
+  uint32_t entry;         // Offset into [code] of the loop header.
+  struct JitTrace* next;  // The next trace of the same function.
+} JitTrace;
+
+// Signature of the entry stub of a compiled function. Runs the compiled code at [entry] on the frame whose stack window starts
+// at [slots]. Returns the address of the instruction at which the interpreter has to continue.
+typedef uint16_t* (*JitFn)(Value* slots, uint8_t* entry);
+
+// Compiles [function] to machine code and stores it in the function. Returns false if the function could not be compiled, in
+// which case it continues to be interpreted.
+bool jit_compile(ObjFunction* function);
+
+// Frees the machine code of a function.
+void jit_free(JitCode* jit);
+
+// Returns the trace of the loop of [function] which starts at [header], creating it if it does not exist yet.
+JitTrace* jit_trace(ObjFunction* function, uint16_t* header);
+
+// Starts recording the next iteration of the loop of [trace] in [function], which runs on the frame whose stack window starts at
+// [slots]. The interpreter then has to call jit_record before each instruction it executes. Returns false if the loop has been
+// recorded too often already.
+bool jit_record_start(ObjFunction* function, JitTrace* trace, Value* slots);
+
+// Records the instruction [ip] points to - on the frame whose stack window starts at [slots] - right before the interpreter
+// executes it. Instructions of functions the loop calls are skipped. Once the recording is back at the start of the loop, the
+// trace is compiled. Returns false if the recording has ended, either because the trace is complete or because the loop left its
+// frame, ran an inner loop or has operands the templates can't handle.
+bool jit_record(ObjFunction* function, Value* slots, uint16_t* ip);
+
+// Frees [trace] and all the traces after it.
+void jit_free_traces(JitTrace* trace);
+
+// Executes the compiled code of [function] starting at the instruction [ip] points to, on the frame whose stack window starts
+// at [slots]. Returns the address of the instruction at which the interpreter has to continue, which is [ip] if the compiled
+// code has nothing to execute there.
+static inline uint16_t* jit_enter(ObjFunction* function, Value* slots, uint16_t* ip) {
+  JitCode* jit   = function->jit;
+  uint32_t entry = jit->entries[ip - function->chunk.code];
+  if (entry == 0) {
+    return ip;
+  }
+  return ((JitFn)(void*)jit->code)(slots, jit->code + entry);
+}
+
+// Executes the compiled code of [trace] on the frame whose stack window starts at [slots]. Returns the address of the instruction
+// at which the interpreter has to continue.
+static inline uint16_t* jit_enter_trace(JitTrace* trace, Value* slots) {
+  trace->running++;
+  uint16_t* ip = ((JitFn)(void*)trace->code)(slots, trace->code + trace->entry);
+  trace->running--;
+  return ip;
+}
+
+#endif
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "common.h"
+#include "jit.h"
 #include "vm.h"
 
 #if SLANG_PLATFORM_WINDOWS
@@ -15,7 +16,11 @@
 #define CMD___VERSION "--version"
 
 #define OPT_STRESS_GC "--stress-gc"
-#define OPT_NO_WARN "--no-warn"  // Enable warnings during compilation
+#define OPT_NO_WARN "--no-warn"                        // Enable warnings during compilation
+#define OPT_MAX_DEPTH "--max-depth"                    // Maximum call stack depth
+#define OPT_JIT "--jit"                                // Enable the baseline JIT and the tracing tier
+#define OPT_JIT_THRESHOLD "--jit-threshold"            // Number of calls after which a function is compiled
+#define OPT_JIT_LOOP_THRESHOLD "--jit-loop-threshold"  // Number of iterations after which a loop is recorded
 
 typedef struct {
   char** argv;
@@ -40,6 +45,25 @@ static bool consume_option(const char* name) {
   return false;
 }
 
+// Consumes an option [name] which is followed by a value. Returns the value, or NULL if the option is not present. Also returns
+// NULL and sets [missing_value] if the option is present, but not followed by a value.
+static char* consume_option_value(const char* name, bool* missing_value) {
+  *missing_value = false;
+  for (int i = 0; i < opts.argc; i++) {
+    if (strcmp(opts.argv[i], name) == 0) {
+      if (i + 1 >= opts.argc) {
+        *missing_value = true;
+        return NULL;
+      }
+      char* value = opts.argv[i + 1];
+      memmove(&opts.argv[i], &opts.argv[i + 2], (opts.argc - i - 2) * sizeof(char*));  // Shift the rest of the args left
+      opts.argc -= 2;
+      return value;
+    }
+  }
+  return NULL;
+}
+
 static char* pop_option(void) {
   if (opts.argc == 0) {
     return NULL;
@@ -64,6 +88,37 @@ static void usage(const char* error) {
   printf("  <options>:\n");
   printf("    " OPT_NO_WARN "                 Disable warnings during compilation\n");
   printf("    " OPT_STRESS_GC "               Enable GC stress testing\n");
+  printf("    " OPT_MAX_DEPTH " <n>           Set the maximum call stack depth (default: %d)\n", FRAMES_MAX_DEFAULT);
+  printf("    " OPT_JIT "                     Compile hot functions and loops to machine code (x86-64 Linux only)\n");
+  printf("    " OPT_JIT_THRESHOLD " <n>       Compile functions after <n> calls (default: %d)\n", JIT_THRESHOLD_DEFAULT);
+  printf("    " OPT_JIT_LOOP_THRESHOLD " <n>  Record and compile loops after <n> iterations (default: %d)\n",
+         JIT_LOOP_THRESHOLD_DEFAULT);
+}
+
+// Consumes the JIT threshold [option] and stores its value in [threshold]. Returns false if the option is not present, exits
+// if its value is not a positive integer.
+static bool consume_jit_threshold(const char* option, int* threshold) {
+  bool missing_value;
+  char* value = consume_option_value(option, &missing_value);
+  char error[128];
+  if (missing_value) {
+    snprintf(error, sizeof(error), "No value provided for %s", option);
+    usage(error);
+    exit(SLANG_EXIT_BAD_USAGE);
+  }
+  if (value == NULL) {
+    return false;
+  }
+
+  char* end;
+  long parsed = strtol(value, &end, 10);
+  if (*end != '\0' || parsed < 1 || parsed > INT_MAX) {
+    snprintf(error, sizeof(error), "Invalid value for %s. Must be a positive integer.", option);
+    usage(error);
+    exit(SLANG_EXIT_BAD_USAGE);
+  }
+  *threshold = (int)parsed;
+  return true;
 }
 
 static void configure_vm() {
@@ -73,6 +128,39 @@ static void configure_vm() {
     INTERNAL_WARN("GC stress testing enabled, can be disabled during runtime using the Gc module.");
     VM_SET_FLAG(VM_FLAG_STRESS_GC);
   }
+
+  bool missing_value;
+  char* max_depth = consume_option_value(OPT_MAX_DEPTH, &missing_value);
+  if (missing_value) {
+    usage("No value provided for " OPT_MAX_DEPTH);
+    exit(SLANG_EXIT_BAD_USAGE);
+  }
+  if (max_depth != NULL) {
+    char* end;
+    long depth = strtol(max_depth, &end, 10);
+    if (*end != '\0' || depth < 1 || depth > INT_MAX || !vm_set_max_depth((int)depth)) {
+      char error[128];
+      snprintf(error, sizeof(error), "Invalid value for " OPT_MAX_DEPTH ". Must be an integer from 1 to %d.", FRAMES_MAX_LIMIT);
+      usage(error);
+      exit(SLANG_EXIT_BAD_USAGE);
+    }
+  }
+
+  int threshold      = JIT_THRESHOLD_DEFAULT;
+  int loop_threshold = JIT_LOOP_THRESHOLD_DEFAULT;
+  bool jit           = consume_option(OPT_JIT);
+  jit                = consume_jit_threshold(OPT_JIT_THRESHOLD, &threshold) || jit;
+  jit                = consume_jit_threshold(OPT_JIT_LOOP_THRESHOLD, &loop_threshold) || jit;
+  if (jit) {
+    if (!vm_enable_jit(threshold, loop_threshold)) {
+#ifdef SLANG_NAN_BOXING
+      usage("The JIT needs the 16-byte value layout, but this build uses NaN-boxing (SLANG_NAN_BOXING).");
+#else
+      usage("The JIT is only supported on x86-64 Linux.");
+#endif
+      exit(SLANG_EXIT_BAD_USAGE);
+    }
+  }
 }
 
 static SlangExitCode repl() {
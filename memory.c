@@ -11,6 +11,7 @@
 #include "compiler.h"
 #include "gc.h"
 #include "hashtable.h"
+#include "jit.h"
 #include "object.h"
 #include "parser.h"
 #include "resolver.h"
@@ -85,18 +86,22 @@ void free_obj(Obj* object) {
     }
     case OBJ_GC_CLOSURE: {
       ObjClosure* closure = (ObjClosure*)object;
-      FREE_ARRAY(ObjUpvalue*, closure->upvalues, closure->upvalue_count);
-      FREE(ObjClosure, object);
+      reallocate(object, sizeof(ObjClosure) + sizeof(ObjUpvalue*) * (size_t)closure->upvalue_count, 0);
       break;
     }
     case OBJ_GC_FUNCTION: {
       ObjFunction* function = (ObjFunction*)object;
       chunk_free(&function->chunk);
+      if (function->jit != NULL) {
+        jit_free(function->jit);
+      }
+      jit_free_traces(function->traces);
       FREE(ObjFunction, object);
       break;
     }
     case OBJ_GC_OBJECT: {
       ObjObject* object_ = (ObjObject*)object;
+      FREE_ARRAY(Value, object_->slots, object_->slot_capacity);
       hashtable_free(&object_->fields);
       FREE(ObjObject, object);
       break;
@@ -127,6 +132,16 @@ void free_obj(Obj* object) {
       FREE(ObjUpvalue, object);
       break;
     }
+    case OBJ_GC_ITER: {
+      ObjIter* iter = (ObjIter*)object;
+      FREE_ARRAY(IterStage, iter->stages, iter->stage_count);
+      FREE(ObjIter, object);
+      break;
+    }
+    case OBJ_GC_INT: {
+      FREE(ObjInt, object);
+      break;
+    }
     default: INTERNAL_ERROR("Don't know how to free unknown object type: %d at %p", object->type, object);
   }
 
@@ -148,7 +163,7 @@ void mark_obj(Obj* object) {
 
 void mark_value(Value value) {
   if (!is_primitive(value)) {
-    mark_obj(value.as.obj);
+    mark_obj(AS_OBJ(value));
   }
 }
 
@@ -208,12 +223,24 @@ static void blacken_object(Obj* object) {
       ObjFunction* function = (ObjFunction*)object;
       mark_obj((Obj*)function->name);
       mark_obj((Obj*)function->globals_context);
+      mark_obj((Obj*)function->closure);
       mark_array(&function->chunk.constants);
+      for (int i = 0; i < function->chunk.cache_count; i++) {
+        InlineCache* cache = &function->chunk.caches[i];
+        for (int j = 0; j < cache->count; j++) {
+          mark_obj((Obj*)cache->entries[j].klass);
+          mark_obj(cache->entries[j].method);
+        }
+      }
       break;
     }
     case OBJ_GC_OBJECT: {
       ObjObject* object_ = (ObjObject*)object;
       mark_obj((Obj*)object_->instance_class);
+      int slot_count = object_->shape != NULL ? object_->shape->slot_count : object_->slot_count;
+      for (int i = 0; i < slot_count; i++) {
+        mark_value(object_->slots[i]);
+      }
       mark_hashtable(&object_->fields);
       break;
     }
@@ -233,7 +260,16 @@ static void blacken_object(Obj* object) {
       mark_obj((Obj*)native->name);
       break;
     }
-    case OBJ_GC_STRING: break;
+    case OBJ_GC_ITER: {
+      ObjIter* iter = (ObjIter*)object;
+      mark_value(iter->source);
+      for (int i = 0; i < iter->stage_count; i++) {
+        mark_value(iter->stages[i].arg);
+      }
+      break;
+    }
+    case OBJ_GC_STRING:
+    case OBJ_GC_INT: break;
     default:
       break;  // TODO (recovery): What do we do here? Throw? Probably yes, bc we
               // need to mark all objects
@@ -251,6 +287,17 @@ void free_heap() {
   gc_assign_current_worker(-1);  // Unassign
 }
 
+// Marks the field names of a shape and all shapes reachable through its transitions. Each shape only marks the name of the field
+// it adds, the others are marked by its parents.
+static void mark_shape(Shape* shape) {
+  if (shape->slot_count > 0) {
+    mark_obj((Obj*)shape->keys[shape->slot_count - 1]);
+  }
+  for (int i = 0; i < shape->transition_count; i++) {
+    mark_shape(shape->transitions[i]);
+  }
+}
+
 // Starts at the roots of the objects in the heap and marks all reachable objects. It's important that all root objects get marked
 // in this phase - if you e.g. had a root which is a long array which gets split into different mark tasks and distributed between
 // the workers, that'd be a problem because the workers are idle until after mark_roots, leaving us with not all roots marked.
@@ -284,8 +331,18 @@ static void mark_roots() {
     mark_obj((Obj*)vm.module);
   }
 
-  // Mark the current error
+  // Mark the current error, as well as the operands of a lazy one
   mark_value(vm.current_error);
+  if (vm.lazy_error.format != NULL) {
+    for (int i = 0; i < vm.lazy_error.count; i++) {
+      mark_value(vm.lazy_error.args[i]);
+    }
+  }
+
+  // The field names of all shapes
+  if (vm.root_shape != NULL) {
+    mark_shape(vm.root_shape);
+  }
 
   // And the native functions and types
   mark_hashtable(&vm.natives);
@@ -309,12 +366,12 @@ static void mark_roots() {
   mark_obj((Obj*)vm.nil_class);
   mark_obj((Obj*)vm.seq_class);
   mark_obj((Obj*)vm.tuple_class);
+  mark_obj((Obj*)vm.iter_class);
   mark_obj((Obj*)vm.str_class);
   mark_obj((Obj*)vm.fn_class);
   mark_obj((Obj*)vm.class_class);
 
   mark_obj((Obj*)vm.upvalue_class);
-  mark_obj((Obj*)vm.handler_class);
 
   mark_obj((Obj*)vm.module_class);
 
@@ -6,46 +6,46 @@
 bool native_set_prop_not_supported(Value receiver, ObjString* name, Value value) {
   UNUSED(name);
   UNUSED(value);
-  vm_error("Type %s does not support property-set access.", receiver.type->name->chars);
+  vm_error_lazy("Type %s does not support property-set access.", 1, str_value(value_type(receiver)->name));
   return false;
 }
 
 bool native_get_subs_not_supported(Value receiver, Value index, Value* result) {
   UNUSED(index);
   UNUSED(result);
-  vm_error("Type %s does not support get-subscripting.", receiver.type->name->chars);
+  vm_error_lazy("Type %s does not support get-subscripting.", 1, str_value(value_type(receiver)->name));
   return false;
 }
 
 bool native_set_subs_not_supported(Value receiver, Value index, Value value) {
   UNUSED(index);
   UNUSED(value);
-  vm_error("Type %s does not support set-subscripting.", receiver.type->name->chars);
+  vm_error_lazy("Type %s does not support set-subscripting.", 1, str_value(value_type(receiver)->name));
   return false;
 }
 
 bool native_equals_not_supported(Value self, Value other) {
   UNUSED(other);
-  vm_error("Type %s does not support equality-comparison.", self.type->name->chars);
+  vm_error_lazy("Type %s does not support equality-comparison.", 1, str_value(value_type(self)->name));
   return false;
 }
 
 uint64_t native_hash_not_supported(Value self) {
-  vm_error("Type %s does not support hashing.", self.type->name->chars);
+  vm_error_lazy("Type %s does not support hashing.", 1, str_value(value_type(self)->name));
   return false;
 }
 
 bool native_default_obj_equals(Value self, Value other) {
-  return self.type == other.type && self.as.obj->hash == other.as.obj->hash;
+  return value_type(self) == value_type(other) && AS_OBJ(self)->hash == AS_OBJ(other)->hash;
 }
 
 uint64_t native_default_obj_hash(Value self) {
-  return self.as.obj->hash;
+  return AS_OBJ(self)->hash;
 }
 
-#define NATIVE_SP_METHOD_NOT_SUPPORTED_BODY(method)                                     \
-  UNUSED(argc);                                                                         \
-  vm_error("Type %s does not support \"" STR(method) "\".", argv[0].type->name->chars); \
+#define NATIVE_SP_METHOD_NOT_SUPPORTED_BODY(method)                                                         \
+  UNUSED(argc);                                                                                             \
+  vm_error_lazy("Type %s does not support \"" STR(method) "\".", 1, str_value(value_type(argv[0])->name)); \
   return nil_value();
 
 Value native___has_not_supported(int argc, Value argv[]) {
@@ -46,6 +46,10 @@ extern void native_seq_class_finalize();
 extern ObjClass* native_tuple_class_partial_init();
 extern void native_tuple_class_finalize();
 
+// Registers the native iter class and its methods.
+extern ObjClass* native_iter_class_partial_init();
+extern void native_iter_class_finalize();
+
 // Registers the native fn class and its methods.
 extern ObjClass* native_fn_class_partial_init();
 extern void native_fn_class_finalize();
@@ -97,6 +101,12 @@ extern Value native_log(int argc, Value argv[]);
  */
 extern Value native_typeof(int argc, Value argv[]);
 
+/**
+ * TYPENAME_T.iter() -> TYPENAME_ITER
+ * @brief Returns a lazy TYPENAME_ITER over the items of a TYPENAME_SEQ or TYPENAME_TUPLE, or the characters of a TYPENAME_STRING.
+ */
+extern Value native_iter(int argc, Value argv[]);
+
 //
 // Default accessors for native classes.
 //
@@ -156,50 +166,51 @@ bool native_default_obj_equals(Value self, Value other);
 uint64_t native_default_obj_hash(Value self);
 
 // Default prop getter for any type.
-#define NATIVE_DEFAULT_GET_PROP_BODY(class)                                                       \
-  if (bind_method(class, name, result)) {                                                         \
-    return true;                                                                                  \
-  }                                                                                               \
-  vm_error("Property '%s' does not exist on value of type %s.", name->chars, class->name->chars); \
+#define NATIVE_DEFAULT_GET_PROP_BODY(class)                                                                      \
+  if (bind_method(class, name, result)) {                                                                        \
+    return true;                                                                                                 \
+  }                                                                                                              \
+  vm_error_lazy("Property '%s' does not exist on value of type %s.", 2, str_value(name), str_value(class->name)); \
   return false;
 
 //
 // Macros for argument checking in native functions and general utilities.
 //
 
-#define NATIVE_BIN_OP_ILLEGAL_TYPES(op)                                                                  \
-  vm_error("Incompatible types for binary operand '%s': %s %s %s.", #op, argv[0].type->name->chars, #op, \
-           argv[1].type->name->chars);
+#define NATIVE_BIN_OP_ILLEGAL_TYPES(op)                                                      \
+  vm_error_lazy("Incompatible types for binary operand '" #op "': %s " #op " %s.", 2,        \
+                str_value(value_type(argv[0])->name), str_value(value_type(argv[1])->name));
 
-#define NATIVE_CHECK_RECEIVER(class)                                                                       \
-  if (argv[0].type != class) {                                                                             \
-    vm_error("Expected receiver of type %s but got %s.", class->name->chars, (argv[0]).type->name->chars); \
-    return nil_value();                                                                                    \
+#define NATIVE_CHECK_RECEIVER(class)                                                                            \
+  if (value_type(argv[0]) != class) {                                                                           \
+    vm_error("Expected receiver of type %s but got %s.", class->name->chars, value_type(argv[0])->name->chars); \
+    return nil_value();                                                                                         \
   }
 
-#define NATIVE_CHECK_RECEIVER_INHERITS(class)                                                                      \
-  if (!vm_inherits(argv[0].type, class)) {                                                                         \
-    vm_error("Expected receiver to inherit type %s but got %s.", class->name->chars, (argv[0]).type->name->chars); \
-    return nil_value();                                                                                            \
+#define NATIVE_CHECK_RECEIVER_INHERITS(class)                                                                           \
+  if (!vm_inherits(value_type(argv[0]), class)) {                                                                       \
+    vm_error("Expected receiver to inherit type %s but got %s.", class->name->chars, value_type(argv[0])->name->chars); \
+    return nil_value();                                                                                                 \
   }
 
-#define NATIVE_CHECK_ARG_AT(index, class)                                                                                    \
-  if ((argv[index]).type != class) {                                                                                         \
-    vm_error("Expected argument %d of type %s but got %s.", index - 1, class->name->chars, (argv[index]).type->name->chars); \
-    return nil_value();                                                                                                      \
+#define NATIVE_CHECK_ARG_AT(index, class)                                                  \
+  if (value_type(argv[index]) != class) {                                                  \
+    vm_error("Expected argument %d of type %s but got %s.", index - 1, class->name->chars, \
+             value_type(argv[index])->name->chars);                                        \
+    return nil_value();                                                                    \
   }
 
 #define NATIVE_CHECK_ARG_AT_INHERITS(index, class)                                                       \
-  if (!vm_inherits((argv[index]).type, class)) {                                                         \
+  if (!vm_inherits(value_type(argv[index]), class)) {                                                    \
     vm_error("Expected argument %d to be a descendant of %s but got %s.", index - 1, class->name->chars, \
-             (argv[index]).type->name->chars);                                                           \
+             value_type(argv[index])->name->chars);                                                      \
     return nil_value();                                                                                  \
   }
 
-#define NATIVE_CHECK_ARG_AT_IS_CALLABLE(index)                                                             \
-  if (!is_callable(argv[index])) {                                                                         \
-    vm_error("Expected argument %d to be callable but got %s.", index - 1, argv[index].type->name->chars); \
-    return nil_value();                                                                                    \
+#define NATIVE_CHECK_ARG_AT_IS_CALLABLE(index)                                                                    \
+  if (!is_callable(argv[index])) {                                                                                \
+    vm_error("Expected argument %d to be callable but got %s.", index - 1, value_type(argv[index])->name->chars); \
+    return nil_value();                                                                                           \
   }
 
 //
@@ -212,30 +223,30 @@ uint64_t native_default_obj_hash(Value self);
     *result          = int_value(items.count);              \
     return true;                                            \
   }                                                         \
-  NATIVE_DEFAULT_GET_PROP_BODY(receiver.type)
-
-#define NATIVE_LISTLIKE_GET_SUBS_BODY()                                                                                        \
-  ValueArray items = NATIVE_LISTLIKE_GET_ARRAY(receiver);                                                                      \
-  if (!is_int(index)) {                                                                                                        \
-    vm_error("Type %s does not support get-subscripting with %s. Expected " STR(TYPENAME_INT) ".", receiver.type->name->chars, \
-             index.type->name->chars);                                                                                         \
-    return false;                                                                                                              \
-  }                                                                                                                            \
-  long long idx = index.as.integer;                                                                                            \
-  if (idx >= items.count) {                                                                                                    \
-    *result = nil_value();                                                                                                     \
-    return true;                                                                                                               \
-  }                                                                                                                            \
-                                                                                                                               \
-  /* Negative index */                                                                                                         \
-  if (idx < 0) {                                                                                                               \
-    idx += items.count;                                                                                                        \
-  }                                                                                                                            \
-  if (idx < 0) {                                                                                                               \
-    *result = nil_value();                                                                                                     \
-    return true;                                                                                                               \
-  }                                                                                                                            \
-  *result = items.values[idx];                                                                                                 \
+  NATIVE_DEFAULT_GET_PROP_BODY(value_type(receiver))
+
+#define NATIVE_LISTLIKE_GET_SUBS_BODY()                                                            \
+  ValueArray items = NATIVE_LISTLIKE_GET_ARRAY(receiver);                                          \
+  if (!is_int(index)) {                                                                            \
+    vm_error("Type %s does not support get-subscripting with %s. Expected " STR(TYPENAME_INT) ".", \
+             value_type(receiver)->name->chars, value_type(index)->name->chars);                   \
+    return false;                                                                                  \
+  }                                                                                                \
+  long long idx = AS_INT(index);                                                                   \
+  if (idx >= items.count) {                                                                        \
+    *result = nil_value();                                                                         \
+    return true;                                                                                   \
+  }                                                                                                \
+                                                                                                   \
+  /* Negative index */                                                                             \
+  if (idx < 0) {                                                                                   \
+    idx += items.count;                                                                            \
+  }                                                                                                \
+  if (idx < 0) {                                                                                   \
+    *result = nil_value();                                                                         \
+    return true;                                                                                   \
+  }                                                                                                \
+  *result = items.values[idx];                                                                     \
   return true;
 
 //
@@ -262,23 +273,24 @@ uint64_t native_default_obj_hash(Value self);
                                                                                      \
   if (is_fn(argv[1])) {                                                              \
     /* Function predicate */                                                         \
+    VmCallback callback;                                                             \
+    vm_callback_init(&callback, argv[1], 1);                                         \
     for (int i = 0; i < count; i++) {                                                \
       /* Execute the provided function on the item */                                \
-      vm_push(argv[1]);         /* Push the function */                              \
-      vm_push(items.values[i]); /* Push the item */                                  \
-      Value result = vm_exec_callable(argv[1], 1);                                   \
+      Value args[] = {items.values[i]};                                              \
+      Value result = vm_callback_call(&callback, args);                              \
       if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                          \
         return nil_value(); /* Propagate the error */                                \
       }                                                                              \
       /* We don't use vm_is_falsey here, because we want a boolean value. */         \
-      if (is_bool(result) && result.as.boolean) {                                    \
+      if (is_bool(result) && AS_BOOL(result)) {                                      \
         return bool_value(true);                                                     \
       }                                                                              \
     }                                                                                \
   } else {                                                                           \
     /* Value equality */                                                             \
     for (int i = 0; i < count; i++) {                                                \
-      if (argv[1].type->__equals(argv[1], items.values[i])) {                        \
+      if (value_type(argv[1])->__equals(argv[1], items.values[i])) {                 \
         return bool_value(true);                                                     \
       }                                                                              \
     }                                                                                \
@@ -302,7 +314,7 @@ uint64_t native_default_obj_hash(Value self);
   for (int i = 0; i < items.count; i++) {                                                                             \
     /* Execute the to_str method on the item */                                                                       \
     vm_push(items.values[i]); /* Push the receiver (item at i) for to_str */                                          \
-    ObjString* item_str = AS_STR(vm_exec_callable(fn_value(items.values[i].type->__to_str), 0));                      \
+    ObjString* item_str = AS_STR(vm_exec_callable(fn_value(value_type(items.values[i])->__to_str), 0));               \
     if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                             \
       return nil_value();                                                                                             \
     }                                                                                                                 \
@@ -359,8 +371,8 @@ uint64_t native_default_obj_hash(Value self);
     return NATIVE_LISTLIKE_NEW_EMPTY();                                    \
   }                                                                        \
                                                                            \
-  int start = (int)argv[1].as.integer;                                     \
-  int end   = (int)argv[2].as.integer;                                     \
+  int start = (int)AS_INT(argv[1]);                                        \
+  int end   = (int)AS_INT(argv[2]);                                        \
                                                                            \
   /* Handle negative indices */                                            \
   if (start < 0) {                                                         \
@@ -411,24 +423,25 @@ uint64_t native_default_obj_hash(Value self);
                                                                                                           \
   if (is_fn(argv[1])) {                                                                                   \
     /* Function predicate */                                                                              \
+    VmCallback callback;                                                                                  \
+    vm_callback_init(&callback, argv[1], 1);                                                              \
     for (int i = 0; i < count; i++) {                                                                     \
       /* Execute the provided function on the item */                                                     \
-      vm_push(argv[1]);         /* Push the function */                                                   \
-      vm_push(items.values[i]); /* Push the item */                                                       \
-      Value result = vm_exec_callable(argv[1], 1);                                                        \
+      Value args[] = {items.values[i]};                                                                   \
+      Value result = vm_callback_call(&callback, args);                                                   \
       if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                               \
         return nil_value(); /* Propagate the error */                                                     \
       }                                                                                                   \
                                                                                                           \
       /* We don't use vm_is_falsey here, because we want to check for a boolean value. */                 \
-      if (is_bool(result) && result.as.boolean) {                                                         \
+      if (is_bool(result) && AS_BOOL(result)) {                                                           \
         return int_value(i);                                                                              \
       }                                                                                                   \
     }                                                                                                     \
   } else {                                                                                                \
     /* Value equality */                                                                                  \
     for (int i = 0; i < count; i++) {                                                                     \
-      if (argv[1].type->__equals(argv[1], items.values[i])) {                                             \
+      if (value_type(argv[1])->__equals(argv[1], items.values[i])) {                                      \
         return int_value(i);                                                                              \
       }                                                                                                   \
     }                                                                                                     \
@@ -454,17 +467,18 @@ uint64_t native_default_obj_hash(Value self);
   int count = items.count; /* We need to store this, because the listlike might change during the loop */ \
                                                                                                           \
   /* Function predicate */                                                                                \
+  VmCallback callback;                                                                                    \
+  vm_callback_init(&callback, argv[1], 1);                                                                \
   for (int i = 0; i < count; i++) {                                                                       \
     /* Execute the provided function on the item */                                                       \
-    vm_push(argv[1]);         /* Push the function */                                                     \
-    vm_push(items.values[i]); /* Push the item */                                                         \
-    Value result = vm_exec_callable(argv[1], 1);                                                          \
+    Value args[] = {items.values[i]};                                                                     \
+    Value result = vm_callback_call(&callback, args);                                                     \
     if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                 \
       return nil_value(); /* Propagate the error */                                                       \
     }                                                                                                     \
                                                                                                           \
     /* We don't use vm_is_falsey here, because we want to check for a boolean value. */                   \
-    if (is_bool(result) && result.as.boolean) {                                                           \
+    if (is_bool(result) && AS_BOOL(result)) {                                                             \
       return items.values[i];                                                                             \
     }                                                                                                     \
   }                                                                                                       \
@@ -489,17 +503,18 @@ uint64_t native_default_obj_hash(Value self);
   int count = items.count; /* We need to store this, because the listlike might change during the loop */ \
                                                                                                           \
   /* Function predicate */                                                                                \
+  VmCallback callback;                                                                                    \
+  vm_callback_init(&callback, argv[1], 1);                                                                \
   for (int i = count - 1; i >= 0; i--) {                                                                  \
     /* Execute the provided function on the item */                                                       \
-    vm_push(argv[1]);         /* Push the function */                                                     \
-    vm_push(items.values[i]); /* Push the item */                                                         \
-    Value result = vm_exec_callable(argv[1], 1);                                                          \
+    Value args[] = {items.values[i]};                                                                     \
+    Value result = vm_callback_call(&callback, args);                                                     \
     if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                 \
       return nil_value(); /* Propagate the error */                                                       \
     }                                                                                                     \
                                                                                                           \
     /* We don't use vm_is_falsey here, because we want to check for a boolean value. */                   \
-    if (is_bool(result) && result.as.boolean) {                                                           \
+    if (is_bool(result) && AS_BOOL(result)) {                                                             \
       return items.values[i];                                                                             \
     }                                                                                                     \
   }                                                                                                       \
@@ -520,13 +535,15 @@ uint64_t native_default_obj_hash(Value self);
   int fn_arity     = callable_get_arity(argv[1]);                                                                \
   int count        = items.count; /* We need to store this, because the listlike might change during the loop */ \
                                                                                                                  \
+  VmCallback callback;                                                                                           \
+  vm_callback_init(&callback, argv[1], fn_arity);                                                                \
+                                                                                                                 \
   /* Loops are duplicated to avoid the overhead of checking the arity on each iteration */                       \
   switch (fn_arity) {                                                                                            \
     case 0: {                                                                                                    \
       for (int i = 0; i < count; i++) {                                                                          \
         /* Execute the provided function on the item */                                                          \
-        vm_push(argv[1]); /* Push the function */                                                                \
-        vm_exec_callable(argv[1], 0);                                                                            \
+        vm_callback_call(&callback, NULL);                                                                       \
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                    \
           return nil_value(); /* Propagate the error */                                                          \
         }                                                                                                        \
@@ -536,9 +553,8 @@ uint64_t native_default_obj_hash(Value self);
     case 1: {                                                                                                    \
       for (int i = 0; i < count; i++) {                                                                          \
         /* Execute the provided function on the item */                                                          \
-        vm_push(argv[1]);         /* Push the function */                                                        \
-        vm_push(items.values[i]); /* arg0: Push the item */                                                      \
-        vm_exec_callable(argv[1], 1);                                                                            \
+        Value args[] = {items.values[i]};                                                                        \
+        vm_callback_call(&callback, args);                                                                       \
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                    \
           return nil_value(); /* Propagate the error */                                                          \
         }                                                                                                        \
@@ -548,10 +564,8 @@ uint64_t native_default_obj_hash(Value self);
     case 2: {                                                                                                    \
       for (int i = 0; i < count; i++) {                                                                          \
         /* Execute the provided function on the item */                                                          \
-        vm_push(argv[1]);         /* Push the function */                                                        \
-        vm_push(items.values[i]); /* arg0 (1): Push the item */                                                  \
-        vm_push(int_value(i));    /* arg1 (2): Push the index */                                                 \
-        vm_exec_callable(argv[1], 2);                                                                            \
+        Value args[] = {items.values[i], int_value(i)};                                                          \
+        vm_callback_call(&callback, args);                                                                       \
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                    \
           return nil_value(); /* Propagate the error */                                                          \
         }                                                                                                        \
@@ -581,13 +595,15 @@ uint64_t native_default_obj_hash(Value self);
   int count         = items.count; /* We need to store this, because the listlike might change during the loop */ \
   ValueArray mapped = value_array_init_of_size(count);                                                            \
                                                                                                                   \
+  VmCallback callback;                                                                                            \
+  vm_callback_init(&callback, argv[1], fn_arity);                                                                 \
+                                                                                                                  \
   /* Loops are duplicated to avoid the overhead of checking the arity on each iteration */                        \
   switch (fn_arity) {                                                                                             \
     case 0: {                                                                                                     \
       while (mapped.count < count) {                                                                              \
         /* Execute the provided function on the item */                                                           \
-        vm_push(argv[1]); /* Push the function */                                                                 \
-        mapped.values[mapped.count] = vm_exec_callable(argv[1], 0);                                               \
+        mapped.values[mapped.count] = vm_callback_call(&callback, NULL);                                          \
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                     \
           return nil_value(); /* Propagate the error */                                                           \
         }                                                                                                         \
@@ -599,9 +615,8 @@ uint64_t native_default_obj_hash(Value self);
     case 1: {                                                                                                     \
       while (mapped.count < count) {                                                                              \
         /* Execute the provided function on the item */                                                           \
-        vm_push(argv[1]);                    /* Push the function */                                              \
-        vm_push(items.values[mapped.count]); /* arg0 (1): Push the item */                                        \
-        mapped.values[mapped.count] = vm_exec_callable(argv[1], 1);                                               \
+        Value args[]                = {items.values[mapped.count]};                                               \
+        mapped.values[mapped.count] = vm_callback_call(&callback, args);                                          \
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                     \
           return nil_value(); /* Propagate the error */                                                           \
         }                                                                                                         \
@@ -613,10 +628,8 @@ uint64_t native_default_obj_hash(Value self);
     case 2: {                                                                                                     \
       while (mapped.count < count) {                                                                              \
         /* Execute the provided function on the item */                                                           \
-        vm_push(argv[1]);                    /* Push the function */                                              \
-        vm_push(items.values[mapped.count]); /* arg0 (1): Push the item */                                        \
-        vm_push(int_value(mapped.count));    /* arg1 (2): Push the index */                                       \
-        mapped.values[mapped.count] = vm_exec_callable(argv[1], 2);                                               \
+        Value args[]                = {items.values[mapped.count], int_value(mapped.count)};                      \
+        mapped.values[mapped.count] = vm_callback_call(&callback, args);                                          \
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                     \
           return nil_value(); /* Propagate the error */                                                           \
         }                                                                                                         \
@@ -657,20 +670,22 @@ uint64_t native_default_obj_hash(Value self);
   value_array_init(&filtered_items);                                                                                  \
   int filtered_count = 0; /* Need to track this so we can clean the stack from the pushed values for GC protection */ \
                                                                                                                       \
+  VmCallback callback;                                                                                                \
+  vm_callback_init(&callback, argv[1], fn_arity);                                                                     \
+                                                                                                                      \
   /* Loops are duplicated to avoid the overhead of checking the arity on each iteration */                            \
   switch (fn_arity) {                                                                                                 \
     case 1: {                                                                                                         \
       for (int i = 0; i < count; i++) {                                                                               \
         /* Execute the provided function on the item */                                                               \
-        vm_push(argv[1]);         /* Push the function */                                                             \
-        vm_push(items.values[i]); /* arg0 (1): Push the item */                                                       \
-        Value result = vm_exec_callable(argv[1], 1);                                                                  \
+        Value args[] = {items.values[i]};                                                                             \
+        Value result = vm_callback_call(&callback, args);                                                             \
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                         \
           return nil_value(); /* Propagate the error */                                                               \
         }                                                                                                             \
                                                                                                                       \
         /* We don't use vm_is_falsey here, because we want to check for a boolean value. */                           \
-        if (is_bool(result) && result.as.boolean) {                                                                   \
+        if (is_bool(result) && AS_BOOL(result)) {                                                                     \
           vm_push(result); /* GC Protection */                                                                        \
           filtered_count++;                                                                                           \
           value_array_write(&filtered_items, items.values[i]);                                                        \
@@ -681,16 +696,14 @@ uint64_t native_default_obj_hash(Value self);
     case 2: {                                                                                                         \
       for (int i = 0; i < count; i++) {                                                                               \
         /* Execute the provided function on the item */                                                               \
-        vm_push(argv[1]);         /* Push the function */                                                             \
-        vm_push(items.values[i]); /* arg0 (1): Push the item */                                                       \
-        vm_push(int_value(i));    /* arg1 (2): Push the index */                                                      \
-        Value result = vm_exec_callable(argv[1], 2);                                                                  \
+        Value args[] = {items.values[i], int_value(i)};                                                               \
+        Value result = vm_callback_call(&callback, args);                                                             \
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                         \
           return nil_value(); /* Propagate the error */                                                               \
         }                                                                                                             \
                                                                                                                       \
         /* We don't use vm_is_falsey here, because we want to check for a boolean value. */                           \
-        if (is_bool(result) && result.as.boolean) {                                                                   \
+        if (is_bool(result) && AS_BOOL(result)) {                                                                     \
           vm_push(result); /* GC Protection */                                                                        \
           filtered_count++;                                                                                           \
           value_array_write(&filtered_items, items.values[i]);                                                        \
@@ -734,7 +747,7 @@ uint64_t native_default_obj_hash(Value self);
     if (!is_str(items.values[i])) {                                                                        \
       /* Execute the to_str method on the item */                                                          \
       vm_push(items.values[i]); /* Push the receiver (item at i) for to_str, or */                         \
-      item_str = AS_STR(vm_exec_callable(fn_value(items.values[i].type->__to_str), 0));                    \
+      item_str = AS_STR(vm_exec_callable(fn_value(value_type(items.values[i])->__to_str), 0));             \
       if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                \
         return nil_value();                                                                                \
       }                                                                                                    \
@@ -800,20 +813,22 @@ uint64_t native_default_obj_hash(Value self);
   int fn_arity     = callable_get_arity(argv[1]);                                                                \
   int count        = items.count; /* We need to store this, because the listlike might change during the loop */ \
                                                                                                                  \
+  VmCallback callback;                                                                                           \
+  vm_callback_init(&callback, argv[1], fn_arity);                                                                \
+                                                                                                                 \
   /* Loops are duplicated to avoid the overhead of checking the arity on each iteration */                       \
   switch (fn_arity) {                                                                                            \
     case 1: {                                                                                                    \
       for (int i = 0; i < count; i++) {                                                                          \
         /* Execute the provided function on the item */                                                          \
-        vm_push(argv[1]);         /* Push the function */                                                        \
-        vm_push(items.values[i]); /* arg0 (1): Push the item */                                                  \
-        Value result = vm_exec_callable(argv[1], 1);                                                             \
+        Value args[] = {items.values[i]};                                                                        \
+        Value result = vm_callback_call(&callback, args);                                                        \
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                    \
           return nil_value(); /* Propagate the error */                                                          \
         }                                                                                                        \
                                                                                                                  \
         /* We don't use vm_is_falsey here, because we want to check for a boolean value. */                      \
-        if (!is_bool(result) || !result.as.boolean) {                                                            \
+        if (!is_bool(result) || !AS_BOOL(result)) {                                                              \
           return bool_value(false);                                                                              \
         }                                                                                                        \
       }                                                                                                          \
@@ -822,16 +837,14 @@ uint64_t native_default_obj_hash(Value self);
     case 2: {                                                                                                    \
       for (int i = 0; i < count; i++) {                                                                          \
         /* Execute the provided function on the item */                                                          \
-        vm_push(argv[1]);         /* Push the function */                                                        \
-        vm_push(items.values[i]); /* arg0 (1): Push the item */                                                  \
-        vm_push(int_value(i));    /* arg1 (2): Push the index */                                                 \
-        Value result = vm_exec_callable(argv[1], 2);                                                             \
+        Value args[] = {items.values[i], int_value(i)};                                                          \
+        Value result = vm_callback_call(&callback, args);                                                        \
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                    \
           return nil_value(); /* Propagate the error */                                                          \
         }                                                                                                        \
                                                                                                                  \
         /* We don't use vm_is_falsey here, because we want to check for a boolean value. */                      \
-        if (!is_bool(result) || !result.as.boolean) {                                                            \
+        if (!is_bool(result) || !AS_BOOL(result)) {                                                              \
           return bool_value(false);                                                                              \
         }                                                                                                        \
       }                                                                                                          \
@@ -863,20 +876,22 @@ uint64_t native_default_obj_hash(Value self);
   int fn_arity     = callable_get_arity(argv[1]);                                                                \
   int count        = items.count; /* We need to store this, because the listlike might change during the loop */ \
                                                                                                                  \
+  VmCallback callback;                                                                                           \
+  vm_callback_init(&callback, argv[1], fn_arity);                                                                \
+                                                                                                                 \
   /* Loops are duplicated to avoid the overhead of checking the arity on each iteration */                       \
   switch (fn_arity) {                                                                                            \
     case 1: {                                                                                                    \
       for (int i = 0; i < count; i++) {                                                                          \
         /* Execute the provided function on the item */                                                          \
-        vm_push(argv[1]);         /* Push the function */                                                        \
-        vm_push(items.values[i]); /* arg0 (1): Push the item */                                                  \
-        Value result = vm_exec_callable(argv[1], 1);                                                             \
+        Value args[] = {items.values[i]};                                                                        \
+        Value result = vm_callback_call(&callback, args);                                                        \
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                    \
           return nil_value(); /* Propagate the error */                                                          \
         }                                                                                                        \
                                                                                                                  \
         /* We don't use vm_is_falsey here, because we want to check for a boolean value. */                      \
-        if (is_bool(result) && result.as.boolean) {                                                              \
+        if (is_bool(result) && AS_BOOL(result)) {                                                                \
           return bool_value(true);                                                                               \
         }                                                                                                        \
       }                                                                                                          \
@@ -885,16 +900,14 @@ uint64_t native_default_obj_hash(Value self);
     case 2: {                                                                                                    \
       for (int i = 0; i < count; i++) {                                                                          \
         /* Execute the provided function on the item */                                                          \
-        vm_push(argv[1]);         /* Push the function */                                                        \
-        vm_push(items.values[i]); /* arg0 (1): Push the item */                                                  \
-        vm_push(int_value(i));    /* arg1 (2): Push the index */                                                 \
-        Value result = vm_exec_callable(argv[1], 2);                                                             \
+        Value args[] = {items.values[i], int_value(i)};                                                          \
+        Value result = vm_callback_call(&callback, args);                                                        \
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                    \
           return nil_value(); /* Propagate the error */                                                          \
         }                                                                                                        \
                                                                                                                  \
         /* We don't use vm_is_falsey here, because we want to check for a boolean value. */                      \
-        if (is_bool(result) && result.as.boolean) {                                                              \
+        if (is_bool(result) && AS_BOOL(result)) {                                                                \
           return bool_value(true);                                                                               \
         }                                                                                                        \
       }                                                                                                          \
@@ -924,15 +937,16 @@ uint64_t native_default_obj_hash(Value self);
   int fn_arity      = callable_get_arity(argv[2]);                                                                \
   int count         = items.count; /* We need to store this, because the listlike might change during the loop */ \
                                                                                                                   \
+  VmCallback callback;                                                                                            \
+  vm_callback_init(&callback, argv[2], fn_arity);                                                                 \
+                                                                                                                  \
   /* Loops are duplicated to avoid the overhead of checking the arity on each iteration */                        \
   switch (fn_arity) {                                                                                             \
     case 2: {                                                                                                     \
       for (int i = 0; i < count; i++) {                                                                           \
         /* Execute the provided function on the item */                                                           \
-        vm_push(argv[2]);         /* Push the function */                                                         \
-        vm_push(accumulator);     /* arg0 (1): Push the accumulator */                                            \
-        vm_push(items.values[i]); /* arg1 (2): Push the item */                                                   \
-        accumulator = vm_exec_callable(argv[2], 2);                                                               \
+        Value args[] = {accumulator, items.values[i]};                                                            \
+        accumulator  = vm_callback_call(&callback, args);                                                         \
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                     \
           return nil_value(); /* Propagate the error */                                                           \
         }                                                                                                         \
@@ -942,11 +956,8 @@ uint64_t native_default_obj_hash(Value self);
     case 3: {                                                                                                     \
       for (int i = 0; i < count; i++) {                                                                           \
         /* Execute the provided function on the item */                                                           \
-        vm_push(argv[2]);         /* Push the function */                                                         \
-        vm_push(accumulator);     /* arg0 (1): Push the accumulator */                                            \
-        vm_push(items.values[i]); /* arg1 (2): Push the item */                                                   \
-        vm_push(int_value(i));    /* arg2 (3): Push the index */                                                  \
-        accumulator = vm_exec_callable(argv[2], 3);                                                               \
+        Value args[] = {accumulator, items.values[i], int_value(i)};                                              \
+        accumulator  = vm_callback_call(&callback, args);                                                         \
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                     \
           return nil_value(); /* Propagate the error */                                                           \
         }                                                                                                         \
@@ -988,24 +999,25 @@ uint64_t native_default_obj_hash(Value self);
     }                                                                                                           \
                                                                                                                 \
     /* Function predicate */                                                                                    \
+    VmCallback callback;                                                                                        \
+    vm_callback_init(&callback, argv[1], 1);                                                                    \
     for (int i = 0; i < count; i++) {                                                                           \
       /* Execute the provided function on the item */                                                           \
-      vm_push(argv[1]);         /* Push the function */                                                         \
-      vm_push(items.values[i]); /* Push the item */                                                             \
-      Value result = vm_exec_callable(argv[1], 1);                                                              \
+      Value args[] = {items.values[i]};                                                                         \
+      Value result = vm_callback_call(&callback, args);                                                         \
       if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                     \
         return nil_value(); /* Propagate the error */                                                           \
       }                                                                                                         \
                                                                                                                 \
       /* We don't use vm_is_falsey here, because we want to check for a boolean value. */                       \
-      if (is_bool(result) && result.as.boolean) {                                                               \
+      if (is_bool(result) && AS_BOOL(result)) {                                                                 \
         occurrences++;                                                                                          \
       }                                                                                                         \
     }                                                                                                           \
   } else {                                                                                                      \
     /* Value equality */                                                                                        \
     for (int i = 0; i < count; i++) {                                                                           \
-      if (argv[1].type->__equals(argv[1], items.values[i])) {                                                   \
+      if (value_type(argv[1])->__equals(argv[1], items.values[i])) {                                            \
         occurrences++;                                                                                          \
       }                                                                                                         \
     }                                                                                                           \
@@ -1056,7 +1068,7 @@ uint64_t native_default_obj_hash(Value self);
   sorted.count = items.count;                                                                                    \
                                                                                                                  \
   SortCompareWrapperFn cmp_fn_wrapper = value_array_sort_compare_wrapper_native;                                 \
-  Value cmp_fn                        = nil_value();                                                             \
+  VmCallback* cmp_fn                  = NULL;                                                                    \
   if (sorted.count <= VALUE_ARRAY_QUICKSORT_THRESHOLD) {                                                         \
     value_array_insertion_sort(&sorted, cmp_fn_wrapper, cmp_fn);                                                 \
   } else {                                                                                                       \
@@ -1096,8 +1108,11 @@ uint64_t native_default_obj_hash(Value self);
   memcpy(sorted.values, items.values, items.count * sizeof(Value));                                              \
   sorted.count = items.count;                                                                                    \
                                                                                                                  \
+  VmCallback callback;                                                                                           \
+  vm_callback_init(&callback, argv[1], 2);                                                                       \
+                                                                                                                 \
   SortCompareWrapperFn cmp_fn_wrapper = value_array_sort_compare_wrapper_custom;                                 \
-  Value cmp_fn                        = argv[1];                                                                 \
+  VmCallback* cmp_fn                  = &callback;                                                               \
   if (sorted.count <= VALUE_ARRAY_QUICKSORT_THRESHOLD) {                                                         \
     value_array_insertion_sort(&sorted, cmp_fn_wrapper, cmp_fn);                                                 \
   } else {                                                                                                       \
@@ -1129,7 +1144,7 @@ uint64_t native_default_obj_hash(Value self);
   Value min = items.values[0];                                                                                 \
   /* We just use value_array_sort_compare_wrapper_native to get the min value, so it's consistent with sort */ \
   for (int i = 1; i < items.count; i++) {                                                                      \
-    if (value_array_sort_compare_wrapper_native(min, items.values[i], nil_value()) > 0) {                      \
+    if (value_array_sort_compare_wrapper_native(min, items.values[i], NULL) > 0) {                             \
       min = items.values[i];                                                                                   \
     }                                                                                                          \
   }                                                                                                            \
@@ -1142,35 +1157,35 @@ uint64_t native_default_obj_hash(Value self);
  * TYPENAME_T is empty. Uses the default "SP_METHOD_GT" method of the items type
  * to compare the items.
  */
-#define NATIVE_LISTLIKE_MAX_BODY(class)                                                                                    \
-  UNUSED(argc);                                                                                                            \
-  NATIVE_CHECK_RECEIVER(class);                                                                                            \
-                                                                                                                           \
-  ValueArray items = NATIVE_LISTLIKE_GET_ARRAY(argv[0]);                                                                   \
-  if (items.count == 0) {                                                                                                  \
-    return nil_value();                                                                                                    \
-  }                                                                                                                        \
-                                                                                                                           \
-  Value max = items.values[0];                                                                                             \
-  for (int i = 0; i < items.count; i++) {                                                                                  \
-    vm_push(max);                                                                                                          \
-    vm_push(items.values[i]);                                                                                              \
-    Value result = vm_exec_callable(fn_value(max.type->__gt), 1);                                                          \
-    if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                                                  \
-      return nil_value();                                                                                                  \
-    }                                                                                                                      \
-                                                                                                                           \
-    if (!is_bool(result)) {                                                                                                \
-      vm_error("Method \"%s." STR(SP_METHOD_GT) "\" must return a " STR(TYPENAME_BOOL) ". Got %s.", max.type->name->chars, \
-               result.type->name->chars);                                                                                  \
-      return nil_value();                                                                                                  \
-    }                                                                                                                      \
-                                                                                                                           \
-    if (!result.as.boolean) {                                                                                              \
-      max = items.values[i];                                                                                               \
-    }                                                                                                                      \
-  }                                                                                                                        \
-                                                                                                                           \
+#define NATIVE_LISTLIKE_MAX_BODY(class)                                                             \
+  UNUSED(argc);                                                                                     \
+  NATIVE_CHECK_RECEIVER(class);                                                                     \
+                                                                                                    \
+  ValueArray items = NATIVE_LISTLIKE_GET_ARRAY(argv[0]);                                            \
+  if (items.count == 0) {                                                                           \
+    return nil_value();                                                                             \
+  }                                                                                                 \
+                                                                                                    \
+  Value max = items.values[0];                                                                      \
+  for (int i = 0; i < items.count; i++) {                                                           \
+    vm_push(max);                                                                                   \
+    vm_push(items.values[i]);                                                                       \
+    Value result = vm_exec_callable(fn_value(value_type(max)->__gt), 1);                            \
+    if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                           \
+      return nil_value();                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    if (!is_bool(result)) {                                                                         \
+      vm_error("Method \"%s." STR(SP_METHOD_GT) "\" must return a " STR(TYPENAME_BOOL) ". Got %s.", \
+               value_type(max)->name->chars, value_type(result)->name->chars);                      \
+      return nil_value();                                                                           \
+    }                                                                                               \
+                                                                                                    \
+    if (!AS_BOOL(result)) {                                                                         \
+      max = items.values[i];                                                                        \
+    }                                                                                               \
+  }                                                                                                 \
+                                                                                                    \
   return max;
 
 /**
@@ -1188,7 +1203,7 @@ uint64_t native_default_obj_hash(Value self);
   }                                                      \
                                                          \
   Value sum    = items.values[0];                        \
-  Value add_fn = fn_value(sum.type->__add);              \
+  Value add_fn = fn_value(value_type(sum)->__add);       \
   for (int i = 1; i < items.count; i++) {                \
     vm_push(sum);             /* receiver (arg a) */     \
     vm_push(items.values[i]); /* arg b */                \
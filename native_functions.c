@@ -29,7 +29,7 @@ Value native_cwd(int argc, Value argv[]) {
   }
 
   Value cwd;
-  if (!hashtable_get_by_string(&vm.module->fields, vm.special_prop_names[SPECIAL_PROP_FILE_PATH], &cwd)) {
+  if (!object_get_field_by_string(vm.module, vm.special_prop_names[SPECIAL_PROP_FILE_PATH], &cwd)) {
     return nil_value();
   }
 
@@ -40,7 +40,7 @@ Value native_log(int argc, Value argv[]) {
   for (int i = 1 /* Skip receiver */; i <= argc; i++) {
     // Execute the to_str method on the receiver
     vm_push(argv[i]);  // Load the receiver onto the stack
-    ObjString* str = AS_STR(vm_exec_callable(fn_value(argv[i].type->__to_str), 0));
+    ObjString* str = AS_STR(vm_exec_callable(fn_value(value_type(argv[i])->__to_str), 0));
     if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
       return nil_value();
     }
@@ -56,6 +56,6 @@ Value native_log(int argc, Value argv[]) {
 
 Value native_typeof(int argc, Value argv[]) {
   UNUSED(argc);
-  ObjClass* klass = argv[1].type;
+  ObjClass* klass = value_type(argv[1]);
   return class_value(klass);
 }
@@ -17,10 +17,10 @@ void native_register_debug_module() {
   ObjObject* debug_module = vm_make_module(NULL, STR(MODULE_NAME));
   define_value(&vm.modules, STR(MODULE_NAME), instance_value(debug_module));
 
-  define_native(&debug_module->fields, "stack", native_debug_stack, 0);
-  define_native(&debug_module->fields, "version", native_debug_version, 0);
-  define_native(&debug_module->fields, "modules", native_debug_modules, 0);
-  define_native(&debug_module->fields, "heap", native_debug_heap, 0);
+  define_module_native(debug_module, "stack", native_debug_stack, 0);
+  define_module_native(debug_module, "version", native_debug_version, 0);
+  define_module_native(debug_module, "modules", native_debug_modules, 0);
+  define_module_native(debug_module, "heap", native_debug_heap, 0);
 }
 
 /**
@@ -92,6 +92,8 @@ static Value native_debug_heap(int argc, Value argv[]) {
       case OBJ_GC_UPVALUE: printf(STR(TYPENAME_UPVALUE)); break;
       case OBJ_GC_SEQ: printf(STR(TYPENAME_SEQ)); break;
       case OBJ_GC_TUPLE: printf(STR(TYPENAME_TUPLE)); break;
+      case OBJ_GC_ITER: printf(STR(TYPENAME_ITER)); break;
+      case OBJ_GC_INT: printf(STR(TYPENAME_INT) " %lld", ((ObjInt*)object)->value); break;
       default: INTERNAL_ERROR("Unknown object type"); break;
     }
     printf("\n");
@@ -19,13 +19,13 @@ void native_register_file_module() {
   ObjObject* file_module = vm_make_module(NULL, STR(MODULE_NAME));
   define_value(&vm.modules, STR(MODULE_NAME), instance_value(file_module));
 
-  define_value(&file_module->fields, "newl", str_value(copy_string(SLANG_ENV_NEWLINE, (int)strlen(SLANG_ENV_NEWLINE))));
-  define_value(&file_module->fields, "sep", str_value(copy_string(SLANG_PATH_SEPARATOR_STR, (int)strlen(SLANG_PATH_SEPARATOR_STR))));
+  define_module_value(file_module, "newl", str_value(copy_string(SLANG_ENV_NEWLINE, (int)strlen(SLANG_ENV_NEWLINE))));
+  define_module_value(file_module, "sep", str_value(copy_string(SLANG_PATH_SEPARATOR_STR, (int)strlen(SLANG_PATH_SEPARATOR_STR))));
 
-  define_native(&file_module->fields, "read", native_file_read, 1);
-  define_native(&file_module->fields, "write", native_file_write, 2);
-  define_native(&file_module->fields, "exists", native_file_exists, 1);
-  define_native(&file_module->fields, "join_path", native_file_join_path, 2);
+  define_module_native(file_module, "read", native_file_read, 1);
+  define_module_native(file_module, "write", native_file_write, 2);
+  define_module_native(file_module, "exists", native_file_exists, 1);
+  define_module_native(file_module, "join_path", native_file_join_path, 2);
 }
 
 /**
@@ -18,9 +18,9 @@ void native_register_gc_module() {
   ObjObject* gc_module = vm_make_module(NULL, STR(MODULE_NAME));
   define_value(&vm.modules, STR(MODULE_NAME), instance_value(gc_module));
 
-  define_native(&gc_module->fields, "collect", native_gc_collect, 0);
-  define_native(&gc_module->fields, "stats", native_gc_stats, 0);
-  define_native(&gc_module->fields, "stress", native_gc_stress, 1);
+  define_module_native(gc_module, "collect", native_gc_collect, 0);
+  define_module_native(gc_module, "stats", native_gc_stats, 0);
+  define_module_native(gc_module, "stress", native_gc_stress, 1);
 }
 
 /**
@@ -84,7 +84,7 @@ static Value native_gc_stress(int argc, Value argv[]) {
   NATIVE_CHECK_ARG_AT(1, vm.bool_class)
 
   bool old_value = VM_HAS_FLAG(VM_FLAG_STRESS_GC);
-  if (argv[1].as.boolean) {
+  if (AS_BOOL(argv[1])) {
     VM_SET_FLAG(VM_FLAG_STRESS_GC);
   } else {
     VM_CLEAR_FLAG(VM_FLAG_STRESS_GC);
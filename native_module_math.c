@@ -27,19 +27,19 @@ void native_register_math_module() {
   ObjObject* math_module = vm_make_module(NULL, STR(MODULE_NAME));
   define_value(&vm.modules, STR(MODULE_NAME), instance_value(math_module));
 
-  define_native(&math_module->fields, "abs", native_math_abs, 1);
-  define_native(&math_module->fields, "ceil", native_math_ceil, 1);
-  define_native(&math_module->fields, "floor", native_math_floor, 1);
-  define_native(&math_module->fields, "round", native_math_round, 1);
-  define_native(&math_module->fields, "pow", native_math_pow, 2);
-  define_native(&math_module->fields, "xor", native_math_xor, 2);
-  define_native(&math_module->fields, "shl", native_math_shl, 2);
-  define_native(&math_module->fields, "shr", native_math_shr, 2);
-  define_native(&math_module->fields, "bor", native_math_bor, 2);
-  define_native(&math_module->fields, "band", native_math_band, 2);
-  define_native(&math_module->fields, "sqrt", native_math_sqrt, 1);
-  // define_native(&math_module->fields, "max", native_math_max, -1);
-  // define_native(&math_module->fields, "min", native_math_min, -1);
+  define_module_native(math_module, "abs", native_math_abs, 1);
+  define_module_native(math_module, "ceil", native_math_ceil, 1);
+  define_module_native(math_module, "floor", native_math_floor, 1);
+  define_module_native(math_module, "round", native_math_round, 1);
+  define_module_native(math_module, "pow", native_math_pow, 2);
+  define_module_native(math_module, "xor", native_math_xor, 2);
+  define_module_native(math_module, "shl", native_math_shl, 2);
+  define_module_native(math_module, "shr", native_math_shr, 2);
+  define_module_native(math_module, "bor", native_math_bor, 2);
+  define_module_native(math_module, "band", native_math_band, 2);
+  define_module_native(math_module, "sqrt", native_math_sqrt, 1);
+  // define_module_native(math_module, "max", native_math_max, -1);
+  // define_module_native(math_module, "min", native_math_min, -1);
 }
 
 /**
@@ -52,10 +52,10 @@ static Value native_math_abs(int argc, Value argv[]) {
   NATIVE_CHECK_ARG_AT_INHERITS(1, vm.num_class);
 
   if (is_int(argv[1])) {
-    return int_value(llabs(argv[1].as.integer));
+    return int_value(llabs(AS_INT(argv[1])));
   }
 
-  return float_value(fabs(argv[1].as.float_));
+  return float_value(fabs(AS_FLOAT(argv[1])));
 }
 
 /**
@@ -71,7 +71,7 @@ static Value native_math_ceil(int argc, Value argv[]) {
     return argv[1];
   }
 
-  return int_value((long long)ceil(argv[1].as.float_));
+  return int_value((long long)ceil(AS_FLOAT(argv[1])));
 }
 
 /**
@@ -87,7 +87,7 @@ static Value native_math_floor(int argc, Value argv[]) {
     return argv[1];
   }
 
-  return int_value((long long)floor(argv[1].as.float_));
+  return int_value((long long)floor(AS_FLOAT(argv[1])));
 }
 
 /**
@@ -102,7 +102,7 @@ static Value native_math_round(int argc, Value argv[]) {
   if (is_int(argv[1])) {
     return argv[1];
   }
-  return int_value((long long)round(argv[1].as.float_));
+  return int_value((long long)round(AS_FLOAT(argv[1])));
 }
 
 /**
@@ -116,10 +116,10 @@ static Value native_math_pow(int argc, Value argv[]) {
   NATIVE_CHECK_ARG_AT_INHERITS(2, vm.num_class);
 
   if (is_int(argv[1]) && is_int(argv[2])) {
-    return int_value(llround(pow(argv[1].as.integer, argv[2].as.integer)));
+    return int_value(llround(pow(AS_INT(argv[1]), AS_INT(argv[2]))));
   }
 
-  return float_value(pow(argv[1].as.float_, argv[2].as.float_));
+  return float_value(pow(AS_FLOAT(argv[1]), AS_FLOAT(argv[2])));
 }
 
 /**
@@ -132,7 +132,7 @@ static Value native_math_xor(int argc, Value argv[]) {
   NATIVE_CHECK_ARG_AT_INHERITS(1, vm.int_class);
   NATIVE_CHECK_ARG_AT_INHERITS(2, vm.int_class);
 
-  return int_value(argv[1].as.integer ^ argv[2].as.integer);
+  return int_value(AS_INT(argv[1]) ^ AS_INT(argv[2]));
 }
 
 /**
@@ -145,7 +145,7 @@ static Value native_math_shl(int argc, Value argv[]) {
   NATIVE_CHECK_ARG_AT_INHERITS(1, vm.int_class);
   NATIVE_CHECK_ARG_AT_INHERITS(2, vm.int_class);
 
-  return int_value(argv[1].as.integer << argv[2].as.integer);
+  return int_value(AS_INT(argv[1]) << AS_INT(argv[2]));
 }
 
 /**
@@ -158,7 +158,7 @@ static Value native_math_shr(int argc, Value argv[]) {
   NATIVE_CHECK_ARG_AT_INHERITS(1, vm.int_class);
   NATIVE_CHECK_ARG_AT_INHERITS(2, vm.int_class);
 
-  return int_value(argv[1].as.integer >> argv[2].as.integer);
+  return int_value(AS_INT(argv[1]) >> AS_INT(argv[2]));
 }
 
 /**
@@ -171,7 +171,7 @@ static Value native_math_bor(int argc, Value argv[]) {
   NATIVE_CHECK_ARG_AT_INHERITS(1, vm.int_class);
   NATIVE_CHECK_ARG_AT_INHERITS(2, vm.int_class);
 
-  return int_value(argv[1].as.integer | argv[2].as.integer);
+  return int_value(AS_INT(argv[1]) | AS_INT(argv[2]));
 }
 
 /**
@@ -184,7 +184,7 @@ static Value native_math_band(int argc, Value argv[]) {
   NATIVE_CHECK_ARG_AT_INHERITS(1, vm.int_class);
   NATIVE_CHECK_ARG_AT_INHERITS(2, vm.int_class);
 
-  return int_value(argv[1].as.integer & argv[2].as.integer);
+  return int_value(AS_INT(argv[1]) & AS_INT(argv[2]));
 }
 
 /**
@@ -196,10 +196,10 @@ static Value native_math_sqrt(int argc, Value argv[]) {
   UNUSED(argv);
   NATIVE_CHECK_ARG_AT_INHERITS(1, vm.num_class);
   if (is_int(argv[1])) {
-    return float_value(sqrt(argv[1].as.integer));
+    return float_value(sqrt(AS_INT(argv[1])));
   }
 
-  return float_value(sqrt(argv[1].as.float_));
+  return float_value(sqrt(AS_FLOAT(argv[1])));
 }
 
 // /**
@@ -1,5 +1,6 @@
 #include <stddef.h>
 #include "common.h"
+#include "hashtable.h"
 #include "native.h"
 #include "object.h"
 #include "sys.h"
@@ -8,6 +9,8 @@
 
 static Value native_perf_now(int argc, Value argv[]);
 static Value native_perf_since(int argc, Value argv[]);
+static Value native_perf_count_caches(int argc, Value argv[]);
+static Value native_perf_cache_stats(int argc, Value argv[]);
 
 #define MODULE_NAME Perf
 
@@ -15,8 +18,10 @@ void native_register_perf_module() {
   ObjObject* perf_module = vm_make_module(NULL, STR(MODULE_NAME));
   define_value(&vm.modules, STR(MODULE_NAME), instance_value(perf_module));
 
-  define_native(&perf_module->fields, "now", native_perf_now, 0);
-  define_native(&perf_module->fields, "since", native_perf_since, 1);
+  define_module_native(perf_module, "now", native_perf_now, 0);
+  define_module_native(perf_module, "since", native_perf_since, 1);
+  define_module_native(perf_module, "count_caches", native_perf_count_caches, 1);
+  define_module_native(perf_module, "cache_stats", native_perf_cache_stats, 0);
 }
 
 /**
@@ -38,5 +43,63 @@ static Value native_perf_since(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_ARG_AT(1, vm.float_class);
 
-  return float_value(get_time() - argv[1].as.float_);
+  return float_value(get_time() - AS_FLOAT(argv[1]));
 }
+
+/**
+ * MODULE_NAME.count_caches(enable: TYPENAME_BOOL) -> TYPENAME_BOOL
+ * @brief Toggles counting the hits and misses of the inline caches, see MODULE_NAME.cache_stats(). Counting is disabled by
+ * default. Returns the value of the flag before the change.
+ */
+static Value native_perf_count_caches(int argc, Value argv[]) {
+  UNUSED(argc);
+
+  NATIVE_CHECK_ARG_AT(1, vm.bool_class)
+
+  bool old_value = VM_HAS_FLAG(VM_FLAG_COUNT_CACHE_STATS);
+  if (AS_BOOL(argv[1])) {
+    VM_SET_FLAG(VM_FLAG_COUNT_CACHE_STATS);
+  } else {
+    VM_CLEAR_FLAG(VM_FLAG_COUNT_CACHE_STATS);
+  }
+
+  return bool_value(old_value);
+}
+
+// Sets the field named after the Vm's [counter] field in [fields] to its value.
+#define PERF_SET_CACHE_STAT(fields, counter) \
+  hashtable_set(fields, str_value(copy_string(STR(counter), STR_LEN(STR(counter)))), int_value((long long)vm.counter))
+
+/**
+ * MODULE_NAME.cache_stats() -> TYPENAME_OBJ
+ * @brief Returns a TYPENAME_OBJ containing the hit and miss counts of the inline caches of all call sites. Only hits and misses
+ * which occurred while counting was enabled (see MODULE_NAME.count_caches()) are included.
+ * The object contains the following fields:
+ * - "invoke_cache_hits":     The number of method invocations which were served by an inline cache.
+ * - "invoke_cache_misses":   The number of method invocations which missed the inline cache.
+ * - "property_cache_hits":   The number of property accesses which were served by an inline cache.
+ * - "property_cache_misses": The number of property accesses which missed the inline cache.
+ */
+static Value native_perf_cache_stats(int argc, Value argv[]) {
+  UNUSED(argc);
+  UNUSED(argv);
+
+  HashTable fields;
+  hashtable_init(&fields);
+
+  VM_SET_FLAG(VM_FLAG_PAUSE_GC);
+
+  PERF_SET_CACHE_STAT(&fields, invoke_cache_hits);
+  PERF_SET_CACHE_STAT(&fields, invoke_cache_misses);
+  PERF_SET_CACHE_STAT(&fields, property_cache_hits);
+  PERF_SET_CACHE_STAT(&fields, property_cache_misses);
+
+  ObjObject* stats = take_object(&fields);
+  Value stats_obj  = instance_value(stats);
+
+  VM_CLEAR_FLAG(VM_FLAG_PAUSE_GC);
+
+  return stats_obj;
+}
+
+#undef PERF_SET_CACHE_STAT
@@ -43,11 +43,11 @@ void native_bool_class_finalize() {
 }
 
 static bool bool_eq(Value self, Value other) {
-  return self.type == other.type && self.as.boolean == other.as.boolean;
+  return value_type(self) == value_type(other) && AS_BOOL(self) == AS_BOOL(other);
 }
 
 static uint64_t bool_hash(Value self) {
-  return self.as.boolean ? 977 : 479;  // Prime numbers. Selected based on trial and error.
+  return AS_BOOL(self) ? 977 : 479;  // Prime numbers. Selected based on trial and error.
 }
 
 static bool bool_get_prop(Value receiver, ObjString* name, Value* result) {
@@ -76,7 +76,7 @@ static Value bool_to_str(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.bool_class)
 
-  if (argv[0].as.boolean) {
+  if (AS_BOOL(argv[0])) {
     ObjString* str_obj = copy_string(VALUE_STR_TRUE, STR_LEN(VALUE_STR_TRUE));
     return str_value(str_obj);
   }
@@ -10,7 +10,7 @@
   if (!is_fn(argv[0])) {                                                                              \
     vm_error("Expected receiver of type " STR(TYPENAME_FUNCTION) ", " STR(TYPENAME_CLOSURE) ", " STR( \
                  TYPENAME_NATIVE) " or " STR(TYPENAME_BOUND_METHOD) ", but got %s.",                  \
-             argv[0].type->name->chars);                                                              \
+             value_type(argv[0])->name->chars);                                                              \
     return nil_value();                                                                               \
   }
 
@@ -154,5 +154,5 @@ static Value fn_bind(int argc, Value argv[]) {
   NATIVE_CHECK_RECEIVER_IS_FN()
 
   Value bind_target = argv[1];
-  return fn_value((Obj*)new_bound_method(bind_target, argv[0].as.obj));
+  return fn_value((Obj*)new_bound_method(bind_target, AS_OBJ(argv[0])));
 }
@@ -0,0 +1,466 @@
+#include "common.h"
+#include "native.h"
+#include "object.h"
+#include "value.h"
+#include "vm.h"
+
+// Called with each item which made it through all stages of an iterator. Returns false to stop the pipeline, e.g. if an error
+// occurred.
+typedef bool (*IterSinkFn)(Value item, void* context);
+
+static bool iter_get_prop(Value receiver, ObjString* name, Value* result);
+
+static Value iter_ctor(int argc, Value argv[]);
+static Value iter_to_str(int argc, Value argv[]);
+static Value iter_map(int argc, Value argv[]);
+static Value iter_sift(int argc, Value argv[]);
+static Value iter_take(int argc, Value argv[]);
+static Value iter_drop(int argc, Value argv[]);
+static Value iter_zip(int argc, Value argv[]);
+static Value iter_enumerate(int argc, Value argv[]);
+static Value iter_each(int argc, Value argv[]);
+static Value iter_fold(int argc, Value argv[]);
+static Value iter_sum(int argc, Value argv[]);
+static Value iter_count(int argc, Value argv[]);
+static Value iter_to_seq(int argc, Value argv[]);
+
+ObjClass* native_iter_class_partial_init() {
+  ObjClass* iter_class = new_class(NULL, NULL);  // Names are null because hashtables are not yet initialized
+
+  iter_class->__get_prop = iter_get_prop;
+  iter_class->__set_prop = native_set_prop_not_supported;  // Not supported
+  iter_class->__get_subs = native_get_subs_not_supported;  // Not supported
+  iter_class->__set_subs = native_set_subs_not_supported;  // Not supported
+  iter_class->__equals   = native_default_obj_equals;
+  iter_class->__hash     = native_default_obj_hash;
+
+  return iter_class;
+}
+
+void native_iter_class_finalize() {
+  define_native(&vm.iter_class->methods, STR(SP_METHOD_CTOR), iter_ctor, 1);
+  define_native(&vm.iter_class->methods, STR(SP_METHOD_TO_STR), iter_to_str, 0);
+  define_native(&vm.iter_class->methods, STR(SP_METHOD_HAS), native___has_not_supported, 1);
+  define_native(&vm.iter_class->methods, STR(SP_METHOD_SLICE), native___slice_not_supported, 2);
+  define_native(&vm.iter_class->methods, STR(SP_METHOD_ADD), native___add_not_supported, 1);
+  define_native(&vm.iter_class->methods, STR(SP_METHOD_SUB), native___sub_not_supported, 1);
+  define_native(&vm.iter_class->methods, STR(SP_METHOD_MUL), native___mul_not_supported, 1);
+  define_native(&vm.iter_class->methods, STR(SP_METHOD_DIV), native___div_not_supported, 1);
+  define_native(&vm.iter_class->methods, STR(SP_METHOD_MOD), native___mod_not_supported, 1);
+  define_native(&vm.iter_class->methods, STR(SP_METHOD_LT), native___lt_not_supported, 1);
+  define_native(&vm.iter_class->methods, STR(SP_METHOD_GT), native___gt_not_supported, 1);
+  define_native(&vm.iter_class->methods, STR(SP_METHOD_LTEQ), native___lteq_not_supported, 1);
+  define_native(&vm.iter_class->methods, STR(SP_METHOD_GTEQ), native___gteq_not_supported, 1);
+
+  define_native(&vm.iter_class->methods, "map", iter_map, 1);
+  define_native(&vm.iter_class->methods, "sift", iter_sift, 1);
+  define_native(&vm.iter_class->methods, "take", iter_take, 1);
+  define_native(&vm.iter_class->methods, "drop", iter_drop, 1);
+  define_native(&vm.iter_class->methods, "zip", iter_zip, 1);
+  define_native(&vm.iter_class->methods, "enumerate", iter_enumerate, 0);
+  define_native(&vm.iter_class->methods, "each", iter_each, 1);
+  define_native(&vm.iter_class->methods, "fold", iter_fold, 2);
+  define_native(&vm.iter_class->methods, "sum", iter_sum, 0);
+  define_native(&vm.iter_class->methods, "count", iter_count, 0);
+  define_native(&vm.iter_class->methods, "to_seq", iter_to_seq, 0);
+  finalize_new_class(vm.iter_class);
+}
+
+static bool iter_get_prop(Value receiver, ObjString* name, Value* result) {
+  UNUSED(receiver);
+  NATIVE_DEFAULT_GET_PROP_BODY(vm.iter_class)
+}
+
+#define NATIVE_CHECK_ARG_AT_IS_ITERABLE(index)                                                                              \
+  if (!is_seq(argv[index]) && !is_tuple(argv[index]) && !is_str(argv[index])) {                                            \
+    vm_error("Expected argument %d of type " STR(TYPENAME_SEQ) ", " STR(TYPENAME_TUPLE) " or " STR(TYPENAME_STRING) " but " \
+             "got %s.",                                                                                                     \
+             index - 1, value_type(argv[index])->name->chars);                                                              \
+    return nil_value();                                                                                                     \
+  }
+
+// Returns the number of items of a Seq, Tuple or Str.
+static inline int iterable_count(Value iterable) {
+  if (is_str(iterable)) {
+    return AS_STR(iterable)->length;
+  }
+  return is_seq(iterable) ? AS_SEQ(iterable)->items.count : AS_TUPLE(iterable)->items.count;
+}
+
+// Returns the item at [index] of a Seq, Tuple or Str. Characters of a Str are copied into a new string, which might trigger
+// garbage collection.
+static inline Value iterable_item(Value iterable, int index) {
+  if (is_str(iterable)) {
+    return str_value(copy_string(AS_STR(iterable)->chars + index, 1));
+  }
+  return is_seq(iterable) ? AS_SEQ(iterable)->items.values[index] : AS_TUPLE(iterable)->items.values[index];
+}
+
+// Replaces the item on top of the stack with the tuple (item, [other]) if [item_first] is true, or ([other], item) otherwise.
+static void iter_pair_top(Value other, bool item_first) {
+  vm_push(other);  // GC Protection
+  ValueArray pair = value_array_init_of_size(2);
+  pair.values[0]  = item_first ? vm.stack_top[-2] : vm.stack_top[-1];
+  pair.values[1]  = item_first ? vm.stack_top[-1] : vm.stack_top[-2];
+  pair.count      = 2;
+  Value tuple     = tuple_value(take_tuple(&pair));  // [other] stays on the stack until the tuple holds it.
+  vm_pop();
+  vm.stack_top[-1] = tuple;
+}
+
+// Returns a new iterator with the stages of [iter] and [stage] appended.
+static Value iter_append_stage(ObjIter* iter, IterStage stage) {
+  IterStage stages[iter->stage_count + 1];
+  for (int i = 0; i < iter->stage_count; i++) {
+    stages[i] = iter->stages[i];
+  }
+  stages[iter->stage_count] = stage;
+
+  return iter_value(new_iter(iter->source, stages, iter->stage_count + 1));
+}
+
+// Runs the pipeline of [iter]: Each item of the source is pushed onto the stack, passed through all stages and - unless a stage
+// dropped it - handed to [sink]. The item stays on top of the stack while doing so, right above whatever the caller pushed
+// before running the pipeline. That's also where terminal methods keep their accumulator, to protect it from the garbage
+// collector. Returns false if an error occurred.
+static bool iter_run(ObjIter* iter, IterSinkFn sink, void* context) {
+  int stage_count = iter->stage_count;
+  long long state[stage_count + 1];  // Remaining items of take and drop stages, position of zip and enumerate stages.
+  VmCallback callbacks[stage_count + 1];
+
+  for (int i = 0; i < stage_count; i++) {
+    IterStage* stage = &iter->stages[i];
+    switch (stage->kind) {
+      case ITER_STAGE_MAP:
+      case ITER_STAGE_SIFT: vm_callback_init(&callbacks[i], stage->arg, 1); break;
+      case ITER_STAGE_TAKE:
+      case ITER_STAGE_DROP: state[i] = stage->count; break;
+      case ITER_STAGE_ZIP:
+      case ITER_STAGE_ENUMERATE: state[i] = 0; break;
+    }
+  }
+
+  // A take stage which passes no items at all ends the pipeline before the first item is pulled.
+  bool done = false;
+  for (int i = 0; i < stage_count; i++) {
+    done = done || (iter->stages[i].kind == ITER_STAGE_TAKE && state[i] <= 0);
+  }
+
+  int count = iterable_count(iter->source);  // We need to store this, because the source might change during the loop
+  for (int index = 0; index < count && !done && index < iterable_count(iter->source); index++) {
+    vm_push(iterable_item(iter->source, index));
+    bool keep = true;
+
+    for (int i = 0; i < stage_count && keep; i++) {
+      IterStage* stage = &iter->stages[i];
+      switch (stage->kind) {
+        case ITER_STAGE_MAP: {
+          Value args[]     = {vm.stack_top[-1]};
+          vm.stack_top[-1] = vm_callback_call(&callbacks[i], args);
+          if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
+            return false;
+          }
+          break;
+        }
+        case ITER_STAGE_SIFT: {
+          Value args[] = {vm.stack_top[-1]};
+          Value result = vm_callback_call(&callbacks[i], args);
+          if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
+            return false;
+          }
+          // We don't use vm_is_falsey here, because we want to check for a boolean value.
+          keep = is_bool(result) && AS_BOOL(result);
+          break;
+        }
+        case ITER_STAGE_TAKE: {
+          if (state[i] <= 0) {
+            keep = false;
+            done = true;
+          } else if (--state[i] == 0) {
+            done = true;  // This one still passes, but no item after it can.
+          }
+          break;
+        }
+        case ITER_STAGE_DROP: {
+          if (state[i] > 0) {
+            state[i]--;
+            keep = false;
+          }
+          break;
+        }
+        case ITER_STAGE_ZIP: {
+          if (state[i] >= iterable_count(stage->arg)) {
+            keep = false;
+            done = true;
+            break;
+          }
+          iter_pair_top(iterable_item(stage->arg, (int)state[i]++), true);
+          break;
+        }
+        case ITER_STAGE_ENUMERATE: {
+          iter_pair_top(int_value(state[i]++), false);
+          break;
+        }
+      }
+    }
+
+    if (keep && !sink(vm.stack_top[-1], context)) {
+      return !VM_HAS_FLAG(VM_FLAG_HAS_ERROR);
+    }
+    vm_pop();  // The item
+  }
+
+  return true;
+}
+
+/**
+ * TYPENAME_ITER.SP_METHOD_CTOR(iterable: TYPENAME_SEQ | TYPENAME_TUPLE | TYPENAME_STRING) -> TYPENAME_ITER
+ * @brief Creates a new lazy TYPENAME_ITER over the items of 'iterable'. Same as 'iterable.iter()'.
+ */
+static Value iter_ctor(int argc, Value argv[]) {
+  UNUSED(argc);
+  NATIVE_CHECK_ARG_AT_IS_ITERABLE(1)
+  return iter_value(new_iter(argv[1], NULL, 0));
+}
+
+Value native_iter(int argc, Value argv[]) {
+  UNUSED(argc);
+  if (!is_seq(argv[0]) && !is_tuple(argv[0]) && !is_str(argv[0])) {
+    vm_error("Expected receiver of type " STR(TYPENAME_SEQ) ", " STR(TYPENAME_TUPLE) " or " STR(TYPENAME_STRING) " but got %s.",
+             value_type(argv[0])->name->chars);
+    return nil_value();
+  }
+  return iter_value(new_iter(argv[0], NULL, 0));
+}
+
+/**
+ * TYPENAME_ITER.SP_METHOD_TO_STR() -> TYPENAME_STRING
+ * @brief Returns a string representation of a TYPENAME_ITER.
+ */
+static Value iter_to_str(int argc, Value argv[]) {
+  UNUSED(argc);
+  NATIVE_CHECK_RECEIVER(vm.iter_class)
+  return str_value(copy_string(VALUE_STR_ITER, STR_LEN(VALUE_STR_ITER)));
+}
+
+/**
+ * TYPENAME_ITER.map(fn: TYPENAME_FUNCTION) -> TYPENAME_ITER
+ * @brief Returns a new TYPENAME_ITER which yields the results of executing 'fn' on each item. 'fn' must take one argument: the
+ * item.
+ */
+static Value iter_map(int argc, Value argv[]) {
+  UNUSED(argc);
+  NATIVE_CHECK_RECEIVER(vm.iter_class)
+  NATIVE_CHECK_ARG_AT_IS_CALLABLE(1)
+
+  int fn_arity = callable_get_arity(argv[1]);
+  if (fn_arity != 1) {
+    vm_error("Function passed to \"" STR(map) "\" must take 1 argument, but got %d.", fn_arity);
+    return nil_value();
+  }
+
+  return iter_append_stage(AS_ITER(argv[0]), (IterStage){.kind = ITER_STAGE_MAP, .arg = argv[1], .count = 0});
+}
+
+/**
+ * TYPENAME_ITER.sift(fn: TYPENAME_FUNCTION -> TYPENAME_BOOL) -> TYPENAME_ITER
+ * @brief Returns a new TYPENAME_ITER which only yields the items for which 'fn' evaluates to VALUE_STR_TRUE. 'fn' must take one
+ * argument: the item.
+ */
+static Value iter_sift(int argc, Value argv[]) {
+  UNUSED(argc);
+  NATIVE_CHECK_RECEIVER(vm.iter_class)
+  NATIVE_CHECK_ARG_AT_IS_CALLABLE(1)
+
+  int fn_arity = callable_get_arity(argv[1]);
+  if (fn_arity != 1) {
+    vm_error("Function passed to \"" STR(sift) "\" must take 1 argument, but got %d.", fn_arity);
+    return nil_value();
+  }
+
+  return iter_append_stage(AS_ITER(argv[0]), (IterStage){.kind = ITER_STAGE_SIFT, .arg = argv[1], .count = 0});
+}
+
+/**
+ * TYPENAME_ITER.take(count: TYPENAME_INT) -> TYPENAME_ITER
+ * @brief Returns a new TYPENAME_ITER which yields the first 'count' items. No more items are pulled from the source after that.
+ */
+static Value iter_take(int argc, Value argv[]) {
+  UNUSED(argc);
+  NATIVE_CHECK_RECEIVER(vm.iter_class)
+  NATIVE_CHECK_ARG_AT(1, vm.int_class)
+
+  return iter_append_stage(AS_ITER(argv[0]), (IterStage){.kind = ITER_STAGE_TAKE, .arg = nil_value(), .count = AS_INT(argv[1])});
+}
+
+/**
+ * TYPENAME_ITER.drop(count: TYPENAME_INT) -> TYPENAME_ITER
+ * @brief Returns a new TYPENAME_ITER which drops the first 'count' items.
+ */
+static Value iter_drop(int argc, Value argv[]) {
+  UNUSED(argc);
+  NATIVE_CHECK_RECEIVER(vm.iter_class)
+  NATIVE_CHECK_ARG_AT(1, vm.int_class)
+
+  return iter_append_stage(AS_ITER(argv[0]), (IterStage){.kind = ITER_STAGE_DROP, .arg = nil_value(), .count = AS_INT(argv[1])});
+}
+
+/**
+ * TYPENAME_ITER.zip(other: TYPENAME_SEQ | TYPENAME_TUPLE | TYPENAME_STRING) -> TYPENAME_ITER
+ * @brief Returns a new TYPENAME_ITER which yields TYPENAME_TUPLEs of each item and the item of 'other' at the same position. Ends
+ * with the shorter of both.
+ */
+static Value iter_zip(int argc, Value argv[]) {
+  UNUSED(argc);
+  NATIVE_CHECK_RECEIVER(vm.iter_class)
+  NATIVE_CHECK_ARG_AT_IS_ITERABLE(1)
+
+  return iter_append_stage(AS_ITER(argv[0]), (IterStage){.kind = ITER_STAGE_ZIP, .arg = argv[1], .count = 0});
+}
+
+/**
+ * TYPENAME_ITER.enumerate() -> TYPENAME_ITER
+ * @brief Returns a new TYPENAME_ITER which yields TYPENAME_TUPLEs of the position of each item and the item.
+ */
+static Value iter_enumerate(int argc, Value argv[]) {
+  UNUSED(argc);
+  NATIVE_CHECK_RECEIVER(vm.iter_class)
+
+  return iter_append_stage(AS_ITER(argv[0]), (IterStage){.kind = ITER_STAGE_ENUMERATE, .arg = nil_value(), .count = 0});
+}
+
+static bool iter_each_sink(Value item, void* context) {
+  Value args[] = {item};
+  vm_callback_call((VmCallback*)context, args);
+  return !VM_HAS_FLAG(VM_FLAG_HAS_ERROR);
+}
+
+/**
+ * TYPENAME_ITER.each(fn: TYPENAME_FUNCTION) -> TYPENAME_NIL
+ * @brief Runs the TYPENAME_ITER and executes 'fn' on each item. 'fn' must take one argument: the item.
+ */
+static Value iter_each(int argc, Value argv[]) {
+  UNUSED(argc);
+  NATIVE_CHECK_RECEIVER(vm.iter_class)
+  NATIVE_CHECK_ARG_AT_IS_CALLABLE(1)
+
+  int fn_arity = callable_get_arity(argv[1]);
+  if (fn_arity != 1) {
+    vm_error("Function passed to \"" STR(each) "\" must take 1 argument, but got %d.", fn_arity);
+    return nil_value();
+  }
+
+  VmCallback callback;
+  vm_callback_init(&callback, argv[1], 1);
+  iter_run(AS_ITER(argv[0]), iter_each_sink, &callback);
+  return nil_value();
+}
+
+static bool iter_fold_sink(Value item, void* context) {
+  Value args[]     = {vm.stack_top[-2], item};  // The accumulator lives right below the item
+  vm.stack_top[-2] = vm_callback_call((VmCallback*)context, args);
+  return !VM_HAS_FLAG(VM_FLAG_HAS_ERROR);
+}
+
+/**
+ * TYPENAME_ITER.fold(initial: TYPENAME_VALUE, fn: TYPENAME_FUNCTION) -> TYPENAME_VALUE
+ * @brief Runs the TYPENAME_ITER and reduces its items to a single value by executing 'fn' on each item, starting with
+ * 'initial'. 'fn' must take two arguments: the accumulator and the item.
+ */
+static Value iter_fold(int argc, Value argv[]) {
+  UNUSED(argc);
+  NATIVE_CHECK_RECEIVER(vm.iter_class)
+  NATIVE_CHECK_ARG_AT_IS_CALLABLE(2)
+
+  int fn_arity = callable_get_arity(argv[2]);
+  if (fn_arity != 2) {
+    vm_error("Function passed to \"" STR(fold) "\" must take 2 arguments, but got %d.", fn_arity);
+    return nil_value();
+  }
+
+  VmCallback callback;
+  vm_callback_init(&callback, argv[2], 2);
+
+  vm_push(argv[1]);  // The accumulator
+  if (!iter_run(AS_ITER(argv[0]), iter_fold_sink, &callback)) {
+    return nil_value();
+  }
+  return vm_pop();
+}
+
+static bool iter_sum_sink(Value item, void* context) {
+  Value* add_fn = (Value*)context;
+  if (is_nil(*add_fn)) {
+    vm.stack_top[-2] = item;  // The first item is the initial sum
+    *add_fn          = fn_value(value_type(item)->__add);
+    return true;
+  }
+
+  vm_push(vm.stack_top[-2]);  // receiver (arg a)
+  vm_push(item);              // arg b
+  Value sum = vm_exec_callable(*add_fn, 1);
+  if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
+    return false;
+  }
+  vm.stack_top[-2] = sum;
+  return true;
+}
+
+/**
+ * TYPENAME_ITER.sum() -> TYPENAME_VALUE
+ * @brief Runs the TYPENAME_ITER and returns the sum of its items, using SP_METHOD_ADD of the first item.
+ * Returns TYPENAME_NIL if there are no items.
+ */
+static Value iter_sum(int argc, Value argv[]) {
+  UNUSED(argc);
+  NATIVE_CHECK_RECEIVER(vm.iter_class)
+
+  Value add_fn = nil_value();
+  vm_push(nil_value());  // The sum
+  if (!iter_run(AS_ITER(argv[0]), iter_sum_sink, &add_fn)) {
+    return nil_value();
+  }
+  return vm_pop();
+}
+
+static bool iter_count_sink(Value item, void* context) {
+  UNUSED(item);
+  (*(long long*)context)++;
+  return true;
+}
+
+/**
+ * TYPENAME_ITER.count() -> TYPENAME_INT
+ * @brief Runs the TYPENAME_ITER and returns the number of items it yields.
+ */
+static Value iter_count(int argc, Value argv[]) {
+  UNUSED(argc);
+  NATIVE_CHECK_RECEIVER(vm.iter_class)
+
+  long long count = 0;
+  if (!iter_run(AS_ITER(argv[0]), iter_count_sink, &count)) {
+    return nil_value();
+  }
+  return int_value(count);
+}
+
+static bool iter_to_seq_sink(Value item, void* context) {
+  UNUSED(context);
+  value_array_write(&AS_SEQ(vm.stack_top[-2])->items, item);  // The seq lives right below the item
+  return true;
+}
+
+/**
+ * TYPENAME_ITER.to_seq() -> TYPENAME_SEQ
+ * @brief Runs the TYPENAME_ITER and collects its items into a new TYPENAME_SEQ.
+ */
+static Value iter_to_seq(int argc, Value argv[]) {
+  UNUSED(argc);
+  NATIVE_CHECK_RECEIVER(vm.iter_class)
+
+  vm_push(seq_value(new_seq()));
+  if (!iter_run(AS_ITER(argv[0]), iter_to_seq_sink, NULL)) {
+    return nil_value();
+  }
+  return vm_pop();
+}
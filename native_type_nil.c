@@ -43,7 +43,7 @@ void native_nil_class_finalize() {
 }
 
 static bool nil_eq(Value self, Value other) {
-  return self.type == other.type && true;  // Nil is always equal to nil
+  return value_type(self) == value_type(other) && true;  // Nil is always equal to nil
 }
 
 static uint64_t nil_hash(Value self) {
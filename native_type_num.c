@@ -155,27 +155,27 @@ static bool float_get_prop(Value receiver, ObjString* name, Value* result) {
 }
 
 static bool int_eq(Value self, Value other) {
-  if (self.type == other.type) {
-    return self.as.integer == other.as.integer;
+  if (value_type(self) == value_type(other)) {
+    return AS_INT(self) == AS_INT(other);
   }
   if (is_float(other)) {
-    return (double)self.as.integer == other.as.float_;
+    return (double)AS_INT(self) == AS_FLOAT(other);
   }
   return false;
 }
 
 static bool float_eq(Value self, Value other) {
-  if (self.type == other.type) {
-    return self.as.float_ == other.as.float_;
+  if (value_type(self) == value_type(other)) {
+    return AS_FLOAT(self) == AS_FLOAT(other);
   }
   if (is_int(other)) {
-    return self.as.float_ == (double)other.as.integer;
+    return AS_FLOAT(self) == (double)AS_INT(other);
   }
   return false;
 }
 
 static uint64_t int_hash(Value self) {
-  return (uint64_t)self.as.integer;  // Bc of 2's complement, directly casting to uint64_t should ensure unique hash values.
+  return (uint64_t)AS_INT(self);  // Bc of 2's complement, directly casting to uint64_t should ensure unique hash values.
 }
 
 static uint64_t float_hash(Value self) {
@@ -186,7 +186,7 @@ static uint64_t float_hash(Value self) {
   };
 
   union BitCast cast;
-  cast.source = (self.as.float_) + 1.0;
+  cast.source = (AS_FLOAT(self)) + 1.0;
   return cast.target;
 }
 
@@ -212,10 +212,10 @@ static Value int_ctor(int argc, Value argv[]) {
     return argv[1];
   }
   if (is_float(argv[1])) {
-    return int_value((long long)argv[1].as.float_);
+    return int_value((long long)AS_FLOAT(argv[1]));
   }
   if (is_bool(argv[1])) {
-    return int_value(argv[1].as.boolean ? 1 : 0);
+    return int_value(AS_BOOL(argv[1]) ? 1 : 0);
   }
   if (is_nil(argv[1])) {
     return int_value(0);
@@ -225,7 +225,7 @@ static Value int_ctor(int argc, Value argv[]) {
     Value num      = parse_number(str->chars, str->length);
     if (!is_int(num)) {
       // Then it must be a float, which, in this case, we cast to an int.
-      double float_val = num.as.float_;
+      double float_val = AS_FLOAT(num);
       return int_value((long long)float_val);
     }
     return num;
@@ -243,7 +243,7 @@ static Value int_to_str(int argc, Value argv[]) {
   NATIVE_CHECK_RECEIVER(vm.int_class)
 
   char buffer[100];
-  int len = snprintf(buffer, sizeof(buffer), VALUE_STR_INT, argv[0].as.integer);
+  int len = snprintf(buffer, sizeof(buffer), VALUE_STR_INT, AS_INT(argv[0]));
 
   ObjString* str_obj = copy_string(buffer, len);
   return str_value(str_obj);
@@ -257,10 +257,10 @@ static Value int_add(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.int_class)
   if (is_int(argv[1])) {
-    return int_value(argv[0].as.integer + argv[1].as.integer);
+    return int_value(AS_INT(argv[0]) + AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    return float_value((double)argv[0].as.integer + argv[1].as.float_);
+    return float_value((double)AS_INT(argv[0]) + AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(+)
   return nil_value();
@@ -274,10 +274,10 @@ static Value int_sub(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.int_class)
   if (is_int(argv[1])) {
-    return int_value(argv[0].as.integer - argv[1].as.integer);
+    return int_value(AS_INT(argv[0]) - AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    return float_value((double)argv[0].as.integer - argv[1].as.float_);
+    return float_value((double)AS_INT(argv[0]) - AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(-)
   return nil_value();
@@ -291,10 +291,10 @@ static Value int_mul(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.int_class)
   if (is_int(argv[1])) {
-    return int_value(argv[0].as.integer * argv[1].as.integer);
+    return int_value(AS_INT(argv[0]) * AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    return float_value((double)argv[0].as.integer * argv[1].as.float_);
+    return float_value((double)AS_INT(argv[0]) * AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(*)
   return nil_value();
@@ -308,18 +308,18 @@ static Value int_div(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.int_class)
   if (is_int(argv[1])) {
-    if (argv[1].as.integer == 0) {
-      vm_error("Division by zero.");
+    if (AS_INT(argv[1]) == 0) {
+      vm_error_lazy("Division by zero.", 0);
       return nil_value();
     }
-    return float_value((double)argv[0].as.integer / (double)argv[1].as.integer);
+    return float_value((double)AS_INT(argv[0]) / (double)AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    if (argv[1].as.float_ == 0.0) {
-      vm_error("Division by zero.");
+    if (AS_FLOAT(argv[1]) == 0.0) {
+      vm_error_lazy("Division by zero.", 0);
       return nil_value();
     }
-    return float_value((double)argv[0].as.integer / argv[1].as.float_);
+    return float_value((double)AS_INT(argv[0]) / AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(/)
   return nil_value();
@@ -333,18 +333,18 @@ static Value int_mod(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.int_class)
   if (is_int(argv[1])) {
-    if (argv[1].as.integer == 0) {
-      vm_error("Modulo by zero.");
+    if (AS_INT(argv[1]) == 0) {
+      vm_error_lazy("Modulo by zero.", 0);
       return nil_value();
     }
-    return int_value(argv[0].as.integer % argv[1].as.integer);
+    return int_value(AS_INT(argv[0]) % AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    if (argv[1].as.float_ == 0.0) {
-      vm_error("Modulo by zero.");
+    if (AS_FLOAT(argv[1]) == 0.0) {
+      vm_error_lazy("Modulo by zero.", 0);
       return nil_value();
     }
-    return float_value(fmod((double)argv[0].as.integer, argv[1].as.float_));
+    return float_value(fmod((double)AS_INT(argv[0]), AS_FLOAT(argv[1])));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(%)
   return nil_value();
@@ -358,10 +358,10 @@ static Value int_lt(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.int_class)
   if (is_int(argv[1])) {
-    return bool_value(argv[0].as.integer < argv[1].as.integer);
+    return bool_value(AS_INT(argv[0]) < AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    return bool_value((double)argv[0].as.integer < argv[1].as.float_);
+    return bool_value((double)AS_INT(argv[0]) < AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(<)
   return nil_value();
@@ -375,10 +375,10 @@ static Value int_gt(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.int_class)
   if (is_int(argv[1])) {
-    return bool_value(argv[0].as.integer > argv[1].as.integer);
+    return bool_value(AS_INT(argv[0]) > AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    return bool_value((double)argv[0].as.integer > argv[1].as.float_);
+    return bool_value((double)AS_INT(argv[0]) > AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(>)
   return nil_value();
@@ -392,10 +392,10 @@ static Value int_lteq(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.int_class)
   if (is_int(argv[1])) {
-    return bool_value(argv[0].as.integer <= argv[1].as.integer);
+    return bool_value(AS_INT(argv[0]) <= AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    return bool_value((double)argv[0].as.integer <= argv[1].as.float_);
+    return bool_value((double)AS_INT(argv[0]) <= AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(<=)
   return nil_value();
@@ -409,10 +409,10 @@ static Value int_gteq(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.int_class)
   if (is_int(argv[1])) {
-    return bool_value(argv[0].as.integer >= argv[1].as.integer);
+    return bool_value(AS_INT(argv[0]) >= AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    return bool_value((double)argv[0].as.integer >= argv[1].as.float_);
+    return bool_value((double)AS_INT(argv[0]) >= AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(>=)
   return nil_value();
@@ -426,13 +426,13 @@ static Value float_ctor(int argc, Value argv[]) {
   UNUSED(argc);
 
   if (is_int(argv[1])) {
-    return float_value((double)argv[1].as.integer);
+    return float_value((double)AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
     return argv[1];
   }
   if (is_bool(argv[1])) {
-    return float_value(argv[1].as.boolean ? 1.0 : 0.0);
+    return float_value(AS_BOOL(argv[1]) ? 1.0 : 0.0);
   }
   if (is_nil(argv[1])) {
     return float_value(0.0);
@@ -442,7 +442,7 @@ static Value float_ctor(int argc, Value argv[]) {
     Value num      = parse_number(str->chars, str->length);
     if (!is_float(num)) {
       // Then it must be an int, which, in this case, we cast to a float.
-      long long int_val = num.as.integer;
+      long long int_val = AS_INT(num);
       return float_value((double)int_val);
     }
     return num;
@@ -460,7 +460,7 @@ static Value float_to_str(int argc, Value argv[]) {
   NATIVE_CHECK_RECEIVER(vm.float_class)
 
   char buffer[100];
-  int len = snprintf(buffer, sizeof(buffer), VALUE_STR_FLOAT, argv[0].as.float_);
+  int len = snprintf(buffer, sizeof(buffer), VALUE_STR_FLOAT, AS_FLOAT(argv[0]));
 
   // Remove trailing zeros. Ugh...
   // TODO (optimize): This is not very efficient, find a better way to do this
@@ -484,10 +484,10 @@ static Value float_add(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.float_class)
   if (is_int(argv[1])) {
-    return float_value(argv[0].as.float_ + (double)argv[1].as.integer);
+    return float_value(AS_FLOAT(argv[0]) + (double)AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    return float_value(argv[0].as.float_ + argv[1].as.float_);
+    return float_value(AS_FLOAT(argv[0]) + AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(+)
   return nil_value();
@@ -501,10 +501,10 @@ static Value float_sub(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.float_class)
   if (is_int(argv[1])) {
-    return float_value(argv[0].as.float_ - (double)argv[1].as.integer);
+    return float_value(AS_FLOAT(argv[0]) - (double)AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    return float_value(argv[0].as.float_ - argv[1].as.float_);
+    return float_value(AS_FLOAT(argv[0]) - AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(-)
   return nil_value();
@@ -518,10 +518,10 @@ static Value float_mul(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.float_class)
   if (is_int(argv[1])) {
-    return float_value(argv[0].as.float_ * (double)argv[1].as.integer);
+    return float_value(AS_FLOAT(argv[0]) * (double)AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    return float_value(argv[0].as.float_ * argv[1].as.float_);
+    return float_value(AS_FLOAT(argv[0]) * AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(*)
   return nil_value();
@@ -535,18 +535,18 @@ static Value float_div(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.float_class)
   if (is_int(argv[1])) {
-    if (argv[1].as.integer == 0) {
-      vm_error("Division by zero.");
+    if (AS_INT(argv[1]) == 0) {
+      vm_error_lazy("Division by zero.", 0);
       return nil_value();
     }
-    return float_value(argv[0].as.float_ / (double)argv[1].as.integer);
+    return float_value(AS_FLOAT(argv[0]) / (double)AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    if (argv[1].as.float_ == 0.0) {
-      vm_error("Division by zero.");
+    if (AS_FLOAT(argv[1]) == 0.0) {
+      vm_error_lazy("Division by zero.", 0);
       return nil_value();
     }
-    return float_value(argv[0].as.float_ / argv[1].as.float_);
+    return float_value(AS_FLOAT(argv[0]) / AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(/)
   return nil_value();
@@ -560,18 +560,18 @@ static Value float_mod(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.float_class)
   if (is_int(argv[1])) {
-    if (argv[1].as.integer == 0) {
-      vm_error("Modulo by zero.");
+    if (AS_INT(argv[1]) == 0) {
+      vm_error_lazy("Modulo by zero.", 0);
       return nil_value();
     }
-    return float_value(fmod(argv[0].as.float_, (double)argv[1].as.integer));
+    return float_value(fmod(AS_FLOAT(argv[0]), (double)AS_INT(argv[1])));
   }
   if (is_float(argv[1])) {
-    if (argv[1].as.float_ == 0.0) {
-      vm_error("Modulo by zero.");
+    if (AS_FLOAT(argv[1]) == 0.0) {
+      vm_error_lazy("Modulo by zero.", 0);
       return nil_value();
     }
-    return float_value(fmod(argv[0].as.float_, argv[1].as.float_));
+    return float_value(fmod(AS_FLOAT(argv[0]), AS_FLOAT(argv[1])));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(%)
   return nil_value();
@@ -585,10 +585,10 @@ static Value float_lt(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.float_class)
   if (is_int(argv[1])) {
-    return bool_value(argv[0].as.float_ < (double)argv[1].as.integer);
+    return bool_value(AS_FLOAT(argv[0]) < (double)AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    return bool_value(argv[0].as.float_ < argv[1].as.float_);
+    return bool_value(AS_FLOAT(argv[0]) < AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(<)
   return nil_value();
@@ -602,10 +602,10 @@ static Value float_gt(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.float_class)
   if (is_int(argv[1])) {
-    return bool_value(argv[0].as.float_ > (double)argv[1].as.integer);
+    return bool_value(AS_FLOAT(argv[0]) > (double)AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    return bool_value(argv[0].as.float_ > argv[1].as.float_);
+    return bool_value(AS_FLOAT(argv[0]) > AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(>)
   return nil_value();
@@ -619,10 +619,10 @@ static Value float_lteq(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.float_class)
   if (is_int(argv[1])) {
-    return bool_value(argv[0].as.float_ <= (double)argv[1].as.integer);
+    return bool_value(AS_FLOAT(argv[0]) <= (double)AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    return bool_value(argv[0].as.float_ <= argv[1].as.float_);
+    return bool_value(AS_FLOAT(argv[0]) <= AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(<=)
   return nil_value();
@@ -636,10 +636,10 @@ static Value float_gteq(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_RECEIVER(vm.float_class)
   if (is_int(argv[1])) {
-    return bool_value(argv[0].as.float_ >= (double)argv[1].as.integer);
+    return bool_value(AS_FLOAT(argv[0]) >= (double)AS_INT(argv[1]));
   }
   if (is_float(argv[1])) {
-    return bool_value(argv[0].as.float_ >= argv[1].as.float_);
+    return bool_value(AS_FLOAT(argv[0]) >= AS_FLOAT(argv[1]));
   }
   NATIVE_BIN_OP_ILLEGAL_TYPES(>=)
   return nil_value();
@@ -56,26 +56,26 @@ void native_obj_class_finalize() {
 
 static bool obj_get_prop(Value receiver, ObjString* name, Value* result) {
   ObjObject* object = AS_OBJECT(receiver);
-  if (hashtable_get_by_string(&object->fields, name, result)) {
+  if (object_get_field_by_string(object, name, result)) {
     return true;
   }
   if (name == vm.special_prop_names[SPECIAL_PROP_LEN]) {
-    *result = int_value(object->fields.count);
+    *result = int_value(object_field_count(object));
     return true;
   }
   NATIVE_DEFAULT_GET_PROP_BODY(
-      receiver.type)  // We must use the receiver's type instead of vm.obj_class here: Instances are ObjObjects.
+      value_type(receiver))  // We must use the receiver's type instead of vm.obj_class here: Instances are ObjObjects.
 }
 
 static bool obj_set_prop(Value receiver, ObjString* name, Value value) {
   ObjObject* object = AS_OBJECT(receiver);
-  hashtable_set(&object->fields, str_value(name), value);
+  object_set_field(object, str_value(name), value);
   return true;
 }
 
 static bool obj_get_subs(Value receiver, Value index, Value* result) {
   ObjObject* object = AS_OBJECT(receiver);
-  if (hashtable_get(&object->fields, index, result)) {
+  if (object_get_field(object, index, result)) {
     return true;
   }
   *result = nil_value();
@@ -84,7 +84,7 @@ static bool obj_get_subs(Value receiver, Value index, Value* result) {
 
 static bool obj_set_subs(Value receiver, Value index, Value value) {
   ObjObject* object = AS_OBJECT(receiver);
-  hashtable_set(&object->fields, index, value);
+  object_set_field(object, index, value);
   return true;
 }
 
@@ -104,7 +104,7 @@ static Value obj_ctor(int argc, Value argv[]) {
 static Value instance_object_to_str(int argc, Value* argv) {
   UNUSED(argc);
 
-  ObjString* name = (argv[0]).type->name;
+  ObjString* name = value_type(argv[0])->name;
   if (name == NULL || name->chars == NULL) {
     name = copy_string("???", 3);
   }
@@ -133,14 +133,13 @@ static Value anonymous_object_to_str(int argc, Value* argv) {
                           // last delimiter
 
   strcpy(chars, VALUE_STR_OBJECT_START);
-  for (int i = 0; i < object->fields.capacity; i++) {
-    if (is_empty_internal(object->fields.entries[i].key)) {
-      continue;
-    }
-
+  int index = 0;
+  Value key;
+  Value value;
+  while (object_next_field(object, &index, &key, &value)) {
     // Execute the to_str method on the key
-    vm_push(object->fields.entries[i].key);  // Push the receiver (key at i) for to_str
-    ObjString* key_str = AS_STR(vm_exec_callable(fn_value(object->fields.entries[i].key.type->__to_str), 0));
+    vm_push(key);  // Push the receiver (key) for to_str
+    ObjString* key_str = AS_STR(vm_exec_callable(fn_value(value_type(key)->__to_str), 0));
     if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
       return nil_value();
     }
@@ -148,8 +147,8 @@ static Value anonymous_object_to_str(int argc, Value* argv) {
     vm_push(str_value(key_str));  // GC Protection
 
     // Execute the to_str method on the value
-    vm_push(object->fields.entries[i].value);  // Push the receiver (value at i) for to_str
-    ObjString* value_str = AS_STR(vm_exec_callable(fn_value(object->fields.entries[i].value.type->__to_str), 0));
+    vm_push(value);  // Push the receiver (value) for to_str
+    ObjString* value_str = AS_STR(vm_exec_callable(fn_value(value_type(value)->__to_str), 0));
     if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
       return nil_value();
     }
@@ -174,7 +173,7 @@ static Value anonymous_object_to_str(int argc, Value* argv) {
     strcat(chars, key_str->chars);
     strcat(chars, VALUE_STR_OBJECT_SEPARATOR);
     strcat(chars, value_str->chars);
-    if (processed < object->fields.count - 1) {
+    if (processed < object_field_count(object) - 1) {
       strcat(chars, VALUE_STR_OBJECT_DELIM);
     }
     processed++;
@@ -211,15 +210,15 @@ static Value obj_to_str(int argc, Value argv[]) {
   // TODO (refactor): Currently, only ObjObject objs are anonymous. The rest is handled as an instance.
 
   // // This here is the catch-all for all values. We print the type-name and memory address of the value.
-  // ObjString* t_name = argv[0].type->name;
+  // ObjString* t_name = value_type(argv[0])->name;
 
   // // Print the memory address of the object using (void*)AS_OBJ(argv[0]).
   // // We need to know the size of the buffer to allocate, so we calculate it first.
-  // size_t adr_str_len = snprintf(NULL, 0, "%p", (void*)argv[0].as.obj);
+  // size_t adr_str_len = snprintf(NULL, 0, "%p", (void*)AS_OBJ(argv[0]));
 
   // size_t buf_size = VALUE_STRFMT_OBJ_LEN + t_name->length + adr_str_len;
   // char* chars     = malloc(buf_size);
-  // snprintf(chars, buf_size, VALUE_STRFMT_OBJ, t_name->chars, (void*)argv[0].as.obj);
+  // snprintf(chars, buf_size, VALUE_STRFMT_OBJ, t_name->chars, (void*)AS_OBJ(argv[0]));
   // // Intuitively, you'd expect to use take_string here, but we don't know where malloc
   // // allocates the memory - we don't want this block in our own memory pool.
   // ObjString* str_obj = copy_string(chars, (int)buf_size - 1);
@@ -258,7 +257,7 @@ static Value obj_has(int argc, Value argv[]) {
         return nil_value();  // Propagate the error
       }
       // We don't use vm_is_falsey here, because we want a boolean value.
-      if (is_bool(result) && result.as.boolean) {
+      if (is_bool(result) && AS_BOOL(result)) {
         return bool_value(true);
       }
     }
@@ -269,7 +268,7 @@ static Value obj_has(int argc, Value argv[]) {
   // Value equality, which is easy given that an obj is a hash table. This is a shortcut before calling obj_get_prop, since most
   // of the time this is what we want.
   Value discard;
-  bool has = hashtable_get(&AS_OBJECT(argv[0])->fields, argv[1], &discard);
+  bool has = object_get_field(AS_OBJECT(argv[0]), argv[1], &discard);
   if (has) {
     return bool_value(true);
   }
@@ -299,20 +298,20 @@ static Value obj_entries(int argc, Value argv[]) {
   NATIVE_CHECK_RECEIVER_INHERITS(vm.obj_class)
 
   ObjObject* object = AS_OBJECT(argv[0]);
-  ValueArray items  = value_array_init_of_size(object->fields.count);
+  ValueArray items  = value_array_init_of_size(object_field_count(object));
   ObjSeq* seq       = take_seq(&items);  // We can already take the seq, because seqs don't calculate the hash upon taking.
   vm_push(seq_value(seq));               // GC Protection
 
   // Since we took the seq, we shouldn't manipule the items array directly, because only its [values] field lives on the heap.
   // Modifying items.count for example, would not be reflected in the seq.
-  for (int i = 0; i < object->fields.capacity; i++) {
-    Entry* entry = &object->fields.entries[i];
-    if (!is_empty_internal(entry->key)) {
-      vm_push(entry->key);
-      vm_push(entry->value);
-      vm_make_seq(2);                                    // Leaves a seq with the key-value on the stack
-      seq->items.values[seq->items.count++] = vm_pop();  // The seq
-    }
+  int index = 0;
+  Value key;
+  Value value;
+  while (object_next_field(object, &index, &key, &value)) {
+    vm_push(key);
+    vm_push(value);
+    vm_make_seq(2);                                    // Leaves a seq with the key-value on the stack
+    seq->items.values[seq->items.count++] = vm_pop();  // The seq
   }
 
   return vm_pop();  // The seq
@@ -327,14 +326,14 @@ static Value obj_keys(int argc, Value argv[]) {
   NATIVE_CHECK_RECEIVER_INHERITS(vm.obj_class)
 
   ObjObject* object = AS_OBJECT(argv[0]);
-  ValueArray items  = value_array_init_of_size(object->fields.count);
+  ValueArray items  = value_array_init_of_size(object_field_count(object));
 
   // We can direclty manipulate items.count, since we haven't taken the seq yet.
-  for (int i = 0; i < object->fields.capacity; i++) {
-    Entry* entry = &object->fields.entries[i];
-    if (!is_empty_internal(entry->key)) {
-      items.values[items.count++] = entry->key;
-    }
+  int index = 0;
+  Value key;
+  Value value;
+  while (object_next_field(object, &index, &key, &value)) {
+    items.values[items.count++] = key;
   }
 
   ObjSeq* seq = take_seq(&items);
@@ -350,14 +349,14 @@ static Value obj_values(int argc, Value argv[]) {
   NATIVE_CHECK_RECEIVER_INHERITS(vm.obj_class)
 
   ObjObject* object = AS_OBJECT(argv[0]);
-  ValueArray items  = value_array_init_of_size(object->fields.count);
+  ValueArray items  = value_array_init_of_size(object_field_count(object));
 
   // We can direclty manipulate items.count, since we haven't taken the seq yet.
-  for (int i = 0; i < object->fields.capacity; i++) {
-    Entry* entry = &object->fields.entries[i];
-    if (!is_empty_internal(entry->key)) {
-      items.values[items.count++] = entry->value;
-    }
+  int index = 0;
+  Value key;
+  Value value;
+  while (object_next_field(object, &index, &key, &value)) {
+    items.values[items.count++] = value;
   }
 
   ObjSeq* seq = take_seq(&items);
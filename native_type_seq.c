@@ -96,6 +96,7 @@ void native_seq_class_finalize() {
   define_native(&vm.seq_class->methods, "min", seq_min, 0);
   define_native(&vm.seq_class->methods, "max", seq_max, 0);
   define_native(&vm.seq_class->methods, "sum", seq_sum, 0);
+  define_native(&vm.seq_class->methods, "iter", native_iter, 0);
   finalize_new_class(vm.seq_class);
 }
 
@@ -113,16 +114,17 @@ static bool seq_get_subs(Value receiver, Value index, Value* result) {
 
 static bool seq_set_subs(Value receiver, Value index, Value value) {
   if (!is_int(index)) {
-    vm_error("Type %s does not support set-subscripting with %s. Expected " STR(TYPENAME_INT) ".", receiver.type->name->chars,
-             index.type->name->chars);
+    vm_error("Type %s does not support set-subscripting with %s. Expected " STR(TYPENAME_INT) ".",
+             value_type(receiver)->name->chars, value_type(index)->name->chars);
     return false;
   }
 
-  long long idx = index.as.integer;
+  long long idx = AS_INT(index);
   ObjSeq* seq   = AS_SEQ(receiver);
 
   if (idx < 0 || idx >= seq->items.count) {
-    vm_error("Index out of bounds. Was %d, but this " STR(TYPENAME_SEQ) " has length %d.", idx, seq->items.count);
+    vm_error_lazy("Index out of bounds. Was %d, but this " STR(TYPENAME_SEQ) " has length %d.", 2, int_value(idx),
+                  int_value(seq->items.count));
     return false;
   }
 
@@ -145,7 +147,7 @@ static Value seq_ctor(int argc, Value argv[]) {
     ObjSeq* seq = take_seq(&items);  // TODO (optimize): Use value_array_init_of_size
     vm_push(seq_value(seq));         // GC Protection
 
-    int count = (int)argv[1].as.integer;
+    int count = (int)AS_INT(argv[1]);
     for (int i = 0; i < count; i++) {
       value_array_write(&seq->items, nil_value());
     }
@@ -167,7 +169,8 @@ static Value seq_ctor(int argc, Value argv[]) {
   }
 
   // TODO: Make a macro for this error message
-  vm_error("Expected argument 0 of type " STR(TYPENAME_INT) " or " STR(TYPENAME_TUPLE) " but got %s.", argv[1].type->name->chars);
+  vm_error("Expected argument 0 of type " STR(TYPENAME_INT) " or " STR(TYPENAME_TUPLE) " but got %s.",
+           value_type(argv[1])->name->chars);
   return nil_value();
 }
 
@@ -208,7 +211,7 @@ static Value seq_yank(int argc, Value argv[]) {
   NATIVE_CHECK_ARG_AT(1, vm.int_class)
 
   ObjSeq* seq     = AS_SEQ(argv[0]);
-  long long index = argv[1].as.integer;
+  long long index = AS_INT(argv[1]);
 
   if (index > INT32_MAX || index < INT32_MIN) {
     vm_error("Index %lld surpasses the maximum value of %d.", index, INT32_MAX);
@@ -235,20 +238,22 @@ static Value seq_cull(int argc, Value argv[]) {
   ObjSeq* seq = new_seq();
   vm_push(seq_value(seq)); /* GC Protection */
 
+  VmCallback callback;
+  vm_callback_init(&callback, argv[1], fn_arity);
+
   /* Loops are duplicated to avoid the overhead of checking the arity on each iteration */
   switch (fn_arity) {
     case 1: {
       for (int i = 0; i < orig->items.count; i++) {
         /* Execute the provided function on the item */
-        vm_push(argv[1]);               /* Push the function */
-        vm_push(orig->items.values[i]); /* arg0 (1): Push the item */
-        Value result = vm_exec_callable(argv[1], 1);
+        Value args[] = {orig->items.values[i]};
+        Value result = vm_callback_call(&callback, args);
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
           return nil_value(); /* Propagate the error */
         }
 
         /* We don't use vm_is_falsey here, because we want to check for a boolean value. */
-        if (is_bool(result) && result.as.boolean) {
+        if (is_bool(result) && AS_BOOL(result)) {
           result = value_array_remove_at(&orig->items, i);
           vm_push(result); /* GC Protection */
           value_array_write(&seq->items, result);
@@ -260,16 +265,14 @@ static Value seq_cull(int argc, Value argv[]) {
     case 2: {
       for (int i = 0; i < orig->items.count; i++) {
         /* Execute the provided function on the item */
-        vm_push(argv[1]);               /* Push the function */
-        vm_push(orig->items.values[i]); /* arg0 (1): Push the item */
-        vm_push(int_value(i));          /* arg1 (2): Push the index */
-        Value result = vm_exec_callable(argv[1], 2);
+        Value args[] = {orig->items.values[i], int_value(i)};
+        Value result = vm_callback_call(&callback, args);
         if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
           return nil_value(); /* Propagate the error */
         }
 
         /* We don't use vm_is_falsey here, because we want to check for a boolean value. */
-        if (is_bool(result) && result.as.boolean) {
+        if (is_bool(result) && AS_BOOL(result)) {
           result = value_array_remove_at(&orig->items, i);
           vm_push(result); /* GC Protection */
           value_array_write(&seq->items, result);
@@ -63,6 +63,7 @@ void native_str_class_finalize() {
   define_native(&vm.str_class->methods, "ascii", str_ascii, 0);
   define_native(&vm.str_class->methods, "ascii_at", str_ascii_at, 1);
   define_native(&vm.str_class->methods, "chars", str_chars, 0);
+  define_native(&vm.str_class->methods, "iter", native_iter, 0);
   define_native(&vm.str_class->methods, "reps", str_reps, 1);
 
   define_native(&vm.str_class->static_methods, "from_ascii", str_from_ascii, 1);
@@ -70,7 +71,7 @@ void native_str_class_finalize() {
 }
 
 static bool str_eq(Value self, Value other) {
-  return self.type == other.type && AS_STR(self) == AS_STR(other);  // Works because strings are interned
+  return value_type(self) == value_type(other) && AS_STR(self) == AS_STR(other);  // Works because strings are interned
 }
 
 static bool str_get_prop(Value receiver, ObjString* name, Value* result) {
@@ -89,7 +90,7 @@ static bool str_get_subs(Value receiver, Value index, Value* result) {
     false;
   }
 
-  long long idx = index.as.integer;
+  long long idx = AS_INT(index);
   if (idx >= string->length) {
     *result = nil_value();
     return true;
@@ -117,7 +118,7 @@ static Value str_ctor(int argc, Value argv[]) {
   UNUSED(argc);
   // Execute the to_str method on the argument
   vm_push(argv[1]);  // Push the receiver for to_str, which is the ctors' argument
-  Value result = vm_exec_callable(fn_value(argv[1].type->__to_str), 0);  // Convert to string
+  Value result = vm_exec_callable(fn_value(value_type(argv[1])->__to_str), 0);  // Convert to string
   if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
     return nil_value();
   }
@@ -269,8 +270,8 @@ static Value str_slice(int argc, Value argv[]) {
     return str_value(copy_string("", 0));
   }
 
-  int start = (int)argv[1].as.integer;
-  int end   = (int)argv[2].as.integer;
+  int start = (int)AS_INT(argv[1]);
+  int end   = (int)AS_INT(argv[2]);
 
   // Handle negative indices
   if (start < 0) {
@@ -311,7 +312,7 @@ static Value str_add(int argc, Value argv[]) {
 
   if (!is_str(other)) {
     vm_push(other);  // Receiver
-    other = vm_exec_callable(fn_value(other.type->__to_str), 0);
+    other = vm_exec_callable(fn_value(value_type(other)->__to_str), 0);
     if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
       return nil_value();
     }
@@ -453,7 +454,7 @@ static Value str_ascii_at(int argc, Value argv[]) {
   NATIVE_CHECK_ARG_AT(1, vm.int_class);
 
   ObjString* str = AS_STR(argv[0]);
-  int index      = (int)argv[1].as.integer;
+  int index      = (int)AS_INT(argv[1]);
 
   if (index < 0 || index >= str->length) {
     return int_value(-1);
@@ -493,7 +494,7 @@ static Value str_reps(int argc, Value argv[]) {
   NATIVE_CHECK_ARG_AT(1, vm.int_class)
 
   ObjString* str = AS_STR(argv[0]);
-  int count      = (int)argv[1].as.integer;
+  int count      = (int)AS_INT(argv[1]);
 
   if (count <= 0) {
     return str_value(copy_string("", 0));
@@ -517,7 +518,7 @@ static Value str_from_ascii(int argc, Value argv[]) {
   UNUSED(argc);
   NATIVE_CHECK_ARG_AT(1, vm.int_class)
 
-  int code = (int)argv[1].as.integer;
+  int code = (int)AS_INT(argv[1]);
   if (code < 0 || code > 255) {
     vm_error("Invalid ASCII code %d.", code);
     return nil_value();
@@ -77,6 +77,7 @@ void native_tuple_class_finalize() {
   define_native(&vm.tuple_class->methods, "min", tuple_min, 0);
   define_native(&vm.tuple_class->methods, "max", tuple_max, 0);
   define_native(&vm.tuple_class->methods, "sum", tuple_sum, 0);
+  define_native(&vm.tuple_class->methods, "iter", native_iter, 0);
   finalize_new_class(vm.tuple_class);
 }
 
@@ -83,7 +83,7 @@ void finalize_new_class(ObjClass* klass) {
     }
 
     if (base != NULL && is_callable(temp)) {
-      *entry->field = temp.as.obj;
+      *entry->field = AS_OBJ(temp);
     } else {
       *entry->field = NULL;
     }
@@ -103,10 +103,236 @@ void finalize_new_class(ObjClass* klass) {
 ObjObject* new_instance(ObjClass* klass) {
   ObjObject* object      = (ObjObject*)allocate_obj(sizeof(ObjObject), OBJ_GC_OBJECT);
   object->instance_class = klass;
+  object->shape          = klass == vm.module_class ? NULL : vm.root_shape;  // The fields of a module are its globals
+  object->slots          = NULL;
+  object->slot_capacity  = 0;
+  object->slot_count     = 0;
   hashtable_init(&object->fields);
   return object;
 }
 
+// Allocates a new shape, which adds the field [key] to [parent]. If [parent] is NULL, a shape without any fields is created.
+// Might trigger garbage collection.
+static Shape* new_shape(Shape* parent, ObjString* key) {
+  Shape* shape               = ALLOCATE_ARRAY(Shape, 1);
+  shape->parent              = parent;
+  shape->slot_count          = parent == NULL ? 0 : parent->slot_count + 1;
+  shape->keys                = NULL;
+  shape->transitions         = NULL;
+  shape->transition_count    = 0;
+  shape->transition_capacity = 0;
+
+  if (parent != NULL) {
+    shape->keys = ALLOCATE_ARRAY(ObjString*, shape->slot_count);
+    if (parent->slot_count > 0) {
+      memcpy(shape->keys, parent->keys, sizeof(ObjString*) * parent->slot_count);  // The keys of the root shape are NULL
+    }
+    shape->keys[parent->slot_count] = key;
+  }
+
+  vm.shape_count++;
+  return shape;
+}
+
+Shape* new_root_shape() {
+  return new_shape(NULL, NULL);
+}
+
+void free_shape(Shape* shape) {
+  for (int i = 0; i < shape->transition_count; i++) {
+    free_shape(shape->transitions[i]);
+  }
+  FREE_ARRAY(Shape*, shape->transitions, shape->transition_capacity);
+  FREE_ARRAY(ObjString*, shape->keys, shape->slot_count);
+  FREE_ARRAY(Shape, shape, 1);
+  vm.shape_count--;
+}
+
+int shape_find_slot(Shape* shape, ObjString* key) {
+  for (int i = 0; i < shape->slot_count; i++) {
+    if (shape->keys[i] == key) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+Shape* shape_transition(Shape* shape, ObjString* key) {
+  for (int i = 0; i < shape->transition_count; i++) {
+    Shape* next = shape->transitions[i];
+    if (next->keys[next->slot_count - 1] == key) {
+      return next;
+    }
+  }
+
+  if (shape->slot_count >= SHAPE_MAX_FIELDS || vm.shape_count >= SHAPE_MAX_COUNT) {
+    return NULL;
+  }
+
+  if (SHOULD_GROW(shape->transition_count + 1, shape->transition_capacity)) {
+    int old_capacity           = shape->transition_capacity;
+    shape->transition_capacity = GROW_CAPACITY(old_capacity);
+    shape->transitions         = RESIZE_ARRAY(Shape*, shape->transitions, old_capacity, shape->transition_capacity);
+  }
+
+  Shape* next                                    = new_shape(shape, key);
+  shape->transitions[shape->transition_count++] = next;
+  return next;
+}
+
+// Moves the fields of an object with a shape into its hashtable. From then on, the object is in dictionary mode. Might trigger
+// garbage collection.
+static void object_to_dictionary(ObjObject* object) {
+  Shape* shape = object->shape;
+  for (int i = 0; i < shape->slot_count; i++) {
+    hashtable_set(&object->fields, str_value(shape->keys[i]), object->slots[i]);
+  }
+
+  FREE_ARRAY(Value, object->slots, object->slot_capacity);
+  object->shape         = NULL;
+  object->slots         = NULL;
+  object->slot_capacity = 0;
+}
+
+// Modules store their globals in slots, which are resolved at compile time. Their [fields] map the names to the slots.
+static inline bool is_module_object(ObjObject* object) {
+  return object->instance_class == vm.module_class;
+}
+
+// Returns the slot of the global [key] in [module], or -1 if the module does not have it.
+static int module_find_slot(ObjObject* module, Value key) {
+  Value slot;
+  return hashtable_get(&module->fields, key, &slot) ? (int)AS_INT(slot) : -1;
+}
+
+// Adds a new, undefined slot for the global [key] to [module] and returns it. Might trigger garbage collection.
+static int module_add_slot(ObjObject* module, Value key) {
+  if (SHOULD_GROW(module->slot_count + 1, module->slot_capacity)) {
+    int old_capacity      = module->slot_capacity;
+    module->slot_capacity = GROW_CAPACITY(old_capacity);
+    module->slots         = RESIZE_ARRAY(Value, module->slots, old_capacity, module->slot_capacity);
+  }
+
+  int slot            = module->slot_count++;
+  module->slots[slot] = empty_internal_value();
+  hashtable_set(&module->fields, key, int_value(slot));
+  return slot;
+}
+
+int module_global_slot(ObjObject* module, ObjString* name) {
+  int slot = module_find_slot(module, str_value(name));
+  return slot >= 0 ? slot : module_add_slot(module, str_value(name));
+}
+
+void object_set_field_transition(ObjObject* object, Shape* next, Value value) {
+  if (SHOULD_GROW(next->slot_count, object->slot_capacity)) {
+    int old_capacity      = object->slot_capacity;
+    object->slot_capacity = GROW_CAPACITY(old_capacity);
+    object->slots         = RESIZE_ARRAY(Value, object->slots, old_capacity, object->slot_capacity);
+  }
+
+  object->slots[next->slot_count - 1] = value;
+  object->shape                       = next;
+}
+
+bool object_get_field(ObjObject* object, Value key, Value* result) {
+  if (object->shape == NULL && is_module_object(object)) {
+    int slot = module_find_slot(object, key);
+    if (slot < 0 || is_empty_internal(object->slots[slot])) {
+      return false;
+    }
+    *result = object->slots[slot];
+    return true;
+  }
+  if (object->shape == NULL) {
+    return hashtable_get(&object->fields, key, result);
+  }
+  return is_str(key) && object_get_field_by_string(object, AS_STR(key), result);
+}
+
+bool object_get_field_by_string(ObjObject* object, ObjString* name, Value* result) {
+  if (object->shape == NULL && is_module_object(object)) {
+    return object_get_field(object, str_value(name), result);
+  }
+  if (object->shape == NULL) {
+    return hashtable_get_by_string(&object->fields, name, result);
+  }
+
+  int slot = shape_find_slot(object->shape, name);
+  if (slot < 0) {
+    return false;
+  }
+  *result = object->slots[slot];
+  return true;
+}
+
+void object_set_field(ObjObject* object, Value key, Value value) {
+  if (object->shape == NULL && is_module_object(object)) {
+    int slot = module_find_slot(object, key);
+    if (slot < 0) {
+      slot = module_add_slot(object, key);
+    }
+    object->slots[slot] = value;
+    return;
+  }
+
+  if (object->shape != NULL && is_str(key)) {
+    int slot = shape_find_slot(object->shape, AS_STR(key));
+    if (slot >= 0) {
+      object->slots[slot] = value;
+      return;
+    }
+
+    Shape* next = shape_transition(object->shape, AS_STR(key));
+    if (next != NULL) {
+      object_set_field_transition(object, next, value);
+      return;
+    }
+  }
+
+  if (object->shape != NULL) {
+    object_to_dictionary(object);
+  }
+  hashtable_set(&object->fields, key, value);
+}
+
+int object_field_count(ObjObject* object) {
+  if (object->shape == NULL && is_module_object(object)) {
+    int count = 0;
+    for (int i = 0; i < object->slot_count; i++) {
+      count += is_empty_internal(object->slots[i]) ? 0 : 1;
+    }
+    return count;
+  }
+  return object->shape == NULL ? object->fields.count : object->shape->slot_count;
+}
+
+bool object_next_field(ObjObject* object, int* index, Value* key, Value* value) {
+  if (object->shape != NULL) {
+    if (*index >= object->shape->slot_count) {
+      return false;
+    }
+    *key   = str_value(object->shape->keys[*index]);
+    *value = object->slots[*index];
+    (*index)++;
+    return true;
+  }
+
+  while (*index < object->fields.capacity) {
+    Entry* entry = &object->fields.entries[(*index)++];
+    if (is_empty_internal(entry->key)) {
+      continue;
+    }
+
+    *key   = entry->key;
+    *value = is_module_object(object) ? object->slots[AS_INT(entry->value)] : entry->value;
+    if (!is_empty_internal(*value)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 ObjUpvalue* new_upvalue(Value* slot) {
   ObjUpvalue* upvalue = (ObjUpvalue*)allocate_obj(sizeof(ObjUpvalue), OBJ_GC_UPVALUE);
   upvalue->closed     = nil_value();
@@ -116,15 +342,14 @@ ObjUpvalue* new_upvalue(Value* slot) {
 }
 
 ObjClosure* new_closure(ObjFunction* function) {
-  ObjUpvalue** upvalues = ALLOCATE_ARRAY(ObjUpvalue*, function->upvalue_count);
-  for (int i = 0; i < function->upvalue_count; i++) {
-    upvalues[i] = NULL;
-  }
+  size_t size = sizeof(ObjClosure) + sizeof(ObjUpvalue*) * (size_t)function->upvalue_count;
 
-  ObjClosure* closure    = (ObjClosure*)allocate_obj(sizeof(ObjClosure), OBJ_GC_CLOSURE);
+  ObjClosure* closure    = (ObjClosure*)allocate_obj(size, OBJ_GC_CLOSURE);
   closure->function      = function;
-  closure->upvalues      = upvalues;
   closure->upvalue_count = function->upvalue_count;
+  for (int i = 0; i < function->upvalue_count; i++) {
+    closure->upvalues[i] = NULL;
+  }
   return closure;
 }
 
@@ -132,8 +357,13 @@ ObjFunction* new_function() {
   ObjFunction* function     = (ObjFunction*)allocate_obj(sizeof(ObjFunction), OBJ_GC_FUNCTION);
   function->arity           = 0;
   function->upvalue_count   = 0;
+  function->max_depth       = 0;
   function->name            = NULL;
   function->globals_context = NULL;
+  function->closure         = NULL;
+  function->call_count      = 0;
+  function->jit             = NULL;
+  function->traces          = NULL;
   chunk_init(&function->chunk);
   return function;
 }
@@ -150,6 +380,36 @@ ObjTuple* new_tuple() {
   return take_tuple(&items);
 }
 
+ObjIter* new_iter(Value source, IterStage* stages, int stage_count) {
+  IterStage* copy = ALLOCATE_ARRAY(IterStage, stage_count);
+  for (int i = 0; i < stage_count; i++) {
+    copy[i] = stages[i];
+  }
+
+  ObjIter* iter     = (ObjIter*)allocate_obj(sizeof(ObjIter), OBJ_GC_ITER);
+  iter->source      = source;
+  iter->stages      = copy;
+  iter->stage_count = stage_count;
+  return iter;
+}
+
+ObjInt* new_boxed_int(SLANG_TYPE_INT value) {
+  bool paused = VM_HAS_FLAG(VM_FLAG_PAUSE_GC);
+  VM_SET_FLAG(VM_FLAG_PAUSE_GC);
+  ObjInt* boxed = (ObjInt*)allocate_obj(sizeof(ObjInt), OBJ_GC_INT);
+  boxed->value  = value;
+  if (!paused) {
+    VM_CLEAR_FLAG(VM_FLAG_PAUSE_GC);
+  }
+  return boxed;
+}
+
+#ifdef SLANG_NAN_BOXING
+SLANG_TYPE_INT value_as_boxed_int(Value value) {
+  return ((ObjInt*)AS_OBJ(value))->value;
+}
+#endif
+
 ObjNative* new_native(NativeFn function, ObjString* name, int arity) {
   ObjNative* native = (ObjNative*)allocate_obj(sizeof(ObjNative), OBJ_GC_NATIVE);
   native->function  = function;
@@ -173,7 +433,7 @@ static uint64_t hash_tuple(ValueArray* items) {
   uint64_t length = items->count;
   uint64_t result = TUPLE_HASH_INITIAL;
   for (uint64_t i = 0; i < length; i++) {
-    result = (result * TUPLE_HASH_MULTIPLIER) ^ items->values[i].type->__hash(items->values[i]);
+    result = (result * TUPLE_HASH_MULTIPLIER) ^ value_type(items->values[i])->__hash(items->values[i]);
   }
   result += TUPLE_HASH_OFFSET;
   return result;
@@ -203,6 +463,10 @@ ObjTuple* take_tuple(ValueArray* items) {
 ObjObject* take_object(HashTable* fields) {
   ObjObject* object      = (ObjObject*)allocate_obj(sizeof(ObjObject), OBJ_GC_OBJECT);
   object->instance_class = vm.obj_class;
+  object->shape          = NULL;
+  object->slots          = NULL;
+  object->slot_capacity  = 0;
+  object->slot_count     = 0;
   object->fields         = *fields;
   return object;
 }
@@ -25,6 +25,8 @@ typedef enum {
   OBJ_GC_STRING,
   OBJ_GC_UPVALUE,
   OBJ_GC_BOUND_METHOD,
+  OBJ_GC_ITER,
+  OBJ_GC_INT,  // Boxed int which doesn't fit into a NaN-boxed value, only used with SLANG_NAN_BOXING.
 } ObjGcType;
 
 // The base object construct.
@@ -45,15 +47,55 @@ struct ObjTuple {
   ValueArray items;
 };
 
+// An int which is boxed on the heap, because it doesn't fit into the payload of a NaN-boxed value. See int_value in vm.h.
+typedef struct {
+  Obj obj;
+  SLANG_TYPE_INT value;
+} ObjInt;
+
+// Kind of a stage of a lazy iterator, see ObjIter.
+typedef enum {
+  ITER_STAGE_MAP,        // Replaces the item with the result of calling [arg] with it.
+  ITER_STAGE_SIFT,       // Drops the item, unless calling [arg] with it returns true.
+  ITER_STAGE_TAKE,       // Passes the first [count] items, then ends the pipeline.
+  ITER_STAGE_DROP,       // Drops the first [count] items.
+  ITER_STAGE_ZIP,        // Pairs the item with the next item of [arg] into a tuple. Ends the pipeline once [arg] is exhausted.
+  ITER_STAGE_ENUMERATE,  // Pairs the position of the item with the item into a tuple.
+} IterStageKind;
+
+typedef struct {
+  IterStageKind kind;
+  Value arg;        // Function of a map or sift stage, the Seq, Tuple or Str of a zip stage.
+  long long count;  // Number of items of a take or drop stage.
+} IterStage;
+
+// A lazy iterator over the items of a Seq, Tuple or Str. Adding a stage (e.g. map, sift, take) creates a new iterator with the
+// stage appended - nothing is executed until a terminal method (e.g. sum, fold, to_seq) consumes it. Then, all stages run fused
+// in a single pass over [source], item by item, without materializing intermediate sequences.
+typedef struct {
+  Obj obj;
+  Value source;
+  IterStage* stages;
+  int stage_count;
+} ObjIter;
+
 struct ObjObject;
+struct JitCode;
+struct JitTrace;
+struct ObjClosure;
 
 typedef struct {
   Obj obj;
   int arity;
   int upvalue_count;
+  int max_depth;  // Most values a frame of the function holds in its stack window, see chunk_max_depth.
   Chunk chunk;
   ObjString* name;
   struct ObjObject* globals_context;
+  struct ObjClosure* closure;  // Closure shared by all OP_CLOSUREs of a function without upvalues, NULL until first created.
+  int call_count;           // Number of calls so far, counted until the function is compiled. See vm_enable_jit.
+  struct JitCode* jit;      // Machine code of the function, NULL if it has not been compiled.
+  struct JitTrace* traces;  // Traces of the loops in the function, see jit_trace.
 } ObjFunction;
 
 // The type of a native function. Native functions are functions that are
@@ -84,11 +126,11 @@ typedef struct ObjUpvalue {
   struct ObjUpvalue* next;
 } ObjUpvalue;
 
-typedef struct {
+typedef struct ObjClosure {
   Obj obj;
   ObjFunction* function;
-  ObjUpvalue** upvalues;
   int upvalue_count;
+  ObjUpvalue* upvalues[];  // Allocated together with the closure, so creating a closure is a single allocation.
 } ObjClosure;
 
 // Prop-getter. Returns false if an error occurred, true otherwise.
@@ -137,10 +179,33 @@ typedef struct ObjClass {
   Obj* __gteq;
 } ObjClass;
 
+// Maximum number of fields an object with a shape can have. Objects which exceed this limit fall back to dictionary mode.
+#define SHAPE_MAX_FIELDS 32
+
+// Maximum number of shapes the vm creates. Once reached, objects which would require a new shape fall back to dictionary mode.
+#define SHAPE_MAX_COUNT 4096
+
+// A shape (hidden class) describes the layout of the fields of an object: which field lives in which slot. Objects which got
+// the same fields assigned in the same order share a shape. Shapes form a transition tree rooted in vm.root_shape, where each
+// child adds exactly one field to its parent. Shapes are not garbage collected, they live as long as the vm.
+typedef struct Shape {
+  struct Shape* parent;
+  ObjString** keys;  // Names of the fields, indexed by slot.
+  int slot_count;    // Number of fields described by this shape.
+
+  struct Shape** transitions;  // Child shapes.
+  int transition_count;
+  int transition_capacity;
+} Shape;
+
 typedef struct ObjObject {
   Obj obj;
   ObjClass* instance_class;  // Only used for garbage collection, to be able to mark the class of an object.
-  HashTable fields;
+  Shape* shape;              // Layout of [slots]. NULL if the object is in dictionary mode, e.g. uses [fields] instead.
+  Value* slots;              // Field values of an object with a shape, laid out as described by [shape]. Globals of a module.
+  int slot_capacity;
+  int slot_count;    // Number of used [slots] of a module. Objects with a shape use [shape] instead.
+  HashTable fields;  // Field values of an object in dictionary mode. Maps the names of a modules' globals to their slots.
 } ObjObject;
 
 typedef struct {
@@ -153,10 +218,50 @@ typedef struct {
 // garbage collection.
 ObjBoundMethod* new_bound_method(Value receiver, Obj* method);
 
-// Creates, initializes and allocates a new object. Might trigger
-// garbage collection.
+// Creates, initializes and allocates a new object. The object starts with the empty root shape, unless it's a module, which are
+// always in dictionary mode. Might trigger garbage collection.
 ObjObject* new_instance(ObjClass* klass);
 
+// Creates the root shape (the shape of an object without any fields).
+Shape* new_root_shape();
+
+// Frees a shape and all shapes which are reachable through its transitions.
+void free_shape(Shape* shape);
+
+// Returns the slot of the field [key] in [shape], or -1 if the shape does not contain the field.
+int shape_find_slot(Shape* shape, ObjString* key);
+
+// Returns the shape which results from adding the field [key] to [shape]. Reuses an existing transition if there is one.
+// Returns NULL if the resulting shape would exceed SHAPE_MAX_FIELDS or SHAPE_MAX_COUNT. Might trigger garbage collection.
+Shape* shape_transition(Shape* shape, ObjString* key);
+
+// Gets the value of the field [key] of an object. Returns false if the object does not have the field.
+bool object_get_field(ObjObject* object, Value key, Value* result);
+
+// Gets the value of the field [name] of an object. Returns false if the object does not have the field.
+bool object_get_field_by_string(ObjObject* object, ObjString* name, Value* result);
+
+// Sets the field [key] of an object to [value], adding the field if it does not exist yet. Objects with a shape transition to
+// the next shape, or fall back to dictionary mode if [key] is not a string or the object outgrows its shape. Might trigger
+// garbage collection.
+void object_set_field(ObjObject* object, Value key, Value value);
+
+// Adds a field to an object with a shape by transitioning to [next], which must be a transition of the objects' current shape
+// (see shape_transition). [value] is stored in the new slot. Might trigger garbage collection.
+void object_set_field_transition(ObjObject* object, Shape* next, Value value);
+
+// Returns the number of fields of an object.
+int object_field_count(ObjObject* object);
+
+// Iterates over the fields of an object. [index] must be initialized to 0 and is advanced with each call. Writes the key and
+// value of the next field to [key] and [value] and returns true, or returns false if there are no more fields.
+bool object_next_field(ObjObject* object, int* index, Value* key, Value* value);
+
+// Returns the slot of the global [name] in [module], adding a slot for it if the module does not have it yet. Slots of globals
+// that are not yet defined hold an empty internal value. Used to resolve globals at compile time. Might trigger garbage
+// collection.
+int module_global_slot(ObjObject* module, ObjString* name);
+
 // Creates, initializes and allocates a new class object. Might trigger garbage
 // collection. Must be finalized with finalize_new_class at some point.
 ObjClass* new_class(ObjString* name, ObjClass* base);
@@ -181,10 +286,18 @@ ObjSeq* new_seq();
 // collection.
 ObjTuple* new_tuple();
 
+// Creates, initializes and allocates a new iterator object over [source] with a copy of the first [stage_count] [stages]. Might
+// trigger garbage collection.
+ObjIter* new_iter(Value source, IterStage* stages, int stage_count);
+
 // Creates, initializes and allocates a new native function object. Might
 // trigger garbage collection.
 ObjNative* new_native(NativeFn function, ObjString* name, int arity);
 
+// Creates, initializes and allocates a new boxed int. Never triggers garbage collection, since ints are created in the middle of
+// arithmetic, where the operands are no longer rooted.
+ObjInt* new_boxed_int(SLANG_TYPE_INT value);
+
 // Creates, initializes and allocates a new upvalue object. Might trigger
 // garbage collection.
 ObjUpvalue* new_upvalue(Value* slot);
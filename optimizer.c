@@ -0,0 +1,462 @@
+#include "optimizer.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "ast.h"
+#include "common.h"
+#include "scanner.h"
+#include "vm.h"
+
+// Forward declarations
+static AstNode* optimize_node(AstNode* node);
+
+//
+// Tree surgery
+//
+
+// Replaces [node] with [replacement] and frees [node]. [replacement] may be one of its children, in which case it's detached
+// before [node] is freed. Returns [replacement], for the caller to put it where [node] was.
+static AstNode* replace_node(AstNode* node, AstNode* replacement) {
+  for (int i = 0; i < node->count; i++) {
+    if (node->children[i] == replacement) {
+      node->children[i] = NULL;
+    }
+  }
+
+  replacement->parent = node->parent;
+  ast_free(node);
+  return replacement;
+}
+
+// Determines whether [node] can be dropped from the block it's in, e.g. because it's never executed. Declarations (of locals)
+// are kept, they're part of the layout of the blocks' scope. So are imports, which declare their variables in the blocks' scope.
+static bool is_removable(AstNode* node) {
+  return node->type == NODE_STMT && ((AstStatement*)node)->type != STMT_IMPORT;
+}
+
+// Determines whether [node] is a statement which never completes normally, making all following statements unreachable.
+static bool is_terminator(AstNode* node) {
+  if (node == NULL || node->type != NODE_STMT) {
+    return false;
+  }
+  switch (((AstStatement*)node)->type) {
+    case STMT_RETURN:
+    case STMT_THROW:
+    case STMT_BREAK:
+    case STMT_SKIP: return true;
+    default: return false;
+  }
+}
+
+//
+// Constant folding
+//
+
+// Determines whether [node] is a literal expression of a single value, e.g. not a Seq, Tuple or Obj. If so, sets [value] to it.
+static bool literal_value(AstNode* node, Value* value) {
+  if (node == NULL || node->type != NODE_EXPR || ((AstExpression*)node)->type != EXPR_LITERAL) {
+    return false;
+  }
+
+  AstLiteral* lit = (AstLiteral*)node->children[0];
+  switch (lit->type) {
+    case LIT_NUMBER:
+    case LIT_STRING:
+    case LIT_BOOL:
+    case LIT_NIL: *value = lit->value; return true;
+    default: return false;
+  }
+}
+
+// Replaces [node] with a literal expression of [value], which spans the same tokens.
+static AstNode* replace_with_literal(AstNode* node, Value value) {
+  Token start = node->token_start;
+  Token end   = node->token_end;
+  AstLiteral* lit;
+  if (is_str(value)) {
+    lit = ast_lit_str_init(start, end, AS_STR(value));
+  } else if (is_bool(value)) {
+    lit = ast_lit_bool_init(start, end, AS_BOOL(value));
+  } else if (is_nil(value)) {
+    lit = ast_lit_nil_init(start, end);
+  } else {
+    lit = ast_lit_number_init(start, end, value);
+  }
+
+  return replace_node(node, (AstNode*)ast_expr_literal_init(start, end, lit));
+}
+
+// Evaluates the binary [operator_] on the constants [left] and [right], exactly like the Vm does. Returns false if the result is
+// not known at compile time, e.g. because the operation throws or is implemented by the operands' class.
+static bool fold_binary(TokenKind operator_, Value left, Value right, Value* result) {
+  if (operator_ == TOKEN_EQ || operator_ == TOKEN_NEQ) {
+    bool equal = value_type(left)->__equals(left, right);
+    *result    = bool_value(operator_ == TOKEN_EQ ? equal : !equal);
+    return true;
+  }
+
+  if (operator_ == TOKEN_PLUS && is_str(left) && is_str(right)) {
+    vm_push(left);
+    vm_push(right);
+    vm_concatenate();
+    *result = vm_pop();  // Rooted by the AST once the literal is created, which doesn't allocate on the managed heap.
+    return true;
+  }
+
+  if (!is_num(left) || !is_num(right)) {
+    return false;
+  }
+
+  bool ints = is_int(left) && is_int(right);
+  double a  = num_as_double(left);
+  double b  = num_as_double(right);
+  switch (operator_) {
+    case TOKEN_PLUS: *result = ints ? int_value(AS_INT(left) + AS_INT(right)) : float_value(a + b); return true;
+    case TOKEN_MINUS: *result = ints ? int_value(AS_INT(left) - AS_INT(right)) : float_value(a - b); return true;
+    case TOKEN_MULT: *result = ints ? int_value(AS_INT(left) * AS_INT(right)) : float_value(a * b); return true;
+    case TOKEN_LT: *result = bool_value(ints ? AS_INT(left) < AS_INT(right) : a < b); return true;
+    case TOKEN_GT: *result = bool_value(ints ? AS_INT(left) > AS_INT(right) : a > b); return true;
+    case TOKEN_LTEQ: *result = bool_value(ints ? AS_INT(left) <= AS_INT(right) : a <= b); return true;
+    case TOKEN_GTEQ: *result = bool_value(ints ? AS_INT(left) >= AS_INT(right) : a >= b); return true;
+    case TOKEN_DIV: {
+      if (!is_nonzero_num(right)) {
+        return false;  // Division by zero is a runtime error.
+      }
+      *result = float_value(a / b);
+      return true;
+    }
+    case TOKEN_MOD: {
+      if (!is_nonzero_num(right)) {
+        return false;  // Modulo by zero is a runtime error.
+      }
+      *result = ints ? int_value(AS_INT(left) % AS_INT(right)) : float_value(fmod(a, b));
+      return true;
+    }
+    default: return false;
+  }
+}
+
+// Folds [expr] if its value is known at compile time, or if it's a branch on a constant. Returns the replacement of [expr], or
+// [expr] itself.
+static AstNode* fold_expr(AstExpression* expr) {
+  AstNode* node = (AstNode*)expr;
+  Value left;
+  Value right;
+  Value result;
+
+  switch (expr->type) {
+    case EXPR_GROUPING: {
+      if (literal_value(node->children[0], &left)) {
+        return replace_node(node, node->children[0]);
+      }
+      break;
+    }
+    case EXPR_UNARY: {
+      if (!literal_value(node->children[0], &left)) {
+        break;
+      }
+      if (expr->operator_.type == TOKEN_NEGATE) {
+        return replace_with_literal(node, bool_value(vm_is_falsey(left)));
+      }
+      if (expr->operator_.type == TOKEN_MINUS && is_int(left)) {
+        return replace_with_literal(node, int_value(-AS_INT(left)));
+      }
+      if (expr->operator_.type == TOKEN_MINUS && is_float(left)) {
+        return replace_with_literal(node, float_value(-AS_FLOAT(left)));
+      }
+      break;
+    }
+    case EXPR_BINARY: {
+      if (literal_value(node->children[0], &left) && literal_value(node->children[1], &right) &&
+          fold_binary(expr->operator_.type, left, right, &result)) {
+        return replace_with_literal(node, result);
+      }
+      break;
+    }
+    case EXPR_AND: {
+      if (literal_value(node->children[0], &left)) {
+        return replace_node(node, node->children[vm_is_falsey(left) ? 0 : 1]);
+      }
+      break;
+    }
+    case EXPR_OR: {
+      if (literal_value(node->children[0], &left)) {
+        return replace_node(node, node->children[vm_is_falsey(left) ? 1 : 0]);
+      }
+      break;
+    }
+    case EXPR_COALESCE: {
+      if (literal_value(node->children[0], &left)) {
+        return replace_node(node, node->children[is_nil(left) ? 1 : 0]);
+      }
+      break;
+    }
+    case EXPR_TERNARY: {
+      if (literal_value(node->children[0], &left)) {
+        return replace_node(node, node->children[vm_is_falsey(left) ? 2 : 1]);
+      }
+      break;
+    }
+    default: break;
+  }
+
+  return node;
+}
+
+//
+// Dead code elimination
+//
+
+// Removes branches on constant conditions from [stmt]. Returns the replacement of [stmt], [stmt] itself, or NULL if it can be
+// removed entirely.
+static AstNode* fold_stmt(AstStatement* stmt) {
+  AstNode* node = (AstNode*)stmt;
+  Value condition;
+  bool in_block = node->parent != NULL && node->parent->type == NODE_BLOCK;
+
+  switch (stmt->type) {
+    case STMT_IF: {
+      if (!literal_value(node->children[0], &condition)) {
+        break;
+      }
+      AstNode* taken = node->children[vm_is_falsey(condition) ? 2 : 1];
+      if (taken != NULL) {
+        return replace_node(node, taken);
+      }
+      if (in_block) {
+        ast_free(node);
+        return NULL;
+      }
+      break;
+    }
+    case STMT_WHILE: {
+      if (literal_value(node->children[0], &condition) && vm_is_falsey(condition) && in_block) {
+        ast_free(node);
+        return NULL;
+      }
+      break;
+    }
+    default: break;
+  }
+
+  return node;
+}
+
+// Removes the statements of [block] which were optimized away, and those which follow a statement that never completes normally.
+static void compact_block(AstNode* block) {
+  bool reachable = true;
+  int count      = 0;
+  for (int i = 0; i < block->count; i++) {
+    AstNode* child = block->children[i];
+    if (child == NULL) {
+      continue;
+    }
+    if (!reachable && is_removable(child)) {
+      ast_free(child);
+      continue;
+    }
+
+    block->children[count++] = child;
+    reachable &= !is_terminator(child);
+  }
+  block->count = count;
+}
+
+// Optimizes [node] and its children, bottom-up. Returns the replacement of [node], [node] itself, or NULL if it was removed.
+static AstNode* optimize_node(AstNode* node) {
+  if (node == NULL) {
+    return NULL;
+  }
+
+  for (int i = 0; i < node->count; i++) {
+    node->children[i] = optimize_node(node->children[i]);
+  }
+
+  switch (node->type) {
+    case NODE_EXPR: return fold_expr((AstExpression*)node);
+    case NODE_STMT: return fold_stmt((AstStatement*)node);
+    case NODE_BLOCK: compact_block(node); return node;
+    default: return node;
+  }
+}
+
+//
+// Common subexpression elimination
+//
+
+// Determines whether evaluating [node] has no side effects. Since nothing is written, evaluating it twice yields the same value
+// - as long as nothing else is evaluated in between that could have side effects. The exception are bound methods, which are
+// created anew on each property access - OP_REUSE takes care of those.
+static bool is_pure(AstNode* node) {
+  if (node == NULL) {
+    return true;
+  }
+  if (node->type != NODE_EXPR) {
+    return false;
+  }
+
+  Value value;
+  switch (((AstExpression*)node)->type) {
+    case EXPR_LITERAL: return literal_value(node, &value);
+    case EXPR_VARIABLE:
+    case EXPR_THIS: return true;
+    case EXPR_GROUPING:
+    case EXPR_DOT: return is_pure(node->children[0]);
+    case EXPR_SUBS: return is_pure(node->children[0]) && is_pure(node->children[1]);
+    default: return false;
+  }
+}
+
+// Determines whether the pure expressions [a] and [b] always evaluate to the same value, if nothing is written in between.
+static bool is_same_value(AstNode* a, AstNode* b) {
+  if (a == NULL || b == NULL || a->type != NODE_EXPR || b->type != NODE_EXPR) {
+    return false;
+  }
+
+  AstExpression* left  = (AstExpression*)a;
+  AstExpression* right = (AstExpression*)b;
+  if (left->type != right->type) {
+    return false;
+  }
+
+  switch (left->type) {
+    case EXPR_THIS: return true;
+    case EXPR_VARIABLE: {
+      AstId* left_id  = (AstId*)a->children[0];
+      AstId* right_id = (AstId*)b->children[0];
+      return left_id->ref != NULL && right_id->ref != NULL && left_id->ref->symbol == right_id->ref->symbol;
+    }
+    case EXPR_LITERAL: {
+      Value left_value;
+      Value right_value;
+      return literal_value(a, &left_value) && literal_value(b, &right_value) &&
+             value_type(left_value) == value_type(right_value) && value_type(left_value)->__equals(left_value, right_value);
+    }
+    case EXPR_GROUPING: return is_same_value(a->children[0], b->children[0]);
+    case EXPR_DOT: {
+      return left->operator_.type == right->operator_.type &&
+             ((AstId*)a->children[1])->name == ((AstId*)b->children[1])->name && is_same_value(a->children[0], b->children[0]);
+    }
+    case EXPR_SUBS: {
+      return left->operator_.type == right->operator_.type && is_same_value(a->children[0], b->children[0]) &&
+             is_same_value(a->children[1], b->children[1]);
+    }
+    default: return false;
+  }
+}
+
+// Determines whether [parent] keeps the values of its children on the stack until it has evaluated all of them, e.g. operands
+// of binary expressions, arguments or the items of a Seq literal. See count_temporaries in the resolver.
+static bool keeps_operands(AstNode* parent) {
+  if (parent->scope != NULL) {
+    return false;  // Inlined calls and lowered Seq methods keep them in locals.
+  }
+  if (parent->type == NODE_LIT) {
+    LiteralType type = ((AstLiteral*)parent)->type;
+    return type == LIT_SEQ || type == LIT_TUPLE;
+  }
+  if (parent->type != NODE_EXPR) {
+    return false;
+  }
+
+  switch (((AstExpression*)parent)->type) {
+    case EXPR_BINARY:
+    case EXPR_CALL:
+    case EXPR_INVOKE:
+    case EXPR_SUBS:
+    case EXPR_SLICE: return true;
+    default: return false;
+  }
+}
+
+// Determines whether [parent] evaluates its child without keeping anything on the stack, e.g. the branches of a ternary, whose
+// condition is popped before they're evaluated.
+static bool passes_through(AstNode* parent) {
+  if (parent->type != NODE_EXPR || parent->scope != NULL) {
+    return false;
+  }
+
+  AstExpression* expr = (AstExpression*)parent;
+  switch (expr->type) {
+    case EXPR_GROUPING:
+    case EXPR_AND:
+    case EXPR_OR:
+    case EXPR_COALESCE:
+    case EXPR_TERNARY: return true;
+    case EXPR_UNARY: return expr->operator_.type == TOKEN_NEGATE || expr->operator_.type == TOKEN_MINUS;
+    default: return false;
+  }
+}
+
+// Returns the number of values [parent] has pushed onto the stack before it evaluates its child at [index]. [parent] must keep
+// its operands.
+static int pushed_before(AstNode* parent, int index) {
+  if (parent->type == NODE_EXPR && ((AstExpression*)parent)->type == EXPR_INVOKE) {
+    return index > 1 ? index - 1 : 0;  // The method name is not pushed.
+  }
+  return index;
+}
+
+// Looks for an expression that evaluates to the same value as [expr], and whose value is still on the stack when [expr] is
+// evaluated - because it's an operand of an enclosing expression that was evaluated right before it. Returns the distance of
+// that value from the top of the stack, or -1 if there's none. Everything evaluated in between must be pure as well.
+static int find_reuse(AstExpression* expr) {
+  int distance   = 0;
+  AstNode* child = (AstNode*)expr;
+  for (AstNode* parent = child->parent; parent != NULL; child = parent, parent = parent->parent) {
+    bool keeps = keeps_operands(parent);
+    if (!keeps && !passes_through(parent)) {
+      return -1;
+    }
+
+    int index = 0;
+    while (parent->children[index] != child) {
+      index++;
+    }
+
+    for (int i = index - 1; i >= 0; i--) {
+      AstNode* sibling = parent->children[i];
+      if (sibling != NULL && sibling->type == NODE_ID) {
+        continue;  // The method name of an invocation.
+      }
+      if (keeps && is_same_value(sibling, (AstNode*)expr)) {
+        return distance + pushed_before(parent, index) - pushed_before(parent, i) - 1;
+      }
+      if (!is_pure(sibling)) {
+        return -1;
+      }
+    }
+
+    if (keeps) {
+      distance += pushed_before(parent, index);
+    }
+  }
+
+  return -1;
+}
+
+// Marks property and subscript reads in [node] which evaluate to a value that's already on the stack, see find_reuse.
+static void mark_reuses(AstNode* node) {
+  if (node == NULL) {
+    return;
+  }
+
+  if (node->type == NODE_EXPR) {
+    AstExpression* expr = (AstExpression*)node;
+    if ((expr->type == EXPR_DOT || expr->type == EXPR_SUBS) && is_pure(node)) {
+      expr->reuse = find_reuse(expr);
+      if (expr->reuse >= 0) {
+        return;  // Rarely evaluated, see OP_REUSE.
+      }
+    }
+  }
+
+  for (int i = 0; i < node->count; i++) {
+    mark_reuses(node->children[i]);
+  }
+}
+
+void optimize(AstFn* ast) {
+  ast->base.children[2] = optimize_node(ast->base.children[2]);
+  mark_reuses((AstNode*)ast);
+}
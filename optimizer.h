@@ -0,0 +1,11 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "ast.h"
+
+// Optimizes a resolved AST in place: Folds constant expressions, removes branches on constant conditions and unreachable
+// statements, and marks common subexpressions whose value is still on the stack, so that the compiler can reuse it. Must only be
+// called on an AST which was resolved without errors.
+void optimize(AstFn* ast);
+
+#endif  // OPTIMIZER_H
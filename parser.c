@@ -13,6 +13,7 @@ typedef enum {
   PREC_NONE,
   PREC_ASSIGN,      // =
   PREC_TERNARY,     // ?:
+  PREC_COALESCE,    // ??
   PREC_OR,          // or
   PREC_AND,         // and
   PREC_EQUALITY,    // == !=
@@ -172,7 +173,7 @@ static bool check_assignment_target(Parser* parser, AstExpression* expr) {
   switch (expr->type) {
     case EXPR_VARIABLE:
     case EXPR_SUBS:
-    case EXPR_DOT: return true;
+    case EXPR_DOT: return expr->operator_.type != TOKEN_SAFE_DOT;  // Nil-safe access yields a value, not a location.
     default: return false;
   }
 }
@@ -581,6 +582,27 @@ static AstExpression* parse_expr_dot(Parser* parser, Token expr_start, AstExpres
   }
 }
 
+// Nil-safe access, e.g. 'a?.b' or 'a?.[i]'. Evaluates to nil if the receiver is nil - or, for properties, if the receiver
+// doesn't have the property.
+static AstExpression* parse_expr_safe_access(Parser* parser, Token expr_start, AstExpression* left) {
+  Token operator_ = parser->previous;  // TOKEN_SAFE_DOT
+  AstExpression* expr;
+
+  if (match(parser, TOKEN_OBRACK)) {
+    AstExpression* index = parse_expression(parser);
+    consume(parser, TOKEN_CBRACK, "Expecting ']' after index.");
+    expr = ast_expr_subs_init(expr_start, parser->previous, left, index);
+  } else {
+    consume(parser, TOKEN_ID, "Expecting property name or '[' after '?.'.");
+    ObjString* property = copy_string(parser->previous.start, parser->previous.length);
+    AstId* id           = ast_id_init(parser->previous, property);
+    expr                = ast_expr_dot_init(expr_start, parser->previous, left, id);
+  }
+
+  expr->operator_ = operator_;
+  return expr;
+}
+
 static AstExpression* parse_expr_ternary(Parser* parser, Token expr_start, AstExpression* left) {
   AstExpression* true_branch = parse_precedence(parser, PREC_TERNARY);
   consume(parser, TOKEN_COLON, "Expecting ':' after true branch.");
@@ -598,6 +620,12 @@ static AstExpression* parse_expr_or(Parser* parser, Token expr_start, AstExpress
   return ast_expr_or_init(expr_start, parser->previous, left, right);
 }
 
+// Right-associative, so 'a ?? b ?? c' evaluates to the first non-nil value.
+static AstExpression* parse_expr_coalesce(Parser* parser, Token expr_start, AstExpression* left) {
+  AstExpression* right = parse_precedence(parser, PREC_COALESCE);
+  return ast_expr_coalesce_init(expr_start, parser->previous, left, right);
+}
+
 static AstExpression* parse_expr_is(Parser* parser, Token expr_start, AstExpression* left) {
   // Operator is either TOKEN_IS or TOKEN_NOT to differentiate between "is" and "is not"
   Token operator = parser->previous;
@@ -654,6 +682,8 @@ static ParseRule rules2[] = {
     [TOKEN_PLUS]         = {NULL, parse_expr_binary, PREC_TERM},
     [TOKEN_PLUS_PLUS]    = {parse_expr_unary, parse_expr_postfix, PREC_CALL},
     [TOKEN_MINUS_MINUS]  = {parse_expr_unary, parse_expr_postfix, PREC_CALL},
+    [TOKEN_COALESCE]     = {NULL, parse_expr_coalesce, PREC_COALESCE},
+    [TOKEN_SAFE_DOT]     = {NULL, parse_expr_safe_access, PREC_CALL},
     [TOKEN_DIV]          = {NULL, parse_expr_binary, PREC_FACTOR},
     [TOKEN_MULT]         = {NULL, parse_expr_binary, PREC_FACTOR},
     [TOKEN_MOD]          = {NULL, parse_expr_binary, PREC_FACTOR},
@@ -896,6 +926,34 @@ static AstStatement* parse_statement_return(Parser* parser) {
   return ast_stmt_return_init(stmt_start, parser->previous, expression);
 }
 
+// Parses a for-in loop, e.g. "for x in xs; ...", "for k, v in obj; ..." or "for i in 0..n; ...". The loop variables are
+// collected in a DECL_FN_PARAMS declaration, because just like parameters, they are defined by the loop itself.
+static AstStatement* parse_statement_for_in(Parser* parser, Token stmt_start) {
+  AstDeclaration* vars = ast_decl_fn_params_init(parser->current, parser->current);
+
+  do {
+    consume(parser, TOKEN_ID, "Expecting loop variable name.");
+    ObjString* var_name = copy_string(parser->previous.start, parser->previous.length);
+    AstId* var_id       = ast_id_init(parser->previous, var_name);
+    ast_decl_fn_params_add_param(vars, var_id);
+  } while (vars->base.count < 2 && match(parser, TOKEN_COMMA));
+  vars->base.token_end = parser->previous;
+
+  consume(parser, TOKEN_IN, "Expecting 'in' after loop variables.");
+  AstExpression* iterable  = parse_expression(parser);
+  AstExpression* range_end = NULL;
+  if (match(parser, TOKEN_DOTDOT)) {
+    if (vars->base.count > 1) {
+      parser_error_at_previous(parser, "Can't have more than one loop variable in a range loop.");
+    }
+    range_end = parse_expression(parser);
+  }
+  consume(parser, TOKEN_SCOLON, "Expecting ';' after loop iterable.");
+
+  AstStatement* body = parse_statement(parser);
+  return ast_stmt_for_in_init(stmt_start, parser->previous, vars, iterable, range_end, body);
+}
+
 static AstStatement* parse_statement_for(Parser* parser) {
   Token stmt_start         = parser->previous;  // Previous is FOR
   AstNode* initializer     = NULL;
@@ -903,6 +961,14 @@ static AstStatement* parse_statement_for(Parser* parser) {
   AstExpression* increment = NULL;
   AstStatement* body       = NULL;
 
+  // A for-in loop starts with a loop variable, followed by 'in' or another loop variable.
+  if (check(parser, TOKEN_ID)) {
+    TokenKind next = scanner_peek_token().type;
+    if (next == TOKEN_IN || next == TOKEN_COMMA) {
+      return parse_statement_for_in(parser, stmt_start);
+    }
+  }
+
   // Initializer
   if (match(parser, TOKEN_SCOLON)) {
     // No initializer
@@ -0,0 +1,265 @@
+#include "peephole.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include "common.h"
+#include "compiler.h"
+
+// Maximum number of passes over a chunk. A rewrite can enable another one, e.g. removing a dead store leaves a value which is
+// pushed and popped right away. Passes are repeated until nothing changes anymore, or until this limit is reached.
+#define PEEPHOLE_MAX_PASSES 4
+
+typedef struct {
+  Chunk* chunk;
+  int* targets;     // Absolute offset the branch instruction at an offset jumps to, -1 if it's not the start of a branch.
+  bool* is_target;  // Whether control can arrive at an offset other than by falling through, e.g. by a jump or a try handler.
+  bool* removed;    // Whether the code unit at an offset is cut out of the chunk.
+} Peephole;
+
+// Returns the opcode of the instruction at [offset], or -1 if [offset] is past the end of the chunk.
+static int op_at(Peephole* p, int offset) {
+  return offset < p->chunk->count ? p->chunk->code[offset] : -1;
+}
+
+// Returns the offset of the instruction following the one at [offset].
+static int next_of(Peephole* p, int offset) {
+  return offset + chunk_instruction_length(p->chunk, offset);
+}
+
+// Returns the offset of the first code unit at or after [offset] which has not been removed.
+static int skip_removed(Peephole* p, int offset) {
+  while (offset < p->chunk->count && p->removed[offset]) {
+    offset++;
+  }
+  return offset;
+}
+
+// Determines whether [op] pushes a value without any side effects, e.g. without reading a global, which might throw.
+static bool is_pure_push(OpCode op) {
+  switch (op) {
+    case OP_CONSTANT:
+    case OP_NIL:
+    case OP_TRUE:
+    case OP_FALSE:
+    case OP_DUPE:
+    case OP_GET_LOCAL:
+    case OP_GET_UPVALUE: return true;
+    default: return false;
+  }
+}
+
+static void remove_units(Peephole* p, int offset, int count) {
+  for (int i = offset; i < offset + count; i++) {
+    p->removed[i] = true;
+  }
+}
+
+// Records the targets of all branches in the chunk, and where else control can arrive - at the handlers of try ranges.
+static void record_targets(Peephole* p) {
+  Chunk* chunk = p->chunk;
+  for (int i = 0; i <= chunk->count; i++) {
+    p->targets[i]   = -1;
+    p->is_target[i] = false;
+  }
+
+  for (int offset = skip_removed(p, 0); offset < chunk->count; offset = skip_removed(p, next_of(p, offset))) {
+    OpCode op   = (OpCode)chunk->code[offset];
+    int next    = next_of(p, offset);
+    int operand = chunk_jump_operand(op);
+    if (operand > 0) {
+      p->targets[offset] = next + chunk->code[offset + operand];
+    } else if (op == OP_LOOP) {
+      p->targets[offset] = next - chunk->code[offset + 1];
+    } else {
+      continue;
+    }
+    p->is_target[p->targets[offset]] = true;
+  }
+
+  for (int i = 0; i < chunk->try_count; i++) {
+    p->is_target[chunk->tries[i].handler] = true;
+  }
+}
+
+// Lets the forward branch at [offset] jump straight to the end of the chain of OP_JUMPs it targets. Returns true if the target
+// changed.
+static bool thread_jump(Peephole* p, int offset) {
+  int next   = next_of(p, offset);
+  int target = p->targets[offset];
+  while (op_at(p, target) == OP_JUMP && p->targets[target] - next <= MAX_JUMP) {
+    target = p->targets[target];
+  }
+
+  if (target == p->targets[offset]) {
+    return false;
+  }
+  p->targets[offset] = target;
+  return true;
+}
+
+// Applies the first matching rewrite to the instruction at [offset] and the ones following it. Returns the offset to continue at,
+// and sets [changed] if something was rewritten.
+static int rewrite(Peephole* p, int offset, bool* changed) {
+  uint16_t* code = p->chunk->code;
+  OpCode op      = (OpCode)code[offset];
+  int b          = next_of(p, offset);
+  int b_op       = op_at(p, b);
+
+  if (p->targets[offset] >= 0 && op != OP_LOOP) {
+    // The branch of an inlined call guard is where the regular call returns to. Errors raised by that call are looked up at the
+    // instruction before it, which must stay within the same try range - so it's not threaded.
+    if (op != OP_CALL_INLINED && op != OP_INVOKE_INLINED) {
+      *changed |= thread_jump(p, offset);
+    }
+
+    // A jump to the next instruction does nothing, the conditional ones leave the condition on the stack.
+    bool no_pop = op == OP_JUMP || op == OP_JUMP_IF_FALSE || op == OP_JUMP_IF_TRUE || op == OP_JUMP_IF_NOT_NIL;
+    if (no_pop && p->targets[offset] == b) {
+      remove_units(p, offset, b - offset);
+      *changed = true;
+    }
+    return b;
+  }
+
+  // [push][pop] -> []
+  if (is_pure_push(op) && b_op == OP_POP && !p->is_target[b]) {
+    remove_units(p, offset, b + 1 - offset);
+    *changed = true;
+    return b + 1;
+  }
+
+  // [nil][return] -> [return_nil]
+  if (op == OP_NIL && b_op == OP_RETURN && !p->is_target[b]) {
+    code[offset] = OP_RETURN_NIL;
+    remove_units(p, b, 1);
+    *changed = true;
+    return b + 1;
+  }
+
+  // [not][jump_if_false][pop] -> [jump_if_true][pop], if the jump also lands on a pop. The condition is popped on both paths, so
+  // it does not matter that it's no longer negated.
+  if (op == OP_NOT && b_op == OP_JUMP_IF_FALSE && !p->is_target[b] && op_at(p, b + 2) == OP_POP &&
+      op_at(p, p->targets[b]) == OP_POP) {
+    code[offset]         = OP_JUMP_IF_TRUE;
+    p->targets[offset]   = p->targets[b];
+    p->targets[b]        = -1;
+    remove_units(p, b + 1, 1);
+    *changed = true;
+    return b + 2;
+  }
+
+  // [set_local a][pop][push][set_local a] -> [pop][push][set_local a], if the push does not read a. Nothing in between can
+  // throw or call anything, so the first store can't be observed.
+  if (op == OP_SET_LOCAL && b_op == OP_POP) {
+    int c            = next_of(p, b);
+    int c_op         = op_at(p, c);
+    bool reads_local = c_op == OP_GET_LOCAL && code[c + 1] == code[offset + 1];
+    bool is_constant = c_op == OP_CONSTANT || c_op == OP_NIL || c_op == OP_TRUE || c_op == OP_FALSE;
+    if (is_constant || (c_op == OP_GET_LOCAL && !reads_local)) {
+      int d = next_of(p, c);
+      if (op_at(p, d) == OP_SET_LOCAL && code[d + 1] == code[offset + 1]) {
+        remove_units(p, offset, b - offset);
+        *changed = true;
+      }
+    }
+  }
+
+  return b;
+}
+
+// Cuts the removed code units out of the chunk. Moves the source views, try ranges and inlined ranges along with the
+// instructions and recomputes the offsets of all branches.
+static void compact(Peephole* p) {
+  Chunk* chunk = p->chunk;
+  int* map     = malloc(sizeof(int) * (size_t)(chunk->count + 1));  // New offset of each code unit, or of the next one kept.
+
+  int count = 0;
+  for (int i = 0; i < chunk->count; i++) {
+    map[i] = count;
+    count += p->removed[i] ? 0 : 1;
+  }
+  map[chunk->count] = count;
+
+  for (int offset = skip_removed(p, 0); offset < chunk->count; offset = skip_removed(p, next_of(p, offset))) {
+    int target = p->targets[offset];
+    if (target < 0) {
+      continue;
+    }
+
+    OpCode op = (OpCode)chunk->code[offset];
+    int next  = map[offset] + chunk_instruction_length(chunk, offset);
+    if (op == OP_LOOP) {
+      chunk->code[offset + 1] = (uint16_t)(next - map[target]);
+    } else {
+      chunk->code[offset + chunk_jump_operand(op)] = (uint16_t)(map[target] - next);
+    }
+  }
+
+  for (int i = 0; i < chunk->count; i++) {
+    if (!p->removed[i]) {
+      chunk->code[map[i]]         = chunk->code[i];
+      chunk->source_views[map[i]] = chunk->source_views[i];
+    }
+  }
+
+  for (int i = 0; i < chunk->try_count; i++) {
+    TryRange* range = &chunk->tries[i];
+    range->start    = map[range->start];
+    range->end      = map[range->end];
+    range->handler  = map[range->handler];
+  }
+  for (int i = 0; i < chunk->inlined_count; i++) {
+    InlinedRange* range = &chunk->inlined[i];
+    range->start        = map[range->start];
+    range->end          = map[range->end];
+    range->site         = map[range->site];
+  }
+
+  chunk->count = count;
+  free(map);
+}
+
+void peephole_optimize(Chunk* chunk) {
+  Peephole p = {
+      .chunk     = chunk,
+      .targets   = malloc(sizeof(int) * (size_t)(chunk->count + 1)),
+      .is_target = malloc(sizeof(bool) * (size_t)(chunk->count + 1)),
+      .removed   = malloc(sizeof(bool) * (size_t)(chunk->count + 1)),
+  };
+
+  for (int pass = 0; pass < PEEPHOLE_MAX_PASSES; pass++) {
+    for (int i = 0; i <= chunk->count; i++) {
+      p.removed[i] = false;
+    }
+    record_targets(&p);
+
+    bool changed = false;
+    for (int offset = 0; offset < chunk->count;) {
+      offset = rewrite(&p, offset, &changed);
+    }
+    if (!changed) {
+      break;
+    }
+    compact(&p);
+  }
+
+  free(p.targets);
+  free(p.is_target);
+  free(p.removed);
+}
+
+void peephole_cut(Chunk* chunk, bool* removed) {
+  Peephole p = {
+      .chunk     = chunk,
+      .targets   = malloc(sizeof(int) * (size_t)(chunk->count + 1)),
+      .is_target = malloc(sizeof(bool) * (size_t)(chunk->count + 1)),
+      .removed   = removed,
+  };
+
+  record_targets(&p);
+  compact(&p);
+
+  free(p.targets);
+  free(p.is_target);
+}
+
+#undef PEEPHOLE_MAX_PASSES
@@ -0,0 +1,18 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include <stdbool.h>
+#include "chunk.h"
+
+// Optimizes the bytecode of a finished [chunk] in place: Threads jumps through chains of jumps, removes values which are pushed
+// and popped right away, fuses OP_NOT + OP_JUMP_IF_FALSE and OP_NIL + OP_RETURN, and removes stores to locals which are
+// overwritten right away. Removed instructions are cut out of the chunk, the source views, try ranges and inlined ranges move
+// along with the instructions. Must only be called on a chunk which was compiled without errors.
+void peephole_optimize(Chunk* chunk);
+
+// Cuts the code units marked in [removed] (one entry per code unit) out of [chunk] - in the same way the peephole optimizer
+// removes instructions. Only whole instructions, or operands of an instruction whose length shrunk, may be marked. Branches must
+// be kept, their targets are moved along with the instructions they jump to.
+void peephole_cut(Chunk* chunk, bool* removed);
+
+#endif  // PEEPHOLE_H
@@ -1,12 +1,15 @@
 #include "resolver.h"
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "ast.h"
 #include "chunk.h"
 #include "file.h"
+#include "memory.h"
 #include "object.h"
+#include "optimizer.h"
 #include "scanner.h"
 #include "scope.h"
 #include "vm.h"
@@ -18,6 +21,11 @@ static Scope* new_scope(FnResolver* resolver);
 static void end_scope(FnResolver* resolver);
 void resolve_children(FnResolver* resolver, AstNode* node);
 static void resolve_node(FnResolver* resolver, AstNode* node);
+static void resolve_top_expr(FnResolver* resolver, AstNode* node);
+static AstFn* inlineable_callee(AstExpression* expr);
+static void register_method(AstFn* fn);
+static void resolve_invoke_args(FnResolver* resolver, AstExpression* expr);
+static void resolve_inlined_call(FnResolver* resolver, AstExpression* expr, AstFn* callee);
 
 static void resolver_init(FnResolver* resolver, FnResolver* enclosing, AstFn* fn) {
   resolver->enclosing = enclosing;
@@ -374,7 +382,7 @@ static void resolve_variable(FnResolver* resolver, AstId* var) {
 
   // ...or in the globals table
   Value discard;
-  if (hashtable_get_by_string(resolver->global_scope, var->name, &discard)) {
+  if (object_get_field_by_string(resolver->global_scope, var->name, &discard)) {
     if (!scope_add_new(resolver->root_scope, var->name, (AstNode*)var, SYMBOL_GLOBAL, SYMSTATE_USED, false, false /* is param */,
                        &global)) {
       INTERNAL_ERROR("External global should not be redeclared.");
@@ -552,6 +560,10 @@ static void resolve_function(FnResolver* resolver, AstFn* fn) {
   // Body / expression
   resolve_node(&subresolver, fn->base.children[2]);
   end_resolver(&subresolver);
+
+  if (fn->type == FN_TYPE_METHOD) {
+    register_method(fn);
+  }
 }
 
 //
@@ -607,7 +619,7 @@ static void resolve_declare_variable(FnResolver* resolver, AstDeclaration* decl)
   // Resolve initializer if present
   AstNode* initializer = decl->base.children[1];
   if (initializer != NULL) {
-    resolve_node(resolver, initializer);
+    resolve_top_expr(resolver, initializer);
   }
 
   // Define the variable
@@ -627,7 +639,7 @@ static void resolve_declare_variable(FnResolver* resolver, AstDeclaration* decl)
 static void resolve_statement_import(FnResolver* resolver, AstStatement* stmt) {
   // Calculate the absolute path of the module to import
   Value cwd_value;
-  if (!hashtable_get_by_string(resolver->global_scope, vm.special_prop_names[SPECIAL_PROP_FILE_PATH], &cwd_value)) {
+  if (!object_get_field_by_string(resolver->global_scope, vm.special_prop_names[SPECIAL_PROP_FILE_PATH], &cwd_value)) {
     resolver_error(resolver, (AstNode*)stmt, "Could not resolve current working directory.");
   }
   const char* cwd = AS_CSTRING(cwd_value);
@@ -711,19 +723,62 @@ static void resolve_statement_for(FnResolver* resolver, AstStatement* stmt) {
   resolver->current_loop_fn_locals = enclosing_loop_fn_locals;
 }
 
+static void resolve_statement_for_in(FnResolver* resolver, AstStatement* stmt) {
+  AstDeclaration* vars = (AstDeclaration*)stmt->base.children[0];
+  AstNode* iterable    = stmt->base.children[1];
+  AstNode* range_end   = stmt->base.children[2];
+  AstNode* body        = stmt->base.children[3];
+
+  stmt->base.scope = new_scope(resolver);
+
+  // The state of the loop lives in hidden locals, see compile_statement_for_in.
+  resolve_node(resolver, iterable);
+  if (range_end != NULL) {
+    inject_local(resolver, "$next", false);
+    resolve_node(resolver, range_end);
+    inject_local(resolver, "$end", true);
+  } else {
+    inject_local(resolver, "$iterable", true);
+    inject_local(resolver, "$index", false);
+  }
+
+  AstStatement* enclosing_loop     = resolver->current_loop;
+  resolver->current_loop           = stmt;
+  int enclosing_loop_fn_locals     = resolver->current_loop_fn_locals;
+  resolver->current_loop_fn_locals = resolver->function->local_count;
+
+  // The loop variables live in a scope of their own, which ends with each iteration. This gives closures in the body a fresh
+  // variable per iteration.
+  vars->base.scope = new_scope(resolver);
+  for (int i = 0; i < vars->base.count; i++) {
+    AstId* id   = get_child_as_id((AstNode*)vars, i, false);
+    Symbol* sym = add_local(resolver, NULL, id, SYMSTATE_INITIALIZED, false, false /* is param */);
+    if (sym != NULL) {
+      id->ref = make_ref(sym);
+    }
+  }
+
+  resolve_node(resolver, body);
+  end_scope(resolver);
+  end_scope(resolver);
+
+  resolver->current_loop           = enclosing_loop;
+  resolver->current_loop_fn_locals = enclosing_loop_fn_locals;
+}
+
 static void resolve_statement_return(FnResolver* resolver, AstStatement* stmt) {
   if (resolver->function->type == FN_TYPE_CONSTRUCTOR && stmt->base.children[0] != NULL) {
     resolver_error(resolver, (AstNode*)stmt, "Can't return a value from a constructor.");
   }
-  resolve_children(resolver, (AstNode*)stmt);
+  resolve_top_expr(resolver, stmt->base.children[0]);
 }
 
 static void resolve_statement_print(FnResolver* resolver, AstStatement* stmt) {
-  resolve_children(resolver, (AstNode*)stmt);
+  resolve_top_expr(resolver, stmt->base.children[0]);
 }
 
 static void resolve_statement_expr(FnResolver* resolver, AstStatement* stmt) {
-  resolve_children(resolver, (AstNode*)stmt);
+  resolve_top_expr(resolver, stmt->base.children[0]);
 }
 
 static void resolve_statement_break(FnResolver* resolver, AstStatement* stmt) {
@@ -746,10 +801,29 @@ static void resolve_statement_throw(FnResolver* resolver, AstStatement* stmt) {
   resolve_children(resolver, (AstNode*)stmt);
 }
 
+// The error is only pushed once the catch block is entered - at which point everything the try block left on the stack has been
+// discarded. That's why it's injected after the try block has been resolved, so it occupies the slot the try block started at.
 static void resolve_statement_try(FnResolver* resolver, AstStatement* stmt) {
-  stmt->base.scope = new_scope(resolver);
-  inject_local(resolver, KEYWORD_ERROR, false);
-  resolve_children(resolver, (AstNode*)stmt);
+  AstNode* try_stmt = stmt->base.children[0];
+  stmt->base.scope  = new_scope(resolver);
+
+  // An import declares its variables in the current scope. Give it a scope of its own, so they are gone before the error is.
+  if (try_stmt->type == NODE_STMT && ((AstStatement*)try_stmt)->type == STMT_IMPORT) {
+    try_stmt->scope = new_scope(resolver);
+    resolve_node(resolver, try_stmt);
+    end_scope(resolver);
+  } else {
+    resolve_node(resolver, try_stmt);
+  }
+
+  // The error is injected as initialized, so we can tell whether the catch block reads it.
+  Symbol* error = inject_local(resolver, KEYWORD_ERROR, false);
+  error->state  = SYMSTATE_INITIALIZED;
+  if (stmt->base.children[1] != NULL) {
+    resolve_node(resolver, stmt->base.children[1]);  // Catch block
+  }
+  stmt->uses_error = error->state == SYMSTATE_USED;
+  error->state     = SYMSTATE_USED;  // Don't warn about an unused error
   end_scope(resolver);
 }
 
@@ -805,6 +879,10 @@ static void resolve_expr_or(FnResolver* resolver, AstExpression* expr) {
   resolve_children(resolver, (AstNode*)expr);
 }
 
+static void resolve_expr_coalesce(FnResolver* resolver, AstExpression* expr) {
+  resolve_children(resolver, (AstNode*)expr);
+}
+
 static void resolve_expr_is(FnResolver* resolver, AstExpression* expr) {
   resolve_children(resolver, (AstNode*)expr);
 }
@@ -814,7 +892,16 @@ static void resolve_expr_in(FnResolver* resolver, AstExpression* expr) {
 }
 
 static void resolve_expr_call(FnResolver* resolver, AstExpression* expr) {
-  resolve_children(resolver, (AstNode*)expr);
+  resolve_node(resolver, expr->base.children[0]);  // Callee
+  AstFn* callee = inlineable_callee(expr);
+  if (callee != NULL) {
+    resolve_inlined_call(resolver, expr, callee);
+    return;
+  }
+
+  for (int i = 1; i < expr->base.count; i++) {
+    resolve_node(resolver, expr->base.children[i]);  // Arguments
+  }
 }
 
 static void resolve_expr_dot(FnResolver* resolver, AstExpression* expr) {
@@ -827,10 +914,7 @@ static void resolve_expr_invoke(FnResolver* resolver, AstExpression* expr) {
   // Only resolve the target and arguments, not the method id - we don't know if that method exists at compile time. (yet)
   AstExpression* target = (AstExpression*)expr->base.children[0];
   resolve_node(resolver, (AstNode*)target);
-  // Skip the method id, resolve the arguments
-  for (int i = 2; i < expr->base.count; i++) {
-    resolve_node(resolver, expr->base.children[i]);
-  }
+  resolve_invoke_args(resolver, expr);
 }
 
 static void resolve_expr_subs(FnResolver* resolver, AstExpression* expr) {
@@ -873,22 +957,397 @@ static void resolve_expr_ternary(FnResolver* resolver, AstExpression* expr) {
   resolve_children(resolver, (AstNode*)expr);
 }
 
+// Counts the values the enclosing expressions of [expr] have already pushed onto the stack when [expr] is evaluated. These are
+// not locals, so they're unknown to the resolver - but they're still there when an error is thrown.
+static int count_temporaries(AstNode* expr) {
+  int count = 0;
+  for (AstNode* child = expr; child->parent != NULL; child = child->parent) {
+    AstNode* parent = child->parent;
+    if ((parent->type != NODE_EXPR && parent->type != NODE_LIT) || parent->scope != NULL) {
+      break;  // Statements and scoped expressions start with an empty stack, apart from their locals.
+    }
+
+    int index = 0;
+    while (parent->children[index] != child) {
+      index++;
+    }
+
+    if (parent->type == NODE_LIT) {
+      count += index;  // Elements, or keys and values of an object literal
+      continue;
+    }
+
+    AstExpression* parent_expr = (AstExpression*)parent;
+    switch (parent_expr->type) {
+      case EXPR_AND:
+      case EXPR_OR:
+      case EXPR_COALESCE:
+      case EXPR_TERNARY: break;  // The condition is popped before the branches are evaluated.
+      case EXPR_INVOKE: count += index > 1 ? index - 1 : 0; break;  // The method name is not pushed.
+      case EXPR_ASSIGN: {
+        if (index == 0) {
+          break;  // The target's receiver and index are evaluated as usual.
+        }
+        AstExpression* target = (AstExpression*)parent->children[0];
+        int receiver          = target->type == EXPR_DOT ? 1 : target->type == EXPR_SUBS ? 2 : 0;
+        bool compound         = parent_expr->operator_.type != TOKEN_ASSIGN;
+        count += receiver + (compound ? 1 : 0);  // Compound assignments load the current value first.
+        break;
+      }
+      default: count += index; break;
+    }
+  }
+
+  return count;
+}
+
+// Like the error of a try statement, the error of a try expression is only pushed once the catch expression is entered. The
+// result of the expression ends up in the slot the try expression started at, which is why we reserve that one for the result
+// and inject the error on top of it. The values of the enclosing expressions are reserved as well, so that the slots of the
+// result and the error match the stack layout at runtime.
 static void resolve_expr_try(FnResolver* resolver, AstExpression* expr) {
   expr->base.scope = new_scope(resolver);
-  inject_local(resolver, KEYWORD_ERROR, false);
 
   AstId* error        = get_child_as_id((AstNode*)expr, 0, false);
   AstNode* try_expr   = expr->base.children[1];
   AstNode* catch_expr = expr->base.children[2];
 
-  resolve_variable(resolver, error);
+  int temporaries = count_temporaries((AstNode*)expr);
+  for (int i = 0; i < temporaries; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "$temp%d", i);
+    inject_local(resolver, name, true);
+  }
+
   resolve_node(resolver, try_expr);
+  inject_local(resolver, "$result", false);
+  Symbol* error_sym = inject_local(resolver, KEYWORD_ERROR, false);
+  error_sym->state  = SYMSTATE_INITIALIZED;  // See resolve_statement_try
   if (catch_expr != NULL) {
     resolve_node(resolver, catch_expr);
   }
+  expr->uses_error = error_sym->state == SYMSTATE_USED;
+  error_sym->state = SYMSTATE_USED;
+  resolve_variable(resolver, error);
   end_scope(resolver);
 }
 
+//
+// Inlining of small functions
+//
+
+#define INLINE_MAX_NODES 16  // Maximum number of nodes in the returned expression of a function which is inlined.
+
+// Methods of the classes which have been resolved so far, in the order they were resolved. See inlineable_method.
+static AstFn** resolved_methods    = NULL;
+static int resolved_method_count    = 0;
+static int resolved_method_capacity = 0;
+
+// Checks whether [node], which is part of the returned expression of a function, can be compiled into the frame of a caller.
+// That's not the case for anything which has locals of its own (nested functions, try expressions or inlined calls), because the
+// parameters must be the only locals it refers to. [size] counts the nodes visited so far.
+static bool is_inlineable_expr(AstNode* node, int* size) {
+  if (node == NULL) {
+    return true;
+  }
+  if (node->type == NODE_FN || node->scope != NULL || ++(*size) > INLINE_MAX_NODES) {
+    return false;
+  }
+
+  for (int i = 0; i < node->count; i++) {
+    if (!is_inlineable_expr(node->children[i], size)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Checks whether the call [expr] with [argc] arguments can be compiled into the returned expression of [fn]. [fn] must not
+// capture anything and consist of nothing but a small returned expression (see is_inlineable_expr). It must be fully resolved
+// already, which also rules out recursion: That's the case if it has been declared before the call, and the call is not within
+// [fn] itself.
+static bool is_inlineable_fn(AstFn* fn, AstExpression* expr, int argc) {
+  AstDeclaration* params = (AstDeclaration*)fn->base.children[1];
+  int arity              = params == NULL ? 0 : params->base.count;
+  if (fn->upvalue_count > 0 || arity != argc) {
+    return false;
+  }
+
+  for (AstNode* node = (AstNode*)expr; node != NULL; node = node->parent) {
+    if (node == (AstNode*)fn) {
+      return false;
+    }
+  }
+
+  int size      = 0;
+  AstNode* body = ast_returned_expr(fn);
+  return body != NULL && is_inlineable_expr(body, &size);
+}
+
+// Returns the function [expr] calls, if the call can be compiled into the function's returned expression - or NULL if it can't.
+// The callee must be a named function of this module, see is_inlineable_fn.
+static AstFn* inlineable_callee(AstExpression* expr) {
+  AstExpression* target = (AstExpression*)expr->base.children[0];
+  if (target->type != EXPR_VARIABLE) {
+    return NULL;
+  }
+
+  AstId* id = (AstId*)target->base.children[0];
+  if (id->ref == NULL || (id->ref->symbol->type != SYMBOL_LOCAL && id->ref->symbol->type != SYMBOL_GLOBAL)) {
+    return NULL;
+  }
+
+  AstNode* source = id->ref->symbol->source;
+  if (source == NULL || source->parent == NULL || source->parent->type != NODE_FN) {
+    return NULL;
+  }
+
+  AstFn* fn = (AstFn*)source->parent;
+  if (fn->type != FN_TYPE_NAMED_FUNCTION || fn->base.children[0] != source) {
+    return NULL;
+  }
+
+  return is_inlineable_fn(fn, expr, expr->base.count - 1) ? fn : NULL;
+}
+
+// Remembers a method which has been resolved, so invocations of it can be inlined. See inlineable_method.
+static void register_method(AstFn* fn) {
+  if (SHOULD_GROW(resolved_method_count + 1, resolved_method_capacity)) {
+    resolved_method_capacity = GROW_CAPACITY(resolved_method_capacity);
+    resolved_methods         = realloc(resolved_methods, sizeof(AstFn*) * resolved_method_capacity);
+  }
+  resolved_methods[resolved_method_count++] = fn;
+}
+
+// Returns the method the invocation [expr] is inlined with, or NULL if it can't be inlined. The receiver's class is not known
+// statically, so this is the method of that name - if only one of the classes resolved so far has one, and it's inlineable (see
+// is_inlineable_fn). Whether the receiver's class actually uses it is checked at runtime.
+static AstFn* inlineable_method(AstExpression* expr) {
+  if (((AstExpression*)expr->base.children[0])->type == EXPR_BASE) {
+    return NULL;  // Invoked on the base class, see OP_BASE_INVOKE.
+  }
+
+  ObjString* name = ((AstId*)expr->base.children[1])->name;
+  AstFn* method   = NULL;
+  for (int i = 0; i < resolved_method_count; i++) {
+    if (((AstId*)resolved_methods[i]->base.children[0])->name != name) {
+      continue;
+    }
+    if (method != NULL) {
+      return NULL;  // Defined by several classes, it's likely to be invoked on receivers of different classes.
+    }
+    method = resolved_methods[i];
+  }
+
+  return method != NULL && is_inlineable_fn(method, expr, expr->base.count - 2) ? method : NULL;
+}
+
+// Resolves the arguments of an invocation, after its receiver has been resolved. Inlines the invocation if possible, see
+// inlineable_method.
+static void resolve_invoke_args(FnResolver* resolver, AstExpression* expr) {
+  AstFn* method = expr->type == EXPR_INVOKE ? inlineable_method(expr) : NULL;
+  if (method != NULL) {
+    resolve_inlined_call(resolver, expr, method);
+    return;
+  }
+
+  for (int i = 2; i < expr->base.count; i++) {
+    resolve_node(resolver, expr->base.children[i]);
+  }
+}
+
+// Resolves a call or invocation which is compiled into the returned expression of [callee] (see inlineable_callee and
+// inlineable_method), guarded by a check that the callee still is that function at runtime. The callee - or the receiver - and
+// the arguments are pushed just like for a regular call, but they're reserved as locals of the call: They form the frame of the
+// inlined function, in which its parameters are the arguments - and `this` is the receiver. The values of the enclosing
+// expressions are reserved as well, like for a try expression. See compile_inlined_call.
+static void resolve_inlined_call(FnResolver* resolver, AstExpression* expr, AstFn* callee) {
+  expr->inlined    = callee;
+  expr->base.scope = new_scope(resolver);
+
+  int temporaries = count_temporaries((AstNode*)expr);
+  for (int i = 0; i < temporaries; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "$temp%d", i);
+    inject_local(resolver, name, true);
+  }
+
+  int first_arg = expr->type == EXPR_INVOKE ? 2 : 1;  // Skip the method name of an invocation
+  inject_local(resolver, expr->type == EXPR_INVOKE ? "$receiver" : "$callee", true);
+  for (int i = first_arg; i < expr->base.count; i++) {
+    resolve_node(resolver, expr->base.children[i]);
+
+    char name[16];
+    snprintf(name, sizeof(name), "$arg%d", i - first_arg);
+    inject_local(resolver, name, true);
+  }
+
+  end_scope(resolver);
+}
+
+//
+// Lowering of higher-order Seq methods
+//
+
+// Checks whether [node], which is part of the body of a function literal, can be compiled inline - into the frame of the
+// enclosing function. That's not the case for control flow which leaves the function (returns, except for the trailing one) or
+// targets a loop outside of it (break, skip).
+static bool is_inlineable(AstNode* node, AstStatement* trailing, int loop_depth) {
+  if (node == NULL || node->type == NODE_FN) {
+    return true;  // Nested functions have their own frame.
+  }
+
+  if (node->type == NODE_STMT) {
+    AstStatement* stmt = (AstStatement*)node;
+    switch (stmt->type) {
+      case STMT_RETURN: return stmt == trailing && is_inlineable(node->children[0], NULL, loop_depth);
+      case STMT_BREAK:
+      case STMT_SKIP: return loop_depth > 0;
+      case STMT_WHILE:
+      case STMT_FOR:
+      case STMT_FOR_IN: loop_depth++; break;
+      default: break;
+    }
+  }
+
+  for (int i = 0; i < node->count; i++) {
+    if (!is_inlineable(node->children[i], trailing, loop_depth)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Checks whether [expr] is a call of a higher-order Seq or Tuple method with a function literal, which can be lowered into a loop.
+// The function literal must take an argument count which the method accepts, otherwise we leave it to the native to complain.
+static bool can_lower_seq_loop(AstExpression* expr, SeqLoopKind* kind) {
+  if (expr->type != EXPR_INVOKE || ((AstExpression*)expr->base.children[0])->type == EXPR_BASE ||
+      !ast_seq_loop_kind((AstId*)expr->base.children[1], kind)) {
+    return false;
+  }
+
+  int argc = expr->base.count - 2;
+  if (argc != (*kind == SEQ_LOOP_FOLD ? 2 : 1)) {
+    return false;
+  }
+
+  AstExpression* literal = (AstExpression*)expr->base.children[expr->base.count - 1];
+  if (literal->base.type != NODE_EXPR || literal->type != EXPR_ANONYMOUS_FN) {
+    return false;
+  }
+
+  AstFn* fn              = (AstFn*)literal->base.children[0];
+  AstDeclaration* params = (AstDeclaration*)fn->base.children[1];
+  int arity              = params == NULL ? 0 : params->base.count;
+  switch (*kind) {
+    case SEQ_LOOP_EACH:
+    case SEQ_LOOP_MAP:
+      if (arity > 2) {
+        return false;
+      }
+      break;
+    case SEQ_LOOP_SIFT:
+    case SEQ_LOOP_EVERY:
+    case SEQ_LOOP_SOME:
+      if (arity < 1 || arity > 2) {
+        return false;
+      }
+      break;
+    case SEQ_LOOP_FOLD:
+      if (arity < 2 || arity > 3) {
+        return false;
+      }
+      break;
+  }
+
+  AstNode* body = fn->base.children[2];
+  return is_inlineable(body, ast_trailing_return(body), 0);
+}
+
+// Resolves a call of a higher-order Seq or Tuple method with a function literal, which is lowered into a loop. Next to the
+// function literal, which is used if the receiver turns out to be something else at runtime, a copy of its body is resolved as
+// if it was written inline: In a scope of its own, nested in a scope which holds the state of the loop. See compile_seq_loop.
+static void resolve_seq_loop(FnResolver* resolver, AstExpression* expr, SeqLoopKind kind) {
+  AstNode* literal = expr->base.children[expr->base.count - 1];
+  AstFn* inlined   = (AstFn*)ast_clone(literal->children[0]);
+
+  resolve_top_expr(resolver, expr->base.children[0]);  // Receiver
+
+  expr->base.scope = new_scope(resolver);
+  inject_local(resolver, "$receiver", true);
+  if (kind == SEQ_LOOP_FOLD) {
+    resolve_node(resolver, expr->base.children[2]);  // Initial value, which becomes the accumulator
+  }
+  inject_local(resolver, "$acc", false);
+  inject_local(resolver, "$count", true);
+  inject_local(resolver, "$index", false);
+
+  resolve_node(resolver, literal);
+  if (resolver->had_error) {
+    ast_free((AstNode*)inlined);  // Errors have been reported for the function literal, no need to report them again.
+    end_scope(resolver);
+    return;
+  }
+
+  // Warnings have been reported for the function literal as well
+  bool disable_warnings      = resolver->disable_warnings;
+  resolver->disable_warnings = true;
+  inlined->base.scope        = new_scope(resolver);
+
+  AstDeclaration* params = (AstDeclaration*)inlined->base.children[1];
+  if (params != NULL) {
+    for (int i = 0; i < params->base.count; i++) {
+      AstId* id = get_child_as_id((AstNode*)params, i, false);
+      add_parameter(resolver, id);
+    }
+  }
+
+  // Body / expression. A trailing return just provides the result, which is why it's not resolved as a statement.
+  AstNode* body = inlined->base.children[2];
+  if (inlined->is_lambda) {
+    resolve_node(resolver, body);
+  } else {
+    AstStatement* trailing = ast_trailing_return(body);
+    for (int i = 0; i < body->count; i++) {
+      if (body->children[i] != (AstNode*)trailing) {
+        resolve_node(resolver, body->children[i]);
+      }
+    }
+    if (trailing != NULL && trailing->base.children[0] != NULL) {
+      resolve_node(resolver, trailing->base.children[0]);
+    }
+  }
+
+  end_scope(resolver);
+  resolver->disable_warnings = disable_warnings;
+  ast_node_add_child(literal, (AstNode*)inlined);  // See compile_seq_loop
+
+  end_scope(resolver);
+}
+
+// Resolves an expression which is evaluated right on top of the locals of the function, with no temporaries below it on the
+// stack: The expression of an expression, print or return statement, the initializer of a variable and the receiver of a method
+// call or property access in such a position. Only there, locals which are declared while evaluating the expression end up in
+// the stack slots the resolver assigns them, which is what lowering a Seq method call into a loop relies on.
+static void resolve_top_expr(FnResolver* resolver, AstNode* node) {
+  if (node == NULL) {
+    return;
+  }
+
+  AstExpression* expr = (AstExpression*)node;
+  SeqLoopKind kind;
+  if (node->type != NODE_EXPR) {
+    resolve_node(resolver, node);
+  } else if (can_lower_seq_loop(expr, &kind)) {
+    resolve_seq_loop(resolver, expr, kind);
+  } else if (expr->type == EXPR_INVOKE || expr->type == EXPR_DOT) {
+    resolve_top_expr(resolver, expr->base.children[0]);  // Receiver
+    resolve_invoke_args(resolver, expr);                 // Arguments, if it's an invocation
+  } else {
+    resolve_node(resolver, node);
+  }
+}
+
 static void resolve_lit_number(FnResolver* resolver, AstLiteral* lit) {
   UNUSED(resolver);
   UNUSED(lit);
@@ -947,6 +1406,7 @@ static void resolve_node(FnResolver* resolver, AstNode* node) {
         case STMT_IF: resolve_statement_if(resolver, stmt); break;
         case STMT_WHILE: resolve_statement_while(resolver, stmt); break;
         case STMT_FOR: resolve_statement_for(resolver, stmt); break;
+        case STMT_FOR_IN: resolve_statement_for_in(resolver, stmt); break;
         case STMT_RETURN: resolve_statement_return(resolver, stmt); break;
         case STMT_PRINT: resolve_statement_print(resolver, stmt); break;
         case STMT_EXPR: resolve_statement_expr(resolver, stmt); break;
@@ -970,6 +1430,7 @@ static void resolve_node(FnResolver* resolver, AstNode* node) {
         case EXPR_ASSIGN: resolve_expr_assign(resolver, expr); break;
         case EXPR_AND: resolve_expr_and(resolver, expr); break;
         case EXPR_OR: resolve_expr_or(resolver, expr); break;
+        case EXPR_COALESCE: resolve_expr_coalesce(resolver, expr); break;
         case EXPR_IS: resolve_expr_is(resolver, expr); break;
         case EXPR_IN: resolve_expr_in(resolver, expr); break;
         case EXPR_CALL: resolve_expr_call(resolver, expr); break;
@@ -1032,8 +1493,9 @@ void verify_late_bound(FnResolver* resolver) {
   }
 }
 
-bool resolve(AstFn* ast, HashTable* global_scope, HashTable* native_scope, bool disable_warnings) {
-  resolver_root = ast;
+bool resolve(AstFn* ast, ObjObject* global_scope, HashTable* native_scope, bool disable_warnings) {
+  resolver_root         = ast;
+  resolved_method_count = 0;
 
   FnResolver resolver;
   resolver_init(&resolver, NULL, ast);
@@ -1050,6 +1512,9 @@ bool resolve(AstFn* ast, HashTable* global_scope, HashTable* native_scope, bool
   end_resolver(&resolver);
 
   verify_late_bound(&resolver);
+  if (!resolver.had_error) {
+    optimize(ast);  // While the AST is still rooted, folding strings allocates.
+  }
 
 #ifdef DEBUG_PRINT_SCOPES
   printf("\n\n\n === RESOLVE ===\n\n");
@@ -1057,6 +1522,10 @@ bool resolve(AstFn* ast, HashTable* global_scope, HashTable* native_scope, bool
 #endif
 
   resolver_root = NULL;
+  free(resolved_methods);
+  resolved_methods         = NULL;
+  resolved_method_count    = 0;
+  resolved_method_capacity = 0;
   return !resolver.had_error;
 }
 
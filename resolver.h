@@ -15,7 +15,7 @@ struct FnResolver {
   // Shared state
   bool disable_warnings;    // Disable warnings during compilation
   Scope* root_scope;        // Root scope of the AST, shared between all resolvers
-  HashTable* global_scope;  // Global scope of the VM, shared between all resolvers. For stuff that the VM adds, like module_name
+  ObjObject* global_scope;  // Module whose globals are resolved, shared between all resolvers. Contains e.g. the module_name
   HashTable* native_scope;  // Scope in which all the native functions are declared, shared between all resolvers
 
   // Loop state
@@ -31,7 +31,7 @@ struct FnResolver {
 };
 
 // Resolves a AST. Returns true if the AST is valid, false otherwise.
-bool resolve(AstFn* ast, HashTable* global_scope, HashTable* native_scope, bool disable_warnings);
+bool resolve(AstFn* ast, ObjObject* global_scope, HashTable* native_scope, bool disable_warnings);
 
 // Marks the roots of the resolver.
 void resolver_mark_roots();
@@ -24,6 +24,8 @@ export enum SlangDefines {
 export enum SlangRunFlags {
   StressGc = '--stress-gc',
   DisableWarnings = '--no-warn',
+  JitEager = '--jit --jit-threshold 1',
+  JitTracesOnly = '--jit --jit-threshold 2147483647 --jit-loop-threshold 1',
 }
 
 export enum SlangFileSuffixes {
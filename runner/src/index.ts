@@ -57,6 +57,8 @@ const hint = [
   '    - no-parallel   Run tests sequentially (default is parallel)',
   '    - no-build      Skip building the project (default is to build)',
   '    - no-stress     Run tests without stressing the GC (default is to stress GC)',
+  '    - jit           Run tests with the JIT enabled, compiling every function on its first call',
+  '    - trace         Run tests with just the tracing tier, recording every loop on its first iteration',
   '    - <pattern>     Run tests that match the regex pattern',
   '  - watch-sample    Watch sample file (sample.sl)',
   '  - watch-test      Watch test files',
@@ -122,6 +124,8 @@ switch (cmd) {
     const doNoParallel = Boolean(consumeOption('no-parallel', false));
     const doNoBuild = Boolean(consumeOption('no-build', false));
     const doNoStress = Boolean(consumeOption('no-stress', false));
+    const doJit = Boolean(consumeOption('jit', false));
+    const doTrace = Boolean(consumeOption('trace', false));
     const testNamePattern = options.pop() || '.*';
     validateOptions();
 
@@ -141,6 +145,11 @@ switch (cmd) {
     if (!doNoStress) {
       flags.push(SlangRunFlags.StressGc);
     }
+    if (doJit) {
+      flags.push(SlangRunFlags.JitEager);
+    } else if (doTrace) {
+      flags.push(SlangRunFlags.JitTracesOnly);
+    }
 
     await runTests(config, testFilepaths, flags, null, doUpdateFiles, !doNoParallel);
     break;
@@ -381,7 +381,7 @@ Token scanner_scan_token() {
     case ':': return make_token(TOKEN_COLON);
     case ';': return make_token(TOKEN_SCOLON);
     case ',': return make_token(TOKEN_COMMA);
-    case '?': return make_token(TOKEN_TERNARY);
+    case '?': return make_token(match('?') ? TOKEN_COALESCE : match('.') ? TOKEN_SAFE_DOT : TOKEN_TERNARY);
 
     case '+': return make_token(match('=') ? TOKEN_PLUS_ASSIGN : match('+') ? TOKEN_PLUS_PLUS : TOKEN_PLUS);
     case '-':
@@ -403,3 +403,10 @@ Token scanner_scan_token() {
 
   return error_token("Unexpected character.");
 }
+
+Token scanner_peek_token() {
+  Scanner saved = scanner;
+  Token token   = scanner_scan_token();
+  scanner       = saved;
+  return token;
+}
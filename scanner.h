@@ -40,6 +40,8 @@ typedef enum {
 
   TOKEN_PLUS_PLUS,    // '++'
   TOKEN_MINUS_MINUS,  // '--'
+  TOKEN_COALESCE,     // '??'
+  TOKEN_SAFE_DOT,     // '?.'
 
   TOKEN_DOT,        // '.'
   TOKEN_DOTDOT,     // '..'
@@ -113,6 +115,9 @@ void scanner_init(const char* source);
 // Scan and return the next token.
 Token scanner_scan_token();
 
+// Scan and return the next token without consuming it.
+Token scanner_peek_token();
+
 // Get the start of a line of a token, exclusive (points to the first character of the line).
 const char* scanner_get_line_start(Token token);
 
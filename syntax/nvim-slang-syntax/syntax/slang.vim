@@ -47,7 +47,7 @@ syntax match slangFunctionName "\<\w\+\>" contained
 syntax keyword slangStorageModifier static
 
 " Types
-syntax keyword slangType Obj Nil Bool Num Int Float Str Seq Tuple Fn Class
+syntax keyword slangType Obj Nil Bool Num Int Float Str Seq Tuple Iter Fn Class
 
 " Constants
 syntax keyword slangConstant nil true false
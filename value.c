@@ -128,19 +128,16 @@ int fprint_string_escaped(FILE* file, const char* str, int max_len, bool quote)
 
 int value_print_safe(FILE* file, Value value) {
   if (is_bool(value)) {
-    return fprintf(file, value.as.boolean ? VALUE_STR_TRUE : VALUE_STR_FALSE);
+    return fprintf(file, AS_BOOL(value) ? VALUE_STR_TRUE : VALUE_STR_FALSE);
   }
   if (is_nil(value)) {
     return fprintf(file, VALUE_STR_NIL);
   }
-  if (is_handler(value)) {
-    return fprintf(file, VALUE_STRFMT_HANDLER, value.as.handler);
-  }
   if (is_int(value)) {
-    return fprintf(file, VALUE_STR_INT, value.as.integer);
+    return fprintf(file, VALUE_STR_INT, AS_INT(value));
   }
   if (is_float(value)) {
-    return fprintf(file, VALUE_STR_FLOAT, value.as.float_);
+    return fprintf(file, VALUE_STR_FLOAT, AS_FLOAT(value));
   }
   if (is_empty_internal(value)) {
     return fprintf(file, VALUE_STR_EMPTY_INTERNAL);
@@ -215,17 +212,15 @@ int value_print_safe(FILE* file, Value value) {
 
     int written   = fprintf(file, VALUE_STR_OBJECT_START);
     int processed = 0;
-    for (int i = 0; i < object->fields.capacity; i++) {
-      if (is_empty_internal(object->fields.entries[i].key)) {
-        continue;
-      }
-      Entry* entry = &object->fields.entries[i];
-
-      written += value_print_safe(file, entry->key);
+    int index     = 0;
+    Value key;
+    Value field;
+    while (object_next_field(object, &index, &key, &field)) {
+      written += value_print_safe(file, key);
       written += fprintf(file, VALUE_STR_OBJECT_SEPARATOR);
-      written += value_print_safe(file, entry->value);
+      written += value_print_safe(file, field);
 
-      if (processed < object->fields.count - 1) {
+      if (processed < object_field_count(object) - 1) {
         written += fprintf(file, VALUE_STR_OBJECT_DELIM);
       }
       processed++;
@@ -235,45 +230,44 @@ int value_print_safe(FILE* file, Value value) {
   }
 
   // Everything else is an instance.
-  return fprintf(file, VALUE_STRFTM_INSTANCE, value.type->name->chars);
+  return fprintf(file, VALUE_STRFTM_INSTANCE, value_type(value)->name->chars);
 }
 
-int value_array_sort_compare_wrapper_native(Value a, Value b, Value cmp_fn) {
+int value_array_sort_compare_wrapper_native(Value a, Value b, struct VmCallback* cmp_fn) {
   UNUSED(cmp_fn);
   vm_push(a);
   vm_push(b);
-  Value result = vm_exec_callable(fn_value(a.type->__lt), 1);
+  Value result = vm_exec_callable(fn_value(value_type(a)->__lt), 1);
   if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
     return 0;
   }
 
   if (is_bool(result)) {
-    return result.as.boolean ? -1 : 1;
+    return AS_BOOL(result) ? -1 : 1;
   }
 
-  vm_error("Method \"%s." STR(SP_METHOD_LT) "\" must return a " STR(TYPENAME_BOOL) ". Got %s.", a.type->name->chars,
-           result.type->name->chars);
+  vm_error("Method \"%s." STR(SP_METHOD_LT) "\" must return a " STR(TYPENAME_BOOL) ". Got %s.", value_type(a)->name->chars,
+           value_type(result)->name->chars);
   return 0;
 }
 
-int value_array_sort_compare_wrapper_custom(Value a, Value b, Value cmp_fn) {
-  vm_push(cmp_fn);
-  vm_push(a);
-  vm_push(b);
-  Value result = vm_exec_callable(cmp_fn, 2);
+int value_array_sort_compare_wrapper_custom(Value a, Value b, struct VmCallback* cmp_fn) {
+  Value args[] = {a, b};
+  Value result = vm_callback_call(cmp_fn, args);
   if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
     return 0;
   }
 
   if (is_int(result)) {
-    return result.as.integer;
+    return AS_INT(result);
   }
 
-  vm_error("Comparison " STR(TYPENAME_FUNCTION) " must return an " STR(TYPENAME_INT) ". Got %s.", result.type->name->chars);
+  vm_error("Comparison " STR(TYPENAME_FUNCTION) " must return an " STR(TYPENAME_INT) ". Got %s.",
+           value_type(result)->name->chars);
   return 0;
 }
 
-void value_array_insertion_sort(ValueArray* array, SortCompareWrapperFn cmp_fn_wrapper, Value cmp_fn) {
+void value_array_insertion_sort(ValueArray* array, SortCompareWrapperFn cmp_fn_wrapper, struct VmCallback* cmp_fn) {
   for (int i = 1; i < array->count; i++) {
     Value current = array->values[i];
     int j         = i;
@@ -295,7 +289,11 @@ void value_array_insertion_sort(ValueArray* array, SortCompareWrapperFn cmp_fn_w
 }
 
 // Select pivot using median-of-three
-static int select_pivot_index(ValueArray* array, int low, int high, SortCompareWrapperFn cmp_fn_wrapper, Value cmp_fn) {
+static int select_pivot_index(ValueArray* array,
+                              int low,
+                              int high,
+                              SortCompareWrapperFn cmp_fn_wrapper,
+                              struct VmCallback* cmp_fn) {
   int mid = low + (high - low) / 2;
 
   // Sort low, mid, high elements
@@ -321,7 +319,7 @@ static int select_pivot_index(ValueArray* array, int low, int high, SortCompareW
 }
 
 // Partition array around pivot
-static int partition(ValueArray* array, int low, int high, SortCompareWrapperFn cmp_fn_wrapper, Value cmp_fn) {
+static int partition(ValueArray* array, int low, int high, SortCompareWrapperFn cmp_fn_wrapper, struct VmCallback* cmp_fn) {
   int pivot_idx = select_pivot_index(array, low, high, cmp_fn_wrapper, cmp_fn);
   Value pivot   = array->values[pivot_idx];
 
@@ -350,7 +348,7 @@ static int partition(ValueArray* array, int low, int high, SortCompareWrapperFn
   return store;
 }
 
-void value_array_quicksort(ValueArray* array, int low, int high, SortCompareWrapperFn cmp_fn_wrapper, Value cmp_fn) {
+void value_array_quicksort(ValueArray* array, int low, int high, SortCompareWrapperFn cmp_fn_wrapper, struct VmCallback* cmp_fn) {
   while (high - low > 50) {  // Use quicksort for larger segments
     int p = partition(array, low, high, cmp_fn_wrapper, cmp_fn);
 
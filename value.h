@@ -7,6 +7,8 @@
 #include <math.h>
 #include <float.h>
 #include <limits.h>
+#include <string.h>
+#include "common.h"
 
 typedef struct Obj Obj;
 typedef struct ObjString ObjString;
@@ -24,6 +26,7 @@ typedef struct ObjClass ObjClass;
 #define TYPENAME_NIL Nil
 #define TYPENAME_SEQ Seq
 #define TYPENAME_TUPLE Tuple
+#define TYPENAME_ITER Iter
 #define TYPENAME_BOUND_METHOD BoundMethod
 #define TYPENAME_CLASS Class
 #define TYPENAME_CLOSURE Fn
@@ -31,7 +34,6 @@ typedef struct ObjClass ObjClass;
 #define TYPENAME_INSTANCE Instance
 #define TYPENAME_NATIVE NativeFn
 #define TYPENAME_UPVALUE Upvalue
-#define TYPENAME_HANDLER $Handler$
 
 #define TYPENAME_MODULE Module
 
@@ -54,7 +56,6 @@ typedef struct ObjClass ObjClass;
 #define VALUE_STRFTM_INSTANCE_LEN (sizeof(VALUE_STRFTM_INSTANCE) - 2)
 #define VALUE_STRFMT_BOUND_METHOD "<BoundMethod %s>"
 #define VALUE_STRFMT_BOUND_METHOD_LEN (sizeof(VALUE_STRFMT_BOUND_METHOD) - 2)
-#define VALUE_STRFMT_HANDLER "<Try -> %hu>"  // The handler is a 16-bit unsigned integer
 #define VALUE_STRFMT_OBJ "<%s at %p>"
 #define VALUE_STRFMT_OBJ_LEN (sizeof(VALUE_STRFMT_OBJ) - 4)
 #define VALUE_STR_SEQ_START "["
@@ -68,6 +69,7 @@ typedef struct ObjClass ObjClass;
 #define VALUE_STR_OBJECT_SEPARATOR ": "
 #define VALUE_STR_OBJECT_DELIM ", "
 #define VALUE_STR_UPVALUE "<Upvalue>"
+#define VALUE_STR_ITER "<Iter>"
 
 // Switchover point for quicksort to insertion sort.
 #define VALUE_ARRAY_QUICKSORT_THRESHOLD 50
@@ -88,6 +90,62 @@ typedef struct ObjClass ObjClass;
 #define SLANG_INT_MAX LLONG_MAX
 #define SLANG_INT_MIN LLONG_MIN
 
+#ifdef SLANG_NAN_BOXING
+
+// The single value construct used to represent all values in the language. In this mode, a value is a NaN-boxed 64-bit word:
+// Every bit pattern which is not a quiet NaN with [VALUE_QNAN] set is a float. The remaining patterns encode the other types:
+// - Int:       [VALUE_SIGN_BIT] set, signed 50-bit payload (bits 0-49). Ints which don't fit are boxed on the heap, e.g. they are
+//              an Obj of type OBJ_GC_INT - see int_value in vm.h.
+// - Obj:       [VALUE_TAG_OBJ], 48-bit pointer payload.
+// - Singleton: [VALUE_TAG_SINGLETON], one of nil, false, true or the empty internal value.
+// The type (class) of a value is not stored, but derived on demand - see value_type in vm.h.
+typedef uint64_t Value;
+
+#define VALUE_SIGN_BIT ((uint64_t)0x8000000000000000)
+#define VALUE_QNAN ((uint64_t)0x7ffc000000000000)
+#define VALUE_CANONICAL_NAN ((uint64_t)0x7ff8000000000000)  // Any NaN float is stored as this (plus its sign).
+#define VALUE_TAG_MASK ((uint64_t)0x0003000000000000)
+#define VALUE_TAG_SINGLETON ((uint64_t)0x0000000000000000)
+#define VALUE_TAG_OBJ ((uint64_t)0x0002000000000000)
+#define VALUE_INT_MASK ((uint64_t)0x0003ffffffffffff)
+#define VALUE_INT_PAYLOAD_MAX ((1LL << 49) - 1)  // Largest int which is not boxed.
+#define VALUE_INT_PAYLOAD_MIN (-(1LL << 49))     // Smallest int which is not boxed.
+#define VALUE_PTR_MASK ((uint64_t)0x0000ffffffffffff)
+
+#define VALUE_EMPTY_INTERNAL (VALUE_QNAN | VALUE_TAG_SINGLETON | 0)
+#define VALUE_NIL (VALUE_QNAN | VALUE_TAG_SINGLETON | 1)
+#define VALUE_FALSE (VALUE_QNAN | VALUE_TAG_SINGLETON | 2)
+#define VALUE_TRUE (VALUE_QNAN | VALUE_TAG_SINGLETON | 3)
+
+#define VALUE_IS_FLOAT(value) (((value) & VALUE_QNAN) != VALUE_QNAN)
+#define VALUE_IS_INT(value) (((value) & (VALUE_SIGN_BIT | VALUE_QNAN)) == (VALUE_SIGN_BIT | VALUE_QNAN))
+#define VALUE_IS_TAGGED(value, tag) \
+  (((value) & (VALUE_SIGN_BIT | VALUE_QNAN | VALUE_TAG_MASK)) == (VALUE_QNAN | (tag)))
+
+static inline SLANG_TYPE_FLOAT value_as_float(Value value) {
+  SLANG_TYPE_FLOAT float_;
+  memcpy(&float_, &value, sizeof(Value));
+  return float_;
+}
+
+// Reads the value of an int which is boxed on the heap. See object.c.
+SLANG_TYPE_INT value_as_boxed_int(Value value);
+
+// Sign-extends the 50-bit payload of an int, or reads it from the heap if it's boxed.
+static inline SLANG_TYPE_INT value_as_int(Value value) {
+  if (VALUE_IS_INT(value)) {
+    return (SLANG_TYPE_INT)((int64_t)(value << 14) >> 14);
+  }
+  return value_as_boxed_int(value);
+}
+
+#define AS_INT(value) value_as_int(value)
+#define AS_FLOAT(value) value_as_float(value)
+#define AS_BOOL(value) ((value) == VALUE_TRUE)
+#define AS_OBJ(value) ((Obj*)(uintptr_t)((value) & VALUE_PTR_MASK))
+
+#else
+
 // The single value construct used to represent all values in the language.
 typedef struct {
   ObjClass* type;
@@ -95,11 +153,17 @@ typedef struct {
     bool boolean;
     SLANG_TYPE_FLOAT float_;
     SLANG_TYPE_INT integer;
-    uint16_t handler;
     Obj* obj;
   } as;
 } Value;
 
+#define AS_INT(value) ((value).as.integer)
+#define AS_FLOAT(value) ((value).as.float_)
+#define AS_BOOL(value) ((value).as.boolean)
+#define AS_OBJ(value) ((value).as.obj)
+
+#endif
+
 // Dynamic array of values.
 // See https://docs.oracle.com/javase/specs/jvms/se7/html/jvms-4.html#jvms-4.4
 typedef struct {
@@ -108,10 +172,12 @@ typedef struct {
   Value* values;
 } ValueArray;
 
-// Wrapper function for sorting comparison functions. Takes (Value a, Value b, Value cmp_fn) and returns an int.
+struct VmCallback;
+
+// Wrapper function for sorting comparison functions. Takes (Value a, Value b, VmCallback* cmp_fn) and returns an int.
 // [cmp_fn] is only used for custom comparison functions and ignored in the native wrapper.
 // Returns a negative value if a < b, a positive value if a > b, and 0 if a == b. Also returns 0 on error.
-typedef int (*SortCompareWrapperFn)(Value, Value, Value);
+typedef int (*SortCompareWrapperFn)(Value, Value, struct VmCallback*);
 
 // Initialize a value array.
 void value_array_init(ValueArray* array);
@@ -152,17 +218,17 @@ int value_print_safe(FILE* file, Value value);
 
 // Native sort fn wrapper. Compares two Values using the [a] types SP_METHOD_LT. [cmp_fn] is ignored, but required for the
 // function signature in sorting context. Returns -1 if a < b, and 1 if a >= b. Returns 0 on error and sets a VM error.
-int value_array_sort_compare_wrapper_native(Value a, Value b, Value cmp_fn);
+int value_array_sort_compare_wrapper_native(Value a, Value b, struct VmCallback* cmp_fn);
 
-// Custom sort fn wrapper. Compare two Values using a custom comparison function [cmp_fn]. The function must take two arguments
-// and return an TYPENAME_INT.
-int value_array_sort_compare_wrapper_custom(Value a, Value b, Value cmp_fn);
+// Custom sort fn wrapper. Compare two Values using a custom comparison function [cmp_fn], prepared via vm_callback_init. The
+// function must take two arguments and return an TYPENAME_INT.
+int value_array_sort_compare_wrapper_custom(Value a, Value b, struct VmCallback* cmp_fn);
 
 // In-place sorting of a value array using insertion sort. This is used for small arrays.
-void value_array_insertion_sort(ValueArray* array, SortCompareWrapperFn cmp_fn_wrapper, Value cmp_fn);
+void value_array_insertion_sort(ValueArray* array, SortCompareWrapperFn cmp_fn_wrapper, struct VmCallback* cmp_fn);
 
 // In-place sorting of a value array using quicksort. This is used for large arrays and will fall back to insertion sort for small
 // arrays. See VALUE_ARRAY_QUICKSORT_THRESHOLD.
-void value_array_quicksort(ValueArray* array, int low, int high, SortCompareWrapperFn cmp_fn_wrapper, Value cmp_fn);
+void value_array_quicksort(ValueArray* array, int low, int high, SortCompareWrapperFn cmp_fn_wrapper, struct VmCallback* cmp_fn);
 
 #endif
@@ -11,6 +11,7 @@
 #include "file.h"
 #include "gc.h"
 #include "hashtable.h"
+#include "jit.h"
 #include "memory.h"
 #include "native.h"
 #include "object.h"
@@ -39,7 +40,61 @@ typedef enum {
 
 static Value run();
 
+// Grows the stack, so that it can hold at least [min_capacity] values. The stack is moved to a new allocation, which is why the
+// pointers into the stack (frame slots, open upvalues and the stack pointer) are fixed up. The previous stack is retired instead
+// of freed, because natives which called back into managed code might still read their arguments (argv) from it.
+static void grow_stack(int min_capacity) {
+  int capacity = vm.stack_capacity;
+  while (capacity < min_capacity) {
+    capacity = GROW_CAPACITY(capacity);
+  }
+
+  Value* stack = malloc(sizeof(Value) * capacity);
+  if (stack == NULL) {
+    INTERNAL_ERROR("Not enough memory to grow the stack");
+    exit(SLANG_EXIT_MEMORY_ERROR);
+  }
+  memcpy(stack, vm.stack, sizeof(Value) * (vm.stack_top - vm.stack));
+
+  for (int i = 0; i < vm.frame_count; i++) {
+    vm.frames[i].slots = stack + (vm.frames[i].slots - vm.stack);
+  }
+  for (ObjUpvalue* upvalue = vm.open_upvalues; upvalue != NULL; upvalue = upvalue->next) {
+    upvalue->location = stack + (upvalue->location - vm.stack);
+  }
+  vm.stack_top = stack + (vm.stack_top - vm.stack);
+
+  Value** retired_stacks = realloc(vm.retired_stacks, sizeof(Value*) * (vm.retired_stack_count + 1));
+  if (retired_stacks == NULL) {
+    INTERNAL_ERROR("Not enough memory to grow the stack");
+    exit(SLANG_EXIT_MEMORY_ERROR);
+  }
+  vm.retired_stacks                           = retired_stacks;
+  vm.retired_stacks[vm.retired_stack_count++] = vm.stack;
+
+  vm.stack          = stack;
+  vm.stack_capacity = capacity;
+}
+
+// Frees the stacks which were retired by grow_stack. Only safe to call if no native is executing.
+static void free_retired_stacks() {
+  for (int i = 0; i < vm.retired_stack_count; i++) {
+    free(vm.retired_stacks[i]);
+  }
+  vm.retired_stack_count = 0;
+}
+
+// Push a value onto the stack without checking the stack's capacity - unlike vm_push. Used by run(), which is fine, because
+// call_managed makes room for the most values a frame ever holds (see chunk_max_depth). The JIT relies on that, too.
+static inline void push(Value value) {
+  *vm.stack_top = value;
+  vm.stack_top++;
+}
+
 void vm_push(Value value) {
+  if (vm.stack_top == vm.stack + vm.stack_capacity) {
+    grow_stack(vm.stack_capacity + 1);
+  }
   *vm.stack_top = value;
   vm.stack_top++;
 }
@@ -55,7 +110,8 @@ static Value peek(int distance) {
 }
 
 void vm_clear_error() {
-  vm.current_error = nil_value();
+  vm.current_error     = nil_value();
+  vm.lazy_error.format = NULL;
   VM_CLEAR_FLAG(VM_FLAG_HAS_ERROR);  // Clear the error flag
 }
 
@@ -68,6 +124,7 @@ static void reset_stack() {
   vm.stack_top     = vm.stack;
   vm.frame_count   = 0;
   vm.open_upvalues = NULL;
+  free_retired_stacks();
 
   VM_CLEAR_FLAG(VM_FLAG_PAUSE_GC);  // Clear the pause flag, just to be sure
   vm_clear_error();
@@ -77,13 +134,26 @@ static void dump_stacktrace() {
   for (int i = vm.frame_count - 1; i >= 0; i--) {
     CallFrame* frame      = &vm.frames[i];
     ObjFunction* function = frame->closure->function;
-    size_t instruction    = frame->ip - function->chunk.code - 1;
-
-    fprintf(stderr, "  at line %d ", function->chunk.source_views[instruction].line);
+    Chunk* chunk          = &function->chunk;
+    int instruction       = (int)(frame->ip - chunk->code - 1);
 
     Value module_name;
-    if (!hashtable_get_by_string(&function->globals_context->fields, vm.special_prop_names[SPECIAL_PROP_MODULE_NAME],
-                                 &module_name)) {
+    bool has_module = object_get_field_by_string(function->globals_context, vm.special_prop_names[SPECIAL_PROP_MODULE_NAME],
+                                                 &module_name);
+
+    // Inlined functions and function literals get a frame too, as if they had been called.
+    for (int j = 0; j < chunk->inlined_count && has_module; j++) {
+      InlinedRange range = chunk->inlined[j];
+      if (instruction >= range.start && instruction < range.end) {
+        fprintf(stderr, "  at line %d in \"%s\" in module \"%s\"\n", chunk->source_views[instruction].line,
+                range.name == NULL ? VALUE_STR_ANON_FN : range.name->chars, AS_CSTRING(module_name));
+        instruction = range.site;
+      }
+    }
+
+    fprintf(stderr, "  at line %d ", chunk->source_views[instruction].line);
+
+    if (!has_module) {
       fprintf(stderr, "in \"%s\"\n", function->name->chars);
       break;
     }
@@ -109,7 +179,52 @@ void vm_error(const char* format, ...) {
   va_end(args);
 
   VM_SET_FLAG(VM_FLAG_HAS_ERROR);
+  vm.lazy_error.format = NULL;
+  vm.current_error     = str_value(copy_string(buffer, (int)length));
+}
+
+void vm_error_lazy(const char* format, int count, ...) {
+  INTERNAL_ASSERT(count <= LAZY_ERROR_ARGS_MAX, "Too many operands for a lazy error.");
+
+  va_list args;
+  va_start(args, count);
+  for (int i = 0; i < count; i++) {
+    vm.lazy_error.args[i] = va_arg(args, Value);
+  }
+  va_end(args);
+
+  VM_SET_FLAG(VM_FLAG_HAS_ERROR);
+  vm.lazy_error.format = format;
+  vm.lazy_error.count  = count;
+  vm.current_error     = nil_value();
+}
+
+// Formats the message of the pending lazy error, if there is one, and makes it the current error.
+static void materialize_lazy_error() {
+  LazyError* error = &vm.lazy_error;
+  if (error->format == NULL) {
+    return;
+  }
+
+  char buffer[1024] = {0};
+  size_t length     = 0;
+  int arg           = 0;
+  for (const char* c = error->format; *c != '\0' && length < sizeof(buffer) - 1; c++) {
+    if (c[0] != '%' || (c[1] != 's' && c[1] != 'd') || arg >= error->count) {
+      buffer[length++] = *c;
+      continue;
+    }
+
+    Value operand = error->args[arg++];
+    int written   = is_int(operand) ? snprintf(buffer + length, sizeof(buffer) - length, VALUE_STR_INT, AS_INT(operand))
+                                    : snprintf(buffer + length, sizeof(buffer) - length, "%s", AS_CSTRING(operand));
+    length        = MIN(length + (size_t)written, sizeof(buffer) - 1);
+    c++;  // Skip the conversion
+  }
+
+  // Operands are still marked by the GC while the string is allocated.
   vm.current_error = str_value(copy_string(buffer, (int)length));
+  error->format    = NULL;
 }
 
 void define_native(HashTable* table, const char* name, NativeFn function, int arity) {
@@ -134,6 +249,22 @@ void define_value(HashTable* table, const char* name, Value value) {
   VM_CLEAR_FLAG(VM_FLAG_PAUSE_GC);
 }
 
+void define_module_native(ObjObject* module, const char* name, NativeFn function, int arity) {
+  VM_SET_FLAG(VM_FLAG_PAUSE_GC);
+  ObjString* name_str = copy_string(name, (int)strlen(name));
+  Value value         = fn_value((Obj*)new_native(function, name_str, arity));
+
+  object_set_field(module, str_value(name_str), value);
+  VM_CLEAR_FLAG(VM_FLAG_PAUSE_GC);  // Resume GC
+}
+
+void define_module_value(ObjObject* module, const char* name, Value value) {
+  VM_SET_FLAG(VM_FLAG_PAUSE_GC);
+  Value key = str_value(copy_string(name, (int)strlen(name)));
+  object_set_field(module, key, value);
+  VM_CLEAR_FLAG(VM_FLAG_PAUSE_GC);
+}
+
 void vm_make_seq(int count) {
   // Since we know the count, we can preallocate the value array for the list. This avoids
   // using value_array_write within the loop, which can trigger a GC due to growing the array
@@ -186,6 +317,17 @@ static void make_object(int count) {
 
 void vm_init() {
   prioritize_main_thread();
+
+  vm.frames_max         = FRAMES_MAX_DEFAULT;
+  vm.frames             = malloc(sizeof(CallFrame) * vm.frames_max);
+  vm.jit_threshold      = 0;
+  vm.jit_loop_threshold = 0;
+  vm.stack_capacity     = STACK_INITIAL_CAPACITY;
+  vm.stack              = malloc(sizeof(Value) * vm.stack_capacity);
+  if (vm.frames == NULL || vm.stack == NULL) {
+    INTERNAL_ERROR("Not enough memory to allocate the stack");
+    exit(SLANG_EXIT_MEMORY_ERROR);
+  }
   reset_stack();
 
   vm.objects         = NULL;
@@ -194,6 +336,14 @@ void vm_init() {
   vm.prev_gc_freed   = 0;
   vm.next_gc         = HEAP_DEFAULT_THRESHOLD;
   vm.exit_on_frame   = 0;  // Default to exit on the first frame
+
+  vm.lazy_error.format = NULL;
+  vm.lazy_error.count  = 0;
+
+  vm.invoke_cache_hits     = 0;
+  vm.invoke_cache_misses   = 0;
+  vm.property_cache_hits   = 0;
+  vm.property_cache_misses = 0;
   atomic_init(&vm.object_count, 0);
 
   gc_thread_pool_init(get_cpu_core_count());
@@ -204,6 +354,9 @@ void vm_init() {
   hashtable_init(&vm.strings);
   hashtable_init(&vm.modules);
 
+  vm.shape_count = 0;
+  vm.root_shape  = new_root_shape();
+
   // Register the built-in classes
   // Names are null, because we cannot intern them yet. At this point hashtables won't work, bc without the file_base classes the
   // the hashtable cannot compare the keys.
@@ -218,8 +371,8 @@ void vm_init() {
   vm.float_class   = native_float_class_partial_init(vm.num_class);
   vm.seq_class     = native_seq_class_partial_init();
   vm.tuple_class   = native_tuple_class_partial_init();
+  vm.iter_class    = native_iter_class_partial_init();
   vm.upvalue_class = new_class(NULL, NULL);
-  vm.handler_class = new_class(NULL, NULL);
 
   // Now, we can intern the names. Hashtables are now usable.
   ObjString* obj_name     = copy_string(STR(TYPENAME_OBJ), STR_LEN(STR(TYPENAME_OBJ)));
@@ -232,9 +385,9 @@ void vm_init() {
   ObjString* int_name     = copy_string(STR(TYPENAME_INT), STR_LEN(STR(TYPENAME_INT)));
   ObjString* float_name   = copy_string(STR(TYPENAME_FLOAT), STR_LEN(STR(TYPENAME_FLOAT)));
   ObjString* upvalue_name = copy_string(STR(TYPENAME_UPVALUE), STR_LEN(STR(TYPENAME_UPVALUE)));
-  ObjString* handler_name = copy_string(STR(TYPENAME_HANDLER), STR_LEN(STR(TYPENAME_HANDLER)));
   ObjString* seq_name     = copy_string(STR(TYPENAME_SEQ), STR_LEN(STR(TYPENAME_SEQ)));
   ObjString* tuple_name   = copy_string(STR(TYPENAME_TUPLE), STR_LEN(STR(TYPENAME_TUPLE)));
+  ObjString* iter_name    = copy_string(STR(TYPENAME_ITER), STR_LEN(STR(TYPENAME_ITER)));
 
   // ...and assign them to the classes
   vm.obj_class->name     = obj_name;
@@ -247,9 +400,9 @@ void vm_init() {
   vm.int_class->name     = int_name;
   vm.float_class->name   = float_name;
   vm.upvalue_class->name = upvalue_name;
-  vm.handler_class->name = handler_name;
   vm.seq_class->name     = seq_name;
   vm.tuple_class->name   = tuple_name;
+  vm.iter_class->name    = iter_name;
 
   // Create the natives lookup table.
   hashtable_init(&vm.natives);
@@ -265,9 +418,9 @@ void vm_init() {
   hashtable_set(&vm.natives, str_value(int_name), class_value(vm.int_class));
   hashtable_set(&vm.natives, str_value(float_name), class_value(vm.float_class));
   hashtable_set(&vm.natives, str_value(upvalue_name), class_value(vm.upvalue_class));
-  hashtable_set(&vm.natives, str_value(handler_name), class_value(vm.handler_class));
   hashtable_set(&vm.natives, str_value(seq_name), class_value(vm.seq_class));
   hashtable_set(&vm.natives, str_value(tuple_name), class_value(vm.tuple_class));
+  hashtable_set(&vm.natives, str_value(iter_name), class_value(vm.iter_class));
 
   // Build the reserved words lookup table
   memset(vm.special_method_names, 0, sizeof(vm.special_method_names));
@@ -312,6 +465,7 @@ void vm_init() {
   native_float_class_finalize();
   native_seq_class_finalize();
   native_tuple_class_finalize();
+  native_iter_class_finalize();
   native_str_class_finalize();
   native_fn_class_finalize();
   native_class_class_finalize();
@@ -334,7 +488,42 @@ void vm_free() {
   memset(vm.special_method_names, 0, sizeof(vm.special_method_names));
   memset(vm.special_prop_names, 0, sizeof(vm.special_prop_names));
   free_heap();
+  free_shape(vm.root_shape);
+  vm.root_shape = NULL;
   gc_thread_pool_shutdown();
+
+  free_retired_stacks();
+  free(vm.retired_stacks);
+  free(vm.stack);
+  free(vm.frames);
+  vm.retired_stacks = NULL;
+  vm.stack          = NULL;
+  vm.frames         = NULL;
+}
+
+bool vm_set_max_depth(int max_depth) {
+  if (max_depth < 1 || max_depth > FRAMES_MAX_LIMIT) {
+    return false;
+  }
+
+  CallFrame* frames = realloc(vm.frames, sizeof(CallFrame) * max_depth);
+  if (frames == NULL) {
+    INTERNAL_ERROR("Not enough memory to allocate %d call frames", max_depth);
+    exit(SLANG_EXIT_MEMORY_ERROR);
+  }
+  vm.frames     = frames;
+  vm.frames_max = max_depth;
+  return true;
+}
+
+bool vm_enable_jit(int threshold, int loop_threshold) {
+  if (!JIT_SUPPORTED || threshold < 1 || loop_threshold < 1) {
+    return false;
+  }
+
+  vm.jit_threshold      = threshold;
+  vm.jit_loop_threshold = loop_threshold;
+  return true;
 }
 
 // If [expected] is positive, [actual] must match exactly. If [expected] is negative, [actual] must be at least
@@ -353,22 +542,71 @@ void vm_free() {
     return CALL_FAILED;                                                          \
   }
 
+// Counts a call to the function of the new [frame] and compiles the function to machine code once it reaches the JIT threshold.
+// If the function has been compiled, its machine code runs right away, until the first instruction it can't execute.
+static void enter_jit(CallFrame* frame) {
+  ObjFunction* function = frame->closure->function;
+  if (function->call_count < vm.jit_threshold && ++function->call_count == vm.jit_threshold) {
+    jit_compile(function);
+  }
+  if (function->jit != NULL) {
+    frame->ip = jit_enter(function, frame->slots, frame->ip);
+  }
+}
+
+// Counts a back-edge to the loop header [frame]'s ip points to. If the loop has been compiled to a trace, the trace takes over
+// right away - in the middle of the loop, which is what allows long-running loops (e.g. at the top level of a module) to switch
+// to machine code without being called again. Returns true once the loop is hot, or its trace keeps exiting in the middle of the
+// loop, in which case its next iteration has to be recorded - see jit_record.
+static bool enter_loop(CallFrame* frame) {
+  ObjFunction* function = frame->closure->function;
+  JitTrace* trace       = jit_trace(function, frame->ip);
+  if (trace->hotness >= vm.jit_loop_threshold && jit_record_start(function, trace, frame->slots)) {
+    return true;
+  }
+  if (trace->code != NULL) {
+    frame->ip = jit_enter_trace(trace, frame->slots);
+    if (frame->ip >= trace->loop_from && frame->ip <= trace->loop_to && trace->hotness < vm.jit_loop_threshold) {
+      trace->hotness++;  // A side exit, the loop continues in the interpreter
+    }
+  } else if (function->jit != NULL) {
+    frame->ip = jit_enter(function, frame->slots, frame->ip);  // Continue in the function's machine code, which is just as good
+  } else if (trace->hotness < vm.jit_loop_threshold) {
+    trace->hotness++;
+  }
+  return false;
+}
+
 // Executes a call to a managed-code function or method by creating a new call frame and pushing it onto the
 // frame stack.
 // `Stack: ...[closure][arg0][arg1]...[argN]`
 static CallResult call_managed(ObjClosure* closure, int arg_count) {
   CHECK_ARGS(closure->function->arity, arg_count);
 
-  if (vm.frame_count == FRAMES_MAX) {
-    vm_error("Stack overflow. Maximum call stack depth of %d reached.", FRAMES_MAX);
+  if (vm.frame_count == vm.frames_max) {
+    vm_error("Stack overflow. Maximum call stack depth of %d reached.", vm.frames_max);
     return CALL_FAILED;
   }
 
+  // Make sure the new frame has room for all of its locals and temporaries.
+  ptrdiff_t frame_end = (vm.stack_top - vm.stack) - arg_count - 1 + closure->function->max_depth;
+  if (frame_end > vm.stack_capacity) {
+    if (frame_end > STACK_MAX_CAPACITY) {
+      vm_error("Stack overflow. The stack can't hold more than %d values.", STACK_MAX_CAPACITY);
+      return CALL_FAILED;
+    }
+    grow_stack((int)frame_end);
+  }
+
   CallFrame* frame = &vm.frames[vm.frame_count++];
   frame->closure   = closure;
   frame->ip        = closure->function->chunk.code;
   frame->slots = vm.stack_top - arg_count - 1;  // -1 to account for either the function or the receiver preceeding the arguments.
-  frame->globals = &closure->function->globals_context->fields;
+  frame->globals = closure->function->globals_context;
+
+  if (vm.jit_threshold > 0) {
+    enter_jit(frame);
+  }
 
   return CALL_RUNNING;
 }
@@ -381,7 +619,7 @@ static CallResult call_native(ObjNative* native, int arg_count) {
   Value* args  = vm.stack_top - arg_count - 1;
   Value result = native->function(arg_count, args);
   vm.stack_top -= arg_count + 1;  // Remove args + fn or receiver
-  vm_push(result);
+  push(result);
 
   return CALL_RETURNED;
 }
@@ -448,7 +686,7 @@ static CallResult call_value(Value callable, int arg_count) {
     return CALL_RETURNED;
   }
 
-  vm_error("Attempted to call non-callable value of type %s.", callable.type->name->chars);
+  vm_error("Attempted to call non-callable value of type %s.", value_type(callable)->name->chars);
   return CALL_FAILED;
 }
 
@@ -458,16 +696,16 @@ static CallResult call_value(Value callable, int arg_count) {
 // for actual method-lookup. If you provide NULL, the receiver's type will be used.
 static CallResult invoke(ObjClass* source_klass, ObjString* name, int arg_count) {
   Value receiver  = peek(arg_count);
-  ObjClass* klass = source_klass == NULL ? receiver.type : source_klass;
+  ObjClass* klass = source_klass == NULL ? value_type(receiver) : source_klass;
   Value method;
 
   // Most likely it's a method on the receiver's class
   if (hashtable_get_by_string(&klass->methods, name, &method)) {
-    switch (method.as.obj->type) {
+    switch (AS_OBJ(method)->type) {
       case OBJ_GC_CLOSURE: return call_managed(AS_CLOSURE(method), arg_count);
       case OBJ_GC_NATIVE: return call_native(AS_NATIVE(method), arg_count);
       default: {
-        vm_error("Cannot invoke method of type %s on class", method.type->name->chars);
+        vm_error("Cannot invoke method of type %s on class", value_type(method)->name->chars);
         return CALL_FAILED;
       }
     }
@@ -478,11 +716,11 @@ static CallResult invoke(ObjClass* source_klass, ObjString* name, int arg_count)
   if (is_class(receiver)) {
     ObjClass* klass_ = AS_CLASS(receiver);
     if (hashtable_get_by_string(&klass_->static_methods, name, &method)) {
-      switch (method.as.obj->type) {
+      switch (AS_OBJ(method)->type) {
         case OBJ_GC_CLOSURE: return call_managed(AS_CLOSURE(method), arg_count);
         case OBJ_GC_NATIVE: return call_native(AS_NATIVE(method), arg_count);
         default: {
-          vm_error("Cannot invoke method of type %s on class", method.type->name->chars);
+          vm_error("Cannot invoke method of type %s on class", value_type(method)->name->chars);
           return CALL_FAILED;
         }
       }
@@ -492,18 +730,144 @@ static CallResult invoke(ObjClass* source_klass, ObjString* name, int arg_count)
   // It could be a field on an object or instance which is a callable value
   if (is_obj(receiver) || is_instance(receiver)) {
     ObjObject* object = AS_OBJECT(receiver);
-    if (hashtable_get_by_string(&object->fields, name, &method)) {
+    if (object_get_field_by_string(object, name, &method)) {
       vm.stack_top[-arg_count - 1] = method;
       return call_value(method, arg_count);
     }
   }
 
-  bool is_base = klass->base == NULL;
-  vm_error("Undefined callable '%s' in type %s%s.", name->chars, klass->name->chars,
-           is_base ? "" : " or any of its parent classes");
+  if (klass->base == NULL) {
+    vm_error_lazy("Undefined callable '%s' in type %s.", 2, str_value(name), str_value(klass->name));
+  } else {
+    vm_error_lazy("Undefined callable '%s' in type %s or any of its parent classes.", 2, str_value(name), str_value(klass->name));
+  }
   return CALL_FAILED;
 }
 
+// Looks up the method cached for [klass] in an inline cache. Returns NULL if the cache has no entry for [klass].
+static inline Obj* inline_cache_lookup(InlineCache* cache, ObjClass* klass) {
+  for (int i = 0; i < cache->count; i++) {
+    if (cache->entries[i].klass == klass) {
+      return cache->entries[i].method;
+    }
+  }
+  return NULL;
+}
+
+// Adds an entry to an inline cache. Does nothing if the cache is full, e.g. the call site is megamorphic.
+static inline void inline_cache_add(InlineCache* cache, ObjClass* klass, Obj* method) {
+  if (cache->count < INLINE_CACHE_SIZE) {
+    cache->entries[cache->count++] = (InlineCacheEntry){.klass = klass, .method = method};
+  }
+}
+
+// Invokes a method on the receiver (see invoke()). Methods of the receivers' type are remembered in the call sites' inline
+// cache, so subsequent invocations on receivers of the same type skip the method lookup. Everything else (static methods,
+// callable fields, errors) takes the slow path.
+// `Stack: ...[receiver][arg0][arg1]...[argN]`
+static CallResult invoke_cached(ObjString* name, int arg_count, InlineCache* cache) {
+  ObjClass* klass = value_type(peek(arg_count));
+  Obj* method     = inline_cache_lookup(cache, klass);
+
+  if (method != NULL) {
+    VM_COUNT_CACHE_STAT(invoke_cache_hits);
+  } else {
+    VM_COUNT_CACHE_STAT(invoke_cache_misses);
+    Value found;
+    if (!hashtable_get_by_string(&klass->methods, name, &found) ||
+        (AS_OBJ(found)->type != OBJ_GC_CLOSURE && AS_OBJ(found)->type != OBJ_GC_NATIVE)) {
+      return invoke(NULL, name, arg_count);
+    }
+    method = AS_OBJ(found);
+    inline_cache_add(cache, klass, method);
+  }
+
+  return method->type == OBJ_GC_CLOSURE ? call_managed((ObjClosure*)method, arg_count)
+                                        : call_native((ObjNative*)method, arg_count);
+}
+
+// Gets a property from the receiver (see __get_prop). Properties which resolve to a method of the receivers' type are
+// remembered in the call sites' inline cache, so subsequent lookups on receivers of the same type skip the method lookup.
+// Fields of TYPENAME_OBJs and instances shadow methods, so the caller must have checked them already. Classes are never
+// cached, because their static methods and fields shadow methods too.
+// `Stack: ...[receiver]`
+static bool get_property_cached(Value receiver, ObjString* name, InlineCache* cache, Value* result) {
+  ObjClass* klass = value_type(receiver);
+  Obj* method = inline_cache_lookup(cache, klass);
+  if (method != NULL) {
+    VM_COUNT_CACHE_STAT(property_cache_hits);
+    *result = fn_value((Obj*)new_bound_method(receiver, method));
+    return true;
+  }
+
+  VM_COUNT_CACHE_STAT(property_cache_misses);
+  if (!klass->__get_prop(receiver, name, result)) {
+    return false;
+  }
+
+  // Only cache properties which resolved to a method of the receivers' type.
+  Value bound = *result;
+  Value found;
+  if (klass != vm.class_class && is_bound_method(bound) && hashtable_get_by_string(&klass->methods, name, &found) &&
+      AS_BOUND_METHOD(bound)->method == AS_OBJ(found)) {
+    inline_cache_add(cache, klass, AS_OBJ(found));
+  }
+
+  return true;
+}
+
+// Gets a field of an TYPENAME_OBJ or instance. If the objects' shape matches the one remembered in the call sites' inline cache,
+// this is just an indexed load. Returns false if the object does not have the field.
+static inline bool get_field_cached(ObjObject* object, ObjString* name, InlineCache* cache, Value* result) {
+  Shape* shape = object->shape;
+  if (shape != NULL && shape == cache->shape) {
+    VM_COUNT_CACHE_STAT(property_cache_hits);
+    *result = object->slots[cache->slot];
+    return true;
+  }
+
+  if (shape == NULL) {
+    return object_get_field_by_string(object, name, result);
+  }
+
+  int slot = shape_find_slot(shape, name);
+  if (slot < 0) {
+    return false;
+  }
+
+  VM_COUNT_CACHE_STAT(property_cache_misses);
+  cache->shape      = shape;
+  cache->transition = shape;
+  cache->slot       = slot;
+  *result           = object->slots[slot];
+  return true;
+}
+
+// Sets a field of an TYPENAME_OBJ or instance. If the objects' shape matches the one remembered in the call sites' inline cache,
+// this is just an indexed store - or a shape transition, if the field is added to the object (e.g. in a constructor).
+// `Stack: ...[receiver][value]`
+static inline void set_field_cached(ObjObject* object, ObjString* name, Value value, InlineCache* cache) {
+  Shape* shape = object->shape;
+  if (shape != NULL && shape == cache->shape) {
+    VM_COUNT_CACHE_STAT(property_cache_hits);
+    if (cache->transition == shape) {
+      object->slots[cache->slot] = value;
+    } else {
+      object_set_field_transition(object, cache->transition, value);
+    }
+    return;
+  }
+
+  object_set_field(object, str_value(name), value);
+
+  if (shape != NULL && object->shape != NULL) {
+    VM_COUNT_CACHE_STAT(property_cache_misses);
+    cache->shape      = shape;
+    cache->transition = object->shape;
+    cache->slot       = shape_find_slot(object->shape, name);
+  }
+}
+
 // Executes a callframe by running the bytecode until it returns a value or an error occurs.
 static Value run_frame() {
   int previous_exit_frame = vm.exit_on_frame;
@@ -529,6 +893,58 @@ Value vm_exec_callable(Value callable, int arg_count) {
   return nil_value();
 }
 
+Value* vm_jit_invoke(Obj* method, int arg_count, uint16_t* ip) {
+  VM_COUNT_CACHE_STAT(invoke_cache_hits);  // The trace's guard on the class of the receiver is the cache lookup
+  current_frame()->ip = ip;                 // Just like the interpreter, which has read the instruction already when it calls
+  CallResult result   = method->type == OBJ_GC_CLOSURE ? call_managed((ObjClosure*)method, arg_count)
+                                                       : call_native((ObjNative*)method, arg_count);
+  if (result == CALL_RUNNING) {
+    push(run_frame());
+  }
+
+  if (result == CALL_FAILED || VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
+    return NULL;
+  }
+  return current_frame()->slots;
+}
+
+void vm_callback_init(VmCallback* callback, Value callable, int arg_count) {
+  callback->callable  = callable;
+  callback->closure   = NULL;
+  callback->receiver  = callable;
+  callback->arg_count = arg_count;
+
+  if (is_closure(callable)) {
+    callback->closure = AS_CLOSURE(callable);
+  } else if (is_bound_method(callable) && AS_BOUND_METHOD(callable)->method->type == OBJ_GC_CLOSURE) {
+    callback->closure  = (ObjClosure*)AS_BOUND_METHOD(callable)->method;
+    callback->receiver = AS_BOUND_METHOD(callable)->receiver;
+  }
+}
+
+Value vm_callback_call(VmCallback* callback, const Value* args) {
+  if (callback->closure == NULL) {
+    vm_push(callback->callable);
+    for (int i = 0; i < callback->arg_count; i++) {
+      vm_push(args[i]);
+    }
+    return vm_exec_callable(callback->callable, callback->arg_count);
+  }
+
+  // Lay out the frame like a call instruction would: [receiver][arg0]...[argN].
+  if (vm.stack_top + callback->arg_count + 1 > vm.stack + vm.stack_capacity) {
+    grow_stack((int)(vm.stack_top - vm.stack) + callback->arg_count + 1);
+  }
+  vm.stack_top[0] = callback->receiver;
+  memcpy(vm.stack_top + 1, args, sizeof(Value) * (size_t)callback->arg_count);
+  vm.stack_top += callback->arg_count + 1;
+
+  if (call_managed(callback->closure, callback->arg_count) != CALL_RUNNING) {
+    return nil_value();
+  }
+  return run_frame();
+}
+
 bool bind_method(ObjClass* klass, ObjString* name, Value* bound_method) {
   Value method;
   if (!hashtable_get_by_string(&klass->methods, name, &method)) {
@@ -536,7 +952,7 @@ bool bind_method(ObjClass* klass, ObjString* name, Value* bound_method) {
     return false;
   }
 
-  ObjBoundMethod* bound = new_bound_method(peek(0), method.as.obj);
+  ObjBoundMethod* bound = new_bound_method(peek(0), AS_OBJ(method));
   *bound_method         = fn_value((Obj*)bound);
   return true;
 }
@@ -585,6 +1001,25 @@ static void close_upvalues(Value* last) {
   }
 }
 
+// Turns the call which was just made from [frame] into a tail call: The callee's frame (the topmost one) replaces [frame]. This
+// closes the upvalues of [frame] and moves the callee's slots down to where [frame]'s slots started. Returns the frame which is
+// now executing the callee.
+static CallFrame* collapse_tail_call(CallFrame* frame) {
+  CallFrame* callee = current_frame();
+  close_upvalues(frame->slots);
+
+  int slot_count = (int)(vm.stack_top - callee->slots);
+  memmove(frame->slots, callee->slots, sizeof(Value) * slot_count);
+  vm.stack_top = frame->slots + slot_count;
+
+  frame->closure = callee->closure;
+  frame->ip      = callee->ip;
+  frame->globals = callee->globals;
+  vm.frame_count--;
+
+  return frame;
+}
+
 // Adds a method to the class on top of the stack.
 // The methods closure is on top of the stack, the class is one below that.
 static void define_method(ObjString* name, FunctionType type) {
@@ -609,7 +1044,7 @@ static void define_method(ObjString* name, FunctionType type) {
 }
 
 bool vm_is_falsey(Value value) {
-  return is_nil(value) || (is_bool(value) && !value.as.boolean);
+  return is_nil(value) || (is_bool(value) && !AS_BOOL(value));
 }
 
 bool vm_inherits(ObjClass* klass, ObjClass* base) {
@@ -656,12 +1091,12 @@ static bool import_module(ObjString* module_name, ObjString* module_path) {
   module                  = vm_run_module(module_path->chars, module_name->chars, true /* no warnings */);
   vm.exit_on_frame        = previous_exit_frame;
 
-  if (module.type == vm.nil_class) {
+  if (value_type(module) == vm.nil_class) {
     return false;  // There was an error loading the module
   }
 
   // Check if the module is actually a module
-  if (!(module.type == vm.module_class)) {
+  if (!(value_type(module) == vm.module_class)) {
     vm_error("Could not import module '%s' from file '%s'. Expected module type", module_name->chars, module_path->chars);
     return false;
   }
@@ -699,37 +1134,47 @@ void vm_concatenate() {
   vm_push(str_value(result));
 }
 
+// Returns the innermost try range of [chunk] which protects the instruction at [offset], or NULL if there is none.
+static TryRange* find_try_range(Chunk* chunk, int offset) {
+  for (TryRange* range = chunk->tries; range < chunk->tries + chunk->try_count; range++) {
+    if (offset >= range->start && offset < range->end) {
+      return range;
+    }
+  }
+  return NULL;
+}
+
 // Handles errors in the virtual machine.
 // This function is responsible for handling errors that occur during the execution of the virtual machine.
-// It searches for the nearest error handler in the call stack and resets the virtual machine state to that
-// handler's call frame.
+// It searches the try ranges of the functions in the call stack for the nearest error handler and resets the virtual machine
+// state to that handler's call frame.
 // If no error handler is found, it prints the error message, dumps the stack trace, resets the virtual
 // machine's stack state and returns false. Returns true if an error handler is found and the virtual machine
 // state is reset, false otherwise.
 static bool handle_runtime_error() {
-  int stack_offset;
-  int frame_offset;
-  int exit_slot = 0;  // Slot in the stack where we should stop looking for a handler
-
-  // If we have an exit frame, we need to use it's stack-start slot as the exit slot
-  // This ensures that we stay within the current frame's stack, and don't go beyond it.
-  if ((vm.exit_on_frame >= 0)) {
-    exit_slot = (int)(vm.frames[vm.exit_on_frame].slots - vm.stack);
-  }
+  // If we have an exit frame, we must not look for a handler below it. This ensures that we stay within the frames of the
+  // current (nested) execution, and don't go beyond it.
+  int exit_frame = vm.exit_on_frame >= 0 ? vm.exit_on_frame : 0;
+  int exit_slot  = (int)(vm.frames[exit_frame].slots - vm.stack);
 
-  // Rewind the stack to the last handler, or the exit slot
-  for (stack_offset = (int)(vm.stack_top - vm.stack - 1);                 // Start at the top of the stack
-       stack_offset >= exit_slot && !is_handler(vm.stack[stack_offset]);  // Stop at the exit slot or handler
-       stack_offset--) {
-    ;
+  // Go through the frames from the top to the bottom. The ip of each frame points past the instruction it is executing - or
+  // past the call which created the frame above it.
+  int frame_offset;
+  TryRange* range = NULL;
+  for (frame_offset = vm.frame_count - 1; frame_offset >= exit_frame && range == NULL; frame_offset--) {
+    CallFrame* frame = &vm.frames[frame_offset];
+    Chunk* chunk     = &frame->closure->function->chunk;
+    range            = find_try_range(chunk, (int)(frame->ip - chunk->code - 1));
   }
+  frame_offset++;  // Undo the last decrement, e.g. point to the frame which owns the handler.
 
-  // Did we find a handler within the current frame?
-  if (stack_offset < exit_slot) {
+  // Did we find a handler within the current execution?
+  if (range == NULL) {
     // No handler found and we reached the bottom of the stack. So we print the stacktrace and reset the Vm's
     // stack state. Should be fine to execute more code after this, because the stack is reset.
     if (exit_slot == 0) {
       VM_SET_FLAG(VM_FLAG_HAD_UNCAUGHT_RUNTIME_ERROR);  // Forever-set
+      materialize_lazy_error();
 
       // Store the current error, so we can reset the stack to call the errors __to_str method
       Value error = vm.current_error;
@@ -739,13 +1184,14 @@ static bool handle_runtime_error() {
       // Now, what if the __to_str method is managed code and it throws an error itself? It's not too bad, because we have that
       // new error too, so we can guide the user through what went wrong.
       vm_push(error);
-      ObjString* str = (ObjString*)vm_exec_callable(fn_value(error.type->__to_str), 0).as.obj;
+      ObjString* str = (ObjString*)AS_OBJ(vm_exec_callable(fn_value(value_type(error)->__to_str), 0));
       if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
         fprintf(stderr, "Uncaught error within " STR(SP_METHOD_TO_STR) "-method of previous error value. ");
         fprintf(stderr, "The previous error value was of type: " ANSI_COLOR_RED);
-        value_print_safe(stderr, class_value(error.type));
+        value_print_safe(stderr, class_value(value_type(error)));
         fprintf(stderr, ANSI_COLOR_RESET "\n");
         fprintf(stderr, "Calling its " STR(SP_METHOD_TO_STR) "-method resulted in the following uncaught error: " ANSI_COLOR_RED);
+        materialize_lazy_error();
         value_print_safe(stderr, vm.current_error);
         fprintf(stderr, ANSI_COLOR_RESET "\n");
         vm_clear_error();  // Is done too in reset_stack, but that might change in the future.
@@ -769,27 +1215,22 @@ static bool handle_runtime_error() {
     return false;
   }
 
-  // We have a handler, now we need to find the frame it belongs to.
-  // We do that by going through the frames from the top to the bottom, and stop at the frame where the
-  // handler (stack_offset) is.
-  for (frame_offset = vm.frame_count - 1;  // Start at the top of the frame stack
-       frame_offset >= 0 && (int)(vm.frames[frame_offset].slots - vm.stack) > stack_offset;  // Stop at the frame
-       frame_offset--) {
-    ;
-  }
+  // We have the handler and the frame it belongs to. Now let's reset the Vm to that call frame and continue at the handler.
+  CallFrame* frame = &vm.frames[frame_offset];
+  Value* base      = frame->slots + range->depth;
+  close_upvalues(base);  // Close upvalues that are no longer needed
+  vm.stack_top   = base;
+  vm.frame_count = frame_offset + 1;
+  frame->ip      = frame->closure->function->chunk.code + range->handler;
 
-  // Did we find a frame that owns the handler?
-  if (frame_offset == -1) {
-    INTERNAL_ERROR("Call stack corrupted. No call frame found that owns the handler.");
-    exit(SLANG_EXIT_SW_ERROR);
+  // Only pay for the message of a lazy error if the handler reads the error.
+  if (range->uses_error) {
+    materialize_lazy_error();
+  } else if (vm.lazy_error.format != NULL) {
+    vm.lazy_error.format = NULL;
+    vm.current_error     = nil_value();
   }
 
-  // We have the handler's index/offset in the stack and the frame it belongs to. Now let's reset the Vm to
-  // that call frame.
-  close_upvalues(&vm.stack[stack_offset]);  // Close upvalues that are no longer needed
-  vm.stack_top   = vm.stack + stack_offset + 1;
-  vm.frame_count = frame_offset + 1;
-
   VM_CLEAR_FLAG(VM_FLAG_HAS_ERROR);
 
   return true;
@@ -829,13 +1270,21 @@ static Value run() {
 #undef DISPATCH_TABLE_ENTRY
   };
 
+  // Used instead of the dispatch table while a loop is recorded, see DO_RECORD.
+  static void* record_table[] = {
+#define RECORD_TABLE_ENTRY(name) &&DO_RECORD,
+      OPCODES(RECORD_TABLE_ENTRY)
+#undef RECORD_TABLE_ENTRY
+  };
+  void** dispatch = dispatch_table;
+
 // Dispatch to the next instruction
 #ifdef DEBUG_TRACE_EXECUTION
 #define DISPATCH()              \
   debug_trace_execution(frame); \
-  goto* dispatch_table[READ_ONE()]
+  goto* dispatch[READ_ONE()]
 #else
-#define DISPATCH() goto* dispatch_table[READ_ONE()]
+#define DISPATCH() goto* dispatch[READ_ONE()]
 #endif
 
 // Read a single piece of data from the current instruction pointer and advance it
@@ -848,13 +1297,110 @@ static Value run() {
 // Read a string from the constant pool.
 #define READ_STRING() AS_STR(READ_CONSTANT())
 
-#define MAKE_OP(sp_name, op)                                                   \
-  Value left   = peek(1);                                                      \
-  Value result = vm_exec_callable(fn_value(left.type->PASTE(__, sp_name)), 1); \
-  if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                        \
-    goto FINISH_ERROR;                                                         \
-  }                                                                            \
-  vm_push(result);                                                             \
+// Read an inline cache of the current chunk. This consumes one piece of data on the stack, which is the index of the cache.
+#define READ_INLINE_CACHE() (&frame->closure->function->chunk.caches[READ_ONE()])
+
+#define MAKE_OP(sp_name, op)                                                          \
+  Value left   = peek(1);                                                             \
+  Value result = vm_exec_callable(fn_value(value_type(left)->PASTE(__, sp_name)), 1); \
+  if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                               \
+    goto FINISH_ERROR;                                                                \
+  }                                                                                   \
+  push(result);                                                                       \
+  DISPATCH();
+
+// Inline fast path for binary operations where both operands are a TYPENAME_INT or TYPENAME_FLOAT. Skips the call to the special
+// method, but must yield the exact same result as the natives in native_type_num.c. [int_wrap] wraps the result of an int-int
+// operation, [float_wrap] the result of any other combination. Falls through if the operands are not both numbers.
+#define MAKE_NUM_FAST_PATH(int_wrap, float_wrap, op)                             \
+  if (is_int(peek(0)) && is_int(peek(1))) {                                      \
+    Value result = int_wrap(AS_INT(peek(1)) op AS_INT(peek(0)));                 \
+    vm.stack_top--;                                                              \
+    vm.stack_top[-1] = result;                                                   \
+    DISPATCH();                                                                  \
+  }                                                                              \
+  if (is_num(peek(0)) && is_num(peek(1))) {                                      \
+    Value result = float_wrap(num_as_double(peek(1)) op num_as_double(peek(0))); \
+    vm.stack_top--;                                                              \
+    vm.stack_top[-1] = result;                                                   \
+    DISPATCH();                                                                  \
+  }
+
+// Rewrites the opcode of the currently executing instruction in place. [operand_count] is the number of operands that have
+// already been read from the instruction. Used to quicken generic opcodes into type-specialized variants and back.
+#define QUICKEN(opcode, operand_count) (frame->ip[-1 - (operand_count)] = (opcode))
+
+// Reverts a specialized instruction back into its generic form [generic] and re-executes it. Used when a guard of a
+// specialized opcode fails. [operand_count] is the number of operands that have already been read from the instruction.
+#define DEOPTIMIZE(generic, operand_count)     \
+  QUICKEN(PASTE(OP_, generic), operand_count); \
+  frame->ip -= operand_count;                  \
+  goto PASTE(DO_OP_, generic);
+
+// Quickens a generic binary number operation [name] into its TYPENAME_INT-TYPENAME_INT or TYPENAME_FLOAT-TYPENAME_FLOAT
+// variant, if the operands on the stack allow it. Mixed operands leave the instruction as is.
+#define QUICKEN_NUM_BINARY(name)                       \
+  if (is_int(peek(0)) && is_int(peek(1))) {            \
+    QUICKEN(PASTE(OP_, name##_INT_INT), 0);            \
+  } else if (is_float(peek(0)) && is_float(peek(1))) { \
+    QUICKEN(PASTE(OP_, name##_FLOAT_FLOAT), 0);        \
+  }
+
+// Body of a specialized binary number operation. Deoptimizes to [generic] if either operand is not of type [guard]. [as] unwraps
+// the payload of an operand.
+#define MAKE_QUICKENED_NUM_OP(generic, guard, wrap, as, op) \
+  if (!guard(peek(0)) || !guard(peek(1))) {                 \
+    DEOPTIMIZE(generic, 0)                                  \
+  }                                                         \
+  Value result = wrap(as(peek(1)) op as(peek(0)));          \
+  vm.stack_top--;                                           \
+  vm.stack_top[-1] = result;                                \
+  DISPATCH();
+
+// Body of a superinstruction which applies a binary number operation [op] to the local in [slot] and [operand] and stores the
+// result back into the local. Falls back to calling the special method [sp_name] on the local if either is not a number.
+#define MAKE_LOCAL_NUM_OP(slot, operand, sp_name, op)                                  \
+  Value local = frame->slots[slot];                                                    \
+  if (is_int(local) && is_int(operand)) {                                              \
+    frame->slots[slot] = int_value(AS_INT(local) op AS_INT(operand));                  \
+    DISPATCH();                                                                        \
+  }                                                                                    \
+  if (is_num(local) && is_num(operand)) {                                              \
+    frame->slots[slot] = float_value(num_as_double(local) op num_as_double(operand));  \
+    DISPATCH();                                                                        \
+  }                                                                                    \
+  push(local);                                                                         \
+  push(operand);                                                                       \
+  Value result = vm_exec_callable(fn_value(value_type(local)->PASTE(__, sp_name)), 1); \
+  if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                                \
+    goto FINISH_ERROR;                                                                 \
+  }                                                                                    \
+  frame->slots[slot] = result;                                                         \
+  DISPATCH();
+
+// Body of a fused compare-and-branch instruction. Pops the top two values, compares them with [op] (or the special method
+// [sp_name] if they are not both numbers) and jumps by the instructions' offset if the result is falsy.
+#define MAKE_COMPARE_JUMP(sp_name, op)                                                 \
+  uint16_t offset = READ_ONE();                                                        \
+  Value left      = peek(1);                                                           \
+  Value right     = peek(0);                                                           \
+  bool result;                                                                         \
+  if (is_int(left) && is_int(right)) {                                                 \
+    result = AS_INT(left) op AS_INT(right);                                            \
+    vm.stack_top -= 2;                                                                 \
+  } else if (is_num(left) && is_num(right)) {                                          \
+    result = num_as_double(left) op num_as_double(right);                              \
+    vm.stack_top -= 2;                                                                 \
+  } else {                                                                             \
+    Value value = vm_exec_callable(fn_value(value_type(left)->PASTE(__, sp_name)), 1); \
+    if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {                                              \
+      goto FINISH_ERROR;                                                               \
+    }                                                                                  \
+    result = !vm_is_falsey(value);                                                     \
+  }                                                                                    \
+  if (!result) {                                                                       \
+    frame->ip += offset;                                                               \
+  }                                                                                    \
   DISPATCH();
 
 #ifdef DEBUG_TRACE_EXECUTION
@@ -879,7 +1425,7 @@ static Value run() {
  */
 DO_OP_CONSTANT: {
   Value constant = READ_CONSTANT();
-  vm_push(constant);
+  push(constant);
   DISPATCH();
 }
 
@@ -889,7 +1435,7 @@ DO_OP_CONSTANT: {
  * @note synopsis: `OP_NIL`
  */
 DO_OP_NIL: {
-  vm_push(nil_value());
+  push(nil_value());
   DISPATCH();
 }
 
@@ -899,7 +1445,7 @@ DO_OP_NIL: {
  * @note synopsis: `OP_TRUE`
  */
 DO_OP_TRUE: {
-  vm_push(bool_value(true));
+  push(bool_value(true));
   DISPATCH();
 }
 
@@ -909,7 +1455,7 @@ DO_OP_TRUE: {
  * @note synopsis: `OP_FALSE`
  */
 DO_OP_FALSE: {
-  vm_push(bool_value(false));
+  push(bool_value(false));
   DISPATCH();
 }
 
@@ -930,7 +1476,25 @@ DO_OP_POP: {
  * @param index index into the vms' stack (0: top, 1: second from top, etc.)
  */
 DO_OP_DUPE: {
-  vm_push(peek(READ_ONE()));
+  push(peek(READ_ONE()));
+  DISPATCH();
+}
+
+/**
+ * Reuses the value of a common subexpression (see find_reuse) by duplicating it, skipping the code which would evaluate it
+ * again. Unless it's a bound method: Each property access creates a distinct one, so the expression is evaluated again.
+ * @note stack: `[...][a]...[b] -> [...][a]...[b][a]` (in case of any value but a bound method)
+ * @note synopsis: `OP_REUSE, index, offset`
+ * @param index index into the vms' stack (0: top, 1: second from top, etc.)
+ * @param offset offset to jump to, past the code of the expression (from the current ip)
+ */
+DO_OP_REUSE: {
+  Value value     = peek(READ_ONE());
+  uint16_t offset = READ_ONE();
+  if (!is_bound_method(value)) {
+    push(value);
+    frame->ip += offset;
+  }
   DISPATCH();
 }
 
@@ -942,28 +1506,27 @@ DO_OP_DUPE: {
  */
 DO_OP_GET_LOCAL: {
   uint16_t slot = READ_ONE();
-  vm_push(frame->slots[slot]);
+  push(frame->slots[slot]);
   DISPATCH();
 }
 
 /**
- * Gets a global variable and pushes it onto the stack.
+ * Gets a global variable and pushes it onto the stack. If the global is not defined (yet), the native with the same name is
+ * used - globals can shadow natives.
  * @note stack: `[...] -> [...][value]`
- * @note synopsis: `OP_GET_GLOBAL, str_index`
- * @param str_index index into constant pool to get the name, which is then used to get [value] from the globals hashtable (or
- * the natives lookup table - subject to change though)
+ * @note synopsis: `OP_GET_GLOBAL_SLOT, slot, str_index`
+ * @param slot index into the global slots of the current frames' module, resolved by the compiler
+ * @param str_index index into constant pool to get the name of the global, used for the natives lookup and error reporting
  */
-DO_OP_GET_GLOBAL: {
+DO_OP_GET_GLOBAL_SLOT: {
+  uint16_t slot   = READ_ONE();
   ObjString* name = READ_STRING();
-  Value value;
-  if (!hashtable_get_by_string(frame->globals, name, &value)) {
-    if (!hashtable_get_by_string(&vm.natives, name, &value)) {
-      INTERNAL_ERROR("This should have been caught in the resolver.");
-      vm_error("Undefined variable '%s'.", name->chars);
-      goto FINISH_ERROR;
-    }
+  Value value     = frame->globals->slots[slot];
+  if (is_empty_internal(value) && !hashtable_get_by_string(&vm.natives, name, &value)) {
+    vm_error("Undefined variable '%s'.", name->chars);
+    goto FINISH_ERROR;
   }
-  vm_push(value);
+  push(value);
   DISPATCH();
 }
 
@@ -975,19 +1538,23 @@ DO_OP_GET_GLOBAL: {
  */
 DO_OP_GET_UPVALUE: {
   uint16_t slot = READ_ONE();
-  vm_push(*frame->closure->upvalues[slot]->location);
+  push(*frame->closure->upvalues[slot]->location);
   DISPATCH();
 }
 
 /**
  * Defines the top value of the stack as a global variable and pops it.
  * @note stack: `[...][value] -> [...]`
- * @note synopsis: `OP_DEFINE_GLOBAL, str_index`
- * @param str_index index into constant pool to get the name, which is then used to set [value] in the globals hashtable.
+ * @note synopsis: `OP_DEFINE_GLOBAL_SLOT, slot, str_index`
+ * @param slot index into the global slots of the current frames' module, resolved by the compiler
+ * @param str_index index into constant pool to get the name of the global, used for error reporting
  */
-DO_OP_DEFINE_GLOBAL: {
+DO_OP_DEFINE_GLOBAL_SLOT: {
+  uint16_t slot   = READ_ONE();
   ObjString* name = READ_STRING();
-  if (!hashtable_set(frame->globals, str_value(name), peek(0))) {
+  bool defined                = !is_empty_internal(frame->globals->slots[slot]);
+  frame->globals->slots[slot] = peek(0);
+  if (defined) {
     vm_error("Variable '%s' is already defined.", name->chars);
     goto FINISH_ERROR;
   }
@@ -1010,20 +1577,18 @@ DO_OP_SET_LOCAL: {
 /**
  * Sets a global variable to the top value of the stack and leaves it.
  * @note stack: `[...][value] -> [...][value]`
- * @note synopsis: `OP_SET_GLOBAL, str_index`
- * @param str_index index into constant pool to get the name, which is then used to set [value] in the globals hashtable.
+ * @note synopsis: `OP_SET_GLOBAL_SLOT, slot, str_index`
+ * @param slot index into the global slots of the current frames' module, resolved by the compiler
+ * @param str_index index into constant pool to get the name of the global, used for error reporting
  */
-DO_OP_SET_GLOBAL: {
+DO_OP_SET_GLOBAL_SLOT: {
+  uint16_t slot   = READ_ONE();
   ObjString* name = READ_STRING();
-
-  if (hashtable_set(frame->globals, str_value(name),
-                    peek(0))) {  // peek, because assignment is an expression!
-    hashtable_delete(frame->globals, str_value(name));
-    INTERNAL_ERROR("This should have been caught in the resolver.");
+  if (is_empty_internal(frame->globals->slots[slot])) {
     vm_error("Undefined variable '%s'.", name->chars);
     goto FINISH_ERROR;
   }
-
+  frame->globals->slots[slot] = peek(0);  // peek, because assignment is an expression!
   DISPATCH();
 }
 
@@ -1049,10 +1614,34 @@ DO_OP_GET_SUBSCRIPT: {
   Value index    = peek(0);
   Value result;
 
-  if (receiver.type->__get_subs(receiver, index, &result)) {
+  if (is_seq(receiver) && is_int(index)) {
+    QUICKEN(OP_GET_SUBSCRIPT_SEQ_INT, 0);
+  }
+
+  if (value_type(receiver)->__get_subs(receiver, index, &result)) {
     vm_pop();
     vm_pop();
-    vm_push(result);
+    push(result);
+    DISPATCH();
+  }
+
+  goto FINISH_ERROR;  // False return value means it encountered an error
+}
+
+/**
+ * Gets a subscript from the top two values on the stack and pushes the result, or nil if the receiver is nil. Out-of-range
+ * indices and missing keys already yield nil. Used for `?.[]`.
+ * @note stack: `[...][receiver][index] -> [...][result]`
+ * @note synopsis: `OP_GET_SUBSCRIPT_SAFE`
+ */
+DO_OP_GET_SUBSCRIPT_SAFE: {
+  Value receiver = peek(1);
+  Value index    = peek(0);
+  Value result   = nil_value();
+
+  if (is_nil(receiver) || value_type(receiver)->__get_subs(receiver, index, &result)) {
+    vm.stack_top--;
+    vm.stack_top[-1] = result;
     DISPATCH();
   }
 
@@ -1069,11 +1658,11 @@ DO_OP_SET_SUBSCRIPT: {
   Value index    = peek(1);
   Value result   = peek(0);
 
-  if (receiver.type->__set_subs(receiver, index, result)) {
+  if (value_type(receiver)->__set_subs(receiver, index, result)) {
     vm_pop();
     vm_pop();
     vm_pop();
-    vm_push(result);  // Assignments are expressions
+    push(result);  // Assignments are expressions
     DISPATCH();
   }
 
@@ -1083,38 +1672,89 @@ DO_OP_SET_SUBSCRIPT: {
 /**
  * Gets a property from the top value on the stack and pushes the result. (Invokes `__get_prop` on the receiver)
  * @note stack: `[...][receiver] -> [...][result]`
- * @note synopsis: `OP_GET_PROPERTY, str_index`
+ * @note synopsis: `OP_GET_PROPERTY, str_index, cache_index`
  * @param str_index index into constant pool to get the name, which is then used to get [result] from the receiver.
+ * @param cache_index index into the chunks' inline caches
  */
 DO_OP_GET_PROPERTY: {
-  ObjString* name = READ_STRING();
-  Value receiver  = peek(0);
+  ObjString* name    = READ_STRING();
+  InlineCache* cache = READ_INLINE_CACHE();
+  Value receiver     = peek(0);
   Value result;
 
-  if (receiver.type->__get_prop(receiver, name, &result)) {
+  if (value_type(receiver)->__get_prop == vm.obj_class->__get_prop) {
+    QUICKEN(OP_GET_PROPERTY_OBJ, 2);
+    frame->ip -= 2;
+    goto DO_OP_GET_PROPERTY_OBJ;
+  }
+
+  if (get_property_cached(receiver, name, cache, &result)) {
     vm_pop();
-    vm_push(result);
+    push(result);
     DISPATCH();
   }
 
   goto FINISH_ERROR;  // False return value means it encountered an error
 }
 
+/**
+ * Gets a property from the top value on the stack and pushes the result, or nil if the receiver is nil or does not have the
+ * property. Fields of TYPENAME_OBJs and instances are looked up directly, so only missing ones go through `__get_prop`. Used for
+ * `?.`.
+ * @note stack: `[...][receiver] -> [...][result]`
+ * @note synopsis: `OP_GET_PROPERTY_SAFE, str_index, cache_index`
+ * @param str_index index into constant pool to get the name, which is then used to get [result] from the receiver.
+ * @param cache_index index into the chunks' inline caches
+ */
+DO_OP_GET_PROPERTY_SAFE: {
+  ObjString* name    = READ_STRING();
+  InlineCache* cache = READ_INLINE_CACHE();
+  Value receiver     = peek(0);
+  Value result       = nil_value();
+
+  if (is_nil(receiver)) {
+    DISPATCH();  // The receiver is the result
+  }
+
+  if (value_type(receiver)->__get_prop == vm.obj_class->__get_prop &&
+      get_field_cached(AS_OBJECT(receiver), name, cache, &result)) {
+    vm.stack_top[-1] = result;
+    DISPATCH();
+  }
+
+  if (!get_property_cached(receiver, name, cache, &result)) {
+    vm_clear_error();  // Clear the "Prop does not exist" error set by __get_prop
+    result = nil_value();
+  }
+  vm.stack_top[-1] = result;
+  DISPATCH();
+}
+
 /**
  * Sets a property on the 2nd-to-top value on the stack and leaves the result. (Invokes `__set_prop` on the receiver)
  * @note stack: `[...][receiver][value] -> [...][result]`
- * @note synopsis: `OP_SET_PROPERTY, str_index`
+ * @note synopsis: `OP_SET_PROPERTY, str_index, cache_index`
  * @param str_index index into constant pool to get the name, which is then used to set [value] in the receiver.
+ * @param cache_index index into the chunks' inline caches
  */
 DO_OP_SET_PROPERTY: {
-  ObjString* name = READ_STRING();
-  Value receiver  = peek(1);
-  Value result    = peek(0);
+  ObjString* name    = READ_STRING();
+  InlineCache* cache = READ_INLINE_CACHE();
+  Value receiver     = peek(1);
+  Value result       = peek(0);
+
+  // Fast path for TYPENAME_OBJs and instances, which always succeeds.
+  if (value_type(receiver)->__set_prop == vm.obj_class->__set_prop) {
+    set_field_cached(AS_OBJECT(receiver), name, result, cache);
+    vm.stack_top--;
+    vm.stack_top[-1] = result;  // Assignments are expressions
+    DISPATCH();
+  }
 
-  if (receiver.type->__set_prop(receiver, name, result)) {
+  if (value_type(receiver)->__set_prop(receiver, name, result)) {
     vm_pop();
     vm_pop();
-    vm_push(result);  // Assignments are expressions
+    push(result);  // Assignments are expressions
     DISPATCH();
   }
 
@@ -1137,7 +1777,7 @@ DO_OP_GET_BASE_METHOD: {
     goto FINISH_ERROR;
   }
   vm_pop();
-  vm_push(bound_method);
+  push(bound_method);
   DISPATCH();
 }
 
@@ -1148,13 +1788,13 @@ DO_OP_GET_BASE_METHOD: {
  */
 DO_OP_GET_SLICE: {
   // [receiver][start][end] is on the stack
-  ObjClass* type = peek(2).type;
+  ObjClass* type = value_type(peek(2));
   Value result   = vm_exec_callable(fn_value(type->__slice), 2);
   if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
     goto FINISH_ERROR;
   }
 
-  vm_push(result);
+  push(result);
 
   DISPATCH();
 }
@@ -1167,7 +1807,7 @@ DO_OP_GET_SLICE: {
 DO_OP_EQ: {
   Value right = vm_pop();
   Value left  = vm_pop();
-  vm_push(bool_value(left.type->__equals(left, right)));
+  push(bool_value(value_type(left)->__equals(left, right)));
   DISPATCH();
 }
 
@@ -1179,7 +1819,7 @@ DO_OP_EQ: {
 DO_OP_NEQ: {
   Value right = vm_pop();
   Value left  = vm_pop();
-  vm_push(bool_value(!left.type->__equals(left, right)));
+  push(bool_value(!value_type(left)->__equals(left, right)));
   DISPATCH();
 }
 
@@ -1188,63 +1828,115 @@ DO_OP_NEQ: {
  * @note stack: `[...][a][b] -> [...][result]`
  * @note synopsis: `OP_GT`
  */
-DO_OP_GT: { MAKE_OP(SP_METHOD_GT, >) }
+DO_OP_GT: {
+  QUICKEN_NUM_BINARY(GT)
+  MAKE_NUM_FAST_PATH(bool_value, bool_value, >)
+  MAKE_OP(SP_METHOD_GT, >)
+}
 
 /**
  * Compares the top two values on the stack for less-than and pushes the result.
  * @note stack: `[...][a][b] -> [...][result]`
  * @note synopsis: `OP_LT`
  */
-DO_OP_LT: { MAKE_OP(SP_METHOD_LT, <) }
+DO_OP_LT: {
+  QUICKEN_NUM_BINARY(LT)
+  MAKE_NUM_FAST_PATH(bool_value, bool_value, <)
+  MAKE_OP(SP_METHOD_LT, <)
+}
 
 /**
  * Compares the top two values on the stack for greater-than-or-equal and pushes the result.
  * @note stack: `[...][a][b] -> [...][result]`
  * @note synopsis: `OP_GTEQ`
  */
-DO_OP_GTEQ: { MAKE_OP(SP_METHOD_GTEQ, >=) }
+DO_OP_GTEQ: {
+  QUICKEN_NUM_BINARY(GTEQ)
+  MAKE_NUM_FAST_PATH(bool_value, bool_value, >=)
+  MAKE_OP(SP_METHOD_GTEQ, >=)
+}
 
 /**
  * Compares the top two values on the stack for less-than-or-equal and pushes the result.
  * @note stack: `[...][a][b] -> [...][result]`
  * @note synopsis: `OP_LTEQ`
  */
-DO_OP_LTEQ: { MAKE_OP(SP_METHOD_LTEQ, <=) }
+DO_OP_LTEQ: {
+  QUICKEN_NUM_BINARY(LTEQ)
+  MAKE_NUM_FAST_PATH(bool_value, bool_value, <=)
+  MAKE_OP(SP_METHOD_LTEQ, <=)
+}
 
 /**
  * Adds the top two values on the stack and pushes the result.
  * @note stack: `[...][a][b] -> [...][result]`
  * @note synopsis: `OP_ADD`
  */
-DO_OP_ADD: { MAKE_OP(SP_METHOD_ADD, +) }
+DO_OP_ADD: {
+  QUICKEN_NUM_BINARY(ADD)
+  MAKE_NUM_FAST_PATH(int_value, float_value, +)
+  MAKE_OP(SP_METHOD_ADD, +)
+}
 
 /**
  * Subtracts the top two values on the stack and pushes the result.
  * @note stack: `[...][a][b] -> [...][result]`
  * @note synopsis: `OP_SUBTRACT`
  */
-DO_OP_SUBTRACT: { MAKE_OP(SP_METHOD_SUB, -) }
+DO_OP_SUBTRACT: {
+  QUICKEN_NUM_BINARY(SUBTRACT)
+  MAKE_NUM_FAST_PATH(int_value, float_value, -)
+  MAKE_OP(SP_METHOD_SUB, -)
+}
 
 /**
  * Multiplies the top two values on the stack and pushes the result.
  * @note stack: `[...][a][b] -> [...][result]`
  * @note synopsis: `OP_MULTIPLY`
  */
-DO_OP_MULTIPLY: { MAKE_OP(SP_METHOD_MUL, *) }
+DO_OP_MULTIPLY: {
+  QUICKEN_NUM_BINARY(MULTIPLY)
+  MAKE_NUM_FAST_PATH(int_value, float_value, *)
+  MAKE_OP(SP_METHOD_MUL, *)
+}
 
 /**
  * Divides the top two values on the stack and pushes the result.
  * @note stack: `[...][a][b] -> [...][result]`
  * @note synopsis: `OP_DIVIDE`
  */
-DO_OP_DIVIDE: { MAKE_OP(SP_METHOD_DIV, /) }
+DO_OP_DIVIDE: {
+  // Division by zero is left to the native, which sets the error.
+  if (is_num(peek(1)) && is_nonzero_num(peek(0))) {
+    Value result = float_value(num_as_double(peek(1)) / num_as_double(peek(0)));
+    vm.stack_top--;
+    vm.stack_top[-1] = result;
+    DISPATCH();
+  }
+  MAKE_OP(SP_METHOD_DIV, /)
+}
 
 /**
  * Modulos the top two values on the stack and pushes the result.
  * @note stack: `[...][a][b] -> [...][result]`
  * @note synopsis: `OP_MODULO`
  */
-DO_OP_MODULO: { MAKE_OP(SP_METHOD_MOD, %) }
+DO_OP_MODULO: {
+  // Modulo by zero is left to the native, which sets the error.
+  if (is_int(peek(1)) && is_int(peek(0)) && AS_INT(peek(0)) != 0) {
+    Value result = int_value(AS_INT(peek(1)) % AS_INT(peek(0)));
+    vm.stack_top--;
+    vm.stack_top[-1] = result;
+    DISPATCH();
+  }
+  if (is_num(peek(1)) && is_nonzero_num(peek(0))) {
+    Value result = float_value(fmod(num_as_double(peek(1)), num_as_double(peek(0))));
+    vm.stack_top--;
+    vm.stack_top[-1] = result;
+    DISPATCH();
+  }
+  MAKE_OP(SP_METHOD_MOD, %)
+}
 
 /**
  * Checks if the top value on the stack is falsy and pushes the result.
@@ -1252,7 +1944,7 @@ DO_OP_MODULO: { MAKE_OP(SP_METHOD_MOD, %) }
  * @note synopsis: `OP_NOT`
  */
 DO_OP_NOT: {
-  vm_push(bool_value(vm_is_falsey(vm_pop())));
+  push(bool_value(vm_is_falsey(vm_pop())));
   DISPATCH();
 }
 
@@ -1263,11 +1955,11 @@ DO_OP_NOT: {
  */
 DO_OP_NEGATE: {
   if (is_int(peek(0))) {
-    vm_push(int_value(-((vm_pop()).as.integer)));
+    push(int_value(-(AS_INT(vm_pop()))));
   } else if (is_float(peek(0))) {
-    vm_push(float_value(-((vm_pop()).as.float_)));
+    push(float_value(-(AS_FLOAT(vm_pop()))));
   } else {
-    vm_error("Type for unary - must be a " STR(TYPENAME_NUM) ". Was %s.", peek(0).type->name->chars);
+    vm_error_lazy("Type for unary - must be a " STR(TYPENAME_NUM) ". Was %s.", 1, str_value(value_type(peek(0))->name));
     goto FINISH_ERROR;
   }
   DISPATCH();
@@ -1279,7 +1971,7 @@ DO_OP_NEGATE: {
  * @note synopsis: `OP_PRINT`
  */
 DO_OP_PRINT: {
-  ObjString* str = (ObjString*)vm_exec_callable(fn_value(peek(0).type->__to_str), 0).as.obj;
+  ObjString* str = (ObjString*)AS_OBJ(vm_exec_callable(fn_value(value_type(peek(0))->__to_str), 0));
   if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
     goto FINISH_ERROR;
   }
@@ -1314,22 +2006,36 @@ DO_OP_JUMP_IF_FALSE: {
 }
 
 /**
- * Pushes a handler-value onto the stack (Consists of try-target and the offset from the start of the callframe to the try
- * block).
- * @note stack: `[...] -> [...][handler]`
- * @note synopsis: `OP_TRY, try_target`
- * @param try_target try-target
+ * Jumps to the instruction at the given offset if the top value on the stack is truthy and leaves it. Only emitted by the peephole
+ * optimizer, in place of `OP_NOT` followed by `OP_JUMP_IF_FALSE`.
+ * @note stack: `[...][a] -> [...][a]`
+ * @note synopsis: `OP_JUMP_IF_TRUE, offset`
+ * @param offset offset to jump to (from the current ip)
  */
-DO_OP_TRY: {
-  uint16_t try_target = READ_ONE();
-  uint16_t offset     = frame->ip - frame->closure->function->chunk.code;  // Offset from start of callframe to the try block
-  Value handler       = handler_value(try_target + offset);
-  vm_push(handler);
+DO_OP_JUMP_IF_TRUE: {
+  uint16_t offset = READ_ONE();
+  if (!vm_is_falsey(peek(0))) {
+    frame->ip += offset;
+  }
   DISPATCH();
 }
 
 /**
- * Loops back to the instruction at the given offset (current ip - offset).
+ * Jumps to the instruction at the given offset if the top value on the stack is not nil and leaves it. Used for `??`.
+ * @note stack: `[...][a] -> [...][a]`
+ * @note synopsis: `OP_JUMP_IF_NOT_NIL, offset`
+ * @param offset offset to jump to (from the current ip)
+ */
+DO_OP_JUMP_IF_NOT_NIL: {
+  uint16_t offset = READ_ONE();
+  if (!is_nil(peek(0))) {
+    frame->ip += offset;
+  }
+  DISPATCH();
+}
+
+/**
+ * Loops back to the instruction at the given offset (current ip - offset).
  * @note stack: `[...] -> [...]`
  * @note synopsis: `OP_LOOP, offset`
  * @param offset offset to loop back to (from the current ip)
@@ -1337,6 +2043,13 @@ DO_OP_TRY: {
 DO_OP_LOOP: {
   uint16_t offset = READ_ONE();
   frame->ip -= offset;
+  if (vm.jit_loop_threshold > 0 && dispatch == dispatch_table) {
+    if (enter_loop(frame)) {
+      dispatch = record_table;
+    } else if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
+      goto FINISH_ERROR;  // Raised by a method the trace invoked, see vm_jit_invoke
+    }
+  }
   DISPATCH();
 }
 
@@ -1362,14 +2075,93 @@ DO_OP_CALL: {
  * Invokes the callable at the top of the stack with the given number of arguments.
  * @note stack: `[...][receiver][arg_0]...[arg_n] -> [...][result]` (in case of a native function)
  * @note stack: `[...][receiver][arg_0]...[arg_n] -> [...][receiver][arg_0][arg_1]...[arg_n]` (in case of a managed function)
- * @note synopsis: `OP_INVOKE, str_index, arg_count`
+ * @note synopsis: `OP_INVOKE, str_index, arg_count, cache_index`
  * @param str_index index into constant pool to get the name of the method to invoke
  * @param arg_count number of arguments to pass to the callable
+ * @param cache_index index into the chunks' inline caches
  */
 DO_OP_INVOKE: {
-  ObjString* method = READ_STRING();
+  ObjString* method  = READ_STRING();
+  int arg_count      = READ_ONE();
+  InlineCache* cache = READ_INLINE_CACHE();
+  bool failed        = invoke_cached(method, arg_count, cache) == CALL_FAILED;
+  if (failed || VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
+    goto FINISH_ERROR;
+  }
+
+  frame = current_frame();
+  DISPATCH();
+}
+
+/**
+ * Calls the callable at the top of the stack with the given number of arguments as a tail call. Always followed by an OP_RETURN.
+ * Works like OP_CALL, but if a new frame was pushed for the callee, it replaces the current frame instead of being stacked on top
+ * of it. The result of a call which returned immediately (e.g. of a native function) is left on the stack for the OP_RETURN.
+ * @note stack: `[...][callable][arg_0]...[arg_n] -> [...][result]` (in case of a native function)
+ * @note stack: `[slots...][callable][arg_0]...[arg_n] -> [callable][arg_0][arg_1]...[arg_n]` (in case of a managed function)
+ * @note synopsis: `OP_TAIL_CALL, arg_count`
+ * @param arg_count number of arguments to pass to the callable
+ */
+DO_OP_TAIL_CALL: {
   int arg_count     = READ_ONE();
-  bool failed       = invoke(NULL, method, arg_count) == CALL_FAILED;
+  CallResult result = call_value(peek(arg_count), arg_count);
+  if (result == CALL_FAILED || VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
+    goto FINISH_ERROR;
+  }
+
+  if (result == CALL_RUNNING) {
+    frame = collapse_tail_call(frame);
+  }
+  DISPATCH();
+}
+
+/**
+ * Invokes the callable at the top of the stack with the given number of arguments as a tail call. Always followed by an
+ * OP_RETURN. Works like OP_INVOKE, but if a new frame was pushed for the callee, it replaces the current frame instead of being
+ * stacked on top of it.
+ * @note stack: `[...][receiver][arg_0]...[arg_n] -> [...][result]` (in case of a native function)
+ * @note stack: `[slots...][receiver][arg_0]...[arg_n] -> [receiver][arg_0][arg_1]...[arg_n]` (in case of a managed function)
+ * @note synopsis: `OP_TAIL_INVOKE, str_index, arg_count, cache_index`
+ * @param str_index index into constant pool to get the name of the method to invoke
+ * @param arg_count number of arguments to pass to the callable
+ * @param cache_index index into the chunks' inline caches
+ */
+DO_OP_TAIL_INVOKE: {
+  ObjString* method  = READ_STRING();
+  int arg_count      = READ_ONE();
+  InlineCache* cache = READ_INLINE_CACHE();
+  CallResult result  = invoke_cached(method, arg_count, cache);
+  if (result == CALL_FAILED || VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
+    goto FINISH_ERROR;
+  }
+
+  if (result == CALL_RUNNING) {
+    frame = collapse_tail_call(frame);
+  }
+  DISPATCH();
+}
+
+/**
+ * Guards the inlined body of a function (see compile_inlined_call): Continues with it if the callee is a closure of that function.
+ * Otherwise, the callee has been reassigned since it was inlined - so it is called regularly and returns past the inlined body.
+ * @note stack: `[...][callee][arg_0]...[arg_n] -> [...][callee][arg_0]...[arg_n]` (in case of the inlined function)
+ * @note stack: `[...][callee][arg_0]...[arg_n] -> [...][result]` (otherwise, once the call returns)
+ * @note synopsis: `OP_CALL_INLINED, arg_count, fn_index, offset`
+ * @param arg_count number of arguments on top of the callee
+ * @param fn_index index into constant pool to get the inlined function
+ * @param offset offset to return to if the callee is not a closure of the inlined function (from the current ip)
+ */
+DO_OP_CALL_INLINED: {
+  int arg_count         = READ_ONE();
+  ObjFunction* function = AS_FUNCTION(READ_CONSTANT());
+  uint16_t offset       = READ_ONE();
+  Value callee          = peek(arg_count);
+  if (is_closure(callee) && AS_CLOSURE(callee)->function == function) {
+    DISPATCH();
+  }
+
+  frame->ip += offset;  // Before calling, because that's where the call returns to
+  bool failed = call_value(callee, arg_count) == CALL_FAILED;
   if (failed || VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
     goto FINISH_ERROR;
   }
@@ -1378,6 +2170,56 @@ DO_OP_INVOKE: {
   DISPATCH();
 }
 
+/**
+ * Guards the inlined body of a method (see compile_inlined_call): Continues with it if the call site's inline cache resolves the
+ * receiver's type to a closure of that method. Otherwise - the receiver is of another type, or its type has not been seen at this
+ * call site yet - the method is invoked regularly (see invoke_cached) and returns past the inlined body.
+ * @note stack: `[...][receiver][arg_0]...[arg_n] -> [...][receiver][arg_0]...[arg_n]` (in case of the inlined method)
+ * @note stack: `[...][receiver][arg_0]...[arg_n] -> [...][result]` (otherwise, once the invocation returns)
+ * @note synopsis: `OP_INVOKE_INLINED, str_index, arg_count, cache_index, fn_index, offset`
+ * @param str_index index into constant pool to get the name of the method to invoke
+ * @param arg_count number of arguments on top of the receiver
+ * @param cache_index index into the chunks' inline caches
+ * @param fn_index index into constant pool to get the inlined function
+ * @param offset offset to return to if the receiver's method is not the inlined one (from the current ip)
+ */
+DO_OP_INVOKE_INLINED: {
+  ObjString* method     = READ_STRING();
+  int arg_count         = READ_ONE();
+  InlineCache* cache    = READ_INLINE_CACHE();
+  ObjFunction* function = AS_FUNCTION(READ_CONSTANT());
+  uint16_t offset       = READ_ONE();
+  Obj* cached           = inline_cache_lookup(cache, value_type(peek(arg_count)));
+  if (cached != NULL && cached->type == OBJ_GC_CLOSURE && ((ObjClosure*)cached)->function == function) {
+    VM_COUNT_CACHE_STAT(invoke_cache_hits);
+    DISPATCH();
+  }
+
+  frame->ip += offset;  // Before invoking, because that's where the invocation returns to
+  bool failed = invoke_cached(method, arg_count, cache) == CALL_FAILED;
+  if (failed || VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
+    goto FINISH_ERROR;
+  }
+
+  frame = current_frame();
+  DISPATCH();
+}
+
+/**
+ * Ends an inlined body (see compile_inlined_call) by replacing the callee and its arguments with the result, just like returning
+ * from the function would.
+ * @note stack: `[...][callee][arg_0]...[arg_n][result] -> [...][result]`
+ * @note synopsis: `OP_RETURN_INLINED, arg_count`
+ * @param arg_count number of arguments on top of the callee
+ */
+DO_OP_RETURN_INLINED: {
+  int arg_count = READ_ONE();
+  Value result  = vm_pop();
+  vm.stack_top -= arg_count + 1;
+  vm_push(result);
+  DISPATCH();
+}
+
 /**
  * Invokes the callable at the top of the stack with the given number of arguments and the base class.
  * @note stack: `[...][receiver][arg_0]...[arg_n][base] -> [...][result]` (in case of a native function)
@@ -1400,7 +2242,8 @@ DO_OP_BASE_INVOKE: {
 }
 
 /**
- * Creates a closure from the function at the given index in the constant pool and pushes it.
+ * Creates a closure from the function at the given index in the constant pool and pushes it. Functions without upvalues share
+ * a single closure.
  * @note stack: `[...] -> [...][closure]`
  * @note synopsis: `OP_CLOSURE, fn_index, (is_local, index) * upvalue_count`
  * @param fn_index index into constant pool to get the function
@@ -1409,8 +2252,18 @@ DO_OP_BASE_INVOKE: {
  */
 DO_OP_CLOSURE: {
   ObjFunction* function = AS_FUNCTION(READ_CONSTANT());
-  ObjClosure* closure   = new_closure(function);
-  vm_push(fn_value((Obj*)closure));
+
+  // Without upvalues, every closure of the function would be the same - so it's created once and reused.
+  if (function->upvalue_count == 0) {
+    if (function->closure == NULL) {
+      function->closure = new_closure(function);
+    }
+    push(fn_value((Obj*)function->closure));
+    DISPATCH();
+  }
+
+  ObjClosure* closure = new_closure(function);
+  push(fn_value((Obj*)closure));
 
   // Bring closure to life
   for (int i = 0; i < closure->upvalue_count; i++) {
@@ -1489,8 +2342,11 @@ DO_OP_RETURN: {
   if (vm.exit_on_frame == vm.frame_count) {
     return result;
   }
-  vm_push(result);
+  push(result);
   frame = current_frame();
+  if (vm.jit_threshold > 0 && frame->closure->function->jit != NULL) {
+    frame->ip = jit_enter(frame->closure->function, frame->slots, frame->ip);  // Continue in the callers' machine code
+  }
   DISPATCH();
 }
 
@@ -1503,7 +2359,7 @@ DO_OP_RETURN: {
 DO_OP_CLASS: {
   // Initially, a class always vm_inherits from Obj
   ObjClass* klass = new_class(READ_STRING(), vm.obj_class);
-  vm_push(class_value(klass));
+  push(class_value(klass));
   hashtable_add_all(&klass->base->methods, &klass->methods);
   DISPATCH();
 }
@@ -1517,7 +2373,7 @@ DO_OP_INHERIT: {
   Value baseclass    = peek(1);
   ObjClass* subclass = AS_CLASS(peek(0));
   if (!is_class(baseclass)) {
-    vm_error("Base class must be a class. Was %s.", baseclass.type->name->chars);
+    vm_error("Base class must be a class. Was %s.", value_type(baseclass)->name->chars);
     goto FINISH_ERROR;
   }
   hashtable_add_all(&AS_CLASS(baseclass)->methods, &subclass->methods);
@@ -1590,7 +2446,8 @@ DO_OP_IMPORT_FROM: {
  * @note synopsis: `OP_THROW`
  */
 DO_OP_THROW: {
-  vm.current_error = vm_pop();
+  vm.lazy_error.format = NULL;
+  vm.current_error     = vm_pop();
   VM_SET_FLAG(VM_FLAG_HAS_ERROR);
   goto FINISH_ERROR;
 }
@@ -1608,17 +2465,17 @@ DO_OP_IS: {
   Value value    = vm_pop();
 
   if (!is_class(type)) {
-    vm_error("Type must be a class. Was %s.", type.type->name->chars);
+    vm_error("Type must be a class. Was %s.", value_type(type)->name->chars);
     goto FINISH_ERROR;
   }
 
-  ObjClass* value_klass = value.type;
+  ObjClass* value_klass = value_type(value);
   ObjClass* type_klass  = AS_CLASS(type);
 
   bool result      = vm_inherits(value_klass, type_klass);
-  bool is_instance = modifier.as.boolean;
+  bool is_instance = AS_BOOL(modifier);
 
-  vm_push(bool_value(result == is_instance));
+  push(bool_value(result == is_instance));
   DISPATCH();
 }
 
@@ -1634,28 +2491,687 @@ DO_OP_IN: {
   Value a        = vm_pop();
   Value b        = vm_pop();
 
-  vm_push(a);
-  vm_push(b);
+  push(a);
+  push(b);
   Value left   = peek(1);
-  Value result = vm_exec_callable(fn_value(left.type->__has), 1);
+  Value result = vm_exec_callable(fn_value(value_type(left)->__has), 1);
   if (VM_HAS_FLAG(VM_FLAG_HAS_ERROR)) {
     goto FINISH_ERROR;
   }
 
-  bool is_in = modifier.as.boolean;
+  bool is_in = AS_BOOL(modifier);
   // If is_in is true, we want to push result as is, otherwise we want to negate it, converting to boolean in the process
-  is_in ? vm_push(result) : vm_push(bool_value(vm_is_falsey(result)));
+  is_in ? push(result) : push(bool_value(vm_is_falsey(result)));
   DISPATCH();
 }
 
+/**
+ * Compares (greater-than) the top two values on the stack, which must both be of type TYPENAME_INT, and pushes the result. Quickened form of
+ * `OP_GT`, deoptimizes back to it if an operand is not of type TYPENAME_INT.
+ * @note stack: `[...][a][b] -> [...][result]`
+ * @note synopsis: `OP_GT_INT_INT`
+ */
+DO_OP_GT_INT_INT: {
+  MAKE_QUICKENED_NUM_OP(GT, is_int, bool_value, AS_INT, >)
+}
+
+/**
+ * Compares (greater-than) the top two values on the stack, which must both be of type TYPENAME_FLOAT, and pushes the result. Quickened form of
+ * `OP_GT`, deoptimizes back to it if an operand is not of type TYPENAME_FLOAT.
+ * @note stack: `[...][a][b] -> [...][result]`
+ * @note synopsis: `OP_GT_FLOAT_FLOAT`
+ */
+DO_OP_GT_FLOAT_FLOAT: {
+  MAKE_QUICKENED_NUM_OP(GT, is_float, bool_value, AS_FLOAT, >)
+}
+
+/**
+ * Compares (less-than) the top two values on the stack, which must both be of type TYPENAME_INT, and pushes the result. Quickened form of
+ * `OP_LT`, deoptimizes back to it if an operand is not of type TYPENAME_INT.
+ * @note stack: `[...][a][b] -> [...][result]`
+ * @note synopsis: `OP_LT_INT_INT`
+ */
+DO_OP_LT_INT_INT: {
+  MAKE_QUICKENED_NUM_OP(LT, is_int, bool_value, AS_INT, <)
+}
+
+/**
+ * Compares (less-than) the top two values on the stack, which must both be of type TYPENAME_FLOAT, and pushes the result. Quickened form of
+ * `OP_LT`, deoptimizes back to it if an operand is not of type TYPENAME_FLOAT.
+ * @note stack: `[...][a][b] -> [...][result]`
+ * @note synopsis: `OP_LT_FLOAT_FLOAT`
+ */
+DO_OP_LT_FLOAT_FLOAT: {
+  MAKE_QUICKENED_NUM_OP(LT, is_float, bool_value, AS_FLOAT, <)
+}
+
+/**
+ * Compares (greater-than-or-equal) the top two values on the stack, which must both be of type TYPENAME_INT, and pushes the result. Quickened form of
+ * `OP_GTEQ`, deoptimizes back to it if an operand is not of type TYPENAME_INT.
+ * @note stack: `[...][a][b] -> [...][result]`
+ * @note synopsis: `OP_GTEQ_INT_INT`
+ */
+DO_OP_GTEQ_INT_INT: {
+  MAKE_QUICKENED_NUM_OP(GTEQ, is_int, bool_value, AS_INT, >=)
+}
+
+/**
+ * Compares (greater-than-or-equal) the top two values on the stack, which must both be of type TYPENAME_FLOAT, and pushes the result. Quickened form of
+ * `OP_GTEQ`, deoptimizes back to it if an operand is not of type TYPENAME_FLOAT.
+ * @note stack: `[...][a][b] -> [...][result]`
+ * @note synopsis: `OP_GTEQ_FLOAT_FLOAT`
+ */
+DO_OP_GTEQ_FLOAT_FLOAT: {
+  MAKE_QUICKENED_NUM_OP(GTEQ, is_float, bool_value, AS_FLOAT, >=)
+}
+
+/**
+ * Compares (less-than-or-equal) the top two values on the stack, which must both be of type TYPENAME_INT, and pushes the result. Quickened form of
+ * `OP_LTEQ`, deoptimizes back to it if an operand is not of type TYPENAME_INT.
+ * @note stack: `[...][a][b] -> [...][result]`
+ * @note synopsis: `OP_LTEQ_INT_INT`
+ */
+DO_OP_LTEQ_INT_INT: {
+  MAKE_QUICKENED_NUM_OP(LTEQ, is_int, bool_value, AS_INT, <=)
+}
+
+/**
+ * Compares (less-than-or-equal) the top two values on the stack, which must both be of type TYPENAME_FLOAT, and pushes the result. Quickened form of
+ * `OP_LTEQ`, deoptimizes back to it if an operand is not of type TYPENAME_FLOAT.
+ * @note stack: `[...][a][b] -> [...][result]`
+ * @note synopsis: `OP_LTEQ_FLOAT_FLOAT`
+ */
+DO_OP_LTEQ_FLOAT_FLOAT: {
+  MAKE_QUICKENED_NUM_OP(LTEQ, is_float, bool_value, AS_FLOAT, <=)
+}
+
+/**
+ * Adds the top two values on the stack, which must both be of type TYPENAME_INT, and pushes the result. Quickened form of
+ * `OP_ADD`, deoptimizes back to it if an operand is not of type TYPENAME_INT.
+ * @note stack: `[...][a][b] -> [...][result]`
+ * @note synopsis: `OP_ADD_INT_INT`
+ */
+DO_OP_ADD_INT_INT: {
+  MAKE_QUICKENED_NUM_OP(ADD, is_int, int_value, AS_INT, +)
+}
+
+/**
+ * Adds the top two values on the stack, which must both be of type TYPENAME_FLOAT, and pushes the result. Quickened form of
+ * `OP_ADD`, deoptimizes back to it if an operand is not of type TYPENAME_FLOAT.
+ * @note stack: `[...][a][b] -> [...][result]`
+ * @note synopsis: `OP_ADD_FLOAT_FLOAT`
+ */
+DO_OP_ADD_FLOAT_FLOAT: {
+  MAKE_QUICKENED_NUM_OP(ADD, is_float, float_value, AS_FLOAT, +)
+}
+
+/**
+ * Subtracts the top two values on the stack, which must both be of type TYPENAME_INT, and pushes the result. Quickened form of
+ * `OP_SUBTRACT`, deoptimizes back to it if an operand is not of type TYPENAME_INT.
+ * @note stack: `[...][a][b] -> [...][result]`
+ * @note synopsis: `OP_SUBTRACT_INT_INT`
+ */
+DO_OP_SUBTRACT_INT_INT: {
+  MAKE_QUICKENED_NUM_OP(SUBTRACT, is_int, int_value, AS_INT, -)
+}
+
+/**
+ * Subtracts the top two values on the stack, which must both be of type TYPENAME_FLOAT, and pushes the result. Quickened form of
+ * `OP_SUBTRACT`, deoptimizes back to it if an operand is not of type TYPENAME_FLOAT.
+ * @note stack: `[...][a][b] -> [...][result]`
+ * @note synopsis: `OP_SUBTRACT_FLOAT_FLOAT`
+ */
+DO_OP_SUBTRACT_FLOAT_FLOAT: {
+  MAKE_QUICKENED_NUM_OP(SUBTRACT, is_float, float_value, AS_FLOAT, -)
+}
+
+/**
+ * Multiplies the top two values on the stack, which must both be of type TYPENAME_INT, and pushes the result. Quickened form of
+ * `OP_MULTIPLY`, deoptimizes back to it if an operand is not of type TYPENAME_INT.
+ * @note stack: `[...][a][b] -> [...][result]`
+ * @note synopsis: `OP_MULTIPLY_INT_INT`
+ */
+DO_OP_MULTIPLY_INT_INT: {
+  MAKE_QUICKENED_NUM_OP(MULTIPLY, is_int, int_value, AS_INT, *)
+}
+
+/**
+ * Multiplies the top two values on the stack, which must both be of type TYPENAME_FLOAT, and pushes the result. Quickened form of
+ * `OP_MULTIPLY`, deoptimizes back to it if an operand is not of type TYPENAME_FLOAT.
+ * @note stack: `[...][a][b] -> [...][result]`
+ * @note synopsis: `OP_MULTIPLY_FLOAT_FLOAT`
+ */
+DO_OP_MULTIPLY_FLOAT_FLOAT: {
+  MAKE_QUICKENED_NUM_OP(MULTIPLY, is_float, float_value, AS_FLOAT, *)
+}
+
+/**
+ * Gets a subscript from a TYPENAME_SEQ with a TYPENAME_INT index and pushes the result. Quickened form of `OP_GET_SUBSCRIPT`,
+ * deoptimizes back to it if the receiver is not a TYPENAME_SEQ or the index is not a TYPENAME_INT.
+ * @note stack: `[...][receiver][index] -> [...][result]`
+ * @note synopsis: `OP_GET_SUBSCRIPT_SEQ_INT`
+ */
+DO_OP_GET_SUBSCRIPT_SEQ_INT: {
+  if (!is_seq(peek(1)) || !is_int(peek(0))) {
+    DEOPTIMIZE(GET_SUBSCRIPT, 0)
+  }
+
+  ValueArray items = AS_SEQ(peek(1))->items;
+  long long idx    = AS_INT(peek(0));
+  if (idx >= 0 && idx < items.count) {
+    vm.stack_top--;
+    vm.stack_top[-1] = items.values[idx];
+    DISPATCH();
+  }
+
+  // Negative and out of bounds indices are left to the native.
+  Value result;
+  if (value_type(peek(1))->__get_subs(peek(1), peek(0), &result)) {
+    vm.stack_top--;
+    vm.stack_top[-1] = result;
+    DISPATCH();
+  }
+
+  goto FINISH_ERROR;  // False return value means it encountered an error
+}
+
+/**
+ * Gets a subscript from a TYPENAME_SEQ with a TYPENAME_INT index and pushes the result, without checking the bounds. Emitted by
+ * the compiler for `list[i]` in the body of a `for` loop whose condition is `i < list.len`, if it proved that neither the index
+ * nor the length of the seq can change in between. Deoptimizes to `OP_GET_SUBSCRIPT` if the receiver is not a TYPENAME_SEQ or
+ * the index is not a TYPENAME_INT.
+ * @note stack: `[...][receiver][index] -> [...][result]`
+ * @note synopsis: `OP_GET_SUBSCRIPT_IN_BOUNDS`
+ */
+DO_OP_GET_SUBSCRIPT_IN_BOUNDS: {
+  if (!is_seq(peek(1)) || !is_int(peek(0))) {
+    DEOPTIMIZE(GET_SUBSCRIPT, 0)
+  }
+
+  vm.stack_top--;
+  vm.stack_top[-1] = AS_SEQ(vm.stack_top[-1])->items.values[AS_INT(vm.stack_top[0])];
+  DISPATCH();
+}
+
+/**
+ * Gets a property from an TYPENAME_OBJ (or an instance) and pushes the result. Quickened form of `OP_GET_PROPERTY`, looks up
+ * the fields directly and only consults the inline cache (or `__get_prop`) if the field does not exist. Deoptimizes back to
+ * `OP_GET_PROPERTY` if the receiver does not use the `__get_prop` of TYPENAME_OBJ.
+ * @note stack: `[...][receiver] -> [...][result]`
+ * @note synopsis: `OP_GET_PROPERTY_OBJ, str_index, cache_index`
+ * @param str_index index into constant pool to get the name, which is then used to get [result] from the receiver.
+ * @param cache_index index into the chunks' inline caches
+ */
+DO_OP_GET_PROPERTY_OBJ: {
+  ObjString* name    = READ_STRING();
+  InlineCache* cache = READ_INLINE_CACHE();
+  Value receiver     = peek(0);
+  Value result;
+
+  if (value_type(receiver)->__get_prop != vm.obj_class->__get_prop) {
+    DEOPTIMIZE(GET_PROPERTY, 2)
+  }
+
+  if (get_field_cached(AS_OBJECT(receiver), name, cache, &result) || get_property_cached(receiver, name, cache, &result)) {
+    vm.stack_top[-1] = result;
+    DISPATCH();
+  }
+
+  goto FINISH_ERROR;  // False return value means it encountered an error
+}
+
+/**
+ * Gets two local variables and pushes them onto the stack. Superinstruction for two consecutive `OP_GET_LOCAL`s, e.g. the
+ * operands of a binary operation.
+ * @note stack: `[...] -> [...][value_a][value_b]`
+ * @note synopsis: `OP_GET_LOCAL_GET_LOCAL, slot_a, slot_b`
+ * @param slot_a index into the current frames' stack window of the first value
+ * @param slot_b index into the current frames' stack window of the second value
+ */
+DO_OP_GET_LOCAL_GET_LOCAL: {
+  uint16_t slot_a = READ_ONE();
+  uint16_t slot_b = READ_ONE();
+  vm.stack_top[0] = frame->slots[slot_a];
+  vm.stack_top[1] = frame->slots[slot_b];
+  vm.stack_top += 2;
+  DISPATCH();
+}
+
+/**
+ * Increments a local variable by one in place. Superinstruction for `++x` or `x++` whose result is discarded.
+ * @note stack: `[...] -> [...]`
+ * @note synopsis: `OP_INC_LOCAL, slot`
+ * @param slot index into the current frames' stack window (aka. slots)
+ */
+DO_OP_INC_LOCAL: {
+  uint16_t slot = READ_ONE();
+  Value one     = int_value(1);
+  MAKE_LOCAL_NUM_OP(slot, one, SP_METHOD_ADD, +)
+}
+
+/**
+ * Decrements a local variable by one in place. Superinstruction for `--x` or `x--` whose result is discarded.
+ * @note stack: `[...] -> [...]`
+ * @note synopsis: `OP_DEC_LOCAL, slot`
+ * @param slot index into the current frames' stack window (aka. slots)
+ */
+DO_OP_DEC_LOCAL: {
+  uint16_t slot = READ_ONE();
+  Value one     = int_value(1);
+  MAKE_LOCAL_NUM_OP(slot, one, SP_METHOD_SUB, -)
+}
+
+/**
+ * Adds a constant to a local variable in place. Superinstruction for `x += <number>` whose result is discarded.
+ * @note stack: `[...] -> [...]`
+ * @note synopsis: `OP_ADD_LOCAL_CONST, slot, index`
+ * @param slot index into the current frames' stack window (aka. slots)
+ * @param index index into the constant pool
+ */
+DO_OP_ADD_LOCAL_CONST: {
+  uint16_t slot  = READ_ONE();
+  Value constant = READ_CONSTANT();
+  MAKE_LOCAL_NUM_OP(slot, constant, SP_METHOD_ADD, +)
+}
+
+/**
+ * Returns a local variable from the current function. Superinstruction for `OP_GET_LOCAL` followed by `OP_RETURN`.
+ * @note stack: `[...] -> [...]`
+ * @note synopsis: `OP_RETURN_LOCAL, slot`
+ * @param slot index into the current frames' stack window (aka. slots)
+ */
+DO_OP_RETURN_LOCAL: {
+  uint16_t slot = READ_ONE();
+  push(frame->slots[slot]);
+  goto DO_OP_RETURN;
+}
+
+/**
+ * Returns nil from the current function. Superinstruction for `OP_NIL` followed by `OP_RETURN`.
+ * @note stack: `[...] -> [...]`
+ * @note synopsis: `OP_RETURN_NIL`
+ */
+DO_OP_RETURN_NIL: {
+  push(nil_value());
+  goto DO_OP_RETURN;
+}
+
+/**
+ * Compares the top two values on the stack for equality, pops them and jumps if they are not equal. Fused form of `OP_EQ`,
+ * `OP_JUMP_IF_FALSE` and `OP_POP`. (Invokes `__equals` on the values)
+ * @note stack: `[...][a][b] -> [...]`
+ * @note synopsis: `OP_EQ_JUMP_IF_FALSE, offset`
+ * @param offset offset to jump to (from the current ip)
+ */
+DO_OP_EQ_JUMP_IF_FALSE: {
+  uint16_t offset = READ_ONE();
+  Value right     = vm_pop();
+  Value left      = vm_pop();
+  if (!value_type(left)->__equals(left, right)) {
+    frame->ip += offset;
+  }
+  DISPATCH();
+}
+
+/**
+ * Compares the top two values on the stack for inequality, pops them and jumps if they are equal. Fused form of `OP_NEQ`,
+ * `OP_JUMP_IF_FALSE` and `OP_POP`. (Invokes `__equals` on the values)
+ * @note stack: `[...][a][b] -> [...]`
+ * @note synopsis: `OP_NEQ_JUMP_IF_FALSE, offset`
+ * @param offset offset to jump to (from the current ip)
+ */
+DO_OP_NEQ_JUMP_IF_FALSE: {
+  uint16_t offset = READ_ONE();
+  Value right     = vm_pop();
+  Value left      = vm_pop();
+  if (value_type(left)->__equals(left, right)) {
+    frame->ip += offset;
+  }
+  DISPATCH();
+}
+
+/**
+ * Compares the top two values on the stack for greater-than, pops them and jumps if the result is falsy. Fused form of
+ * `OP_GT`, `OP_JUMP_IF_FALSE` and `OP_POP`.
+ * @note stack: `[...][a][b] -> [...]`
+ * @note synopsis: `OP_GT_JUMP_IF_FALSE, offset`
+ * @param offset offset to jump to (from the current ip)
+ */
+DO_OP_GT_JUMP_IF_FALSE: {
+  MAKE_COMPARE_JUMP(SP_METHOD_GT, >)
+}
+
+/**
+ * Compares the top two values on the stack for less-than, pops them and jumps if the result is falsy. Fused form of `OP_LT`,
+ * `OP_JUMP_IF_FALSE` and `OP_POP`.
+ * @note stack: `[...][a][b] -> [...]`
+ * @note synopsis: `OP_LT_JUMP_IF_FALSE, offset`
+ * @param offset offset to jump to (from the current ip)
+ */
+DO_OP_LT_JUMP_IF_FALSE: {
+  MAKE_COMPARE_JUMP(SP_METHOD_LT, <)
+}
+
+/**
+ * Compares the top two values on the stack for greater-than-or-equal, pops them and jumps if the result is falsy. Fused form
+ * of `OP_GTEQ`, `OP_JUMP_IF_FALSE` and `OP_POP`.
+ * @note stack: `[...][a][b] -> [...]`
+ * @note synopsis: `OP_GTEQ_JUMP_IF_FALSE, offset`
+ * @param offset offset to jump to (from the current ip)
+ */
+DO_OP_GTEQ_JUMP_IF_FALSE: {
+  MAKE_COMPARE_JUMP(SP_METHOD_GTEQ, >=)
+}
+
+/**
+ * Compares the top two values on the stack for less-than-or-equal, pops them and jumps if the result is falsy. Fused form of
+ * `OP_LTEQ`, `OP_JUMP_IF_FALSE` and `OP_POP`.
+ * @note stack: `[...][a][b] -> [...]`
+ * @note synopsis: `OP_LTEQ_JUMP_IF_FALSE, offset`
+ * @param offset offset to jump to (from the current ip)
+ */
+DO_OP_LTEQ_JUMP_IF_FALSE: {
+  MAKE_COMPARE_JUMP(SP_METHOD_LTEQ, <=)
+}
+
+/**
+ * Compares a value with the length of a receiver, pops both and jumps if the value is not less than it. Fused form of
+ * `OP_GET_PROPERTY` for `len` and `OP_LT_JUMP_IF_FALSE`, used for loop conditions like `i < list.len`. A TYPENAME_INT is compared
+ * with the item count of a TYPENAME_SEQ or TYPENAME_TUPLE directly, anything else gets the property through `__get_prop` and
+ * continues as `OP_LT_JUMP_IF_FALSE`.
+ * @note stack: `[...][a][receiver] -> [...]`
+ * @note synopsis: `OP_LT_LEN_JUMP_IF_FALSE, offset`
+ * @param offset offset to jump to (from the current ip)
+ */
+DO_OP_LT_LEN_JUMP_IF_FALSE: {
+  Value receiver = peek(0);
+  if (is_int(peek(1)) && (is_seq(receiver) || is_tuple(receiver))) {
+    uint16_t offset = READ_ONE();
+    int count       = is_seq(receiver) ? AS_SEQ(receiver)->items.count : AS_TUPLE(receiver)->items.count;
+    if (!(AS_INT(peek(1)) < count)) {
+      frame->ip += offset;
+    }
+    vm.stack_top -= 2;
+    DISPATCH();
+  }
+
+  Value length;
+  if (!value_type(receiver)->__get_prop(receiver, vm.special_prop_names[SPECIAL_PROP_LEN], &length)) {
+    goto FINISH_ERROR;  // False return value means it encountered an error
+  }
+  vm.stack_top[-1] = length;
+  goto DO_OP_LT_JUMP_IF_FALSE;
+}
+
+/**
+ * Starts a higher-order method call on a Seq or Tuple which the compiler lowered into a loop. Jumps to the regular invocation if
+ * the receiver is neither a Seq nor a Tuple - the methods of builtin classes can't be redefined, so that's all it takes to know
+ * that the builtin method would be called. Otherwise, pushes the state of the loop: The accumulator (for a fold, that's the
+ * initial value, which is already on the stack), the number of items to visit and the index of the current item.
+ * @note stack: `[...][receiver] -> [...][receiver][acc][count][index]`
+ * @note stack: `[...][receiver][initial] -> [...][receiver][acc][count][index]` (in case of a fold)
+ * @note synopsis: `OP_SEQ_LOOP_ENTER, kind, offset`
+ * @param kind the SeqLoopKind of the method
+ * @param offset offset to jump to if the receiver is not a Seq or Tuple (from the current ip)
+ */
+DO_OP_SEQ_LOOP_ENTER: {
+  SeqLoopKind kind = (SeqLoopKind)READ_ONE();
+  uint16_t offset  = READ_ONE();
+  Value receiver   = peek(kind == SEQ_LOOP_FOLD ? 1 : 0);
+  if (!is_seq(receiver) && !is_tuple(receiver)) {
+    frame->ip += offset;
+    DISPATCH();
+  }
+
+  int count = is_seq(receiver) ? AS_SEQ(receiver)->items.count : AS_TUPLE(receiver)->items.count;
+  switch (kind) {
+    case SEQ_LOOP_EACH: push(nil_value()); break;
+    case SEQ_LOOP_MAP: {
+      ValueArray mapped = value_array_init_of_size(count);
+      push(seq_value(take_seq(&mapped)));
+      break;
+    }
+    case SEQ_LOOP_SIFT: push(seq_value(new_seq())); break;
+    case SEQ_LOOP_FOLD: break;
+    case SEQ_LOOP_EVERY: push(bool_value(true)); break;
+    case SEQ_LOOP_SOME: push(bool_value(false)); break;
+  }
+  push(int_value(count));
+  push(int_value(0));
+  DISPATCH();
+}
+
+/**
+ * Advances a lowered higher-order method call to the next item. Jumps out of the loop if all items have been visited. Otherwise,
+ * pushes the arguments of the inlined function literal, as indicated by [args].
+ * @note stack: `[...] -> [...][acc][item][index]` (depending on [args])
+ * @note synopsis: `OP_SEQ_LOOP_NEXT, slot, args, offset`
+ * @param slot index into the current frames' stack window (aka. slots), where the receiver of the loop is stored
+ * @param args combination of the SEQ_LOOP_PUSH_* flags
+ * @param offset offset to jump to if all items have been visited (from the current ip)
+ */
+DO_OP_SEQ_LOOP_NEXT: {
+  Value* loop     = frame->slots + READ_ONE();  // [receiver][acc][count][index]
+  uint16_t args   = READ_ONE();
+  uint16_t offset = READ_ONE();
+
+  ValueArray items = is_seq(loop[0]) ? AS_SEQ(loop[0])->items : AS_TUPLE(loop[0])->items;
+  long long index  = AS_INT(loop[3]);
+  if (index >= AS_INT(loop[2]) || index >= items.count) {
+    frame->ip += offset;
+    DISPATCH();
+  }
+
+  if (args & SEQ_LOOP_PUSH_ACC) {
+    push(loop[1]);
+  }
+  if (args & SEQ_LOOP_PUSH_ITEM) {
+    push(items.values[index]);
+  }
+  if (args & SEQ_LOOP_PUSH_INDEX) {
+    push(loop[3]);
+  }
+  DISPATCH();
+}
+
+/**
+ * Consumes the result of the inlined function literal of a lowered higher-order method call for the current item. Stops the loop
+ * early once the result of an every or some call is known.
+ * @note stack: `[...][result] -> [...]`
+ * @note synopsis: `OP_SEQ_LOOP_STEP, kind, slot`
+ * @param kind the SeqLoopKind of the method
+ * @param slot index into the current frames' stack window (aka. slots), where the receiver of the loop is stored
+ */
+DO_OP_SEQ_LOOP_STEP: {
+  SeqLoopKind kind = (SeqLoopKind)READ_ONE();
+  Value* loop      = frame->slots + READ_ONE();  // [receiver][acc][count][index]
+  Value result     = peek(0);                    // Stays on the stack until we're done, in case appending triggers a GC.
+
+  // We don't use vm_is_falsey here, because - just like the natives - we want to check for a boolean value.
+  bool is_true = is_bool(result) && AS_BOOL(result);
+  switch (kind) {
+    case SEQ_LOOP_EACH: break;
+    case SEQ_LOOP_MAP: value_array_write(&AS_SEQ(loop[1])->items, result); break;
+    case SEQ_LOOP_SIFT: {
+      ValueArray items = is_seq(loop[0]) ? AS_SEQ(loop[0])->items : AS_TUPLE(loop[0])->items;
+      long long index  = AS_INT(loop[3]);
+      if (is_true && index < items.count) {
+        value_array_write(&AS_SEQ(loop[1])->items, items.values[index]);
+      }
+      break;
+    }
+    case SEQ_LOOP_FOLD: loop[1] = result; break;
+    case SEQ_LOOP_EVERY:
+    case SEQ_LOOP_SOME: {
+      if (is_true == (kind == SEQ_LOOP_SOME)) {
+        loop[1] = bool_value(is_true);
+        loop[3] = loop[2];  // Done, skip the remaining items.
+      }
+      break;
+    }
+  }
+
+  vm.stack_top--;
+  DISPATCH();
+}
+
+/**
+ * Finishes a lowered higher-order method call. Replaces the state of the loop with the result of the call, converting it to a
+ * tuple if the receiver is a Tuple.
+ * @note stack: `[...][receiver][acc][count][index] -> [...][result]`
+ * @note synopsis: `OP_SEQ_LOOP_END, kind`
+ * @param kind the SeqLoopKind of the method
+ */
+DO_OP_SEQ_LOOP_END: {
+  SeqLoopKind kind = (SeqLoopKind)READ_ONE();
+  Value result     = peek(2);
+  if ((kind == SEQ_LOOP_MAP || kind == SEQ_LOOP_SIFT) && is_tuple(peek(3))) {
+    // Copy, because the items must stay reachable through the seq, in case creating the tuple triggers a GC.
+    ValueArray items = AS_SEQ(result)->items;
+    ValueArray tuple = value_array_init_of_size(items.count);
+    if (items.count > 0) {
+      memcpy(tuple.values, items.values, sizeof(Value) * (size_t)items.count);  // The values of an empty seq are NULL
+    }
+    tuple.count = items.count;
+    result      = tuple_value(take_tuple(&tuple));
+  }
+
+  vm.stack_top -= 3;
+  vm.stack_top[-1] = result;
+  DISPATCH();
+}
+
+/**
+ * Starts a for-in loop over the iterable on top of the stack by pushing the index of the next item, 0. Only TYPENAME_SEQ,
+ * TYPENAME_TUPLE, TYPENAME_STRING, TYPENAME_OBJ and instances are iterable.
+ * @note stack: `[...][iterable] -> [...][iterable][index]`
+ * @note synopsis: `OP_FOR_IN_INIT`
+ */
+DO_OP_FOR_IN_INIT: {
+  Value iterable = peek(0);
+  if (!is_seq(iterable) && !is_tuple(iterable) && !is_str(iterable) && !is_obj(iterable) && !is_instance(iterable)) {
+    vm_error_lazy("Type %s is not iterable.", 1, str_value(value_type(iterable)->name));
+    goto FINISH_ERROR;
+  }
+  push(int_value(0));
+  DISPATCH();
+}
+
+/**
+ * Advances a for-in loop. Pushes the loop variables for the next item and advances the index - or jumps out of the loop if there
+ * are no more items. The items are read straight from the storage of the iterable, so nothing is allocated (except for the
+ * single-char strings of a TYPENAME_STRING). The length is checked on every iteration, since the body might modify the iterable.
+ * A TYPENAME_SEQ or TYPENAME_TUPLE pushes the item, or the index and the item. A TYPENAME_STRING pushes the char, or the index and
+ * the char. A TYPENAME_OBJ or an instance pushes the key, or the key and the value of its fields.
+ * @note stack: `[...] -> [...][item]` or `[...] -> [...][index|key][item|value]`
+ * @note synopsis: `OP_FOR_IN_NEXT, slot, vars, offset`
+ * @param slot index into the current frames' stack window (aka. slots), where the iterable of the loop is stored
+ * @param vars number of loop variables, 1 or 2
+ * @param offset offset to jump to if there are no more items (from the current ip)
+ */
+DO_OP_FOR_IN_NEXT: {
+  Value* loop     = frame->slots + READ_ONE();  // [iterable][index]
+  uint16_t vars   = READ_ONE();
+  uint16_t offset = READ_ONE();
+
+  long long index = AS_INT(loop[1]);
+  if (!is_seq(loop[0]) && !is_tuple(loop[0]) && !is_str(loop[0])) {  // A TYPENAME_OBJ or an instance, see OP_FOR_IN_INIT
+    int field = (int)index;
+    Value key;
+    Value value;
+    if (!object_next_field(AS_OBJECT(loop[0]), &field, &key, &value)) {
+      frame->ip += offset;
+      DISPATCH();
+    }
+    loop[1] = int_value(field);
+    push(key);
+    if (vars > 1) {
+      push(value);
+    }
+    DISPATCH();
+  }
+
+  Value item;
+  if (is_str(loop[0])) {
+    ObjString* str = AS_STR(loop[0]);
+    if (index >= str->length) {
+      frame->ip += offset;
+      DISPATCH();
+    }
+    item = str_value(copy_string(str->chars + index, 1));
+  } else {
+    ValueArray items = is_seq(loop[0]) ? AS_SEQ(loop[0])->items : AS_TUPLE(loop[0])->items;
+    if (index >= items.count) {
+      frame->ip += offset;
+      DISPATCH();
+    }
+    item = items.values[index];
+  }
+
+  if (vars > 1) {
+    push(loop[1]);
+  }
+  push(item);
+  loop[1] = int_value(index + 1);
+  DISPATCH();
+}
+
+/**
+ * Starts a for-in loop over a range of TYPENAME_INTs. The bounds stay on the stack, the lower one becomes the next value of the
+ * loop. Nothing is allocated.
+ * @note stack: `[...][start][end] -> [...][start][end]`
+ * @note synopsis: `OP_FOR_RANGE_INIT`
+ */
+DO_OP_FOR_RANGE_INIT: {
+  if (!is_int(peek(1)) || !is_int(peek(0))) {
+    vm_error("Bounds of a range must be " STR(TYPENAME_INT) "s. Was %s and %s.", value_type(peek(1))->name->chars,
+             value_type(peek(0))->name->chars);
+    goto FINISH_ERROR;
+  }
+  DISPATCH();
+}
+
+/**
+ * Advances a for-in loop over a range of TYPENAME_INTs. Pushes the next value and increments it - or jumps out of the loop if it
+ * reached the (exclusive) upper bound.
+ * @note stack: `[...] -> [...][value]`
+ * @note synopsis: `OP_FOR_RANGE_NEXT, slot, offset`
+ * @param slot index into the current frames' stack window (aka. slots), where the next value of the loop is stored, followed by
+ * the upper bound
+ * @param offset offset to jump to if the range is exhausted (from the current ip)
+ */
+DO_OP_FOR_RANGE_NEXT: {
+  Value* loop     = frame->slots + READ_ONE();  // [next][end]
+  uint16_t offset = READ_ONE();
+
+  long long next = AS_INT(loop[0]);
+  if (next >= AS_INT(loop[1])) {
+    frame->ip += offset;
+    DISPATCH();
+  }
+  push(loop[0]);
+  loop[0] = int_value(next + 1);
+  DISPATCH();
+}
+
+/**
+ * Records the instruction the interpreter is about to execute while a loop is recorded, and then executes it. Not an opcode, but
+ * the target of every entry in the record table.
+ */
+DO_RECORD: {
+  frame->ip--;  // Un-read the opcode
+  if (!jit_record(frame->closure->function, frame->slots, frame->ip)) {
+    dispatch = dispatch_table;
+  }
+  goto* dispatch_table[READ_ONE()];
+}
+
 FINISH_ERROR: {
   if (handle_runtime_error()) {
-    frame     = current_frame();                                            // Get the current frame
-    frame->ip = frame->closure->function->chunk.code + peek(0).as.handler;  // Jump to the handler
+    frame = current_frame();  // The frame of the handler, which already points to it.
 
-    // Remove the handler from the stack and push the error value
-    vm_pop();
-    vm_push(vm.current_error);
+    // The stack has been cut back to the depth of the try, push the error value
+    push(vm.current_error);
 
     // We're done with the error, so we can clear it
     vm.current_error = nil_value();
@@ -1672,8 +3188,16 @@ FINISH_ERROR: {
 #undef READ_ONE
 #undef READ_CONSTANT
 #undef READ_STRING
+#undef READ_INLINE_CACHE
 
 #undef MAKE_OP
+#undef MAKE_NUM_FAST_PATH
+#undef QUICKEN
+#undef DEOPTIMIZE
+#undef QUICKEN_NUM_BINARY
+#undef MAKE_QUICKENED_NUM_OP
+#undef MAKE_LOCAL_NUM_OP
+#undef MAKE_COMPARE_JUMP
 }
 
 ObjObject* vm_make_module(const char* source_path, const char* module_name) {
@@ -1685,14 +3209,14 @@ ObjObject* vm_make_module(const char* source_path, const char* module_name) {
   vm.module = module;
 
   // Add a reference to the module name, mostly used for stack traces
-  define_value(&module->fields, STR(SP_PROP_MODULE_NAME), str_value(copy_string(module_name, (int)strlen(module_name))));
+  define_module_value(module, STR(SP_PROP_MODULE_NAME), str_value(copy_string(module_name, (int)strlen(module_name))));
 
   // Add a reference to the file path of the module, if available
   if (source_path == NULL) {
-    hashtable_set(&module->fields, str_value(vm.special_prop_names[SPECIAL_PROP_FILE_PATH]), nil_value());
+    object_set_field(module, str_value(vm.special_prop_names[SPECIAL_PROP_FILE_PATH]), nil_value());
   } else {
     char* base_dir_path = file_base(source_path);
-    define_value(&module->fields, STR(SP_PROP_FILE_PATH), str_value(copy_string(base_dir_path, (int)strlen(base_dir_path))));
+    define_module_value(module, STR(SP_PROP_FILE_PATH), str_value(copy_string(base_dir_path, (int)strlen(base_dir_path))));
     free(base_dir_path);
   }
 
@@ -1730,7 +3254,7 @@ SlangExitCode vm_interpret(const char* source, ObjString* name, bool disable_war
   }
 
   // Resolve
-  bool resolved = resolve(ast, &vm.module->fields, &vm.natives, disable_warnings);
+  bool resolved = resolve(ast, vm.module, &vm.natives, disable_warnings);
   if (!resolved) {
     ast_free((AstNode*)ast);
     return SLANG_EXIT_COMPILE_ERROR;
@@ -1,6 +1,7 @@
 #ifndef vm_h
 #define vm_h
 
+#include <limits.h>
 #include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -10,8 +11,10 @@
 #include "object.h"
 #include "value.h"
 
-#define FRAMES_MAX 128
-#define STACK_MAX (FRAMES_MAX * UINT8_COUNT)
+#define STACK_INITIAL_CAPACITY (8 * UINT8_COUNT)  // Initial number of values the stack can hold before it grows.
+#define STACK_MAX_CAPACITY (INT_MAX / 2)         // Most values the stack can hold. Making room for more is a stack overflow.
+#define FRAMES_MAX_DEFAULT 128                   // Default maximum call stack depth. See vm_set_max_depth.
+#define FRAMES_MAX_LIMIT (INT_MAX / UINT8_COUNT)  // Upper bound for the maximum call stack depth.
 
 #define KEYWORD_THIS "this"
 #define KEYWORD_BASE "base"
@@ -42,9 +45,18 @@ typedef struct {
   ObjClosure* closure;
   uint16_t* ip;
   Value* slots;
-  HashTable* globals;  // Global variables
+  ObjObject* globals;  // Module which holds the global variables
 } CallFrame;
 
+// A callable prepared for repeated calls from native code, e.g. by the higher-order functions of Seq and Tuple which call it once
+// per item. See vm_callback_init.
+typedef struct VmCallback {
+  Value callable;       // The callable, as passed to vm_callback_init.
+  ObjClosure* closure;  // The closure to run directly. NULL if the callable is not managed code, see vm_callback_call.
+  Value receiver;       // Value for slot 0 of the callee's frame: The callable itself, or the receiver of a bound method.
+  int arg_count;        // Number of arguments passed on each call.
+} VmCallback;
+
 typedef enum {
   // Methods that are commonly used in the VM and need to be accessed quickly.
   SPECIAL_METHOD_CTOR,
@@ -73,16 +85,34 @@ typedef enum {
   SPECIAL_PROP_MAX,
 } SpecialPropNames;
 
+#define LAZY_ERROR_ARGS_MAX 3  // Maximum number of operands of a lazy error.
+
+// An error whose message has not been formatted yet - see vm_error_lazy. Errors are often caught and discarded right away (e.g.
+// `try grid[y][x] else nil`), so formatting their message and allocating a string for it is deferred until it is observed.
+typedef struct {
+  const char* format;               // Format of the message. NULL if there's no pending lazy error.
+  int count;                        // Number of [args].
+  Value args[LAZY_ERROR_ARGS_MAX];  // Operands of the message.
+} LazyError;
+
 // The virtual machine.
 // Contains all the state the Vm requires to execute code.
 typedef struct {
-  CallFrame frames[FRAMES_MAX];
+  CallFrame* frames;  // Call frames. Allocated for [frames_max] frames, so pointers to frames stay valid.
   int frame_count;
+  int frames_max;  // Maximum call stack depth.
+
+  int jit_threshold;       // Number of calls after which a function is compiled to machine code. 0 if the JIT is disabled.
+  int jit_loop_threshold;  // Number of iterations after which a loop is recorded and compiled. 0 if the JIT is disabled.
 
   Chunk* chunk;
-  uint16_t* ip;  // Instruction pointer, points to the NEXT instruction to execute
-  Value stack[STACK_MAX];
-  Value* stack_top;  // Stack pointer
+  uint16_t* ip;        // Instruction pointer, points to the NEXT instruction to execute
+  Value* stack;        // The value stack. Grows on demand, which moves it - see vm_push.
+  Value* stack_top;    // Stack pointer
+  int stack_capacity;  // Number of values the stack can hold before it needs to grow.
+
+  Value** retired_stacks;   // Stacks which were replaced by a grown one. Natives might still hold pointers (argv) into them.
+  int retired_stack_count;  // Number of retired stacks.
 
   HashTable modules;  // Modules
   HashTable strings;  // Interned strings
@@ -97,6 +127,7 @@ typedef struct {
   ObjObject* module;  // The current module
   int exit_on_frame;  // Index of the frame to exit on
   Value current_error;
+  LazyError lazy_error;  // Pending error, which becomes [current_error] once it's observed.
   int flags;
 
   ObjClass* obj_class;    // Base class: The obj class
@@ -107,18 +138,26 @@ typedef struct {
   ObjClass* nil_class;    // Base class: The nil class
   ObjClass* seq_class;    // Base class: The sequence class
   ObjClass* tuple_class;  // Base class: The tuple class
+  ObjClass* iter_class;   // Base class: The lazy iterator class
   ObjClass* str_class;    // Base class: The string class
   ObjClass* fn_class;     // Base class: The function class
   ObjClass* class_class;  // Base class: The class class
 
   ObjClass* upvalue_class;  // Unused, just for pointer comparison
-  ObjClass* handler_class;  // Unused, just for pointer comparison
 
   ObjClass* module_class;  // Obj-class: The module class
 
+  Shape* root_shape;  // Shape of objects without fields. Root of the shape transition tree.
+  int shape_count;    // Number of shapes in the shape transition tree.
+
   size_t bytes_allocated;  // Number of bytes currently allocated.
   size_t prev_gc_freed;    // Number of bytes freed in the last garbage collection.
   size_t next_gc;          // Number of bytes at which the next garbage collection will occur.
+
+  size_t invoke_cache_hits;      // Number of method lookups of OP_INVOKE served by an inline cache.
+  size_t invoke_cache_misses;    // Number of method lookups of OP_INVOKE which missed the inline cache.
+  size_t property_cache_hits;    // Number of property accesses of OP_GET_PROPERTY/OP_SET_PROPERTY served by an inline cache.
+  size_t property_cache_misses;  // Number of property accesses of OP_GET_PROPERTY/OP_SET_PROPERTY which missed the inline cache.
 } Vm;
 
 #define VM_FLAG_PAUSE_GC (1 << 0)
@@ -126,11 +165,16 @@ typedef struct {
 #define VM_FLAG_STRESS_GC (1 << 2)
 #define VM_FLAG_HAD_COMPILE_ERROR (1 << 3)
 #define VM_FLAG_HAD_UNCAUGHT_RUNTIME_ERROR (1 << 4)
+#define VM_FLAG_COUNT_CACHE_STATS (1 << 5)
 
 #define VM_SET_FLAG(flag) (vm.flags |= (flag))
 #define VM_CLEAR_FLAG(flag) (vm.flags &= ~(flag))
 #define VM_HAS_FLAG(flag) (vm.flags & (flag))
 
+// Counts an inline cache hit or miss in the [counter] field of the Vm. Only counts while VM_FLAG_COUNT_CACHE_STATS is set (see
+// Perf.count_caches()), so the cached paths only pay for testing the flag.
+#define VM_COUNT_CACHE_STAT(counter) (VM_HAS_FLAG(VM_FLAG_COUNT_CACHE_STATS) ? (void)vm.counter++ : (void)0)
+
 extern Vm vm;
 
 // Initialize the virtual machine.
@@ -139,6 +183,15 @@ void vm_init();
 // Free the virtual machine.
 void vm_free();
 
+// Sets the maximum call stack depth to [max_depth] frames. Must be called before any code is executed, because it reallocates
+// the call frames. Returns false if [max_depth] is out of range (1 to FRAMES_MAX_LIMIT).
+bool vm_set_max_depth(int max_depth);
+
+// Enables the baseline JIT and the tracing tier. Functions are compiled to machine code once they have been called [threshold]
+// times, loops are recorded and compiled as a trace once they have iterated [loop_threshold] times. Returns false if the JIT is not
+// supported on this platform (see jit.h) or a threshold is not positive.
+bool vm_enable_jit(int threshold, int loop_threshold);
+
 // Creates a new module instance. [source_path] is optional. The [module_name] however, is required.
 ObjObject* vm_make_module(const char* source_path, const char* module_name);
 
@@ -159,7 +212,8 @@ Value vm_run_module(const char* source_path, const char* module_name, bool disab
 // Reads a file from [source_path], compiles it and then runs it. Returns the resulting exit code.
 SlangExitCode vm_run_entry_point(const char* source_path, bool disable_warnings);
 
-// Push a value onto the stack.
+// Push a value onto the stack. Grows the stack if it is full. Growing moves the stack: The frames' slots, open upvalues and the
+// stack pointer are fixed up and the previous stack is retired, so natives can still read their arguments (argv).
 void vm_push(Value value);
 
 // Pop a value off the stack.
@@ -168,6 +222,11 @@ Value vm_pop();
 // Sets the current error value and puts the Vm into error state.
 void vm_error(const char* format, ...);
 
+// Puts the Vm into error state, like vm_error, but only formats the message once the error value is observed. [format] must be
+// a string literal and may only contain '%s' conversions for Str operands and '%d' conversions for Int operands. The [count]
+// operands are passed as Values.
+void vm_error_lazy(const char* format, int count, ...);
+
 // Clears the error state of the Vm.
 void vm_clear_error();
 
@@ -182,6 +241,24 @@ void vm_clear_error();
 // **Calls should be followed by a check for errors!**
 Value vm_exec_callable(Value callable, int arg_count);
 
+// Invokes [method] - a closure or native of the receiver's class - with [arg_count] arguments for a trace of the JIT (see jit.h).
+// The current frame continues at [ip] afterwards. Closures run to completion on a nested run(). Returns the start of the current
+// frame's stack window, which might have moved, or NULL if an error was raised. The interpreter handles it after the trace exits.
+// `Stack before: ...[receiver][arg0][arg1]...[argN]`
+// `Stack after:  ...[result]`
+Value* vm_jit_invoke(Obj* method, int arg_count, uint16_t* ip);
+
+// Prepares [callable] to be called with [arg_count] arguments from native code via vm_callback_call. What kind of callable it is,
+// and what goes into slot 0 of its frame, is resolved once here instead of on every call.
+void vm_callback_init(VmCallback* callback, Value callable, int arg_count);
+
+// Calls a prepared [callback] with the first [callback->arg_count] values of [args]. For closures and bound methods, the arguments
+// are written straight into the callee's frame - without dispatching on the type of the callable again. The frame still runs on
+// a nested run() of its own, like with vm_exec_callable: This only saves the per-call setup, not the re-entry. Everything else
+// goes through vm_exec_callable. The stack is left as it was before the call.
+// **Calls should be followed by a check for errors!**
+Value vm_callback_call(VmCallback* callback, const Value* args);
+
 // Determines whether a [value] is falsey. We consider nil and false to be falsey,
 // and everything else to be truthy.
 bool vm_is_falsey(Value value);
@@ -222,8 +299,212 @@ void define_native(HashTable* table, const char* name, NativeFn function, int ar
 // TODO (refactor): Move to object.h/c
 void define_value(HashTable* table, const char* name, Value value);
 
+// Defines a native [function] as a global of the given [module] with the provided [name] and [arity].
+void define_module_native(ObjObject* module, const char* name, NativeFn function, int arity);
+
+// Defines a [value] as a global of the given [module] with the provided [name].
+void define_module_value(ObjObject* module, const char* name, Value value);
+
 // TODO (refactor): Move all of the following to value.h/c
 
+#ifdef SLANG_NAN_BOXING
+
+// Wraps an object pointer into a value.
+static inline Value obj_ptr_value(Obj* obj) {
+  return VALUE_QNAN | VALUE_TAG_OBJ | ((uint64_t)(uintptr_t)obj & VALUE_PTR_MASK);
+}
+// Checks if a value holds an object pointer.
+static inline bool is_obj_ptr(Value value) {
+  return VALUE_IS_TAGGED(value, VALUE_TAG_OBJ);
+}
+// Checks if a value holds an object pointer to an object of the given gc-[type].
+static inline bool is_obj_ptr_of(Value value, ObjGcType type) {
+  return is_obj_ptr(value) && AS_OBJ(value)->type == type;
+}
+
+// Wraps an integer into a value. Integers which don't fit the 50-bit payload are boxed on the heap.
+static inline Value int_value(long long value) {
+  if (value >= VALUE_INT_PAYLOAD_MIN && value <= VALUE_INT_PAYLOAD_MAX) {
+    return VALUE_SIGN_BIT | VALUE_QNAN | ((uint64_t)value & VALUE_INT_MASK);
+  }
+  return obj_ptr_value((Obj*)new_boxed_int(value));
+}
+// Checks if a value is of type int.
+static inline bool is_int(Value value) {
+  return VALUE_IS_INT(value) || is_obj_ptr_of(value, OBJ_GC_INT);
+}
+
+// Wraps a float into a value. NaNs are canonicalized (keeping their sign), so their payload can't be mistaken for a tag.
+static inline Value float_value(double value) {
+  Value result;
+  memcpy(&result, &value, sizeof(Value));
+  if (value != value) {
+    return VALUE_CANONICAL_NAN | (result & VALUE_SIGN_BIT);
+  }
+  return result;
+}
+// Checks if a value is of type float.
+static inline bool is_float(Value value) {
+  return VALUE_IS_FLOAT(value);
+}
+
+// Wraps a boolean into a value.
+static inline Value bool_value(bool value) {
+  return value ? VALUE_TRUE : VALUE_FALSE;
+}
+// Checks if a value is of type bool.
+static inline bool is_bool(Value value) {
+  return (value | 1) == VALUE_TRUE;
+}
+
+// Wraps nil into a value.
+static inline Value nil_value() {
+  return VALUE_NIL;
+}
+// Checks if a value is of type nil.
+static inline bool is_nil(Value value) {
+  return value == VALUE_NIL;
+}
+
+// Wraps a seq-obj into a value.
+static inline Value seq_value(ObjSeq* value) {
+  return obj_ptr_value((Obj*)value);
+}
+// Checks if a value is of type seq.
+static inline bool is_seq(Value value) {
+  return is_obj_ptr_of(value, OBJ_GC_SEQ);
+}
+
+// Wraps a tuple-obj into a value.
+static inline Value tuple_value(ObjTuple* value) {
+  return obj_ptr_value((Obj*)value);
+}
+// Checks if a value is of type tuple.
+static inline bool is_tuple(Value value) {
+  return is_obj_ptr_of(value, OBJ_GC_TUPLE);
+}
+
+// Wraps an iter-obj into a value.
+static inline Value iter_value(ObjIter* value) {
+  return obj_ptr_value((Obj*)value);
+}
+// Checks if a value is of type iter.
+static inline bool is_iter(Value value) {
+  return is_obj_ptr_of(value, OBJ_GC_ITER);
+}
+
+// Wraps a string-obj into a value.
+static inline Value str_value(ObjString* value) {
+  return obj_ptr_value((Obj*)value);
+}
+// Checks if a value is of type string.
+static inline bool is_str(Value value) {
+  return is_obj_ptr_of(value, OBJ_GC_STRING);
+}
+
+// Wraps a class-obj into a value.
+static inline Value class_value(ObjClass* value) {
+  return obj_ptr_value((Obj*)value);
+}
+// Checks if a value is of type class.
+static inline bool is_class(Value value) {
+  return is_obj_ptr_of(value, OBJ_GC_CLASS);
+}
+
+// Wraps an obj-object into a value.
+static inline Value obj_value(ObjObject* value) {
+  return obj_ptr_value((Obj*)value);
+}
+// Checks if a value is of type obj.
+static inline bool is_obj(Value value) {
+  return is_obj_ptr_of(value, OBJ_GC_OBJECT) && ((ObjObject*)AS_OBJ(value))->instance_class == vm.obj_class;
+}
+
+// Wraps an obj-object into a value. The type of the value is inferred by the instance type of the obj-object.
+static inline Value instance_value(ObjObject* instance) {
+  return obj_ptr_value((Obj*)instance);
+}
+// Checks if a value is an instance. An instance is basically any value whose type is not an internal type.
+static inline bool is_instance(Value value) {
+  return is_obj_ptr_of(value, OBJ_GC_OBJECT) && ((ObjObject*)AS_OBJ(value))->instance_class != vm.obj_class;
+}
+
+// Checks if a value is of type fn AND the object is of type function.
+static inline bool is_function(Value value) {
+  return is_obj_ptr_of(value, OBJ_GC_FUNCTION);
+}
+
+// Checks if a value is of type fn AND the object is of type closure.
+static inline bool is_closure(Value value) {
+  return is_obj_ptr_of(value, OBJ_GC_CLOSURE);
+}
+
+// Checks if a value is of type fn AND the object is of type native.
+static inline bool is_native(Value value) {
+  return is_obj_ptr_of(value, OBJ_GC_NATIVE);
+}
+
+// Checks if a value is of type fn AND the object is of type bound method.
+static inline bool is_bound_method(Value value) {
+  return is_obj_ptr_of(value, OBJ_GC_BOUND_METHOD);
+}
+
+// Wraps any function-like-obj into a value. [fn] must be of one: Function, closure, native or bound method
+static inline Value fn_value(Obj* fn) {
+  return obj_ptr_value(fn);
+}
+// Checks if a value is of type fn.
+static inline bool is_fn(Value value) {
+  return is_function(value) || is_closure(value) || is_native(value) || is_bound_method(value);
+}
+
+// Wraps an empty internal into a value.
+static inline Value empty_internal_value() {
+  return VALUE_EMPTY_INTERNAL;
+}
+// Checks if a value is of type empty internal.
+static inline bool is_empty_internal(Value value) {
+  return value == VALUE_EMPTY_INTERNAL;
+}
+
+// Get the type (class) of a value. The type is not stored in the value, it's derived from the tag or the object header.
+static inline ObjClass* value_type(Value value) {
+  if (is_float(value)) {
+    return vm.float_class;
+  }
+  if (is_int(value)) {
+    return vm.int_class;
+  }
+  if (is_obj_ptr(value)) {
+    Obj* obj = AS_OBJ(value);
+    switch (obj->type) {
+      case OBJ_GC_OBJECT: return ((ObjObject*)obj)->instance_class;
+      case OBJ_GC_STRING: return vm.str_class;
+      case OBJ_GC_SEQ: return vm.seq_class;
+      case OBJ_GC_TUPLE: return vm.tuple_class;
+      case OBJ_GC_ITER: return vm.iter_class;
+      case OBJ_GC_INT: return vm.int_class;
+      case OBJ_GC_CLASS: return vm.class_class;
+      case OBJ_GC_UPVALUE: return vm.upvalue_class;
+      case OBJ_GC_CLOSURE:
+      case OBJ_GC_FUNCTION:
+      case OBJ_GC_NATIVE:
+      case OBJ_GC_BOUND_METHOD: return vm.fn_class;
+    }
+  }
+  if (is_nil(value)) {
+    return vm.nil_class;
+  }
+  return is_bool(value) ? vm.bool_class : NULL;
+}
+
+#else
+
+// Get the type (class) of a value.
+static inline ObjClass* value_type(Value value) {
+  return value.type;
+}
+
 // Wraps an integer into a value.
 static inline Value int_value(long long value) {
   return (Value){.type = vm.int_class, {.integer = value}};
@@ -278,6 +559,15 @@ static inline bool is_tuple(Value value) {
   return value.type == vm.tuple_class;
 }
 
+// Wraps an iter-obj into a value.
+static inline Value iter_value(ObjIter* value) {
+  return (Value){.type = vm.iter_class, {.obj = (Obj*)value}};
+}
+// Checks if a value is of type iter.
+static inline bool is_iter(Value value) {
+  return value.type == vm.iter_class;
+}
+
 // Wraps a string-obj into a value.
 static inline Value str_value(ObjString* value) {
   return (Value){.type = vm.str_class, {.obj = (Obj*)value}};
@@ -313,28 +603,28 @@ static inline Value instance_value(ObjObject* instance) {
 static inline bool is_instance(Value value) {
   return value.type != vm.obj_class && value.type != vm.nil_class && value.type != vm.str_class && value.type != vm.class_class &&
          value.type != vm.fn_class && value.type != vm.bool_class && value.type != vm.num_class && value.type != vm.int_class &&
-         value.type != vm.float_class && value.type != vm.upvalue_class && value.type != vm.handler_class &&
-         value.type != vm.seq_class && value.type != vm.tuple_class;
+         value.type != vm.float_class && value.type != vm.upvalue_class && value.type != vm.seq_class &&
+         value.type != vm.tuple_class && value.type != vm.iter_class;
 }
 
 // Checks if a value is of type fn AND the object is of type function.
 static inline bool is_function(Value value) {
-  return value.type == vm.fn_class && value.as.obj->type == OBJ_GC_FUNCTION;
+  return value.type == vm.fn_class && AS_OBJ(value)->type == OBJ_GC_FUNCTION;
 }
 
 // Checks if a value is of type fn AND the object is of type closure.
 static inline bool is_closure(Value value) {
-  return value.type == vm.fn_class && value.as.obj->type == OBJ_GC_CLOSURE;
+  return value.type == vm.fn_class && AS_OBJ(value)->type == OBJ_GC_CLOSURE;
 }
 
 // Checks if a value is of type fn AND the object is of type native.
 static inline bool is_native(Value value) {
-  return value.type == vm.fn_class && value.as.obj->type == OBJ_GC_NATIVE;
+  return value.type == vm.fn_class && AS_OBJ(value)->type == OBJ_GC_NATIVE;
 }
 
 // Checks if a value is of type fn AND the object is of type bound method.
 static inline bool is_bound_method(Value value) {
-  return value.type == vm.fn_class && value.as.obj->type == OBJ_GC_BOUND_METHOD;
+  return value.type == vm.fn_class && AS_OBJ(value)->type == OBJ_GC_BOUND_METHOD;
 }
 
 // Wraps any function-like-obj into a value. [fn] must be of one: Function, closure, native or bound method
@@ -346,15 +636,6 @@ static inline bool is_fn(Value value) {
   return value.type == vm.fn_class;
 }
 
-// Wraps a handler into a value.
-static inline Value handler_value(uint16_t value) {
-  return (Value){.type = vm.handler_class, {.handler = value}};
-}
-// Checks if a value is of type handler.
-static inline bool is_handler(Value value) {
-  return value.type == vm.handler_class;
-}
-
 // Wraps an empty internal into a value.
 static inline Value empty_internal_value() {
   return (Value){.type = NULL};
@@ -364,35 +645,40 @@ static inline bool is_empty_internal(Value value) {
   return value.type == NULL;
 }
 
+#endif
+
 // Converts a value into a bound method. Value must be of type bound method.
-#define AS_BOUND_METHOD(value) ((ObjBoundMethod*)(value.as.obj))
+#define AS_BOUND_METHOD(value) ((ObjBoundMethod*)AS_OBJ(value))
 
 // Converts a value into a class. Value must be of type class.
-#define AS_CLASS(value) ((ObjClass*)(value.as.obj))
+#define AS_CLASS(value) ((ObjClass*)AS_OBJ(value))
 
 // Converts a value into a closure. Value must be of type closure.
-#define AS_CLOSURE(value) ((ObjClosure*)(value.as.obj))
+#define AS_CLOSURE(value) ((ObjClosure*)AS_OBJ(value))
 
 // Converts a value into a sequence. Value must be of type sequence.
-#define AS_SEQ(value) ((ObjSeq*)(value.as.obj))
+#define AS_SEQ(value) ((ObjSeq*)AS_OBJ(value))
 
 // Converts a value into a tuple. Value must be of type tuple.
-#define AS_TUPLE(value) ((ObjTuple*)(value.as.obj))
+#define AS_TUPLE(value) ((ObjTuple*)AS_OBJ(value))
+
+// Converts a value into an iterator. Value must be of type iter.
+#define AS_ITER(value) ((ObjIter*)AS_OBJ(value))
 
 // Converts a value into a function. Value must be of type function.
-#define AS_FUNCTION(value) ((ObjFunction*)(value.as.obj))
+#define AS_FUNCTION(value) ((ObjFunction*)AS_OBJ(value))
 
 // Converts a value into an object. Value must be of type object.
-#define AS_OBJECT(value) ((ObjObject*)(value.as.obj))
+#define AS_OBJECT(value) ((ObjObject*)AS_OBJ(value))
 
 // Converts a value into a native function. Value must be of type native function.
-#define AS_NATIVE(value) (((ObjNative*)(value.as.obj)))
+#define AS_NATIVE(value) (((ObjNative*)AS_OBJ(value)))
 
 // Converts a value into a string. Value must be of type string.
-#define AS_STR(value) ((ObjString*)(value.as.obj))
+#define AS_STR(value) ((ObjString*)AS_OBJ(value))
 
 // Converts a value into a C string. Value must be of type string.
-#define AS_CSTRING(value) (((ObjString*)(value.as.obj))->chars)
+#define AS_CSTRING(value) (((ObjString*)AS_OBJ(value))->chars)
 
 //
 // Utility functions for values
@@ -400,8 +686,27 @@ static inline bool is_empty_internal(Value value) {
 
 // Checks if a value is a primitive. Primitive implies that the value is not an object and not markable by the GC.
 static inline bool is_primitive(Value value) {
+#ifdef SLANG_NAN_BOXING
+  return !is_obj_ptr(value);
+#else
   return value.type == vm.nil_class || value.type == vm.bool_class || value.type == vm.int_class ||
-         value.type == vm.float_class || value.type == vm.handler_class || value.type == NULL;
+         value.type == vm.float_class || value.type == NULL;
+#endif
+}
+
+// Checks if a value is a TYPENAME_INT or a TYPENAME_FLOAT.
+static inline bool is_num(Value value) {
+  return is_int(value) || is_float(value);
+}
+
+// Checks if a value is a TYPENAME_INT or a TYPENAME_FLOAT and not zero.
+static inline bool is_nonzero_num(Value value) {
+  return (is_int(value) && AS_INT(value) != 0) || (is_float(value) && AS_FLOAT(value) != 0.0);
+}
+
+// Converts a TYPENAME_INT or TYPENAME_FLOAT value to a double. Value must be a number.
+static inline double num_as_double(Value value) {
+  return is_int(value) ? (double)AS_INT(value) : AS_FLOAT(value);
 }
 
 // Callables are fn's or classes.
@@ -431,7 +736,7 @@ static inline int callable_get_arity(Value callable) {
     return AS_FUNCTION(callable)->arity;
   }
 
-  INTERNAL_ERROR("Unhandled callable type: %s", callable.type->name->chars);
+  INTERNAL_ERROR("Unhandled callable type: %s", value_type(callable)->name->chars);
   return 0;
 }
 
@@ -448,7 +753,7 @@ static inline ObjString* fn_get_name(Value fn) {
   if (is_function(fn)) {
     return AS_FUNCTION(fn)->name;
   }
-  INTERNAL_ERROR("Unhandled function type: %s", fn.type->name->chars);
+  INTERNAL_ERROR("Unhandled function type: %s", value_type(fn)->name->chars);
   return NULL;
 }
 #endif